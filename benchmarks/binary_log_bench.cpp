@@ -0,0 +1,95 @@
+// Throughput of the binary log sink against the text sink.
+//
+// Logs the same relay-style debug line through LOG_DEBUG_FMT three ways and
+// reports records per second, counting until everything is on disk:
+//   text sync    text sink, formatted and flushed on the logging thread
+//   text async   text sink with the background writer thread
+//   binary       binary sink only, text level above Debug
+// Storm suppression is turned off and the async queue blocks when full, so
+// every record is really written.
+// Files go to the system temp directory and are removed afterwards.
+//
+// Usage: binary_log_bench [records]
+
+#include "BinaryLog.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+template <typename Body>
+double recordsPerSecond(long records, Body body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body(records);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return records / std::chrono::duration<double>(elapsed).count();
+}
+
+void logRecords(long records)
+{
+    const QString cameraId = "front-door";
+    const QString direction = "camera->client";
+    for (long i = 0; i < records; ++i) {
+        LOG_DEBUG_FMT("Data forwarded: %1 bytes %2 for camera %3", "PortForwarder",
+                      1316 + (i & 0xFF), direction, cameraId);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const long records = argc > 1 ? std::atol(argv[1]) : 500000;
+    if (records <= 0) {
+        std::fprintf(stderr, "Usage: %s [records]\n", argv[0]);
+        return 2;
+    }
+
+    const QString textPath = QDir::temp().filePath("visco-binary-log-bench.log");
+    const QString binaryPath = QDir::temp().filePath("visco-binary-log-bench.vlog");
+    QFile::remove(textPath);
+    QFile::remove(binaryPath);
+
+    Logger& logger = Logger::instance();
+    logger.setLogFile(textPath);
+    logger.setRotation(0, 0, 0, false);
+    logger.setStormSuppression(false);
+
+    logger.setLogLevel(LogLevel::Debug);
+    const double textSync = recordsPerSecond(records, [](long n) { logRecords(n); });
+    const qint64 textBytes = QFileInfo(textPath).size();
+
+    logger.startAsync(65536, Logger::DEFAULT_FLUSH_INTERVAL_MS, LogOverflowPolicy::Block);
+    const double textAsync = recordsPerSecond(records, [&logger](long n) {
+        logRecords(n);
+        logger.stopAsync();
+    });
+
+    logger.setLogLevel(LogLevel::Info);
+    BinaryLog& binary = BinaryLog::instance();
+    binary.open(binaryPath, LogLevel::Debug);
+    const double binaryRate = recordsPerSecond(records, [&binary](long n) {
+        logRecords(n);
+        binary.flush();
+    });
+    binary.close();
+    const qint64 binaryBytes = QFileInfo(binaryPath).size();
+
+    std::printf("records         %ld\n", records);
+    std::printf("text sync       %.0f records/s\n", textSync);
+    std::printf("text async      %.0f records/s\n", textAsync);
+    std::printf("binary          %.0f records/s, %llu dropped\n", binaryRate,
+                static_cast<unsigned long long>(binary.droppedRecords()));
+    std::printf("bytes/record    text %.1f, binary %.1f\n",
+                static_cast<double>(textBytes) / records, static_cast<double>(binaryBytes) / records);
+
+    QFile::remove(textPath);
+    QFile::remove(binaryPath);
+    return 0;
+}
@@ -0,0 +1,407 @@
+// Round trip latency and throughput of an echo server.
+//
+// K clients each keep --depth messages of --size bytes in flight: a new
+// message goes out whenever an echo completes. The first 8 bytes of every
+// message carry its send time, so each completed echo gives one round trip
+// time, from the write() of the message to the read() of its last byte.
+//
+// Without --target it starts an EchoServer in-process on loopback, which
+// measures the server itself; with --target host:port it measures whatever
+// answers there, such as the echo server on the far side of the WireGuard
+// tunnel. The in-process server runs in --server-mode, standard or scalable,
+// with room for all clients; it still disconnects clients after 30 seconds.
+//
+// After --warmup seconds it measures for --seconds and prints messages and
+// bytes per second, RTT percentiles (p50/p90/p99/p999/max) and an RTT
+// histogram with one row per power of two microseconds.
+//
+// Usage: echo_bench [--target host:port | --server-mode standard|scalable]
+//            [--clients K] [--size bytes] [--depth n] [--seconds s]
+//            [--warmup s] [--threads n]
+
+#include "EchoServer.h"
+#include "Logger.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QtAlgorithms>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Options {
+    QString host;
+    quint16 port = 0;
+    int clients = 8;
+    int messageBytes = 64;
+    int depth = 1;              // Messages in flight per client
+    double seconds = 10.0;
+    double warmupSeconds = 1.0;
+    int threads = 2;
+};
+
+const int TIMESTAMP_BYTES = 8;
+const int READ_BUFFER_BYTES = 64 * 1024;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Log-linear histogram: 32 buckets per power of two, about 3% resolution
+class Histogram
+{
+public:
+    void record(quint64 value)
+    {
+        ++m_counts[bucketOf(value)];
+        ++m_total;
+        m_max = qMax(m_max, value);
+    }
+
+    void merge(const Histogram& other)
+    {
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = qMax(m_max, other.m_max);
+    }
+
+    quint64 count() const { return m_total; }
+    quint64 max() const { return m_max; }
+
+    // Middle of the bucket holding the given fraction of the samples
+    quint64 percentile(double fraction) const
+    {
+        const quint64 rank = qMin(m_total, static_cast<quint64>(fraction * m_total) + 1);
+        quint64 seen = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            seen += m_counts[i];
+            if (seen >= rank && m_counts[i] > 0) {
+                return qMin(m_max, lowerBound(i) + width(i) / 2);
+            }
+        }
+        return m_max;
+    }
+
+    // Samples in [from, to)
+    quint64 countBetween(quint64 from, quint64 to) const
+    {
+        quint64 count = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            if (lowerBound(i) >= from && lowerBound(i) < to) {
+                count += m_counts[i];
+            }
+        }
+        return count;
+    }
+
+private:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    static size_t bucketOf(quint64 value)
+    {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        const int magnitude = 63 - qCountLeadingZeroBits(value);
+        const int shift = magnitude - SUB_BUCKET_BITS;
+        const int sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + sub);
+    }
+
+    static quint64 lowerBound(size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        return static_cast<quint64>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    }
+
+    static quint64 width(size_t bucket)
+    {
+        return bucket < SUB_BUCKETS ? 1 : quint64(1) << (bucket / SUB_BUCKETS - 1);
+    }
+
+    std::array<quint64, (64 - SUB_BUCKET_BITS) * SUB_BUCKETS> m_counts{};
+    quint64 m_total = 0;
+    quint64 m_max = 0;
+};
+
+// Clients on one thread
+class ClientGroup : public QObject
+{
+public:
+    ClientGroup(const Options& options, int clients)
+        : m_options(options)
+        , m_clientCount(clients)
+        , m_message(options.messageBytes, 'e')
+        , m_readBuffer(READ_BUFFER_BYTES)
+    {
+    }
+
+    std::atomic<bool> measuring{false};
+    std::atomic<quint64> messages{0};     // Completed while measuring
+    std::atomic<int> connected{0};
+    std::atomic<int> lost{0};             // Refused, failed or dropped by the server
+    Histogram rttNs;                      // Read once the thread has stopped
+
+    // Runs on the group thread
+    void start()
+    {
+        for (int i = 0; i < m_clientCount; ++i) {
+            Client* client = new Client;
+            client->socket = new QTcpSocket(this);
+            client->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            connect(client->socket, &QTcpSocket::connected, this, [this, client]() {
+                connected.fetch_add(1, std::memory_order_relaxed);
+                for (int message = 0; message < m_options.depth; ++message) {
+                    send(client);
+                }
+            });
+            connect(client->socket, &QTcpSocket::readyRead, this, [this, client]() { read(client); });
+            connect(client->socket, &QTcpSocket::errorOccurred, this, [this, client]() {
+                if (!client->lost) {
+                    client->lost = true;
+                    lost.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            client->socket->connectToHost(m_options.host, m_options.port);
+            m_clients.append(client);
+        }
+    }
+
+    void stop()
+    {
+        for (Client* client : m_clients) {
+            QObject::disconnect(client->socket, nullptr, this, nullptr);
+            client->socket->abort();
+            delete client;
+        }
+        m_clients.clear();
+    }
+
+private:
+    struct Client {
+        QTcpSocket* socket = nullptr;
+        qint64 offset = 0;          // Bytes of echo received so far
+        char stamp[TIMESTAMP_BYTES];
+        bool lost = false;
+    };
+
+    void send(Client* client)
+    {
+        const qint64 sent = nowNs();
+        std::memcpy(m_message.data(), &sent, TIMESTAMP_BYTES);
+        client->socket->write(m_message);
+    }
+
+    void read(Client* client)
+    {
+        const qint64 size = m_options.messageBytes;
+        for (;;) {
+            const qint64 received = client->socket->read(m_readBuffer.data(), static_cast<qint64>(m_readBuffer.size()));
+            if (received <= 0) {
+                return;
+            }
+            const qint64 readNs = nowNs();
+            const bool measure = measuring.load(std::memory_order_relaxed);
+            const char* data = m_readBuffer.data();
+            qint64 left = received;
+            while (left > 0) {
+                const qint64 position = client->offset % size;
+                const qint64 take = qMin(size - position, left);
+                if (position < TIMESTAMP_BYTES) {
+                    const qint64 stampBytes = qMin<qint64>(TIMESTAMP_BYTES - position, take);
+                    std::memcpy(client->stamp + position, data, static_cast<size_t>(stampBytes));
+                }
+                data += take;
+                left -= take;
+                client->offset += take;
+
+                if (position + take == size) {
+                    // Echo complete: time it and put the next message in flight
+                    if (measure) {
+                        qint64 sentNs;
+                        std::memcpy(&sentNs, client->stamp, TIMESTAMP_BYTES);
+                        rttNs.record(static_cast<quint64>(qMax<qint64>(0, readNs - sentNs)));
+                        messages.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    send(client);
+                }
+            }
+        }
+    }
+
+    const Options m_options;
+    const int m_clientCount;
+    QByteArray m_message;
+    std::vector<char> m_readBuffer;
+    QList<Client*> m_clients;
+};
+
+QString microseconds(quint64 ns)
+{
+    return QString::number(ns / 1000.0, 'f', 1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Echo server latency and throughput benchmark");
+    parser.addHelpOption();
+    const QCommandLineOption targetOption("target", "Echo server to measure instead of an in-process EchoServer.",
+                                          "host:port");
+    const QCommandLineOption clientsOption("clients", "Concurrent client connections.", "K", "8");
+    const QCommandLineOption sizeOption("size", "Message size, at least 8.", "bytes", "64");
+    const QCommandLineOption depthOption("depth", "Messages in flight per client.", "n", "1");
+    const QCommandLineOption secondsOption("seconds", "Measured seconds.", "s", "10");
+    const QCommandLineOption warmupOption("warmup", "Seconds before measuring.", "s", "1");
+    const QCommandLineOption threadsOption("threads", "Client threads.", "n", "2");
+    const QCommandLineOption serverModeOption("server-mode", "Mode of the in-process EchoServer: standard or scalable.",
+                                              "mode", "standard");
+    parser.addOptions({targetOption, serverModeOption, clientsOption, sizeOption, depthOption, secondsOption, warmupOption,
+                       threadsOption});
+    parser.process(app);
+
+    Options options;
+    options.clients = parser.value(clientsOption).toInt();
+    options.messageBytes = parser.value(sizeOption).toInt();
+    options.depth = parser.value(depthOption).toInt();
+    options.seconds = parser.value(secondsOption).toDouble();
+    options.warmupSeconds = parser.value(warmupOption).toDouble();
+    options.threads = parser.value(threadsOption).toInt();
+    if (options.clients < 1 || options.messageBytes < TIMESTAMP_BYTES || options.depth < 1
+        || options.seconds <= 0.0 || options.warmupSeconds < 0.0 || options.threads < 1) {
+        err << "Invalid options, see --help" << Qt::endl;
+        return 2;
+    }
+
+    Logger::instance().setLogLevel(LogLevel::Warning);
+    EchoServer server;
+    QString targetDescription;
+    if (parser.isSet(targetOption)) {
+        const QString target = parser.value(targetOption);
+        const int colon = target.lastIndexOf(':');
+        bool portOk = false;
+        options.host = target.left(colon);
+        options.port = static_cast<quint16>(target.mid(colon + 1).toUShort(&portOk));
+        if (colon <= 0 || !portOk || options.port == 0) {
+            err << "--target must be host:port" << Qt::endl;
+            return 2;
+        }
+        targetDescription = target;
+    } else {
+        server.setMode(EchoServer::modeFromString(parser.value(serverModeOption)));
+        server.setMaxConnections(options.clients);
+        if (!server.startServer(0, QHostAddress::LocalHost)) {
+            err << "Could not start the in-process echo server" << Qt::endl;
+            return 1;
+        }
+        options.host = "127.0.0.1";
+        options.port = server.serverPort();
+        targetDescription = QString("127.0.0.1:%1 (in-process EchoServer, %2 mode)")
+                            .arg(options.port).arg(EchoServer::modeToString(server.mode()));
+    }
+
+    options.threads = qMin(options.threads, options.clients);
+    QList<QThread*> threads;
+    QList<ClientGroup*> groups;
+    for (int i = 0; i < options.threads; ++i) {
+        const int clients = options.clients / options.threads + (i < options.clients % options.threads ? 1 : 0);
+        QThread* thread = new QThread;
+        ClientGroup* group = new ClientGroup(options, clients);
+        group->moveToThread(thread);
+        thread->start();
+        threads.append(thread);
+        groups.append(group);
+        QMetaObject::invokeMethod(group, [group]() { group->start(); }, Qt::QueuedConnection);
+    }
+
+    QElapsedTimer measured;
+    QTimer::singleShot(static_cast<int>(options.warmupSeconds * 1000), &app, [&]() {
+        for (ClientGroup* group : groups) {
+            group->measuring.store(true, std::memory_order_relaxed);
+        }
+        measured.start();
+        QTimer::singleShot(static_cast<int>(options.seconds * 1000), &app, [&]() {
+            for (ClientGroup* group : groups) {
+                group->measuring.store(false, std::memory_order_relaxed);
+            }
+            app.quit();
+        });
+    });
+    app.exec();
+    const double elapsedSeconds = measured.nsecsElapsed() / 1e9;
+
+    for (ClientGroup* group : groups) {
+        QMetaObject::invokeMethod(group, [group]() { group->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    for (QThread* thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+
+    Histogram rtt;
+    quint64 messages = 0;
+    int connected = 0;
+    int lost = 0;
+    for (ClientGroup* group : groups) {
+        rtt.merge(group->rttNs);
+        messages += group->messages.load(std::memory_order_relaxed);
+        connected += group->connected.load(std::memory_order_relaxed);
+        lost += group->lost.load(std::memory_order_relaxed);
+    }
+    qDeleteAll(groups);
+    qDeleteAll(threads);
+    server.stopServer();
+
+    const double messagesPerSecond = messages / elapsedSeconds;
+    out << "target       " << targetDescription << Qt::endl;
+    out << QString("load         %1 clients (%2 connected, %3 lost), %4-byte messages, %5 in flight each")
+               .arg(options.clients).arg(connected).arg(lost).arg(options.messageBytes).arg(options.depth) << Qt::endl;
+    out << QString("messages/s   %1").arg(messagesPerSecond, 0, 'f', 0) << Qt::endl;
+    out << QString("bytes/s      %1 MB/s each way").arg(messagesPerSecond * options.messageBytes / 1e6, 0, 'f', 2)
+        << Qt::endl;
+    if (rtt.count() == 0) {
+        out << "RTT          no echoes completed" << Qt::endl;
+        return 1;
+    }
+    out << QString("RTT us       p50 %1  p90 %2  p99 %3  p999 %4  max %5  (%6 echoes)")
+               .arg(microseconds(rtt.percentile(0.50)), microseconds(rtt.percentile(0.90)),
+                    microseconds(rtt.percentile(0.99)), microseconds(rtt.percentile(0.999)),
+                    microseconds(rtt.max()))
+               .arg(rtt.count()) << Qt::endl;
+
+    // One row per power of two microseconds that has samples
+    const int barWidth = 40;
+    for (quint64 fromUs = 0, toUs = 1; fromUs * 1000 <= rtt.max(); fromUs = toUs, toUs *= 2) {
+        const quint64 count = rtt.countBetween(fromUs * 1000, toUs * 1000);
+        if (count == 0) {
+            continue;
+        }
+        const int bar = qMax(1, static_cast<int>(count * barWidth / rtt.count()));
+        out << QString("  %1 - %2 us %3 %4")
+                   .arg(fromUs, 8).arg(toUs, -8).arg(count, 10).arg(QString(bar, '#')) << Qt::endl;
+    }
+    return lost == 0 ? 0 : 1;
+}
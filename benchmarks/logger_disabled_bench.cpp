@@ -0,0 +1,71 @@
+// Cost of a log line whose level is filtered out.
+//
+// Times a LOG_DEBUG shaped like the ones on the relay hot path while the
+// logger runs at Info. The lazy variant goes through the macro, which checks
+// the level before the message is built. The eager variant builds the same
+// QString and hands it to Logger::debug(), the way the macros used to.
+// An empty loop gives the floor both are measured against.
+//
+// Exits with status 1 if a filtered LOG_DEBUG costs more than a twentieth
+// of building its message.
+//
+// Usage: logger_disabled_bench [iterations]
+
+#include "Logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+volatile int g_sink = 0;
+
+template <typename Body>
+double nanosecondsPerCall(long iterations, Body body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        body(i);
+        g_sink = g_sink + 1;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 2000000;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    Logger::instance().setLogLevel(LogLevel::Info);
+    const QString cameraId = "front-door";
+
+    const double floor = nanosecondsPerCall(iterations, [](long) {});
+    const double lazy = nanosecondsPerCall(iterations, [&](long i) {
+        LOG_DEBUG(QString("Forwarded %1 bytes to viewer %2 for camera %3")
+                  .arg(i).arg(i % 7).arg(cameraId), "PortForwarder");
+    });
+    const double eager = nanosecondsPerCall(iterations, [&](long i) {
+        Logger::instance().debug(QString("Forwarded %1 bytes to viewer %2 for camera %3")
+                                 .arg(i).arg(i % 7).arg(cameraId), "PortForwarder");
+    });
+
+    std::printf("iterations      %ld\n", iterations);
+    std::printf("empty loop      %.2f ns/call\n", floor);
+    std::printf("lazy LOG_DEBUG  %.2f ns/call (%.2f over the loop)\n", lazy, lazy - floor);
+    std::printf("eager format    %.2f ns/call (%.2f over the loop)\n", eager, eager - floor);
+
+    if ((lazy - floor) * 20 > eager - floor) {
+        std::fprintf(stderr, "FAIL: filtered LOG_DEBUG costs %.2f ns, eager formatting %.2f ns\n",
+                     lazy - floor, eager - floor);
+        return 1;
+    }
+    std::printf("OK: filtered log lines are not formatted\n");
+    return 0;
+}
@@ -0,0 +1,527 @@
+// Throughput and latency of PortForwarder relaying loopback camera streams.
+//
+// Starts a PortForwarder in-process with M cameras that point at local
+// camera sources, then opens N viewer connections to each camera's external
+// port. Every viewer connection gets its own camera connection streaming
+// fixed-size chunks at the given bitrate, or as fast as the relay takes
+// them with --bitrate 0. The first 8 bytes of each chunk carry its send
+// time, so the viewers measure relay latency per chunk: from the source's
+// write() to the viewer's read(), socket buffering on both sides included.
+//
+// After --warmup seconds it measures for --seconds and prints JSON:
+//   throughput_gbps       bytes delivered to viewers
+//   cpu_seconds_per_gb    process CPU time, sources and viewers included
+//   latency_us            p50, p99, p999 and max chunk relay latency
+//   peak_rss_kb           peak resident set size of the whole process
+// Sources and viewers run on --load-threads threads each, the forwarder
+// on the main thread plus its --threads workers.
+//
+// The camera streams are plain bytes, not RTSP, so the relay stays on the
+// user-space path; the splice backend only switches after an RTSP handshake.
+//
+// Usage: port_forwarder_bench [--cameras M] [--clients N] [--bitrate Mbit/s]
+//            [--chunk bytes] [--seconds s] [--warmup s] [--threads n]
+//            [--load-threads n] [--base-port port] [--output file]
+
+#include "Logger.h"
+#include "PortForwarder.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Options {
+    int cameras = 4;
+    int clients = 2;             // Viewer connections per camera
+    double bitrateMbps = 8.0;    // Per connection, 0 for unlimited
+    int chunkBytes = 1400;
+    double seconds = 10.0;
+    double warmupSeconds = 2.0;
+    int threads = -1;            // Forwarding threads, -1 for the CPU count
+    int loadThreads = 2;
+    int basePort = 18550;
+};
+
+const int TIMESTAMP_BYTES = 8;
+const qint64 MAX_QUEUED_BYTES = 256 * 1024;  // Per source connection
+const int PACING_INTERVAL_MS = 1;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ProcessUsage {
+    double cpuSeconds = 0.0;
+    qint64 peakRssKb = 0;
+};
+
+ProcessUsage processUsage()
+{
+    ProcessUsage usage;
+#ifdef Q_OS_WIN
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        auto seconds = [](const FILETIME& time) {
+            return ((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+        };
+        usage.cpuSeconds = seconds(kernel) + seconds(user);
+    }
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        usage.peakRssKb = static_cast<qint64>(memory.PeakWorkingSetSize / 1024);
+    }
+#else
+    struct rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0) {
+        usage.cpuSeconds = resources.ru_utime.tv_sec + resources.ru_utime.tv_usec / 1e6
+                         + resources.ru_stime.tv_sec + resources.ru_stime.tv_usec / 1e6;
+#ifdef Q_OS_MACOS
+        usage.peakRssKb = resources.ru_maxrss / 1024;  // Bytes on macOS
+#else
+        usage.peakRssKb = resources.ru_maxrss;
+#endif
+    }
+#endif
+    return usage;
+}
+
+// Loopback cameras: every accepted connection gets a paced chunk stream
+class CameraSource : public QObject
+{
+public:
+    explicit CameraSource(const Options& options)
+        : m_options(options)
+        , m_bytesPerNs(options.bitrateMbps * 1e6 / 8.0 / 1e9)
+        , m_chunk(options.chunkBytes, 'v')
+    {
+    }
+
+    std::atomic<int> streams{0};
+
+    // Runs on the source thread; returns the listening ports
+    QList<quint16> listen(int cameras)
+    {
+        QList<quint16> ports;
+        for (int i = 0; i < cameras; ++i) {
+            QTcpServer* server = new QTcpServer(this);
+            if (!server->listen(QHostAddress::LocalHost, 0)) {
+                return QList<quint16>();
+            }
+            connect(server, &QTcpServer::newConnection, this, [this, server]() {
+                while (QTcpSocket* socket = server->nextPendingConnection()) {
+                    accept(socket);
+                }
+            });
+            ports.append(server->serverPort());
+        }
+
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(PACING_INTERVAL_MS);
+        connect(m_timer, &QTimer::timeout, this, [this]() {
+            const qint64 now = nowNs();
+            const qint64 elapsed = now - m_lastTickNs;
+            m_lastTickNs = now;
+            for (Stream* stream : m_streams) {
+                stream->budget = qMin(stream->budget + elapsed * m_bytesPerNs, 8.0 * m_options.chunkBytes);
+                fill(stream);
+            }
+        });
+        m_lastTickNs = nowNs();
+        m_timer->start();
+        return ports;
+    }
+
+    void stop()
+    {
+        m_timer->stop();
+        for (Stream* stream : m_streams) {
+            stream->socket->abort();
+            delete stream;
+        }
+        m_streams.clear();
+    }
+
+private:
+    struct Stream {
+        QTcpSocket* socket = nullptr;
+        double budget = 0.0;  // Bytes the bitrate allows to send now
+    };
+
+    void accept(QTcpSocket* socket)
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        Stream* stream = new Stream;
+        stream->socket = socket;
+        m_streams.append(stream);
+        streams.fetch_add(1, std::memory_order_relaxed);
+        if (m_options.bitrateMbps <= 0.0) {
+            connect(socket, &QTcpSocket::bytesWritten, this, [this, stream]() { fill(stream); });
+            fill(stream);
+        }
+    }
+
+    void fill(Stream* stream)
+    {
+        const bool unlimited = m_options.bitrateMbps <= 0.0;
+        while (stream->socket->bytesToWrite() < MAX_QUEUED_BYTES
+               && (unlimited || stream->budget >= m_options.chunkBytes)) {
+            const qint64 sent = nowNs();
+            std::memcpy(m_chunk.data(), &sent, TIMESTAMP_BYTES);
+            stream->socket->write(m_chunk);  // Copied into the socket buffer
+            stream->budget -= m_options.chunkBytes;
+        }
+    }
+
+    const Options m_options;
+    const double m_bytesPerNs;
+    QByteArray m_chunk;
+    QList<Stream*> m_streams;
+    QTimer* m_timer = nullptr;
+    qint64 m_lastTickNs = 0;
+};
+
+// Viewers: count relayed bytes and time each chunk by its stamp
+class ViewerSink : public QObject
+{
+public:
+    explicit ViewerSink(const Options& options)
+        : m_options(options)
+        , m_buffer(64 * 1024)
+    {
+    }
+
+    std::atomic<quint64> bytes{0};
+    std::atomic<bool> measuring{false};
+    std::vector<qint64> latenciesNs;  // Read once the sink thread has stopped
+
+    // Runs on the sink thread
+    void connectTo(const QList<quint16>& ports)
+    {
+        latenciesNs.reserve(1 << 20);
+        for (quint16 port : ports) {
+            Viewer* viewer = new Viewer;
+            viewer->socket = new QTcpSocket(this);
+            viewer->socket->setReadBufferSize(0);
+            connect(viewer->socket, &QTcpSocket::readyRead, this, [this, viewer]() { read(viewer); });
+            viewer->socket->connectToHost(QHostAddress::LocalHost, port);
+            m_viewers.append(viewer);
+        }
+    }
+
+    void stop()
+    {
+        for (Viewer* viewer : m_viewers) {
+            viewer->socket->abort();
+            delete viewer;
+        }
+        m_viewers.clear();
+    }
+
+private:
+    struct Viewer {
+        QTcpSocket* socket = nullptr;
+        qint64 offset = 0;  // Bytes received so far
+        char stamp[TIMESTAMP_BYTES];
+    };
+
+    void read(Viewer* viewer)
+    {
+        const qint64 chunk = m_options.chunkBytes;
+        for (;;) {
+            const qint64 received = viewer->socket->read(m_buffer.data(), static_cast<qint64>(m_buffer.size()));
+            if (received <= 0) {
+                return;
+            }
+            const qint64 readNs = nowNs();
+            const bool measure = measuring.load(std::memory_order_relaxed);
+            bytes.fetch_add(static_cast<quint64>(received), std::memory_order_relaxed);
+
+            // Walk chunk boundaries; a stamp may be split across reads
+            const char* data = m_buffer.data();
+            qint64 left = received;
+            while (left > 0) {
+                const qint64 position = viewer->offset % chunk;
+                if (position < TIMESTAMP_BYTES) {
+                    const qint64 take = qMin<qint64>(TIMESTAMP_BYTES - position, left);
+                    std::memcpy(viewer->stamp + position, data, static_cast<size_t>(take));
+                    if (position + take == TIMESTAMP_BYTES && measure) {
+                        qint64 sent;
+                        std::memcpy(&sent, viewer->stamp, TIMESTAMP_BYTES);
+                        latenciesNs.push_back(readNs - sent);
+                    }
+                    data += take;
+                    left -= take;
+                    viewer->offset += take;
+                } else {
+                    const qint64 take = qMin<qint64>(chunk - position, left);
+                    data += take;
+                    left -= take;
+                    viewer->offset += take;
+                }
+            }
+        }
+    }
+
+    const Options m_options;
+    std::vector<char> m_buffer;
+    QList<Viewer*> m_viewers;
+};
+
+double percentileUs(const std::vector<qint64>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = qMin(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("PortForwarder throughput and latency benchmark");
+    parser.addHelpOption();
+    const QCommandLineOption camerasOption("cameras", "Cameras forwarded.", "M", "4");
+    const QCommandLineOption clientsOption("clients", "Viewer connections per camera.", "N", "2");
+    const QCommandLineOption bitrateOption("bitrate", "Mbit/s per connection, 0 for unlimited.", "Mbit/s", "8");
+    const QCommandLineOption chunkOption("chunk", "Bytes per chunk written by the camera.", "bytes", "1400");
+    const QCommandLineOption secondsOption("seconds", "Measured seconds.", "s", "10");
+    const QCommandLineOption warmupOption("warmup", "Seconds before measuring.", "s", "2");
+    const QCommandLineOption threadsOption("threads", "Forwarding threads, -1 for the CPU count.", "n", "-1");
+    const QCommandLineOption loadThreadsOption("load-threads", "Threads for the sources and for the viewers.", "n", "2");
+    const QCommandLineOption basePortOption("base-port", "External port of the first camera.", "port", "18550");
+    const QCommandLineOption outputOption("output", "Write the JSON here instead of standard output.", "file");
+    parser.addOptions({camerasOption, clientsOption, bitrateOption, chunkOption, secondsOption, warmupOption,
+                       threadsOption, loadThreadsOption, basePortOption, outputOption});
+    parser.process(app);
+
+    Options options;
+    options.cameras = parser.value(camerasOption).toInt();
+    options.clients = parser.value(clientsOption).toInt();
+    options.bitrateMbps = parser.value(bitrateOption).toDouble();
+    options.chunkBytes = parser.value(chunkOption).toInt();
+    options.seconds = parser.value(secondsOption).toDouble();
+    options.warmupSeconds = parser.value(warmupOption).toDouble();
+    options.threads = parser.value(threadsOption).toInt();
+    options.loadThreads = parser.value(loadThreadsOption).toInt();
+    options.basePort = parser.value(basePortOption).toInt();
+    if (options.cameras < 1 || options.clients < 1 || options.chunkBytes < TIMESTAMP_BYTES
+        || options.seconds <= 0.0 || options.loadThreads < 1 || options.bitrateMbps < 0.0
+        || options.basePort < 1 || options.basePort + options.cameras > 65536) {
+        std::fprintf(stderr, "Invalid options, see --help\n");
+        return 2;
+    }
+    if (options.threads < 0) {
+        options.threads = ForwardingEngine::defaultThreadCount();
+    }
+
+    Logger::instance().setLogLevel(LogLevel::Warning);
+
+    // Cameras, spread over the source threads
+    QList<QThread*> threads;
+    QList<CameraSource*> sources;
+    QList<quint16> cameraPorts;
+    for (int i = 0; i < options.loadThreads; ++i) {
+        const int cameras = options.cameras / options.loadThreads + (i < options.cameras % options.loadThreads ? 1 : 0);
+        if (cameras == 0) {
+            continue;
+        }
+        QThread* thread = new QThread;
+        CameraSource* source = new CameraSource(options);
+        source->moveToThread(thread);
+        thread->start();
+        threads.append(thread);
+        sources.append(source);
+
+        QList<quint16> ports;
+        QMetaObject::invokeMethod(source, [&ports, source, cameras]() { ports = source->listen(cameras); },
+                                  Qt::BlockingQueuedConnection);
+        if (ports.isEmpty()) {
+            std::fprintf(stderr, "Could not listen for the loopback cameras\n");
+            return 1;
+        }
+        cameraPorts.append(ports);
+    }
+
+    PortForwarder forwarder;
+    forwarder.configureEngine(options.threads, ForwardingEngine::ShardMode::ByConnection, false);
+    QList<quint16> externalPorts;
+    for (int i = 0; i < cameraPorts.size(); ++i) {
+        CameraConfig camera(QString("bench-%1").arg(i), "127.0.0.1", cameraPorts.at(i), QString(), QString(), true);
+        camera.setExternalPort(options.basePort + i);
+        if (!forwarder.startForwarding(camera)) {
+            std::fprintf(stderr, "Could not forward port %d\n", options.basePort + i);
+            return 1;
+        }
+        externalPorts.append(static_cast<quint16>(options.basePort + i));
+    }
+
+    // Viewers, spread over their own threads
+    QList<ViewerSink*> sinks;
+    const int connections = options.cameras * options.clients;
+    for (int i = 0; i < options.loadThreads; ++i) {
+        QList<quint16> ports;
+        for (int connection = i; connection < connections; connection += options.loadThreads) {
+            ports.append(externalPorts.at(connection % options.cameras));
+        }
+        if (ports.isEmpty()) {
+            continue;
+        }
+        QThread* thread = new QThread;
+        ViewerSink* sink = new ViewerSink(options);
+        sink->moveToThread(thread);
+        thread->start();
+        threads.append(thread);
+        sinks.append(sink);
+        QMetaObject::invokeMethod(sink, [sink, ports]() { sink->connectTo(ports); }, Qt::QueuedConnection);
+    }
+
+    // Every viewer has its camera stream once the sources saw all connections
+    auto streamCount = [&sources]() {
+        int count = 0;
+        for (CameraSource* source : sources) {
+            count += source->streams.load(std::memory_order_relaxed);
+        }
+        return count;
+    };
+    QElapsedTimer connecting;
+    connecting.start();
+    while (streamCount() < connections && connecting.elapsed() < 10000) {
+        app.processEvents(QEventLoop::AllEvents, 10);
+    }
+    if (streamCount() < connections) {
+        std::fprintf(stderr, "Only %d of %d connections came up\n", streamCount(), connections);
+        return 1;
+    }
+
+    // Warm up, then measure
+    auto totalBytes = [&sinks]() {
+        quint64 bytes = 0;
+        for (ViewerSink* sink : sinks) {
+            bytes += sink->bytes.load(std::memory_order_relaxed);
+        }
+        return bytes;
+    };
+    quint64 startBytes = 0;
+    quint64 endBytes = 0;
+    ProcessUsage startUsage;
+    ProcessUsage endUsage;
+    QElapsedTimer measured;
+    QTimer::singleShot(static_cast<int>(options.warmupSeconds * 1000), &app, [&]() {
+        for (ViewerSink* sink : sinks) {
+            sink->measuring.store(true, std::memory_order_relaxed);
+        }
+        startBytes = totalBytes();
+        startUsage = processUsage();
+        measured.start();
+        QTimer::singleShot(static_cast<int>(options.seconds * 1000), &app, [&]() {
+            for (ViewerSink* sink : sinks) {
+                sink->measuring.store(false, std::memory_order_relaxed);
+            }
+            endBytes = totalBytes();
+            endUsage = processUsage();
+            app.quit();
+        });
+    });
+    app.exec();
+    const double elapsedSeconds = measured.nsecsElapsed() / 1e9;
+
+    for (ViewerSink* sink : sinks) {
+        QMetaObject::invokeMethod(sink, [sink]() { sink->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    for (CameraSource* source : sources) {
+        QMetaObject::invokeMethod(source, [source]() { source->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    for (QThread* thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+    forwarder.stopAllForwarding();
+
+    std::vector<qint64> latencies;
+    for (ViewerSink* sink : sinks) {
+        latencies.insert(latencies.end(), sink->latenciesNs.begin(), sink->latenciesNs.end());
+        delete sink;
+    }
+    for (CameraSource* source : sources) {
+        delete source;
+    }
+    qDeleteAll(threads);
+    std::sort(latencies.begin(), latencies.end());
+
+    const quint64 bytes = endBytes - startBytes;
+    const double gigabytes = bytes / 1e9;
+    const double cpuSeconds = endUsage.cpuSeconds - startUsage.cpuSeconds;
+
+    QJsonObject config;
+    config["cameras"] = options.cameras;
+    config["clients_per_camera"] = options.clients;
+    config["bitrate_mbps"] = options.bitrateMbps;
+    config["chunk_bytes"] = options.chunkBytes;
+    config["seconds"] = options.seconds;
+    config["forwarding_threads"] = options.threads;
+    config["load_threads"] = options.loadThreads;
+
+    QJsonObject latency;
+    latency["samples"] = static_cast<qint64>(latencies.size());
+    latency["p50"] = percentileUs(latencies, 0.50);
+    latency["p99"] = percentileUs(latencies, 0.99);
+    latency["p999"] = percentileUs(latencies, 0.999);
+    latency["max"] = latencies.empty() ? 0.0 : latencies.back() / 1000.0;
+
+    QJsonObject results;
+    results["bytes"] = static_cast<qint64>(bytes);
+    results["elapsed_seconds"] = elapsedSeconds;
+    results["throughput_gbps"] = elapsedSeconds > 0.0 ? bytes * 8.0 / elapsedSeconds / 1e9 : 0.0;
+    results["cpu_seconds"] = cpuSeconds;
+    results["cpu_seconds_per_gb"] = gigabytes > 0.0 ? cpuSeconds / gigabytes : 0.0;
+    results["latency_us"] = latency;
+    results["peak_rss_kb"] = endUsage.peakRssKb;
+
+    QJsonObject root;
+    root["benchmark"] = "port_forwarder";
+    root["qt_version"] = QString(qVersion());
+    root["config"] = config;
+    root["results"] = results;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "Could not write %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+    return 0;
+}
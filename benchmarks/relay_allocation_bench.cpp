@@ -0,0 +1,316 @@
+// Allocation check for the ForwardingWorker relay path.
+//
+// Streams interleaved RTP from a loopback camera through a real
+// ForwardingWorker session to a loopback viewer, counting heap allocations
+// with a replaced global operator new. The camera sends one chunk at a time
+// and waits for the viewer to receive it, so every run relays the same
+// chunks in the same number of rounds.
+//
+// The same stream is then relayed by a bare QTcpSocket relay that reads into
+// a fixed buffer, which is what Qt's own socket machinery costs per chunk.
+// The check fails when the worker allocates more than that baseline plus one
+// allocation per RELAY_SLACK_ROUNDS chunks, as it did when every read was a
+// readAll() into a new QByteArray.
+//
+// Exits with status 1 on failure, 2 on setup errors. Registered with ctest.
+//
+// Usage: relay_allocation_bench [chunks] [chunk bytes]
+
+#include "ForwardingWorker.h"
+#include "Logger.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+void* countedAllocate(size_t size, size_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    void* memory = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        memory = std::malloc(size);
+    } else {
+        const size_t rounded = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+        memory = _aligned_malloc(rounded, alignment);
+#else
+        memory = std::aligned_alloc(alignment, rounded);
+#endif
+    }
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void countedFree(void* memory, size_t alignment)
+{
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(memory);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(memory);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<size_t>(alignment)); }
+void operator delete(void* memory) noexcept { countedFree(memory, 0); }
+void operator delete[](void* memory) noexcept { countedFree(memory, 0); }
+void operator delete(void* memory, size_t) noexcept { countedFree(memory, 0); }
+void operator delete[](void* memory, size_t) noexcept { countedFree(memory, 0); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<size_t>(alignment)); }
+void operator delete[](void* memory, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<size_t>(alignment)); }
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<size_t>(alignment)); }
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept { countedFree(memory, static_cast<size_t>(alignment)); }
+
+namespace {
+
+const int WARMUP_ROUNDS = 2000;
+const int RELAY_SLACK_ROUNDS = 10;
+const int TIMEOUT_MS = 60000;
+const int READ_BUFFER_SIZE = 64 * 1024;
+
+// Interleaved RTP with a keepalive response now and then, as seen on the
+// target->client direction once a stream plays
+std::string buildStream(size_t targetSize)
+{
+    std::string out;
+    out.reserve(targetSize + 1024);
+    uint32_t seed = 7;
+    size_t frame = 0;
+    while (out.size() < targetSize) {
+        seed = seed * 1664525u + 1013904223u;
+        const size_t length = 200 + (seed >> 16) % 1260;
+        out.push_back('$');
+        out.push_back(static_cast<char>(frame % 10 == 9 ? 1 : 0));
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(length & 0xff));
+        out.append(length, static_cast<char>(seed));
+        if (++frame % 2000 == 0) {
+            out += "RTSP/1.0 200 OK\r\nCSeq: 9\r\nSession: 1234\r\n\r\n";
+        }
+    }
+    return out;
+}
+
+// Hands accepted connections to a ForwardingWorker, as PortForwarder does
+class WorkerListener : public QTcpServer
+{
+public:
+    WorkerListener(ForwardingWorker* worker, const CameraConfig& camera)
+        : m_worker(worker), m_camera(camera), m_traffic(new TrafficCounters) {}
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        m_worker->acceptConnection(m_camera, 1, m_traffic, socketDescriptor);
+    }
+
+private:
+    ForwardingWorker* m_worker;
+    CameraConfig m_camera;
+    QSharedPointer<TrafficCounters> m_traffic;
+};
+
+// The least a QTcpSocket relay can do: read into a fixed buffer, write to
+// the peer. Socket options match ForwardingWorker::optimizeSocketForStreaming().
+class BareRelay : public QTcpServer
+{
+public:
+    explicit BareRelay(quint16 cameraPort) : m_cameraPort(cameraPort), m_buffer(READ_BUFFER_SIZE) {}
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        QTcpSocket* client = new QTcpSocket(this);
+        client->setSocketDescriptor(socketDescriptor);
+        QTcpSocket* target = new QTcpSocket(this);
+        for (QTcpSocket* socket : { client, target }) {
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            socket->setReadBufferSize(128 * 1024);
+        }
+        connect(client, &QTcpSocket::readyRead, this, [this, client, target]() { relay(client, target); });
+        connect(target, &QTcpSocket::readyRead, this, [this, client, target]() { relay(target, client); });
+        target->connectToHost(QHostAddress::LocalHost, m_cameraPort);
+    }
+
+private:
+    void relay(QTcpSocket* from, QTcpSocket* to)
+    {
+        while (from->bytesAvailable() > 0) {
+            const qint64 size = from->read(m_buffer.data(), static_cast<qint64>(m_buffer.size()));
+            if (size <= 0) {
+                break;
+            }
+            to->write(m_buffer.data(), size);
+            to->flush();
+        }
+    }
+
+    quint16 m_cameraPort;
+    std::vector<char> m_buffer;
+};
+
+struct Result {
+    bool completed = false;
+    uint64_t allocations = 0;
+    double seconds = 0.0;
+};
+
+// Sends `rounds` chunks camera -> relay -> viewer, one at a time, and counts
+// the allocations of the rounds after warm-up. startRelay listens on a free
+// port and returns it, forwarding to the camera port it is given.
+Result run(const std::string& stream, int rounds, int chunkSize,
+           const std::function<quint16(quint16 cameraPort)>& startRelay)
+{
+    Result result;
+    QTcpServer camera;
+    if (!camera.listen(QHostAddress::LocalHost)) {
+        return result;
+    }
+    const quint16 relayPort = startRelay(camera.serverPort());
+    if (relayPort == 0) {
+        return result;
+    }
+
+    QEventLoop loop;
+    QTcpSocket viewer;
+    QTcpSocket* cameraSocket = nullptr;
+    std::vector<char> readBuffer(READ_BUFFER_SIZE);
+    size_t position = 0;
+    qint64 sent = 0;       // Bytes of the chunk in flight
+    qint64 received = 0;
+    int round = 0;
+    uint64_t allocationsBefore = 0;
+    QElapsedTimer timer;
+
+    // The stream ends on a frame boundary, so its last chunk is cut short
+    // there and the next one starts over at the beginning
+    auto sendChunk = [&]() {
+        if (position == stream.size()) {
+            position = 0;
+        }
+        sent = static_cast<qint64>(std::min(stream.size() - position, static_cast<size_t>(chunkSize)));
+        cameraSocket->write(stream.data() + position, sent);
+        position += static_cast<size_t>(sent);
+    };
+
+    QObject::connect(&camera, &QTcpServer::newConnection, &loop, [&]() {
+        cameraSocket = camera.nextPendingConnection();
+        cameraSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        sendChunk();
+    });
+    QObject::connect(&viewer, &QTcpSocket::readyRead, &loop, [&]() {
+        while (viewer.bytesAvailable() > 0) {
+            const qint64 size = viewer.read(readBuffer.data(), static_cast<qint64>(readBuffer.size()));
+            if (size <= 0) {
+                break;
+            }
+            received += size;
+        }
+        if (received < sent) {
+            return;
+        }
+        received = 0;
+        ++round;
+        if (round == WARMUP_ROUNDS) {
+            allocationsBefore = g_allocations.load();
+            timer.start();
+        } else if (round == WARMUP_ROUNDS + rounds) {
+            result.allocations = g_allocations.load() - allocationsBefore;
+            result.seconds = timer.nsecsElapsed() / 1e9;
+            result.completed = true;
+            loop.quit();
+            return;
+        }
+        sendChunk();
+    });
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    viewer.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    viewer.connectToHost(QHostAddress::LocalHost, relayPort);
+    loop.exec();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int chunkSize = argc > 2 ? std::atoi(argv[2]) : 16 * 1024;
+    if (rounds <= 0 || chunkSize <= 0 || chunkSize > READ_BUFFER_SIZE) {
+        std::fprintf(stderr, "Usage: %s [chunks] [chunk bytes <= %d]\n", argv[0], READ_BUFFER_SIZE);
+        return 2;
+    }
+
+    Logger::instance().setLogLevel(LogLevel::Warning);
+    const std::string stream = buildStream(8 * 1024 * 1024);
+
+    ForwardingWorker worker;
+    WorkerListener* workerListener = nullptr;
+    const Result relayed = run(stream, rounds, chunkSize, [&](quint16 cameraPort) -> quint16 {
+        CameraConfig camera("alloc-check", "127.0.0.1", cameraPort, QString(), QString(), true);
+        workerListener = new WorkerListener(&worker, camera);
+        return workerListener->listen(QHostAddress::LocalHost) ? workerListener->serverPort() : 0;
+    });
+    worker.closeAll();
+    delete workerListener;
+
+    BareRelay* bareRelay = nullptr;
+    const Result baseline = run(stream, rounds, chunkSize, [&](quint16 cameraPort) -> quint16 {
+        bareRelay = new BareRelay(cameraPort);
+        return bareRelay->listen(QHostAddress::LocalHost) ? bareRelay->serverPort() : 0;
+    });
+    delete bareRelay;
+
+    if (!relayed.completed || !baseline.completed) {
+        std::fprintf(stderr, "Relay did not deliver %d chunks within %d s\n", WARMUP_ROUNDS + rounds, TIMEOUT_MS / 1000);
+        return 2;
+    }
+
+    std::printf("chunks            %d of %d bytes after %d warm-up chunks\n", rounds, chunkSize, WARMUP_ROUNDS);
+    std::printf("ForwardingWorker  %llu allocations, %.1f us/chunk\n",
+                static_cast<unsigned long long>(relayed.allocations), relayed.seconds * 1e6 / rounds);
+    std::printf("bare Qt relay     %llu allocations, %.1f us/chunk\n",
+                static_cast<unsigned long long>(baseline.allocations), baseline.seconds * 1e6 / rounds);
+
+    const uint64_t limit = baseline.allocations + static_cast<uint64_t>(rounds / RELAY_SLACK_ROUNDS);
+    if (relayed.allocations > limit) {
+        std::fprintf(stderr, "FAIL: ForwardingWorker allocated %llu times, more than the %llu of the bare relay "
+                     "plus one per %d chunks\n", static_cast<unsigned long long>(relayed.allocations),
+                     static_cast<unsigned long long>(baseline.allocations), RELAY_SLACK_ROUNDS);
+        return 1;
+    }
+    std::printf("OK: the relay path adds no per-chunk allocations\n");
+    return 0;
+}
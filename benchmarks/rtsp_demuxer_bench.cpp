@@ -0,0 +1,137 @@
+// Microbenchmark for RtspDemuxer.
+//
+// Builds an in-memory RTSP session (handshake, interleaved RTP/RTCP frames of
+// mixed sizes and periodic keepalive responses), then feeds it through the
+// demuxer in socket sized chunks until the requested volume has been
+// processed. Chunk sizes vary so messages and frames straddle chunk
+// boundaries the way they do on a real connection. Every pass checks the
+// event counts against the generated stream.
+//
+// Usage: rtsp_demuxer_bench [gigabytes] [chunk bytes]
+
+#include "RtspDemuxer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Stream {
+    std::string bytes;
+    size_t messages = 0;
+    size_t frames = 0;
+};
+
+void appendFrame(std::string& out, int channel, size_t length, uint32_t& seed)
+{
+    out.push_back('$');
+    out.push_back(static_cast<char>(channel));
+    out.push_back(static_cast<char>((length >> 8) & 0xff));
+    out.push_back(static_cast<char>(length & 0xff));
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        out.push_back(static_cast<char>(seed >> 24));
+    }
+}
+
+Stream buildStream(size_t targetSize)
+{
+    Stream stream;
+    std::string& out = stream.bytes;
+    out.reserve(targetSize + 4096);
+
+    const std::string sdp =
+        "v=0\r\no=- 0 0 IN IP4 127.0.0.1\r\ns=Bench\r\nt=0 0\r\n"
+        "m=video 0 RTP/AVP 96\r\na=rtpmap:96 H264/90000\r\na=control:trackID=0\r\n";
+    out += "RTSP/1.0 200 OK\r\nCSeq: 2\r\nContent-Type: application/sdp\r\nContent-Length: " +
+           std::to_string(sdp.size()) + "\r\n\r\n" + sdp;
+    out += "RTSP/1.0 200 OK\r\nCSeq: 3\r\nTransport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n"
+           "Session: 12345678;timeout=60\r\n\r\n";
+    out += "RTSP/1.0 200 OK\r\nCSeq: 4\r\nSession: 12345678\r\nRange: npt=0.000-\r\n\r\n";
+    stream.messages = 3;
+
+    uint32_t seed = 1;
+    size_t frame = 0;
+    while (out.size() < targetSize) {
+        // Mostly full MTU video packets, some small ones, RTCP every so often
+        seed = seed * 1664525u + 1013904223u;
+        const size_t length = (seed >> 28) < 12 ? 1400 + (seed >> 24) % 60 : 12 + (seed >> 20) % 400;
+        appendFrame(out, frame % 50 == 49 ? 1 : 0, length, seed);
+        ++stream.frames;
+
+        if (++frame % 5000 == 0) {
+            out += "RTSP/1.0 200 OK\r\nCSeq: " + std::to_string(frame) + "\r\nSession: 12345678\r\n\r\n";
+            ++stream.messages;
+        }
+    }
+    return stream;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const double gigabytes = argc > 1 ? std::atof(argv[1]) : 4.0;
+    const size_t chunkSize = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 65536;
+    if (gigabytes <= 0 || chunkSize == 0) {
+        std::fprintf(stderr, "Usage: %s [gigabytes] [chunk bytes]\n", argv[0]);
+        return 2;
+    }
+
+    const Stream stream = buildStream(64 * 1024 * 1024);
+    const uint64_t target = static_cast<uint64_t>(gigabytes * 1024 * 1024 * 1024);
+    const uint64_t passes = (target + stream.bytes.size() - 1) / stream.bytes.size();
+
+    std::vector<RtspDemuxer::Event> events;
+    events.reserve(256);
+
+    uint64_t processed = 0;
+    uint64_t eventCount = 0;
+    const auto started = std::chrono::steady_clock::now();
+
+    for (uint64_t pass = 0; pass < passes; ++pass) {
+        RtspDemuxer demuxer;
+        size_t messages = 0;
+        size_t frames = 0;
+
+        size_t pos = 0;
+        size_t chunk = 0;
+        while (pos < stream.bytes.size()) {
+            // Vary the chunk size by up to an eighth so boundaries keep moving
+            const size_t size = std::min(stream.bytes.size() - pos,
+                                         chunkSize - (chunk++ * 7919) % (chunkSize / 8 + 1));
+            demuxer.feed(stream.bytes.data() + pos, size, events);
+            for (const RtspDemuxer::Event& event : events) {
+                if (event.type == RtspDemuxer::EventType::Interleaved) {
+                    ++frames;
+                } else if (event.type == RtspDemuxer::EventType::Response) {
+                    ++messages;
+                }
+            }
+            eventCount += events.size();
+            pos += size;
+        }
+
+        if (!demuxer.isSynchronized() || messages != stream.messages || frames != stream.frames) {
+            std::fprintf(stderr, "Framing mismatch: %zu/%zu messages, %zu/%zu frames\n",
+                         messages, stream.messages, frames, stream.frames);
+            return 1;
+        }
+        processed += stream.bytes.size();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double processedGb = static_cast<double>(processed) / (1024.0 * 1024.0 * 1024.0);
+
+    std::printf("chunk size      %zu bytes\n", chunkSize);
+    std::printf("processed       %.2f GiB, %llu events\n", processedGb,
+                static_cast<unsigned long long>(eventCount));
+    std::printf("time            %.3f s\n", seconds);
+    std::printf("throughput      %.2f GiB/s\n", processedGb / seconds);
+    std::printf("cost            %.1f ms per GiB, %.1f ns per event\n",
+                seconds * 1000.0 / processedGb, seconds * 1e9 / static_cast<double>(eventCount));
+    return 0;
+}
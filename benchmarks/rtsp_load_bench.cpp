@@ -0,0 +1,652 @@
+// RTSP client load generator for the forwarder's external ports.
+//
+// Opens --sessions RTSP sessions at --rate new connections per second,
+// spread over --ports round robin, and takes each through OPTIONS,
+// DESCRIBE, SETUP (RTP/AVP/TCP interleaved) and PLAY, with Basic or Digest
+// authentication when --user is given. Playing sessions read and frame the
+// interleaved stream with RtspDemuxer and keep their RTSP session alive with
+// GET_PARAMETER. Sessions run on --threads threads; the open file limit is
+// raised to its hard limit first.
+//
+// Once the ramp is done the sessions are held for --hold seconds, then it
+// prints percentile summaries (p50/p90/p99/p999/max) of
+//   connect          TCP connect time
+//   first RTP        connect start to the first RTP frame after PLAY
+//   goodput          RTP payload bit rate of each playing session
+//   longest gap      longest pause in a session's stream
+// plus counts of failures by cause and of stalls, gaps longer than
+// --stall-ms. A progress line every 5 seconds shows when sessions start
+// failing during the ramp.
+//
+// Point it at camera-sim directly for a baseline, then at the forwarder.
+//
+// Usage: rtsp_load_bench --ports 8551-8560 [--host ip] [--path /stream]
+//            [--sessions n] [--rate n/s] [--hold s] [--threads n]
+//            [--stall-ms ms] [--timeout s] [--user name --password secret]
+
+#include "RtspDemuxer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#ifndef Q_OS_WIN
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Options {
+    QString host = "127.0.0.1";
+    QList<quint16> ports;
+    QString path = "/";
+    int sessions = 1000;
+    double rate = 200.0;          // New connections per second
+    double holdSeconds = 30.0;
+    int threads = 4;
+    int stallMs = 500;
+    int timeoutSeconds = 10;      // For connect and handshake
+    QString user;
+    QString password;
+};
+
+const int TICK_MS = 10;
+const int READ_BUFFER_BYTES = 64 * 1024;
+const int DEFAULT_SESSION_TIMEOUT_SECONDS = 60;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// What a session measured, copied out when the run ends
+struct Result {
+    bool connected = false;
+    bool playing = false;
+    QString failure;              // Empty unless the session failed
+    double connectMs = -1.0;
+    double firstRtpMs = -1.0;
+    quint64 rtpBytes = 0;
+    double playingSeconds = 0.0;
+    int stalls = 0;
+    double longestGapMs = 0.0;
+};
+
+bool parsePorts(const QString& text, QList<quint16>* ports)
+{
+    const QStringList parts = text.split(',', Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        const QStringList range = part.split('-');
+        bool firstOk = false;
+        bool lastOk = false;
+        const int first = range.value(0).toInt(&firstOk);
+        const int last = range.size() == 2 ? range.value(1).toInt(&lastOk) : first;
+        if (!firstOk || (range.size() == 2 && !lastOk) || range.size() > 2
+            || first < 1 || last > 65535 || last < first) {
+            return false;
+        }
+        for (int port = first; port <= last; ++port) {
+            ports->append(static_cast<quint16>(port));
+        }
+    }
+    return !ports->isEmpty();
+}
+
+class SessionGroup : public QObject
+{
+public:
+    SessionGroup(const Options& options, int first, int count)
+        : m_options(options)
+        , m_first(first)
+        , m_count(count)
+        , m_readBuffer(READ_BUFFER_BYTES)
+    {
+    }
+
+    std::atomic<int> started{0};
+    std::atomic<int> playing{0};
+    std::atomic<int> failed{0};
+    std::atomic<quint64> rtpBytes{0};
+
+    // Runs on the group thread
+    void start()
+    {
+        m_startNs = nowNs();
+        m_timer = new QTimer(this);
+        m_timer->setInterval(TICK_MS);
+        connect(m_timer, &QTimer::timeout, this, &SessionGroup::tick);
+        m_timer->start();
+    }
+
+    // Runs on the group thread; stops the sessions and returns their results
+    QList<Result> finish()
+    {
+        m_timer->stop();
+        const qint64 now = nowNs();
+        QList<Result> results;
+        results.reserve(m_sessions.size());
+        for (Session* session : m_sessions) {
+            QObject::disconnect(session->socket, nullptr, this, nullptr);
+            if (session->result.playing && session->result.failure.isEmpty()) {
+                session->result.playingSeconds = (now - session->playStartNs) / 1e9;
+                session->result.longestGapMs = qMax(session->result.longestGapMs, (now - session->lastDataNs) / 1e6);
+            } else if (!session->result.playing && session->result.failure.isEmpty()) {
+                session->result.failure = "still in handshake";
+            }
+            results.append(session->result);
+            session->socket->abort();
+            delete session->socket;
+            delete session;
+        }
+        m_sessions.clear();
+        return results;
+    }
+
+private:
+    enum class Step { Connecting, Options, Describe, Setup, Play, Playing, Done };
+
+    struct Session {
+        int index = 0;
+        QTcpSocket* socket = nullptr;
+        Step step = Step::Connecting;
+        QString url;
+        QString controlUrl;       // SETUP target from the SDP
+        QString sessionId;
+        int cseq = 0;
+        QByteArray input;         // Handshake responses not parsed yet
+        RtspDemuxer demuxer;
+        QString authorization;    // Header line sent with every request once known
+        bool retriedAuth = false;
+        QString lastMethod;
+        QString lastUri;
+        QString lastHeaders;
+        qint64 startNs = 0;
+        qint64 playStartNs = 0;
+        qint64 lastDataNs = 0;
+        qint64 keepaliveIntervalNs = 0;
+        qint64 lastKeepaliveNs = 0;
+        bool inStall = false;
+        Result result;
+    };
+
+    void tick()
+    {
+        const qint64 now = nowNs();
+
+        // Ramp: this group's share of the connection rate
+        const double rate = m_options.rate * m_count / m_options.sessions;
+        const int due = qMin(m_count, static_cast<int>((now - m_startNs) / 1e9 * rate) + 1);
+        while (m_sessions.size() < due) {
+            open(m_first + m_sessions.size());
+        }
+
+        const qint64 stallNs = static_cast<qint64>(m_options.stallMs) * 1000000;
+        const qint64 timeoutNs = static_cast<qint64>(m_options.timeoutSeconds) * 1000000000;
+        for (Session* session : m_sessions) {
+            if (session->step == Step::Playing) {
+                if (!session->inStall && now - session->lastDataNs > stallNs) {
+                    session->inStall = true;
+                    ++session->result.stalls;
+                }
+                if (session->keepaliveIntervalNs > 0 && now - session->lastKeepaliveNs > session->keepaliveIntervalNs) {
+                    session->lastKeepaliveNs = now;
+                    send(session, "GET_PARAMETER", session->url, QString());
+                }
+            } else if (session->step != Step::Done && now - session->startNs > timeoutNs) {
+                fail(session, session->step == Step::Connecting ? "connect timeout" : "handshake timeout");
+            }
+        }
+    }
+
+    void open(int index)
+    {
+        Session* session = new Session;
+        session->index = index;
+        const quint16 port = m_options.ports.at(index % m_options.ports.size());
+        session->url = QString("rtsp://%1:%2%3").arg(m_options.host).arg(port).arg(m_options.path);
+        session->socket = new QTcpSocket;
+        session->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        session->startNs = nowNs();
+        m_sessions.append(session);
+        started.fetch_add(1, std::memory_order_relaxed);
+
+        connect(session->socket, &QTcpSocket::connected, this, [this, session]() {
+            session->result.connected = true;
+            session->result.connectMs = (nowNs() - session->startNs) / 1e6;
+            session->step = Step::Options;
+            send(session, "OPTIONS", session->url, QString());
+        });
+        connect(session->socket, &QTcpSocket::readyRead, this, [this, session]() { read(session); });
+        connect(session->socket, &QTcpSocket::errorOccurred, this, [this, session](QAbstractSocket::SocketError error) {
+            if (error == QAbstractSocket::RemoteHostClosedError) {
+                fail(session, session->step == Step::Playing ? "closed while playing" : "closed in handshake");
+            } else if (session->step == Step::Connecting) {
+                fail(session, "connect: " + session->socket->errorString());
+            } else {
+                fail(session, "socket: " + session->socket->errorString());
+            }
+        });
+        session->socket->connectToHost(m_options.host, port);
+    }
+
+    void fail(Session* session, const QString& reason)
+    {
+        if (session->step == Step::Done) {
+            return;
+        }
+        if (session->step == Step::Playing) {
+            const qint64 now = nowNs();
+            session->result.playingSeconds = (now - session->playStartNs) / 1e9;
+            playing.fetch_sub(1, std::memory_order_relaxed);
+        }
+        session->step = Step::Done;
+        session->result.failure = reason;
+        failed.fetch_add(1, std::memory_order_relaxed);
+        // Not deleted here: this may run inside one of the socket's signals
+        session->socket->abort();
+    }
+
+    void send(Session* session, const QString& method, const QString& uri, const QString& headers)
+    {
+        session->lastMethod = method;
+        session->lastUri = uri;
+        session->lastHeaders = headers;
+        QString request = QString("%1 %2 RTSP/1.0\r\nCSeq: %3\r\nUser-Agent: rtsp_load_bench\r\n")
+                              .arg(method, uri).arg(++session->cseq);
+        if (!session->authorization.isEmpty()) {
+            request += authorizationHeader(session, method, uri);
+        }
+        if (!session->sessionId.isEmpty()) {
+            request += QString("Session: %1\r\n").arg(session->sessionId);
+        }
+        request += headers;
+        request += "\r\n";
+        session->socket->write(request.toLatin1());
+    }
+
+    QString authorizationHeader(const Session* session, const QString& method, const QString& uri) const
+    {
+        // "Basic" or "Digest realm nonce"
+        const QStringList scheme = session->authorization.split('\n');
+        if (scheme.first() == "Basic") {
+            const QByteArray credentials = (m_options.user + ':' + m_options.password).toUtf8().toBase64();
+            return QString("Authorization: Basic %1\r\n").arg(QString::fromLatin1(credentials));
+        }
+        const QString realm = scheme.value(1);
+        const QString nonce = scheme.value(2);
+        auto md5 = [](const QString& text) {
+            return QString::fromLatin1(QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Md5).toHex());
+        };
+        const QString response = md5(md5(m_options.user + ':' + realm + ':' + m_options.password) + ':' + nonce
+                                     + ':' + md5(method + ':' + uri));
+        return QString("Authorization: Digest username=\"%1\", realm=\"%2\", nonce=\"%3\", uri=\"%4\", response=\"%5\"\r\n")
+            .arg(m_options.user, realm, nonce, uri, response);
+    }
+
+    void read(Session* session)
+    {
+        for (;;) {
+            const qint64 received = session->socket->read(m_readBuffer.data(), static_cast<qint64>(m_readBuffer.size()));
+            if (received <= 0 || session->step == Step::Done) {
+                return;
+            }
+            if (session->step == Step::Playing) {
+                consume(session, m_readBuffer.data(), static_cast<size_t>(received));
+            } else {
+                session->input.append(m_readBuffer.data(), static_cast<int>(received));
+                parseResponses(session);
+            }
+        }
+    }
+
+    // Handshake responses, up to and including the PLAY response
+    void parseResponses(Session* session)
+    {
+        while (session->step != Step::Playing && session->step != Step::Done) {
+            const int headerEnd = session->input.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                return;
+            }
+            QHash<QString, QString> headers;
+            const QList<QByteArray> lines = session->input.left(headerEnd).split('\n');
+            for (int i = 1; i < lines.size(); ++i) {
+                const QString line = QString::fromLatin1(lines.at(i)).trimmed();
+                const int colon = line.indexOf(':');
+                if (colon > 0) {
+                    headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+                }
+            }
+            const int bodyBytes = headers.value("content-length").toInt();
+            if (session->input.size() < headerEnd + 4 + bodyBytes) {
+                return;
+            }
+            const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+            const int status = statusLine.value(1).toInt();
+            const QByteArray body = session->input.mid(headerEnd + 4, bodyBytes);
+            session->input.remove(0, headerEnd + 4 + bodyBytes);
+            handleResponse(session, status, headers, body);
+        }
+
+        // Stream data that came with the PLAY response
+        if (session->step == Step::Playing && !session->input.isEmpty()) {
+            const QByteArray rest = session->input;
+            session->input.clear();
+            consume(session, rest.constData(), static_cast<size_t>(rest.size()));
+        }
+    }
+
+    void handleResponse(Session* session, int status, const QHash<QString, QString>& headers, const QByteArray& body)
+    {
+        if (status == 401 && !session->retriedAuth && !m_options.user.isEmpty()) {
+            const QString challenge = headers.value("www-authenticate");
+            if (challenge.startsWith("Digest", Qt::CaseInsensitive)) {
+                static const QRegularExpression realmRegex("realm=\"([^\"]*)\"");
+                static const QRegularExpression nonceRegex("nonce=\"([^\"]*)\"");
+                session->authorization = QString("Digest\n%1\n%2")
+                    .arg(realmRegex.match(challenge).captured(1), nonceRegex.match(challenge).captured(1));
+            } else {
+                session->authorization = "Basic";
+            }
+            session->retriedAuth = true;
+            send(session, session->lastMethod, session->lastUri, session->lastHeaders);
+            return;
+        }
+        if (status != 200) {
+            fail(session, QString("RTSP %1 on %2").arg(status).arg(session->lastMethod));
+            return;
+        }
+        session->retriedAuth = false;
+
+        switch (session->step) {
+        case Step::Options:
+            session->step = Step::Describe;
+            send(session, "DESCRIBE", session->url, "Accept: application/sdp\r\n");
+            break;
+        case Step::Describe: {
+            const QString base = headers.value("content-base", session->url);
+            session->controlUrl = trackUrl(base, QString::fromUtf8(body));
+            session->step = Step::Setup;
+            send(session, "SETUP", session->controlUrl, "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n");
+            break;
+        }
+        case Step::Setup: {
+            const QString sessionHeader = headers.value("session");
+            session->sessionId = sessionHeader.section(';', 0, 0).trimmed();
+            static const QRegularExpression timeoutRegex("timeout=(\\d+)");
+            const QRegularExpressionMatch timeout = timeoutRegex.match(sessionHeader);
+            const int seconds = timeout.hasMatch() ? timeout.captured(1).toInt() : DEFAULT_SESSION_TIMEOUT_SECONDS;
+            session->keepaliveIntervalNs = qMax(1, seconds / 2) * 1000000000LL;
+            session->step = Step::Play;
+            send(session, "PLAY", session->url, "Range: npt=0.000-\r\n");
+            break;
+        }
+        case Step::Play: {
+            const qint64 now = nowNs();
+            session->step = Step::Playing;
+            session->result.playing = true;
+            session->playStartNs = now;
+            session->lastDataNs = now;
+            session->lastKeepaliveNs = now;
+            playing.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        case Step::Connecting:
+        case Step::Playing:
+        case Step::Done:
+            break;
+        }
+    }
+
+    // SETUP target: the first media section's control attribute against base
+    static QString trackUrl(const QString& base, const QString& sdp)
+    {
+        QString control;
+        bool inMedia = false;
+        const QStringList lines = sdp.split('\n');
+        for (const QString& rawLine : lines) {
+            const QString line = rawLine.trimmed();
+            if (line.startsWith("m=")) {
+                if (inMedia) {
+                    break;
+                }
+                inMedia = true;
+            } else if (inMedia && line.startsWith("a=control:")) {
+                control = line.mid(10);
+            }
+        }
+        if (control.isEmpty() || control == "*") {
+            return base;
+        }
+        if (control.startsWith("rtsp://", Qt::CaseInsensitive)) {
+            return control;
+        }
+        return base.endsWith('/') ? base + control : base + '/' + control;
+    }
+
+    void consume(Session* session, const char* data, size_t size)
+    {
+        const qint64 now = nowNs();
+        session->result.longestGapMs = qMax(session->result.longestGapMs, (now - session->lastDataNs) / 1e6);
+        session->lastDataNs = now;
+        session->inStall = false;
+
+        session->demuxer.feed(data, size, m_events);
+        for (const RtspDemuxer::Event& event : m_events) {
+            if (event.type != RtspDemuxer::EventType::Interleaved || event.channel % 2 != 0) {
+                continue;
+            }
+            if (session->result.firstRtpMs < 0.0) {
+                session->result.firstRtpMs = (now - session->startNs) / 1e6;
+            }
+            // Counted whole when the frame starts
+            session->result.rtpBytes += event.length;
+            rtpBytes.fetch_add(event.length, std::memory_order_relaxed);
+        }
+    }
+
+    const Options m_options;
+    const int m_first;
+    const int m_count;
+    std::vector<char> m_readBuffer;
+    std::vector<RtspDemuxer::Event> m_events;
+    QList<Session*> m_sessions;
+    QTimer* m_timer = nullptr;
+    qint64 m_startNs = 0;
+};
+
+QString percentiles(std::vector<double> values, const QString& unit)
+{
+    if (values.empty()) {
+        return "no samples";
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double fraction) {
+        return values[qMin(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+    };
+    return QString("p50 %1  p90 %2  p99 %3  p999 %4  max %5 %6  (%7 sessions)")
+        .arg(at(0.50), 0, 'f', 2).arg(at(0.90), 0, 'f', 2).arg(at(0.99), 0, 'f', 2)
+        .arg(at(0.999), 0, 'f', 2).arg(values.back(), 0, 'f', 2).arg(unit).arg(values.size());
+}
+
+void raiseOpenFileLimit()
+{
+#ifndef Q_OS_WIN
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("RTSP client load generator");
+    parser.addHelpOption();
+    const QCommandLineOption hostOption("host", "Address of the forwarder or camera.", "ip", "127.0.0.1");
+    const QCommandLineOption portsOption("ports", "Ports to use round robin, as 8551-8560,8600.", "ports");
+    const QCommandLineOption pathOption("path", "Stream path of the RTSP URL.", "path", "/");
+    const QCommandLineOption sessionsOption("sessions", "Sessions to open.", "n", "1000");
+    const QCommandLineOption rateOption("rate", "New connections per second.", "n", "200");
+    const QCommandLineOption holdOption("hold", "Seconds to keep the sessions playing after the ramp.", "s", "30");
+    const QCommandLineOption threadsOption("threads", "Client threads.", "n", "4");
+    const QCommandLineOption stallOption("stall-ms", "A gap in the stream longer than this is a stall.", "ms", "500");
+    const QCommandLineOption timeoutOption("timeout", "Seconds allowed for connect and handshake.", "s", "10");
+    const QCommandLineOption userOption("user", "User name for Basic or Digest authentication.", "name");
+    const QCommandLineOption passwordOption("password", "Password for --user.", "secret");
+    parser.addOptions({hostOption, portsOption, pathOption, sessionsOption, rateOption, holdOption, threadsOption,
+                       stallOption, timeoutOption, userOption, passwordOption});
+    parser.process(app);
+
+    Options options;
+    options.host = parser.value(hostOption);
+    options.path = parser.value(pathOption);
+    if (!options.path.startsWith('/')) {
+        options.path.prepend('/');
+    }
+    options.sessions = parser.value(sessionsOption).toInt();
+    options.rate = parser.value(rateOption).toDouble();
+    options.holdSeconds = parser.value(holdOption).toDouble();
+    options.threads = parser.value(threadsOption).toInt();
+    options.stallMs = parser.value(stallOption).toInt();
+    options.timeoutSeconds = parser.value(timeoutOption).toInt();
+    options.user = parser.value(userOption);
+    options.password = parser.value(passwordOption);
+    if (!parsePorts(parser.value(portsOption), &options.ports) || QHostAddress(options.host).isNull()
+        || options.sessions < 1 || options.rate <= 0.0 || options.holdSeconds < 0.0 || options.threads < 1
+        || options.stallMs < 1 || options.timeoutSeconds < 1) {
+        err << "Invalid options, see --help" << Qt::endl;
+        return 2;
+    }
+    options.threads = qMin(options.threads, options.sessions);
+
+    raiseOpenFileLimit();
+
+    QList<QThread*> threads;
+    QList<SessionGroup*> groups;
+    int first = 0;
+    for (int i = 0; i < options.threads; ++i) {
+        const int count = options.sessions / options.threads + (i < options.sessions % options.threads ? 1 : 0);
+        QThread* thread = new QThread;
+        SessionGroup* group = new SessionGroup(options, first, count);
+        group->moveToThread(thread);
+        thread->start();
+        threads.append(thread);
+        groups.append(group);
+        QMetaObject::invokeMethod(group, [group]() { group->start(); }, Qt::QueuedConnection);
+        first += count;
+    }
+
+    // Progress every 5 seconds
+    QElapsedTimer elapsed;
+    elapsed.start();
+    quint64 lastBytes = 0;
+    qint64 lastMs = 0;
+    QTimer progress;
+    progress.setInterval(5000);
+    QObject::connect(&progress, &QTimer::timeout, &app, [&]() {
+        int started = 0;
+        int playing = 0;
+        int failed = 0;
+        quint64 bytes = 0;
+        for (SessionGroup* group : groups) {
+            started += group->started.load(std::memory_order_relaxed);
+            playing += group->playing.load(std::memory_order_relaxed);
+            failed += group->failed.load(std::memory_order_relaxed);
+            bytes += group->rtpBytes.load(std::memory_order_relaxed);
+        }
+        const qint64 nowMs = elapsed.elapsed();
+        err << QString("%1 s  started %2  playing %3  failed %4  %5 Mbit/s")
+                   .arg(nowMs / 1000).arg(started).arg(playing).arg(failed)
+                   .arg((bytes - lastBytes) * 8.0 / qMax<qint64>(1, nowMs - lastMs) / 1000.0, 0, 'f', 1)
+            << Qt::endl;
+        lastBytes = bytes;
+        lastMs = nowMs;
+    });
+    progress.start();
+
+    const double rampSeconds = options.sessions / options.rate;
+    QTimer::singleShot(static_cast<int>((rampSeconds + options.holdSeconds) * 1000), &app, &QCoreApplication::quit);
+    app.exec();
+    progress.stop();
+
+    QList<Result> results;
+    for (SessionGroup* group : groups) {
+        QList<Result> groupResults;
+        QMetaObject::invokeMethod(group, [&groupResults, group]() { groupResults = group->finish(); },
+                                  Qt::BlockingQueuedConnection);
+        results.append(groupResults);
+    }
+    for (QThread* thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+    qDeleteAll(groups);
+    qDeleteAll(threads);
+
+    std::vector<double> connectMs;
+    std::vector<double> firstRtpMs;
+    std::vector<double> goodputKbps;
+    std::vector<double> longestGapMs;
+    QHash<QString, int> failures;
+    int playedThrough = 0;
+    int stalls = 0;
+    int stalledSessions = 0;
+    quint64 totalRtpBytes = 0;
+    for (const Result& result : results) {
+        if (result.connectMs >= 0.0) {
+            connectMs.push_back(result.connectMs);
+        }
+        if (result.firstRtpMs >= 0.0) {
+            firstRtpMs.push_back(result.firstRtpMs);
+        }
+        if (result.playing) {
+            if (result.playingSeconds > 0.0) {
+                goodputKbps.push_back(result.rtpBytes * 8.0 / result.playingSeconds / 1000.0);
+            }
+            longestGapMs.push_back(result.longestGapMs);
+            stalls += result.stalls;
+            stalledSessions += result.stalls > 0 ? 1 : 0;
+            totalRtpBytes += result.rtpBytes;
+        }
+        if (result.failure.isEmpty()) {
+            ++playedThrough;
+        } else {
+            failures[result.failure] += 1;
+        }
+    }
+
+    out << QString("sessions      %1 opened, %2 played to the end, %3 failed")
+               .arg(results.size()).arg(playedThrough).arg(results.size() - playedThrough) << Qt::endl;
+    out << "connect       " << percentiles(connectMs, "ms") << Qt::endl;
+    out << "first RTP     " << percentiles(firstRtpMs, "ms") << Qt::endl;
+    out << "goodput       " << percentiles(goodputKbps, "kbit/s") << Qt::endl;
+    out << "longest gap   " << percentiles(longestGapMs, "ms") << Qt::endl;
+    out << QString("stalls        %1 in %2 sessions (gaps over %3 ms)")
+               .arg(stalls).arg(stalledSessions).arg(options.stallMs) << Qt::endl;
+    out << QString("RTP received  %1 MB").arg(totalRtpBytes / 1e6, 0, 'f', 1) << Qt::endl;
+    for (auto it = failures.constBegin(); it != failures.constEnd(); ++it) {
+        out << QString("failed        %1  %2").arg(it.value(), 6).arg(it.key()) << Qt::endl;
+    }
+    return playedThrough == results.size() ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <type_traits>
+#include "Logger.h"
+
+// Binary log sink for debug logging that stays on around the clock.
+//
+// Each LOG_*_FMT call site registers its format string once and gets an id.
+// A record then holds only that id, a timestamp and the raw argument values;
+// the text is put together offline by visco-logcat. A definition of each id
+// is written ahead of its first record in a file, so every file decodes on
+// its own.
+//
+// File layout, little-endian: FILE_MAGIC, then records that each start with
+// a RecordType byte.
+//   Definition  id u32, level u8, category u16 + bytes, format u16 + UTF-8
+//   Entry       id u32, timestamp ms i64, argument count u8, arguments
+// An argument is an ArgumentTag byte followed by an i64, u64 or f64, or by
+// a u16 length and UTF-8 bytes for strings.
+//
+// Records are buffered in memory and written by the Logger writer thread on
+// its flush interval, or from the logging thread every SYNC_FLUSH_BYTES when
+// the logger runs synchronously.
+class BinaryLog
+{
+public:
+    enum RecordType : quint8 {
+        Definition = 1,
+        Entry = 2
+    };
+
+    enum ArgumentTag : quint8 {
+        Int = 1,
+        UInt = 2,
+        Double = 3,
+        String = 4
+    };
+
+    static BinaryLog& instance();
+
+    static bool isEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= s_logLevel.load(std::memory_order_relaxed);
+    }
+
+    // Records at level and above go to filePath until close()
+    bool open(const QString& filePath, LogLevel level = LogLevel::Debug);
+    void close();
+    void flush();
+    void flushAfterCrash();  // Gives up instead of waiting on a held lock
+
+    static int registerFormat(LogLevel level, LogCategory category, const char* format);
+
+    template <typename... Args>
+    void write(int formatId, const Args&... args);
+
+    // Same text the record decodes to, for the text sink
+    template <typename... Args>
+    static QString formatText(const char* format, const Args&... args);
+
+    quint64 recordCount() const { return m_records.load(std::memory_order_relaxed); }
+    quint64 droppedRecords() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static const char FILE_MAGIC[8];
+    static const int SYNC_FLUSH_BYTES = 64 * 1024;
+    static const int MAX_BUFFERED_BYTES = 4 * 1024 * 1024;   // Records beyond it are dropped
+    static const qint64 MAX_FILE_BYTES = 256 * 1024 * 1024;  // Then the file moves to <name>.1
+
+private:
+    struct FormatDefinition {
+        LogLevel level;
+        LogCategory category;
+        const char* format;
+    };
+
+    BinaryLog();
+    ~BinaryLog();
+
+    void appendDefinition(int formatId);
+    void writeBuffered();  // Called with m_fileMutex held
+    void rotateFile();     // Called with m_fileMutex held
+
+    static void appendInt(QByteArray& buffer, quint64 value, int bytes);
+    static void appendArgument(QByteArray& buffer, const QString& value);
+    static void appendArgument(QByteArray& buffer, const QByteArray& value);
+    static void appendArgument(QByteArray& buffer, const char* value);
+    static void appendArgument(QByteArray& buffer, double value);
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type appendArgument(QByteArray& buffer, T value)
+    {
+        buffer.append(static_cast<char>(std::is_signed<T>::value ? Int : UInt));
+        appendInt(buffer, static_cast<quint64>(value), 8);
+    }
+
+    static QString textArgument(const QString& value) { return value; }
+    static QString textArgument(const QByteArray& value) { return QString::fromUtf8(value); }
+    static QString textArgument(const char* value) { return QString::fromUtf8(value); }
+    static double textArgument(double value) { return value; }
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, qlonglong>::type
+    textArgument(T value) { return value; }
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, qulonglong>::type
+    textArgument(T value) { return value; }
+
+    QMutex m_bufferMutex;        // m_buffer, m_defined
+    QMutex m_fileMutex;          // m_file, m_spare; taken before m_bufferMutex
+    QByteArray m_buffer;
+    QByteArray m_spare;          // Swapped with m_buffer to write outside the buffer lock
+    QVector<bool> m_defined;     // Ids with a definition in the current file
+    QFile m_file;
+    qint64 m_fileBytes;
+    bool m_open;
+    std::atomic<quint64> m_records;
+    std::atomic<quint64> m_dropped;
+
+    static QMutex s_formatMutex;
+    static QVector<FormatDefinition> s_formats;
+    static std::atomic<int> s_logLevel;
+};
+
+// Decodes a binary log file record by record
+class BinaryLogReader
+{
+public:
+    struct Line {
+        qint64 timestampMs = 0;
+        LogLevel level = LogLevel::Info;
+        QString category;
+        QString message;
+    };
+
+    explicit BinaryLogReader(QIODevice* device);
+
+    bool readHeader();
+    bool next(Line* line);  // False at the end or at a damaged record
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct Definition {
+        LogLevel level;
+        QString category;
+        QString format;
+    };
+
+    bool readBytes(char* data, qint64 size);
+    bool readUInt(quint64* value, int bytes);
+    bool readString(QString* value);
+
+    QIODevice* m_device;
+    QHash<quint32, Definition> m_definitions;
+    QString m_errorString;
+};
+
+template <typename... Args>
+void BinaryLog::write(int formatId, const Args&... args)
+{
+    static_assert(sizeof...(Args) < 256, "Too many log arguments");
+    const qint64 timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_bufferMutex);
+    if (!m_open || m_buffer.size() >= MAX_BUFFERED_BYTES) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (formatId >= m_defined.size() || !m_defined.at(formatId)) {
+        appendDefinition(formatId);
+    }
+    m_buffer.append(static_cast<char>(Entry));
+    appendInt(m_buffer, static_cast<quint32>(formatId), 4);
+    appendInt(m_buffer, static_cast<quint64>(timestampMs), 8);
+    m_buffer.append(static_cast<char>(sizeof...(Args)));
+    (appendArgument(m_buffer, args), ...);
+    m_records.fetch_add(1, std::memory_order_relaxed);
+
+    const bool flushNow = m_buffer.size() >= SYNC_FLUSH_BYTES && !Logger::instance().isAsync();
+    locker.unlock();
+    if (flushNow) {
+        flush();
+    }
+}
+
+template <typename... Args>
+QString BinaryLog::formatText(const char* format, const Args&... args)
+{
+    QString text = QString::fromUtf8(format);
+    ((text = text.arg(textArgument(args))), ...);
+    return text;
+}
+
+// Like LOG_*, but the format string and its arguments are passed apart so
+// they can go to the binary log without being formatted. Arguments may be
+// integers, doubles, QString, QByteArray or C strings; at least one is needed.
+#define VISCO_LOG_FMT(level, fmt, cat, ...) \
+    do { \
+        if (Logger::isEnabled(level) || BinaryLog::isEnabled(level)) { \
+            static const int viscoLogFormatId = BinaryLog::registerFormat(level, cat, fmt); \
+            if (BinaryLog::isEnabled(level)) { \
+                BinaryLog::instance().write(viscoLogFormatId, __VA_ARGS__); \
+            } \
+            if (Logger::isEnabled(level)) { \
+                Logger::instance().log(level, BinaryLog::formatText(fmt, __VA_ARGS__), cat); \
+            } \
+        } \
+    } while (0)
+
+#ifdef VISCO_STRIP_DEBUG_LOGS
+#define LOG_DEBUG_FMT(fmt, cat, ...) \
+    do { \
+        if (false) { \
+            VISCO_LOG_FMT(LogLevel::Debug, fmt, cat, __VA_ARGS__); \
+        } \
+    } while (0)
+#else
+#define LOG_DEBUG_FMT(fmt, cat, ...) VISCO_LOG_FMT(LogLevel::Debug, fmt, cat, __VA_ARGS__)
+#endif
+#define LOG_INFO_FMT(fmt, cat, ...) VISCO_LOG_FMT(LogLevel::Info, fmt, cat, __VA_ARGS__)
+#define LOG_WARNING_FMT(fmt, cat, ...) VISCO_LOG_FMT(LogLevel::Warning, fmt, cat, __VA_ARGS__)
+#define LOG_ERROR_FMT(fmt, cat, ...) VISCO_LOG_FMT(LogLevel::Error, fmt, cat, __VA_ARGS__)
+
+#endif // BINARYLOG_H
@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QJsonObject>
+#include <QtGlobal>
 
 class CameraConfig
 {
@@ -19,7 +20,9 @@ public:
     int externalPort() const { return m_externalPort; }
     QString id() const { return m_id; }
     QString brand() const { return m_brand; }
-    QString model() const { return m_model; }    // Setters
+    QString model() const { return m_model; }
+    bool isFanOutEnabled() const { return m_fanOutEnabled; }
+    int warmConnections() const { return m_warmConnections; }    // Setters
     void setName(const QString& name) { m_name = name; }
     void setIpAddress(const QString& ipAddress) { m_ipAddress = ipAddress; }
     void setPort(int port) { m_port = port; }
@@ -29,6 +32,10 @@ public:
     void setExternalPort(int externalPort) { m_externalPort = externalPort; }
     void setBrand(const QString& brand) { m_brand = brand; }
     void setModel(const QString& model) { m_model = model; }
+    void setFanOutEnabled(bool enabled) { m_fanOutEnabled = enabled; }
+    void setWarmConnections(int count) { m_warmConnections = qBound(0, count, MAX_WARM_CONNECTIONS); }
+
+    static const int MAX_WARM_CONNECTIONS = 4;
 
     // JSON serialization
     QJsonObject toJson() const;
@@ -48,6 +55,8 @@ private:
     int m_externalPort;
     QString m_brand;
     QString m_model;
+    bool m_fanOutEnabled;   // Share one camera RTSP session between all viewers
+    int m_warmConnections;  // Idle camera connections kept open for new viewers
 };
 
 #endif // CAMERACONFIG_H
@@ -51,6 +51,7 @@ private slots:
 private:
     void loadConfiguration();
     void saveConfiguration();
+    void applyForwarderSettings();
     
     PortForwarder* m_portForwarder;
     QHash<QString, CameraConfig> m_cameras;
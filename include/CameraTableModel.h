@@ -0,0 +1,151 @@
+#ifndef CAMERATABLEMODEL_H
+#define CAMERATABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStyledItemDelegate>
+#include <QHash>
+#include <QVector>
+#include "CameraConfig.h"
+#include "TrafficCounters.h"
+#include "ThroughputHistory.h"
+
+class CameraManager;
+
+// Camera list for the main window's camera table.
+//
+// One row per configured camera, in configuration order. Configuration
+// changes reload the rows; running state and traffic statistics update them
+// in place, and dataChanged is only emitted for rows whose shown values
+// changed, so a statistics tick over thousands of idle cameras costs no
+// repaint at all.
+class CameraTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IndexColumn,
+        NameColumn,
+        BrandColumn,
+        ModelColumn,
+        IpAddressColumn,
+        PortColumn,
+        ExternalPortColumn,
+        StatusColumn,
+        ConnectionsColumn,
+        DataColumn,
+        ThroughputColumn,
+        ActionsColumn,
+        ColumnCount
+    };
+
+    enum Roles {
+        CameraIdRole = Qt::UserRole,
+        RunningRole,
+        EnabledRole
+    };
+
+    enum TestState {
+        NotTested,
+        Testing,
+        Online,
+        Offline
+    };
+
+    explicit CameraTableModel(CameraManager* cameraManager, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    int rowOf(const QString& cameraId) const { return m_rowById.value(cameraId, -1); }
+    QString cameraId(int row) const;
+    CameraConfig camera(int row) const;
+    CameraConfig camera(const QString& cameraId) const { return camera(rowOf(cameraId)); }
+    const ThroughputHistory* throughputHistory(int row) const;  // Null unless running
+
+    void reload();
+    void refreshCamera(const QString& cameraId);  // After it started or stopped
+    void updateStatistics(const QHash<QString, TrafficSnapshot>& snapshots);
+    void setTestState(const QString& cameraId, TestState state);
+
+    static QString formatBytes(quint64 bytes);
+
+    static const int SPARKLINE_SECONDS = 60;
+
+public slots:
+    void updateThroughput();  // After PortForwarder::throughputSampled()
+
+private:
+    struct Row {
+        CameraConfig camera;
+        bool running = false;
+        int connections = 0;
+        quint64 bytes = 0;
+        TestState testState = NotTested;
+    };
+
+    void refreshRow(int row, const QHash<QString, TrafficSnapshot>* snapshots);
+    void emitRowChanged(int row, int firstColumn, int lastColumn);
+
+    CameraManager* m_cameraManager;
+    QVector<Row> m_rows;
+    QHash<QString, int> m_rowById;
+};
+
+// Paints the last SPARKLINE_SECONDS of throughput and the current rate
+class CameraThroughputDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit CameraThroughputDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+};
+
+// Paints the Start/Stop, restart and Test buttons of the Actions column.
+// Nothing is instantiated per row; clicks are hit-tested against the
+// painted button rectangles.
+class CameraActionDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit CameraActionDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    bool helpEvent(QHelpEvent* event, QAbstractItemView* view, const QStyleOptionViewItem& option,
+                   const QModelIndex& index) override;
+
+signals:
+    void startStopClicked(const QString& cameraId);
+    void restartClicked(const QString& cameraId);
+    void testClicked(const QString& cameraId);
+
+protected:
+    bool editorEvent(QEvent* event, QAbstractItemModel* model, const QStyleOptionViewItem& option,
+                     const QModelIndex& index) override;
+
+private:
+    enum Button {
+        StartStopButton,
+        RestartButton,
+        TestButton,
+        ButtonCount
+    };
+
+    static QRect buttonRect(const QRect& cell, int button);
+    static bool isButtonEnabled(const QModelIndex& index, int button);
+
+    static const int BUTTON_WIDTHS[ButtonCount];
+    static const int BUTTON_MARGIN = 2;
+    static const int BUTTON_SPACING = 2;
+
+    QPersistentModelIndex m_pressedIndex;
+    int m_pressedButton;
+};
+
+#endif // CAMERATABLEMODEL_H
@@ -30,12 +30,51 @@ public:
     void setEchoServerEnabled(bool enabled);
     int getEchoServerPort() const { return m_echoServerPort; }
     void setEchoServerPort(int port);
+    QString getEchoServerMode() const { return m_echoServerMode; }
+    void setEchoServerMode(const QString& mode);
+    int getEchoServerMaxConnections() const { return m_echoServerMaxConnections; }
+    void setEchoServerMaxConnections(int maxConnections);
+    bool isUdpEchoServerEnabled() const { return m_udpEchoServerEnabled; }
+    void setUdpEchoServerEnabled(bool enabled);
+    int getUdpEchoServerPort() const { return m_udpEchoServerPort; }
+    void setUdpEchoServerPort(int port);
+    
+    // Relay settings
+    QString getRelayBackend() const { return m_relayBackend; }
+    void setRelayBackend(const QString& backend);
+    bool isRelayPayloadInspectionEnabled() const { return m_relayPayloadInspection; }
+    void setRelayPayloadInspectionEnabled(bool enabled);
+    int getForwardingThreads() const { return m_forwardingThreads; }
+    void setForwardingThreads(int threads);
+    QString getForwardingShardMode() const { return m_forwardingShardMode; }
+    void setForwardingShardMode(const QString& mode);
+    bool isForwardingCpuPinningEnabled() const { return m_forwardingCpuPinning; }
+    void setForwardingCpuPinningEnabled(bool enabled);
+    int getStatsUpdateIntervalMs() const { return m_statsUpdateIntervalMs; }
+    void setStatsUpdateIntervalMs(int intervalMs);
+    bool isUdpRelayEnabled() const { return m_udpRelayEnabled; }
+    void setUdpRelayEnabled(bool enabled);
+    int getUdpRelayPortMin() const { return m_udpRelayPortMin; }
+    int getUdpRelayPortMax() const { return m_udpRelayPortMax; }
+    void setUdpRelayPortRange(int minPort, int maxPort);
+    
+    // Log file settings
+    int getLogMaxFileSizeMb() const { return m_logMaxFileSizeMb; }
+    int getLogRotationHours() const { return m_logRotationHours; }
+    int getLogRetainedFiles() const { return m_logRetainedFiles; }
+    void setLogRotation(int maxFileSizeMb, int rotationHours, int retainedFiles);
+    bool isLogCompressionEnabled() const { return m_logCompressionEnabled; }
+    void setLogCompressionEnabled(bool enabled);
+    bool isBinaryDebugLogEnabled() const { return m_binaryDebugLogEnabled; }
+    void setBinaryDebugLogEnabled(bool enabled);
     
     int getNextExternalPort() const;
     
     // File paths
     QString getConfigFilePath() const;
+    void setConfigFilePath(const QString& filePath);  // Before loadConfig()
     QString getLogFilePath() const;
+    QString getBinaryLogFilePath() const;
 
 signals:
     void configChanged();
@@ -46,12 +85,33 @@ private:
     
     void createDefaultConfig();
     void updateWindowsAutoStart();
+    void applyLogRotation();
+    void applyBinaryDebugLog();
       QList<CameraConfig> m_cameras;
     bool m_autoStartEnabled;
     bool m_echoServerEnabled;
     int m_echoServerPort;
+    QString m_echoServerMode;
+    int m_echoServerMaxConnections;
+    bool m_udpEchoServerEnabled;
+    int m_udpEchoServerPort;
+    QString m_relayBackend;
+    bool m_relayPayloadInspection;
+    int m_forwardingThreads;
+    QString m_forwardingShardMode;
+    bool m_forwardingCpuPinning;
+    int m_statsUpdateIntervalMs;
+    bool m_udpRelayEnabled;
+    int m_udpRelayPortMin;
+    int m_udpRelayPortMax;
+    int m_logMaxFileSizeMb;
+    int m_logRotationHours;
+    int m_logRetainedFiles;
+    bool m_logCompressionEnabled;
+    bool m_binaryDebugLogEnabled;
     QString m_configFilePath;
     QString m_logFilePath;
+    QString m_binaryLogFilePath;
 };
 
 #endif // CONFIGMANAGER_H
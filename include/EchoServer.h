@@ -7,15 +7,43 @@
 #include <QHostAddress>
 #include <QTimer>
 #include <QHash>
+#include "RelayBufferPool.h"
 
+class EpollEchoLoop;
+
+// TCP echo server for checking the path through the tunnel.
+//
+// In the standard mode clients are QTcpSockets on the owner's thread. The
+// scalable mode hands the listening socket to an EpollEchoLoop thread for
+// monitoring fleets that probe with thousands of clients at once; it is
+// Linux only and elsewhere falls back to the standard mode. The statistics
+// read the same in both modes. dataEchoed() is only emitted in the
+// standard mode.
 class EchoServer : public QObject
 {
     Q_OBJECT
 
 public:
+    enum class Mode {
+        Standard,
+        Scalable
+    };
+
     explicit EchoServer(QObject *parent = nullptr);
     ~EchoServer();
 
+    // Take effect at the next startServer()
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+    void setMaxConnections(int maxConnections);
+    int maxConnections() const { return m_maxConnections; }
+
+    static QString modeToString(Mode mode);
+    static Mode modeFromString(const QString& mode);
+
+    static const int DEFAULT_MAX_CONNECTIONS = 50;
+    static const int MAX_CONNECTIONS_LIMIT = 100000;
+
     // Server control
     bool startServer(quint16 port = 7777, const QHostAddress& address = QHostAddress::Any);
     void stopServer();
@@ -46,18 +74,23 @@ private slots:
     void handleSocketError();
 
 private:
+    bool startEpollLoop(quint16 port, const QHostAddress& address);
+    bool usesEpollLoop() const;
     void resetStatistics();
     QString getClientKey(QTcpSocket* socket) const;
     
     QTcpServer* m_server;
     QHash<QTcpSocket*, QString> m_clients; // socket -> client address
+    RelayBufferPool m_bufferPool;          // Read buffers, reused across clients
+    EpollEchoLoop* m_epollLoop;            // Scalable mode, kept for its statistics after stop
+    Mode m_mode;
+    int m_maxConnections;
     
     // Statistics
     quint64 m_totalBytesReceived;
     quint64 m_totalBytesSent;
     quint64 m_totalConnections;
     
-    static const int MAX_CONCURRENT_CONNECTIONS = 50;
     static const int CLIENT_TIMEOUT_MS = 30000; // 30 seconds
 };
 
@@ -0,0 +1,100 @@
+#ifndef EPOLLECHOLOOP_H
+#define EPOLLECHOLOOP_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <atomic>
+#include <vector>
+
+class QThread;
+
+// Echo server loop for thousands of clients, EchoServer's scalable mode.
+//
+// One dedicated thread accepts and echoes every connection through an
+// edge-triggered epoll set, without QTcpSocket objects or Qt events per
+// client. Each client is disconnected CLIENT_TIMEOUT_MS after it connected,
+// as in EchoServer's standard mode; the deadlines live in one timer wheel
+// with a slot per second instead of a timer per client. Clients beyond the
+// connection cap are closed right after accept.
+//
+// The statistics are atomics and can be read from any thread. The client
+// signals are emitted on the loop thread. Linux only: elsewhere
+// isSupported() returns false and start() fails.
+class EpollEchoLoop : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EpollEchoLoop(QObject *parent = nullptr);
+    ~EpollEchoLoop();
+
+    static bool isSupported();
+
+    bool start(const QHostAddress& address, quint16 port, int maxConnections, QString* errorString = nullptr);
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+
+    quint16 serverPort() const { return m_port; }
+    QHostAddress serverAddress() const { return m_address; }
+
+    int connectionCount() const { return m_connectionCount.load(std::memory_order_relaxed); }
+    quint64 totalBytesReceived() const { return m_totalBytesReceived.load(std::memory_order_relaxed); }
+    quint64 totalBytesSent() const { return m_totalBytesSent.load(std::memory_order_relaxed); }
+    quint64 totalConnections() const { return m_totalConnections.load(std::memory_order_relaxed); }
+    quint64 rejectedConnections() const { return m_rejectedConnections.load(std::memory_order_relaxed); }
+
+    static const int CLIENT_TIMEOUT_MS = 30000; // Same as EchoServer
+
+signals:
+    void clientConnected(const QString& clientAddress);
+    void clientDisconnected(const QString& clientAddress);
+
+private:
+    struct Client {
+        int fd = -1;
+        QString address;
+        std::vector<char> pending;     // Echo bytes the socket did not take yet
+        size_t pendingOffset = 0;
+        bool readBlocked = false;      // Stopped reading until pending drains
+        bool peerClosed = false;       // Close once pending is flushed
+        int wheelSlot = -1;
+        Client* wheelPrev = nullptr;
+        Client* wheelNext = nullptr;
+    };
+
+    void run();
+    void acceptClients();
+    bool readClient(Client* client);   // False once the client is closed
+    bool flushClient(Client* client);
+    void closeClient(Client* client);
+    void expireSlot(int slot);
+    void closeDescriptors();
+
+    QThread* m_thread;
+    int m_listenFd;
+    int m_epollFd;
+    int m_wakeFd;                      // eventfd that stops the loop
+    int m_maxConnections;
+    QHostAddress m_address;
+    quint16 m_port;
+
+    // Loop thread only
+    std::vector<Client*> m_wheel;      // Intrusive list heads, one per second
+    int m_wheelPosition;
+    std::vector<char> m_readBuffer;
+    qint64 m_lastRejectLogMs;
+
+    std::atomic<int> m_connectionCount;
+    std::atomic<quint64> m_totalBytesReceived;
+    std::atomic<quint64> m_totalBytesSent;
+    std::atomic<quint64> m_totalConnections;
+    std::atomic<quint64> m_rejectedConnections;
+
+    static const int WHEEL_SLOTS = CLIENT_TIMEOUT_MS / 1000 + 2;
+    static const int READ_BUFFER_SIZE = 64 * 1024;
+    static const int MAX_PENDING_BYTES = 1024 * 1024; // Per client, then reading pauses
+    static const int MAX_EVENTS = 256;
+    static const int LISTEN_BACKLOG = 4096;
+};
+
+#endif // EPOLLECHOLOOP_H
@@ -0,0 +1,54 @@
+#ifndef FORWARDINGENGINE_H
+#define FORWARDINGENGINE_H
+
+#include <QObject>
+#include <QList>
+#include <QThread>
+
+class ForwardingWorker;
+
+// Pool of ForwardingWorker event loops that relay camera connections.
+//
+// With a thread count of 0 a single worker runs on the engine's own thread,
+// which is how forwarding behaved before the engine existed. Otherwise every
+// worker gets a dedicated QThread and connections are spread across them
+// either per camera (all viewers of a camera share a thread) or per
+// connection (round robin).
+class ForwardingEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class ShardMode {
+        ByCamera,
+        ByConnection
+    };
+
+    explicit ForwardingEngine(QObject *parent = nullptr);
+    ~ForwardingEngine();
+
+    void start(int threadCount, ShardMode mode, bool pinThreads);
+    void shutdown();
+    bool isRunning() const { return !m_workers.isEmpty(); }
+
+    int threadCount() const { return m_threads.size(); }
+    ShardMode shardMode() const { return m_shardMode; }
+    const QList<ForwardingWorker*>& workers() const { return m_workers; }
+
+    ForwardingWorker* workerFor(const QString& cameraId);
+    ForwardingWorker* workerForCamera(const QString& cameraId) const; // Ignores the shard mode
+
+    static int defaultThreadCount();
+    static QString shardModeToString(ShardMode mode);
+    static ShardMode shardModeFromString(const QString& mode);
+
+private:
+    QList<QThread*> m_threads;
+    QList<ForwardingWorker*> m_workers;
+    ShardMode m_shardMode;
+    int m_nextWorker;
+
+    static const int MAX_DEFAULT_THREADS = 4;
+};
+
+#endif // FORWARDINGENGINE_H
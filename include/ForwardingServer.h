@@ -0,0 +1,37 @@
+#ifndef FORWARDINGSERVER_H
+#define FORWARDINGSERVER_H
+
+#include <QTcpServer>
+
+// Listening socket for one camera's external port.
+//
+// Accepted connections are not wrapped in a QTcpSocket here. The raw
+// descriptor is handed out instead so PortForwarder can adopt it on whichever
+// ForwardingEngine thread will relay the connection.
+class ForwardingServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit ForwardingServer(const QString& cameraId, QObject *parent = nullptr)
+        : QTcpServer(parent)
+        , m_cameraId(cameraId)
+    {
+    }
+
+    QString cameraId() const { return m_cameraId; }
+
+signals:
+    void connectionPending(qintptr socketDescriptor);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        emit connectionPending(socketDescriptor);
+    }
+
+private:
+    QString m_cameraId;
+};
+
+#endif // FORWARDINGSERVER_H
@@ -0,0 +1,213 @@
+#ifndef FORWARDINGWORKER_H
+#define FORWARDINGWORKER_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <vector>
+#include "CameraConfig.h"
+#include "RtspDemuxer.h"
+#include "RelayBufferPool.h"
+#include "TrafficCounters.h"
+
+class QTimer;
+class SpliceRelay;
+class RtspFanOut;
+class UdpRelay;
+class UdpPortPool;
+
+// Relays the client <-> camera connections handed to it by PortForwarder.
+//
+// Each worker lives on one ForwardingEngine thread and owns every socket it
+// creates, so all socket I/O for a connection happens on that thread's event
+// loop. Results are reported back through signals, which reach PortForwarder
+// as queued connections. Traffic is the exception: it is added to the
+// session's TrafficCounters, which PortForwarder reads on its own schedule.
+// Sessions are identified by camera ID plus the session ID PortForwarder
+// assigned when forwarding was started, so late events from a stopped
+// session are never mistaken for a restarted one.
+class ForwardingWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Direction {
+        ClientToTarget,
+        TargetToClient
+    };
+    Q_ENUM(Direction)
+
+    explicit ForwardingWorker(QObject *parent = nullptr);
+    ~ForwardingWorker();
+
+    static QString directionName(Direction direction);
+
+public slots:
+    void acceptConnection(const CameraConfig& camera, quint64 sessionId,
+                          const QSharedPointer<TrafficCounters>& traffic, qintptr socketDescriptor);
+    void prewarmSession(const CameraConfig& camera, quint64 sessionId,
+                        const QSharedPointer<TrafficCounters>& traffic);
+    void closeSession(const QString& cameraId, quint64 sessionId);
+    void closeAll();
+    void pruneInactiveConnections(const QString& cameraId, quint64 sessionId);
+    void reportQueueDepths(const QString& cameraId, quint64 sessionId);
+    void reportBufferPoolStats();
+    void setRelayOptions(bool useSplice, bool payloadInspection);
+    void setUdpRelayPorts(const QSharedPointer<UdpPortPool>& ports);
+    void pinToCpu(int cpu);
+
+signals:
+    void connectionEstablished(const QString& cameraId, quint64 sessionId, const QString& clientAddress);
+    void connectionClosed(const QString& cameraId, quint64 sessionId, const QString& clientAddress);
+    void targetConnected(const QString& cameraId, quint64 sessionId);
+    void targetDisconnected(const QString& cameraId, quint64 sessionId);
+    void connectionError(const QString& cameraId, quint64 sessionId, const QString& error);
+    void connectionBackpressure(const QString& cameraId, quint64 sessionId, const QString& clientAddress,
+                                bool paused, qint64 queuedBytes);
+    void queueDepthsReported(const QString& cameraId, quint64 sessionId, const QHash<QString, qint64>& depths);
+    void udpStreamOpened(const QString& cameraId, quint64 sessionId, const QString& stream,
+                         const QSharedPointer<TrafficCounters>& traffic);
+    void udpStreamClosed(const QString& cameraId, quint64 sessionId, const QString& stream);
+
+private slots:
+    void handleClientDisconnected();
+    void handleClientDataReady();
+    void handleTargetConnected();
+    void handleTargetDisconnected();
+    void handleTargetDataReady();
+    void handleConnectionError(QAbstractSocket::SocketError error);
+    void handleSpliceBytesRelayed(qint64 bytes, bool clientToTarget);
+    void handleSpliceFinished();
+    void handleBytesWritten();
+    void handleFanOutViewerClosed(const QString& clientAddress);
+    void handleFanOutBytesRelayed(qint64 bytes, bool clientToTarget);
+    void handleFanOutUpstreamConnected();
+    void handleFanOutUpstreamDisconnected();
+    void handleFanOutUpstreamError(const QString& error);
+    void handleWarmConnected();
+    void handleWarmDisconnected();
+    void handleWarmError(QAbstractSocket::SocketError error);
+    void handleUdpBytesRelayed(qint64 bytes, int packets, bool clientToTarget);
+
+private:
+    struct WorkerSession;
+    struct ConnectionInfo;
+
+    // Outcome of relaying one chunk. Closed means the connection was cleaned
+    // up while relaying (a failed splice hand-off, or a write error that
+    // aborted a socket), so its ConnectionInfo and SocketContexts are gone.
+    enum class RelayResult {
+        Relayed,
+        Failed,
+        Closed
+    };
+
+    // One per socket of a connection, reached from the signalling socket with
+    // a single pointer lookup
+    struct SocketContext {
+        QTcpSocket* socket;            // Socket this context belongs to
+        QTcpSocket* peer;              // Socket the data read here is written to
+        ConnectionInfo* connection;
+        Direction direction;           // Direction of the data read from socket
+        bool readPaused;               // Peer send queue above the high watermark
+        qint64 lastFlushWarningMs;     // Log throttling for flush() failures
+        RtspDemuxer demuxer;           // Frames the data read here for logging and splice hand-off
+    };
+
+    struct ConnectionInfo {
+        WorkerSession* session;
+        QTcpSocket* clientSocket;
+        QTcpSocket* targetSocket;
+        SocketContext clientContext;
+        SocketContext targetContext;
+        QString clientAddress;
+        TrafficCounters traffic;
+        QDateTime connectedTime;
+        qint64 connectStartedMs;       // TrafficCounters::nowMs() when the camera connect began
+        bool isTargetConnected;
+        QByteArray pendingClientData;  // Data received before target connection, at most PENDING_CLIENT_DATA_LIMIT
+        SpliceRelay* spliceRelay;      // Zero-copy relay after hand-off, sockets are detached then
+        bool rtspPlaySent;             // PLAY forwarded, hand off once the camera answers
+        bool spliceHandoffPending;     // Waiting for QTcpSocket write buffers to drain
+        bool spliceDisabled;           // Hand-off failed, stay on the user space relay
+        bool rewriteTransport;         // UDP relay on, SETUP transports are rewritten
+        QHash<QByteArray, UdpRelay*> pendingUdpSetups; // CSeq -> relay waiting for the camera's reply
+        QList<UdpRelay*> udpRelays;    // Media streams running over UDP
+    };
+
+    struct WorkerSession {
+        CameraConfig camera;
+        QString cameraId;
+        quint64 sessionId;
+        qint64 lastDataLogMs;          // Log throttling for forwarded data
+        QHash<QTcpSocket*, ConnectionInfo*> connections; // client -> connection info
+        RtspFanOut* fanOut;            // Shared camera stream, fan-out cameras only
+        QSharedPointer<TrafficCounters> traffic; // Shared with PortForwarder and other workers
+        QList<QTcpSocket*> warmSockets; // Idle camera connections waiting for a viewer
+        bool warmPoolActive;           // Refill the pool as connections are handed out
+        QTimer* warmLingerTimer;       // Drains the pool once the last viewer has been gone a while
+    };
+
+    // An idle camera connection kept ready for the next viewer
+    struct WarmConnection {
+        WorkerSession* session;
+        qint64 connectStartedMs;
+        bool connected;
+    };
+
+    WorkerSession* sessionFor(const CameraConfig& camera, quint64 sessionId,
+                              const QSharedPointer<TrafficCounters>& traffic);
+    void removeSession(const QString& cameraId);
+    void cleanupConnection(ConnectionInfo* info);
+    bool forwardData(SocketContext* source);   // False once the connection is closed
+    RelayResult relayChunk(SocketContext* source, const char* data, qint64 dataSize);
+    bool isConnectionOpen(QTcpSocket* socket) const { return m_socketContexts.contains(socket); }
+    void optimizeSocketForStreaming(QTcpSocket* socket);
+    void logConnectionDetails(const ConnectionInfo* info, const QString& event);
+    int inspectData(SocketContext* source, const char* data, qint64 size);
+    void recordTraffic(ConnectionInfo* info, Direction direction, qint64 bytes, int packets);
+    void trackSpliceHandoff(SocketContext* source);
+    bool trySpliceHandoff(ConnectionInfo* info);
+    bool rewriteRtspTransport(SocketContext* source, const char* data, qint64 size, size_t heldBefore, QByteArray* out);
+    QByteArray rewriteSetupRequest(ConnectionInfo* info, const RtspDemuxer::Event& event);
+    QByteArray rewriteSetupResponse(ConnectionInfo* info, const RtspDemuxer::Event& event);
+    void closeUdpRelay(UdpRelay* relay, bool announced);
+    static QString udpStreamName(const ConnectionInfo* info, const UdpRelay* relay);
+    void acceptFanOutViewer(WorkerSession* session, QTcpSocket* clientSocket, const QString& clientAddress);
+    WorkerSession* fanOutSession(QObject* fanOut) const;
+    QTcpSocket* takeWarmConnection(WorkerSession* session);
+    void refillWarmPool(WorkerSession* session);
+    void openWarmConnection(WorkerSession* session);
+    void dropWarmConnection(QTcpSocket* socket);
+    void drainWarmPool(WorkerSession* session);
+    void startWarmPoolLinger(WorkerSession* session);
+
+    QHash<QString, WorkerSession*> m_sessions;
+    QHash<QTcpSocket*, SocketContext*> m_socketContexts;
+    QHash<SpliceRelay*, ConnectionInfo*> m_spliceRelays;
+    QHash<QTcpSocket*, WarmConnection> m_warmConnections;
+    QHash<UdpRelay*, ConnectionInfo*> m_udpRelays;
+    QSharedPointer<UdpPortPool> m_udpPorts;    // Null while the UDP relay is off
+    bool m_useSplice;
+    bool m_payloadInspection;
+    std::vector<RtspDemuxer::Event> m_demuxEvents; // Events of the chunk inspected last, reused
+    RelayBufferPool m_bufferPool;  // Read buffers for forwardData()
+    qint64 m_lastPoolReportMs;
+
+    static const int TARGET_CONNECT_TIMEOUT_MS = 30000;
+    static const int INACTIVE_CONNECTION_TIMEOUT_S = 300;
+    static const int PENDING_CLIENT_DATA_LIMIT = 32768;
+    static const int BUFFER_POOL_REPORT_INTERVAL_MS = 30000;
+    static const int WARM_POOL_LINGER_MS = 60000;
+    static const int WARM_POOL_RETRY_MS = 5000;
+
+    // Per-socket send queue limits. Reading from the source stops above the
+    // high watermark and resumes once the queue drains below the low one.
+    static const qint64 WRITE_HIGH_WATERMARK = 1024 * 1024;
+    static const qint64 WRITE_LOW_WATERMARK = 256 * 1024;
+};
+
+#endif // FORWARDINGWORKER_H
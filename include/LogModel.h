@@ -0,0 +1,90 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <QHash>
+#include <QTimer>
+#include <QVector>
+#include "Logger.h"
+
+// Last MAX_LINES log lines for the log view.
+//
+// Lines are kept in a ring and handed to the view in batches: append() only
+// queues the line, and a timer adds everything queued about 60 times a
+// second with one insert (and, once full, one remove) notification, so a
+// log storm costs the GUI thread a handful of layouts per second instead of
+// one per line. Level and category are parsed from the "[time] [LEVEL]
+// [category] message" format once, when the line is added.
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        LevelRole = Qt::UserRole,
+        CategoryRole
+    };
+
+    explicit LogModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    QStringList categories() const { return m_categories; }
+
+    static const int MAX_LINES = 5000;
+    static const int BATCH_INTERVAL_MS = 16;
+
+public slots:
+    void append(const QString& line);
+    void clear();
+
+signals:
+    void categoryAdded(const QString& category);
+
+private slots:
+    void addPending();
+
+private:
+    struct Line {
+        QString text;
+        LogLevel level = LogLevel::Info;
+        int category = -1;  // Index into m_categories, -1 when the line has none
+    };
+
+    Line parse(const QString& text);
+    const Line& lineAt(int row) const { return m_lines[(m_first + row) % MAX_LINES]; }
+
+    QVector<Line> m_lines;      // Ring of MAX_LINES slots
+    int m_first;
+    int m_count;
+    QStringList m_pending;
+    QTimer m_batchTimer;
+    QStringList m_categories;
+    QHash<QString, int> m_categoryIndex;
+};
+
+// Shows the lines of a LogModel at or above a level, optionally of one
+// category only. Filtering works on the parsed roles, the text is never
+// searched.
+class LogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogFilterModel(QObject *parent = nullptr);
+
+    void setMinimumLevel(LogLevel level);
+    void setCategory(const QString& category);  // Empty shows all
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private:
+    LogLevel m_minimumLevel;
+    QString m_category;
+};
+
+#endif // LOGMODEL_H
@@ -0,0 +1,53 @@
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Logger.h"
+
+// One queued log line. The message is the QString the caller already built,
+// so queuing it only bumps a reference count.
+struct LogRecord {
+    qint64 timestampMs = 0;
+    LogLevel level = LogLevel::Info;
+    LogCategory category;
+    QString message;
+};
+
+// Bounded multi-producer queue of log records.
+//
+// Every slot carries a sequence number that says whether it is free for the
+// producer at a given position or holds a record for the consumer there, so
+// pushing and popping each take one compare-and-swap on a shared position
+// and never a lock. Pops are safe from several threads too, which lets the
+// crash handler drain the queue while the writer thread is stuck.
+class LogRing
+{
+public:
+    explicit LogRing(size_t capacity);  // Rounded up to a power of two
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Moves the record in and returns true, or leaves it alone when full
+    bool tryPush(LogRecord& record);
+    bool tryPop(LogRecord* record);
+
+    size_t capacity() const { return m_mask + 1; }
+    size_t depth() const;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_pushPosition;
+    alignas(64) std::atomic<size_t> m_popPosition;
+};
+
+#endif // LOGRING_H
@@ -6,6 +6,12 @@
 #include <QMutex>
 #include <QTextStream>
 #include <QFile>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QHash>
+#include <atomic>
+#include <cstddef>
+#include <memory>
 
 enum class LogLevel {
     Debug,
@@ -14,6 +20,33 @@ enum class LogLevel {
     Error
 };
 
+// Log category, a view of the string literal it was built from. Passing one
+// costs a pointer and a length; no QString is made unless the line is logged.
+class LogCategory
+{
+public:
+    constexpr LogCategory() : m_name(""), m_size(0) {}
+    template <std::size_t N>
+    constexpr LogCategory(const char (&name)[N]) : m_name(name), m_size(N - 1) {}
+
+    constexpr const char* name() const { return m_name; }
+    constexpr std::size_t size() const { return m_size; }
+
+private:
+    const char* m_name;
+    std::size_t m_size;
+};
+
+// What a log call does when the async queue is full
+enum class LogOverflowPolicy {
+    Drop,   // Discard the line and count it
+    Block   // Wait for the writer thread to make room
+};
+
+class LogRing;
+struct LogRecord;
+class QThread;
+
 class Logger : public QObject
 {
     Q_OBJECT
@@ -24,12 +57,55 @@ public:
     void setLogFile(const QString& filePath);
     void setLogLevel(LogLevel level);
     
-    void log(LogLevel level, const QString& message, const QString& category = "General");
+    // Starts a new file once the current one reaches maxFileBytes or is
+    // older than maxFileAgeMs (0 turns that check off). The old file is
+    // renamed with a timestamp, gzip-compressed on a pool thread, and the
+    // oldest rotated files beyond retainedFiles are deleted.
+    void setRotation(qint64 maxFileBytes, qint64 maxFileAgeMs, int retainedFiles, bool compress = true);
+    
+    // Collapsing of repeated lines and the per category rate limit, on by default
+    void setStormSuppression(bool enabled);
+    
+    // Queues log lines for a background thread that formats them and writes
+    // them out in batches, flushing the file every flushIntervalMs. Warnings
+    // and errors wake the writer at once. The queue is sized on the first
+    // call. Until startAsync() and after stopAsync() every line is written
+    // before log() returns.
+    void startAsync(int queueCapacity = DEFAULT_QUEUE_CAPACITY,
+                    int flushIntervalMs = DEFAULT_FLUSH_INTERVAL_MS,
+                    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Drop);
+    void stopAsync();  // Writes out everything queued first
+    bool isAsync() const { return m_asyncRunning.load(std::memory_order_relaxed); }
     
-    void debug(const QString& message, const QString& category = "General");
-    void info(const QString& message, const QString& category = "General");
-    void warning(const QString& message, const QString& category = "General");
-    void error(const QString& message, const QString& category = "General");
+    // Lines discarded because the queue was full, and lines waiting in it
+    quint64 droppedMessageCount() const { return m_droppedMessages.load(std::memory_order_relaxed); }
+    int queueDepth() const;
+    int queueCapacity() const;
+    
+    // Writes out queued lines from the calling thread without waiting for
+    // the writer. For crash handlers, which cannot rely on other threads.
+    void flushAfterCrash();
+    
+    static QString logLevelToString(LogLevel level);
+    
+    // Lock-free, the LOG_* macros call it before building their message
+    static bool isEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= s_logLevel.load(std::memory_order_relaxed);
+    }
+    
+    void log(LogLevel level, const QString& message, LogCategory category = "General");
+    
+    void debug(const QString& message, LogCategory category = "General");
+    void info(const QString& message, LogCategory category = "General");
+    void warning(const QString& message, LogCategory category = "General");
+    void error(const QString& message, LogCategory category = "General");
+
+    static const int DEFAULT_QUEUE_CAPACITY = 8192;
+    static const int DEFAULT_FLUSH_INTERVAL_MS = 250;
+    static const qint64 DEFAULT_MAX_FILE_BYTES = 10 * 1024 * 1024;
+    static const qint64 DEFAULT_MAX_FILE_AGE_MS = 24 * 60 * 60 * 1000;
+    static const int DEFAULT_RETAINED_FILES = 10;
 
 signals:
     void logMessage(const QString& message);
@@ -38,20 +114,100 @@ private:
     Logger();
     ~Logger();
     
-    QString formatMessage(LogLevel level, const QString& message, const QString& category) const;
-    QString logLevelToString(LogLevel level) const;
+    bool enqueue(LogRecord& record);
+    void runWriter();
+    void wakeWriter();
+    int writeQueued();        // Called with m_mutex held
+    void writeLine(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category);
+    bool admitLine(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category);
+    int writeSuppressionSummaries(qint64 nowMs, bool all);
+    static quint64 templateKey(const QString& message, LogCategory category);
+    void openLogFile();       // Called with m_mutex held
+    void rotateLogFile();     // Called with m_mutex held
+    void queueRotatedFileCleanup();
+    static void cleanUpRotatedFiles(const QString& logFilePath, int retainedFiles, bool compress);
+    static bool gzipFile(const QString& sourcePath, const QString& targetPath);
+    static void installCrashHandlers();
     
-    QMutex m_mutex;
+    QString formatMessage(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category);
+    
+    QMutex m_mutex;           // File, stream and timestamp cache
     QFile m_logFile;
     QTextStream m_logStream;
-    LogLevel m_logLevel;
     bool m_logToFile;
+    qint64 m_cachedSecond;
+    QString m_cachedSecondText;
+    
+    qint64 m_fileBytes;       // Written to the current file, counted in characters
+    qint64 m_fileOpenedMs;
+    qint64 m_maxFileBytes;
+    qint64 m_maxFileAgeMs;
+    int m_retainedFiles;
+    bool m_compressRotated;
+    QThreadPool m_rotationPool;  // One thread, so cleanups run in order
+    
+    // Log storm suppression, touched only with m_mutex held
+    struct RepeatedLine {
+        qint64 windowStartMs = 0;
+        int repeats = 0;          // Suppressed since the line was written
+        LogLevel level = LogLevel::Info;
+        LogCategory category;
+        QString lastMessage;
+    };
+    struct CategoryBudget {
+        double tokens = 0;
+        qint64 refilledMs = 0;
+        int suppressed = 0;
+    };
+    QHash<quint64, RepeatedLine> m_repeatedLines;
+    QHash<QByteArray, CategoryBudget> m_categoryBudgets;
+    qint64 m_lastSummaryMs;
+    bool m_stormSuppression;
+    
+    std::unique_ptr<LogRing> m_ring;
+    QThread* m_writerThread;
+    QMutex m_wakeMutex;
+    QWaitCondition m_writerWake;
+    bool m_wakeRequested;     // Guarded by m_wakeMutex, a wake the writer has not seen yet
+    std::atomic<bool> m_asyncRunning;
+    std::atomic<quint64> m_droppedMessages;
+    quint64 m_reportedDrops;
+    int m_flushIntervalMs;
+    LogOverflowPolicy m_overflowPolicy;
+    
+    static std::atomic<int> s_logLevel;
+    static const int CRASH_FLUSH_LOCK_TIMEOUT_MS = 500;
+    static const int GZIP_CHUNK_SIZE = 1024 * 1024;  // Each chunk is one gzip member
+    static const int REPEAT_WINDOW_MS = 10000;        // Repeats within it collapse into one line
+    static const int MAX_TRACKED_TEMPLATES = 1024;
+    static const int CATEGORY_LINES_PER_SECOND = 50;
+    static const int CATEGORY_BURST_LINES = 200;
+    static const int SUMMARY_INTERVAL_MS = 1000;
 };
 
-// Convenience macros
-#define LOG_DEBUG(msg, cat) Logger::instance().debug(msg, cat)
-#define LOG_INFO(msg, cat) Logger::instance().info(msg, cat)
-#define LOG_WARNING(msg, cat) Logger::instance().warning(msg, cat)
-#define LOG_ERROR(msg, cat) Logger::instance().error(msg, cat)
+// Convenience macros. The message argument is only evaluated when its level
+// is enabled, so a filtered LOG_DEBUG costs one relaxed load and a branch.
+// Building with VISCO_STRIP_DEBUG_LOGS removes LOG_DEBUG lines entirely; the
+// dead branch keeps their arguments compiling.
+#define VISCO_LOG(level, msg, cat) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            Logger::instance().log(level, msg, cat); \
+        } \
+    } while (0)
+
+#ifdef VISCO_STRIP_DEBUG_LOGS
+#define LOG_DEBUG(msg, cat) \
+    do { \
+        if (false) { \
+            Logger::instance().log(LogLevel::Debug, msg, cat); \
+        } \
+    } while (0)
+#else
+#define LOG_DEBUG(msg, cat) VISCO_LOG(LogLevel::Debug, msg, cat)
+#endif
+#define LOG_INFO(msg, cat) VISCO_LOG(LogLevel::Info, msg, cat)
+#define LOG_WARNING(msg, cat) VISCO_LOG(LogLevel::Warning, msg, cat)
+#define LOG_ERROR(msg, cat) VISCO_LOG(LogLevel::Error, msg, cat)
 
 #endif // LOGGER_H
@@ -2,13 +2,14 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTableWidget>
+#include <QTableView>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLabel>
 #include <QCheckBox>
-#include <QTextEdit>
+#include <QListView>
+#include <QComboBox>
 #include <QSplitter>
 #include <QGroupBox>
 #include <QStatusBar>
@@ -19,6 +20,8 @@
 #include "CameraManager.h"
 #include "SystemTrayManager.h"
 #include "VpnWidget.h"
+#include "LogModel.h"
+#include "CameraTableModel.h"
 
 QT_BEGIN_NAMESPACE
 class QAction;
@@ -27,6 +30,7 @@ QT_END_NAMESPACE
 
 class NetworkInterfaceManager;
 class EchoServer;
+class UdpEchoServer;
 class PingResponder;
 class UserProfileWidget;
 
@@ -65,7 +69,7 @@ private slots:
     void onConfigurationChanged();
     void onLogMessage(const QString& message);
     void onPingFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    void refreshConnectionStatistics();
+    void refreshConnectionStatistics(const QHash<QString, TrafficSnapshot>& snapshots);
     
     // Network interface manager slots
     void onNetworkInterfacesChanged();
@@ -86,7 +90,9 @@ private:
     void createStatusBar();
     void createCentralWidget();
     void setupConnections();
-    void updateCameraTable();    void updateButtons();    void loadSettings();
+    QString selectedCameraId() const;
+    void showThroughputHistory(const QString& cameraId);
+    void updateButtons();    void loadSettings();
     void saveSettings();
     void updateNetworkStatus();
     void restartEchoServer();
@@ -96,7 +102,8 @@ private:
     QWidget* m_centralWidget;
       // Camera management
     QGroupBox* m_cameraGroupBox;
-    QTableWidget* m_cameraTable;
+    QTableView* m_cameraTable;
+    CameraTableModel* m_cameraModel;
     QPushButton* m_addButton;
     QPushButton* m_discoverButton;
     QPushButton* m_editButton;
@@ -112,8 +119,13 @@ private:
     QLabel* m_serviceStatusLabel;
       // Log viewer
     QGroupBox* m_logGroupBox;
-    QTextEdit* m_logTextEdit;
+    LogModel* m_logModel;
+    LogFilterModel* m_logFilterModel;
+    QListView* m_logView;
+    QComboBox* m_logLevelFilter;
+    QComboBox* m_logCategoryFilter;
     QPushButton* m_clearLogButton;
+    bool m_logFollowTail;  // View was at the bottom when the last batch came in
       // VPN Widget
     VpnWidget* m_vpnWidget;
     
@@ -132,6 +144,7 @@ private:
     SystemTrayManager* m_trayManager;
     NetworkInterfaceManager* m_networkManager;
     EchoServer* m_echoServer;
+    UdpEchoServer* m_udpEchoServer;
     PingResponder* m_pingResponder;
     
     // State
@@ -139,7 +152,6 @@ private:
     bool m_forceQuit;
     QProcess* m_pingProcess;
     QString m_currentTestingCameraId;
-    QTimer* m_statisticsRefreshTimer;
 };
 
 #endif // MAINWINDOW_H
@@ -8,15 +8,29 @@
 #include <QTimer>
 #include <QHash>
 #include <QHostAddress>
+#include <QSharedPointer>
 #include "CameraConfig.h"
+#include "TrafficCounters.h"
+#include "ThroughputHistory.h"
+#include "ForwardingEngine.h"
+#include "ForwardingWorker.h"
+
+class UdpPortPool;
 
 class NetworkInterfaceManager;
+class ForwardingServer;
 
 class PortForwarder : public QObject
 {
     Q_OBJECT
 
 public:
+    // How bytes are moved between a client and its camera connection
+    enum class RelayBackend {
+        UserSpace,  // QTcpSocket read/write (all platforms)
+        Splice      // Kernel splice() after the RTSP handshake (Linux only)
+    };
+
     explicit PortForwarder(QObject *parent = nullptr);    ~PortForwarder();
       bool startForwarding(const CameraConfig& camera);
     void stopForwarding(const QString& cameraId);
@@ -35,72 +49,115 @@ public:
     qint64 getBytesTransferred(const QString& cameraId) const;
     QString getConnectionStatus(const QString& cameraId) const;
     QString getBindingInfo(const QString& cameraId) const;
+    // Bytes queued towards each viewer (client address -> bytes), refreshed by
+    // the health check and whenever a viewer is paused or resumed
+    QHash<QString, qint64> getConnectionQueueDepths(const QString& cameraId) const;
+    // Traffic counters, read without waiting on the forwarding threads
+    TrafficSnapshot getTrafficSnapshot(const QString& cameraId) const;
+    QHash<QString, TrafficSnapshot> getTrafficSnapshots() const;
+    // Per-second throughput of the running session, null when not forwarding.
+    // Valid until the session stops or throughputSampled() is next emitted.
+    const ThroughputHistory* getThroughputHistory(const QString& cameraId) const;
+    // How often statsUpdated() is emitted
+    void setStatsUpdateInterval(int intervalMs);
+    int statsUpdateInterval() const;
 
     // Network interface management
     void setNetworkInterfaceManager(NetworkInterfaceManager* manager);
     NetworkInterfaceManager* networkInterfaceManager() const;
 
+    // Relay backend selection
+    void setRelayBackend(RelayBackend backend);
+    RelayBackend relayBackend() const { return m_relayBackend; }
+    void setPayloadInspectionEnabled(bool enabled);
+    bool isPayloadInspectionEnabled() const { return m_payloadInspection; }
+    // RTP/RTCP over UDP through relay port pairs from [firstPort, lastPort].
+    // Applies to connections accepted after the call.
+    void setUdpRelay(bool enabled, int firstPort, int lastPort);
+    bool isUdpRelayEnabled() const { return !m_udpPorts.isNull(); }
+
+    // Worker threads. Takes effect the next time forwarding starts from idle;
+    // a thread count of 0 relays on the thread that owns the PortForwarder.
+    void configureEngine(int threadCount, ForwardingEngine::ShardMode shardMode, bool pinThreads);
+    int workerThreadCount() const { return m_engineThreads; }
+
 signals:
     void forwardingStarted(const QString& cameraId, int externalPort);
     void forwardingStopped(const QString& cameraId);
     void forwardingError(const QString& cameraId, const QString& error);
     void connectionEstablished(const QString& cameraId, const QString& clientAddress);
     void connectionClosed(const QString& cameraId, const QString& clientAddress);
-    void dataTransferred(const QString& cameraId, qint64 bytes, const QString& direction);
+    void statsUpdated(const QHash<QString, TrafficSnapshot>& snapshots); // camera ID -> traffic
+    void throughputSampled(); // Every ThroughputHistory::SAMPLE_INTERVAL_MS
+    void connectionBackpressure(const QString& cameraId, const QString& clientAddress, bool paused, qint64 queuedBytes);
     void reconnectionAttempt(const QString& cameraId, int attemptNumber);
     void portChanged(const QString& cameraId, int oldPort, int newPort);
 
 private slots:
-    void handleNewConnection();
-    void handleClientDisconnected();
-    void handleClientDataReady();
-    void handleTargetConnected();
-    void handleTargetDisconnected();
-    void handleTargetDataReady();
-    void handleConnectionError(QAbstractSocket::SocketError error);    void handleReconnectTimer();    void onNetworkInterfacesChanged();
+    void handleNewConnection(qintptr socketDescriptor);
+    void handleWorkerConnectionEstablished(const QString& cameraId, quint64 sessionId, const QString& clientAddress);
+    void handleWorkerConnectionClosed(const QString& cameraId, quint64 sessionId, const QString& clientAddress);
+    void handleWorkerTargetConnected(const QString& cameraId, quint64 sessionId);
+    void handleWorkerTargetDisconnected(const QString& cameraId, quint64 sessionId);
+    void handleWorkerConnectionError(const QString& cameraId, quint64 sessionId, const QString& error);
+    void handleWorkerConnectionBackpressure(const QString& cameraId, quint64 sessionId, const QString& clientAddress,
+                                            bool paused, qint64 queuedBytes);
+    void handleWorkerQueueDepths(const QString& cameraId, quint64 sessionId, const QHash<QString, qint64>& depths);
+    void handleWorkerUdpStreamOpened(const QString& cameraId, quint64 sessionId, const QString& stream,
+                                     const QSharedPointer<TrafficCounters>& traffic);
+    void handleWorkerUdpStreamClosed(const QString& cameraId, quint64 sessionId, const QString& stream);
+    void handleReconnectTimer();    void onNetworkInterfacesChanged();
     void onWireGuardStateChanged(bool active);
     void handleHealthCheck();
+    void handleStatsTimer();
+    void handleThroughputTimer();
 
-private:    struct ConnectionInfo {
-        QTcpSocket* clientSocket;
-        QTcpSocket* targetSocket;
-        QString clientAddress;
-        qint64 bytesTransferred;
-        QDateTime connectedTime;
-        bool isTargetConnected;
-        QByteArray pendingClientData;  // Buffer for data received before target connection
-    };
-    
+private:
     struct ForwardingSession {
-        QTcpServer* server;
+        ForwardingServer* server;
         CameraConfig camera;
-        QHash<QTcpSocket*, ConnectionInfo*> connections; // client -> connection info
+        quint64 sessionId;       // Tags worker events so a restarted session ignores stale ones
+        int connectionCount;
+        QHash<QString, qint64> queueDepths; // client address -> bytes queued towards it
         QTimer* reconnectTimer;
         QTimer* healthCheckTimer;
         bool isReconnecting;
         int reconnectAttempts;
-        qint64 totalBytesTransferred;
-        QDateTime lastActivity;
+        QSharedPointer<TrafficCounters> traffic; // Written by the workers, see TrafficCounters
+        ThroughputHistory throughput;            // Sampled from traffic every second
+        QHash<QString, QSharedPointer<TrafficCounters>> udpStreams; // UDP media streams by name
         QString status;
     };
       void setupReconnectTimer(const QString& cameraId);
     void setupHealthCheckTimer(const QString& cameraId);
-    void cleanupSession(const QString& cameraId);
-    void cleanupConnection(const QString& cameraId, QTcpSocket* clientSocket);    void forwardData(QTcpSocket* from, QTcpSocket* to, const QString& cameraId, const QString& direction);
-    void optimizeSocketForStreaming(QTcpSocket* socket);
     bool bindToAllInterfaces(QTcpServer* server, quint16 port);
     void restartAllForwarding();
     void updateSessionStatus(const QString& cameraId, const QString& status);
-    void logConnectionDetails(const QString& cameraId, const ConnectionInfo* info, const QString& event);
+    void ensureEngine();
+    void applyRelayOptions();
+    ForwardingSession* findSession(const QString& cameraId, quint64 sessionId) const;
     
     QHash<QString, ForwardingSession*> m_sessions;
-    QHash<QTcpSocket*, QString> m_socketToCameraMap;
     NetworkInterfaceManager* m_networkManager;
+    RelayBackend m_relayBackend;
+    bool m_payloadInspection;
+    QSharedPointer<UdpPortPool> m_udpPorts;
+    
+    // Forwarding engine
+    ForwardingEngine* m_engine;
+    int m_engineThreads;
+    ForwardingEngine::ShardMode m_engineShardMode;
+    bool m_enginePinThreads;
+    quint64 m_nextSessionId;
+    QTimer* m_statsTimer;
+    QTimer* m_throughputTimer;
     
     // Constants
     static const int MAX_RECONNECT_ATTEMPTS = 10;
     static const int RECONNECT_INTERVAL_MS = 5000;
     static const int HEALTH_CHECK_INTERVAL_MS = 30000;
+    static const int DEFAULT_STATS_UPDATE_INTERVAL_MS = 2000;
+    static const int MIN_STATS_UPDATE_INTERVAL_MS = 100;
 };
 
 #endif // PORTFORWARDER_H
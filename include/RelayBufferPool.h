@@ -0,0 +1,71 @@
+#ifndef RELAYBUFFERPOOL_H
+#define RELAYBUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size, cache-line aligned scratch buffers for relaying socket data.
+//
+// Sockets are read into a slab with read(char*, maxSize) and the slab is
+// handed back once the bytes have been written on, so a steady relay reuses
+// the same few slabs instead of allocating a QByteArray per chunk. Slabs
+// released while the cache is full are freed, which bounds the memory held
+// after a burst.
+//
+// Not thread safe: each ForwardingWorker (and the EchoServer) owns its own
+// pool and only touches it from its thread.
+class RelayBufferPool
+{
+public:
+    struct Stats {
+        uint64_t hits = 0;        // acquire() served from the cache
+        uint64_t misses = 0;      // acquire() had to allocate a slab
+        size_t inUse = 0;         // Slabs currently handed out
+        size_t highWater = 0;     // Most slabs ever handed out at once
+        size_t cached = 0;        // Free slabs kept for reuse
+    };
+
+    // Scoped slab, returned to the pool when it goes out of scope
+    class Buffer
+    {
+    public:
+        explicit Buffer(RelayBufferPool& pool) : m_pool(pool), m_data(pool.acquire()) {}
+        ~Buffer() { m_pool.release(m_data); }
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        char* data() const { return m_data; }
+        size_t size() const { return m_pool.slabSize(); }
+
+    private:
+        RelayBufferPool& m_pool;
+        char* m_data;
+    };
+
+    explicit RelayBufferPool(size_t slabSize = DEFAULT_SLAB_SIZE, size_t maxCachedSlabs = DEFAULT_MAX_CACHED_SLABS);
+    ~RelayBufferPool();
+    RelayBufferPool(const RelayBufferPool&) = delete;
+    RelayBufferPool& operator=(const RelayBufferPool&) = delete;
+
+    char* acquire();
+    void release(char* slab);
+
+    size_t slabSize() const { return m_slabSize; }
+    const Stats& stats() const { return m_stats; }
+
+    static const size_t CACHE_LINE_SIZE = 64;
+    static const size_t DEFAULT_SLAB_SIZE = 64 * 1024;  // Matches the socket read buffer limit
+    static const size_t DEFAULT_MAX_CACHED_SLABS = 4;
+
+private:
+    static char* allocateSlab(size_t size);
+    static void freeSlab(char* slab);
+
+    size_t m_slabSize;
+    size_t m_maxCachedSlabs;
+    std::vector<char*> m_freeSlabs;  // Capacity reserved up front, never grows
+    Stats m_stats;
+};
+
+#endif // RELAYBUFFERPOOL_H
@@ -0,0 +1,87 @@
+#ifndef RTSPDEMUXER_H
+#define RTSPDEMUXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Incremental framer for one direction of an RTSP connection.
+//
+// Data is fed in whatever chunks the socket delivers. The demuxer follows
+// RTSP message framing (headers up to "\r\n\r\n" plus Content-Length) and
+// "$" channel length interleaved frames across chunk boundaries and reports
+// one event per message or frame. Payloads are never copied: bodies and frame
+// data are skipped by length, only RTSP header blocks that straddle two
+// chunks are reassembled in an internal buffer.
+//
+// A stream that does not start like RTSP (HTTP, ONVIF, ...) loses sync for
+// good and all further data is reported as Unknown until reset().
+//
+// Events for a reassembled header block point into the internal buffer
+// instead of the chunk. Such an event covers the bytes held back from earlier
+// chunks (bufferedHeaderSize() before the call) followed by the start of this
+// chunk, which lets a relay that holds those bytes back rewrite the block.
+// Held bytes that turn out not to be RTSP come back the same way as an
+// Unknown event before the Unknown data of the chunk.
+//
+// Plain C++ without Qt so the relay benchmarks can link it on their own.
+class RtspDemuxer
+{
+public:
+    enum class EventType {
+        Request,        // RTSP request, data/size cover start line and headers
+        Response,       // RTSP response, data/size cover start line and headers
+        Interleaved,    // Interleaved frame, data/size cover the payload bytes in this chunk
+        Unknown         // Data that is not RTSP, data/size cover the rest of the chunk
+    };
+
+    struct Event {
+        EventType type;
+        const char* data;   // Valid until the next feed() call
+        size_t size;
+        size_t length;      // Content-Length of a message, payload length of a frame
+        int channel;        // Interleaved channel, -1 otherwise
+    };
+
+    // Replaces the contents of events with the messages and frames that start
+    // in this chunk. The vector is meant to be reused between calls.
+    void feed(const char* data, size_t size, std::vector<Event>& events);
+    void reset();
+
+    bool isSynchronized() const { return m_state != State::Lost; }
+
+    // Bytes of an incomplete header block buffered from earlier chunks
+    size_t bufferedHeaderSize() const { return m_state == State::Headers ? m_pending.size() : 0; }
+
+    // Length of the start line of a Request/Response event, without CRLF
+    static size_t startLineLength(const Event& event);
+
+    static const size_t MAX_HEADER_SIZE = 64 * 1024;
+    static const size_t MAX_BODY_SIZE = 16 * 1024 * 1024; // Caps absurd Content-Length values
+
+private:
+    enum class State {
+        Start,          // Between messages
+        FrameHeader,    // Inside the 4 byte header of an interleaved frame
+        Headers,        // Inside an RTSP start line or header block
+        Skip,           // Inside a message body or frame payload
+        Lost            // Not RTSP, no longer framing
+    };
+
+    enum class Classification { Request, Response, Unknown, Incomplete };
+
+    static Classification classify(const char* data, size_t size);
+    void releasePending(std::vector<Event>& events);
+    static size_t findHeaderEnd(const char* data, size_t size, size_t from);
+    static size_t contentLength(const char* headers, size_t size);
+
+    static const size_t HEADER_BUFFER_RESERVE = 2048;
+
+    State m_state = State::Start;
+    std::string m_pending;    // Header bytes split across chunks, never payload
+    std::string m_message;    // Reassembled header block handed out in the last event
+    uint64_t m_remaining = 0; // Body or payload bytes still to skip
+};
+
+#endif // RTSPDEMUXER_H
@@ -0,0 +1,177 @@
+#ifndef RTSPFANOUT_H
+#define RTSPFANOUT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include "CameraConfig.h"
+
+// Shares one upstream RTSP session per camera stream between many viewers.
+//
+// Viewers talk RTSP to the fan-out itself: OPTIONS, DESCRIBE, SETUP, PLAY,
+// PAUSE, TEARDOWN and GET/SET_PARAMETER are answered locally from the SDP of
+// the upstream session. That session is opened on the first DESCRIBE for a
+// stream path and kept playing while at least one viewer is attached. Media
+// is requested from the camera as interleaved RTP on the RTSP connection and
+// every frame is copied to the attached viewers, so the camera serves a
+// single client however many viewers there are.
+//
+// Viewers must use interleaved transport too. UDP SETUPs get 461, which makes
+// common players retry over TCP. When the camera has credentials configured,
+// viewers have to present the same ones (Basic or Digest) since the camera
+// no longer sees their requests.
+class RtspFanOut : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RtspFanOut(const CameraConfig& camera, QObject *parent = nullptr);
+    ~RtspFanOut();
+
+    void addViewer(QTcpSocket* socket, const QString& clientAddress);
+    void closeAll();
+
+    int viewerCount() const { return m_viewers.size(); }
+    int upstreamCount() const { return m_upstreamsByPath.size(); }
+    QHash<QString, qint64> queueDepths() const;
+
+signals:
+    void viewerClosed(const QString& clientAddress);
+    void bytesRelayed(qint64 bytes, bool clientToTarget);
+    void upstreamConnected();
+    void upstreamDisconnected();
+    void upstreamError(const QString& error);
+
+private slots:
+    void handleViewerReadyRead();
+    void handleViewerDisconnected();
+    void handleUpstreamConnected();
+    void handleUpstreamReadyRead();
+    void handleUpstreamDisconnected();
+    void handleUpstreamError(QAbstractSocket::SocketError error);
+    void handleHousekeeping();
+
+private:
+    struct Upstream;
+
+    struct RtspMessage {
+        QByteArray startLine;
+        QList<QPair<QByteArray, QByteArray>> headers; // names lower-cased
+        QByteArray body;
+
+        QByteArray header(const QByteArray& name) const;
+        QList<QByteArray> headerValues(const QByteArray& name) const;
+    };
+
+    enum class Codec { Other, H264, H265 };
+
+    struct Track {
+        QByteArray control;        // Control URL advertised to viewers (relative)
+        QByteArray setupUrl;       // Absolute control URL on the camera
+        int channel;               // Interleaved RTP channel on the upstream connection
+        bool video;
+        Codec codec;               // From a=rtpmap
+    };
+
+    struct Viewer {
+        QTcpSocket* socket;
+        QString clientAddress;
+        QByteArray buffer;
+        Upstream* upstream;
+        QByteArray sessionId;
+        QHash<int, int> channelMap;      // upstream channel -> viewer channel
+        bool authenticated;
+        bool playing;
+        bool dropping;                   // Send queue overflowed, skipping media until a resume point
+        qint64 droppedFrames;            // Whole video frames (audio frames without video)
+        QByteArray pendingDescribeCSeq;  // DESCRIBE answered once the SDP is known
+        QByteArray pendingDescribeUrl;
+    };
+
+    enum class UpstreamState {
+        Connecting,
+        Options,
+        Describe,
+        Setup,
+        Play,
+        Playing
+    };
+
+    struct Upstream {
+        QString path;
+        QTcpSocket* socket;
+        QByteArray buffer;
+        UpstreamState state;
+        int cseq;
+        QByteArray url;
+        QByteArray contentBase;
+        QByteArray sessionHeader;
+        int sessionTimeoutS;
+        QByteArray sdp;                  // Rewritten for viewers
+        QList<Track> tracks;
+        int setupIndex;
+        QByteArray authRealm;
+        QByteArray authNonce;
+        QByteArray authQop;
+        bool authDigest;
+        bool authRetried;
+        QByteArray lastMethod;
+        QByteArray lastUrl;
+        QByteArray lastExtraHeaders;
+        QList<Viewer*> viewers;
+        qint64 openedMs;                 // Camera connect began, for the setup deadline
+        qint64 idleSinceMs;
+        qint64 lastKeepAliveMs;
+        int videoChannel;                // RTP channel of the first video track, -1 without video
+        Codec videoCodec;
+        QHash<int, bool> frameStart;     // RTP channel -> next packet starts a frame (last had the marker bit)
+    };
+
+    // Parses one RTSP message or interleaved frame starting at offset
+    enum class ParseResult { NeedMore, Message, Frame, Error };
+    static ParseResult parseNext(const QByteArray& buffer, int& offset, RtspMessage& message,
+                                 int& frameChannel, const char*& frameData, int& frameSize);
+
+    Upstream* upstreamFor(const QString& path);
+    void sendUpstreamRequest(Upstream* upstream, const QByteArray& method, const QByteArray& url,
+                             const QByteArray& extraHeaders = QByteArray());
+    void handleUpstreamResponse(Upstream* upstream, const RtspMessage& response);
+    void parseDescription(Upstream* upstream, const QByteArray& sdp);
+    void distributeFrame(Upstream* upstream, int channel, const char* frame, int frameSize, qint64& bytesWritten);
+    static bool startsKeyframe(Codec codec, const char* rtp, int size, bool frameStart);
+    void closeUpstream(Upstream* upstream, const QString& reason);
+
+    void handleViewerRequest(Viewer* viewer, const RtspMessage& request);
+    bool checkViewerAuthorization(Viewer* viewer, const QByteArray& method, const RtspMessage& request);
+    void sendViewerResponse(Viewer* viewer, int code, const QByteArray& reason, const QByteArray& cseq,
+                            const QByteArray& extraHeaders = QByteArray(), const QByteArray& body = QByteArray());
+    void answerDescribe(Viewer* viewer);
+    void detachViewer(Viewer* viewer);
+    void removeViewer(Viewer* viewer);
+
+    QByteArray authorizationHeader(const Upstream* upstream, const QByteArray& method, const QByteArray& url) const;
+    static QByteArray md5Hex(const QByteArray& data);
+    static QByteArray authParam(const QByteArray& header, const QByteArray& name);
+    static QString pathFromUrl(const QByteArray& url);
+
+    CameraConfig m_camera;
+    QByteArray m_viewerNonce;
+    QHash<QTcpSocket*, Viewer*> m_viewers;
+    QHash<QTcpSocket*, Upstream*> m_upstreams;
+    QHash<QString, Upstream*> m_upstreamsByPath;
+    QTimer* m_housekeepingTimer;
+
+    static const int MAX_MESSAGE_SIZE = 64 * 1024;
+    static const int HOUSEKEEPING_INTERVAL_MS = 5000;
+    static const int UPSTREAM_LINGER_MS = 10000;       // Keep an unwatched stream open this long
+    static const int UPSTREAM_SETUP_TIMEOUT_MS = 30000; // Connect to PLAY, as ForwardingWorker's TARGET_CONNECT_TIMEOUT_MS
+    static const int DEFAULT_SESSION_TIMEOUT_S = 60;
+    static const qint64 VIEWER_HIGH_WATERMARK = 1024 * 1024;
+    static const qint64 VIEWER_LOW_WATERMARK = 256 * 1024;
+    static const int RTP_HEADER_SIZE = 12;
+};
+
+#endif // RTSPFANOUT_H
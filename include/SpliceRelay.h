@@ -0,0 +1,66 @@
+#ifndef SPLICERELAY_H
+#define SPLICERELAY_H
+
+#include <QObject>
+#include <QSocketNotifier>
+
+// Zero-copy TCP relay between two connected sockets.
+//
+// On Linux the bytes are moved kernel-side with splice() through one pipe per
+// direction, so the payload never enters user space. The relay owns the two
+// socket descriptors it is given and closes them when it is destroyed.
+// On other platforms isSupported() returns false and start() fails, callers
+// keep using the QTcpSocket based relay.
+class SpliceRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpliceRelay(qintptr clientDescriptor, qintptr targetDescriptor, QObject *parent = nullptr);
+    ~SpliceRelay();
+
+    static bool isSupported();
+    static qintptr duplicateDescriptor(qintptr descriptor);
+    static void closeDescriptor(qintptr descriptor);
+
+    bool start(QString* errorString = nullptr);
+    void close();
+    bool isActive() const { return m_active; }
+
+signals:
+    void bytesRelayed(qint64 bytes, bool clientToTarget);
+    void finished();
+
+private slots:
+    void handleClientReadable();
+    void handleTargetReadable();
+    void handleClientWritable();
+    void handleTargetWritable();
+
+private:
+    struct Pump {
+        qintptr source = -1;
+        qintptr destination = -1;
+        int pipeRead = -1;
+        int pipeWrite = -1;
+        qint64 pipeBytes = 0;
+        bool sourceClosed = false;
+        bool destinationShutdown = false;
+        QSocketNotifier* readNotifier = nullptr;
+        QSocketNotifier* writeNotifier = nullptr;
+    };
+
+    bool openPipe(Pump& pump, QString* errorString);
+    void pump(Pump& pump, bool clientToTarget);
+    void finish();
+
+    Pump m_clientToTarget;
+    Pump m_targetToClient;
+    qintptr m_clientDescriptor;
+    qintptr m_targetDescriptor;
+    bool m_active;
+
+    static const int PIPE_CAPACITY = 256 * 1024; // Matches the socket buffers set by PortForwarder
+};
+
+#endif // SPLICERELAY_H
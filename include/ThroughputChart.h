@@ -0,0 +1,32 @@
+#ifndef THROUGHPUTCHART_H
+#define THROUGHPUTCHART_H
+
+#include <QWidget>
+#include "ThroughputHistory.h"
+
+// Line chart of a camera's throughput over the whole ThroughputHistory, in
+// Mbit/s, received and sent. paintSparkline() draws the compact form used
+// in the camera table.
+class ThroughputChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ThroughputChart(QWidget *parent = nullptr);
+
+    void setHistory(const ThroughputHistory& history);
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+    // Received bytes of the last seconds samples, scaled to rect
+    static void paintSparkline(QPainter* painter, const QRect& rect, const ThroughputHistory& history, int seconds);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    ThroughputHistory m_history;
+};
+
+#endif // THROUGHPUTCHART_H
@@ -0,0 +1,81 @@
+#ifndef THROUGHPUTHISTORY_H
+#define THROUGHPUTHISTORY_H
+
+#include <QtGlobal>
+#include <array>
+
+// Bytes relayed per second over the last CAPACITY seconds of a session.
+//
+// Filled once a second from the session's TrafficCounters totals; the
+// samples live in a fixed array, so recording never allocates and a session
+// holds sizeof(ThroughputHistory), about 4.7 KB (600 samples of two 32-bit
+// counters), however long it runs. Received is camera to viewers, sent is
+// viewers to camera.
+//
+// Not thread safe: owned by the PortForwarder and only used on its thread.
+class ThroughputHistory
+{
+public:
+    struct Sample {
+        quint32 receivedBytes = 0;
+        quint32 sentBytes = 0;
+    };
+
+    // Records the bytes since the previous call from the running totals. The
+    // first call only sets the baseline.
+    void record(quint64 totalReceived, quint64 totalSent)
+    {
+        if (m_hasBaseline) {
+            Sample& sample = m_samples[m_next];
+            sample.receivedBytes = clampedDelta(totalReceived, m_lastReceived);
+            sample.sentBytes = clampedDelta(totalSent, m_lastSent);
+            m_next = (m_next + 1) % CAPACITY;
+            m_count = qMin(m_count + 1, CAPACITY);
+            m_idleSeconds = (sample.receivedBytes == 0 && sample.sentBytes == 0) ? m_idleSeconds + 1 : 0;
+        }
+        m_lastReceived = totalReceived;
+        m_lastSent = totalSent;
+        m_hasBaseline = true;
+    }
+
+    int size() const { return m_count; }
+
+    // Sample secondsAgo seconds before the latest one; zero beyond size()
+    Sample at(int secondsAgo) const
+    {
+        if (secondsAgo < 0 || secondsAgo >= m_count) {
+            return Sample();
+        }
+        return m_samples[(m_next - 1 - secondsAgo + CAPACITY) % CAPACITY];
+    }
+
+    Sample latest() const { return at(0); }
+
+    // Consecutive empty samples up to the latest one
+    int idleSeconds() const { return m_idleSeconds; }
+
+    static double toMbitPerSecond(quint64 bytesPerSecond) { return bytesPerSecond * 8.0 / 1000000.0; }
+
+    static const int CAPACITY = 600;           // 10 minutes
+    static const int SAMPLE_INTERVAL_MS = 1000;
+
+private:
+    static quint32 clampedDelta(quint64 total, quint64 last)
+    {
+        // A counter never goes back; treat it as a restart rather than wrap
+        if (total < last) {
+            return 0;
+        }
+        return static_cast<quint32>(qMin<quint64>(total - last, 0xFFFFFFFFu));
+    }
+
+    std::array<Sample, CAPACITY> m_samples{};
+    int m_next = 0;
+    int m_count = 0;
+    int m_idleSeconds = 0;
+    quint64 m_lastReceived = 0;
+    quint64 m_lastSent = 0;
+    bool m_hasBaseline = false;
+};
+
+#endif // THROUGHPUTHISTORY_H
@@ -0,0 +1,89 @@
+#ifndef TRAFFICCOUNTERS_H
+#define TRAFFICCOUNTERS_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <atomic>
+
+// Point-in-time copy of a TrafficCounters
+struct TrafficSnapshot {
+    quint64 bytesClientToTarget = 0;
+    quint64 bytesTargetToClient = 0;
+    quint64 chunks = 0;            // Reads relayed (socket reads, splice batches, fan-out frames)
+    quint64 packets = 0;           // Interleaved RTP/RTCP frames seen by the demuxer
+    qint64 lastActivityMs = 0;     // TrafficCounters::nowMs() of the last activity, 0 if none
+    quint64 cameraConnects = 0;    // TCP connects to the camera that succeeded
+    quint64 cameraConnectTotalMs = 0;
+    qint64 lastCameraConnectMs = 0;
+    quint64 warmHandouts = 0;      // Viewers given an already connected camera socket
+
+    quint64 totalBytes() const { return bytesClientToTarget + bytesTargetToClient; }
+    qint64 averageCameraConnectMs() const
+    {
+        return cameraConnects > 0 ? static_cast<qint64>(cameraConnectTotalMs / cameraConnects) : 0;
+    }
+};
+
+Q_DECLARE_METATYPE(TrafficSnapshot)
+
+// Relay statistics updated from the forwarding threads and read from any
+// thread without locking. Every access is relaxed: the counters are only ever
+// summed and displayed, nothing else is ordered against them. A snapshot may
+// therefore mix values from slightly different moments.
+class TrafficCounters
+{
+public:
+    void record(bool clientToTarget, qint64 bytes, int packets = 0)
+    {
+        (clientToTarget ? m_bytesClientToTarget : m_bytesTargetToClient)
+            .fetch_add(static_cast<quint64>(bytes), std::memory_order_relaxed);
+        m_chunks.fetch_add(1, std::memory_order_relaxed);
+        if (packets > 0) {
+            m_packets.fetch_add(static_cast<quint64>(packets), std::memory_order_relaxed);
+        }
+        touch();
+    }
+
+    void touch() { m_lastActivityMs.store(nowMs(), std::memory_order_relaxed); }
+
+    void recordCameraConnect(qint64 connectMs)
+    {
+        m_cameraConnects.fetch_add(1, std::memory_order_relaxed);
+        m_cameraConnectTotalMs.fetch_add(static_cast<quint64>(qMax<qint64>(connectMs, 0)), std::memory_order_relaxed);
+        m_lastCameraConnectMs.store(connectMs, std::memory_order_relaxed);
+    }
+
+    void recordWarmHandout() { m_warmHandouts.fetch_add(1, std::memory_order_relaxed); }
+
+    TrafficSnapshot snapshot() const
+    {
+        TrafficSnapshot snapshot;
+        snapshot.bytesClientToTarget = m_bytesClientToTarget.load(std::memory_order_relaxed);
+        snapshot.bytesTargetToClient = m_bytesTargetToClient.load(std::memory_order_relaxed);
+        snapshot.chunks = m_chunks.load(std::memory_order_relaxed);
+        snapshot.packets = m_packets.load(std::memory_order_relaxed);
+        snapshot.lastActivityMs = m_lastActivityMs.load(std::memory_order_relaxed);
+        snapshot.cameraConnects = m_cameraConnects.load(std::memory_order_relaxed);
+        snapshot.cameraConnectTotalMs = m_cameraConnectTotalMs.load(std::memory_order_relaxed);
+        snapshot.lastCameraConnectMs = m_lastCameraConnectMs.load(std::memory_order_relaxed);
+        snapshot.warmHandouts = m_warmHandouts.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    // Monotonic milliseconds from a coarse clock (a tick of a few ms), cheap
+    // enough to read on every relayed chunk
+    static qint64 nowMs();
+
+private:
+    std::atomic<quint64> m_bytesClientToTarget{0};
+    std::atomic<quint64> m_bytesTargetToClient{0};
+    std::atomic<quint64> m_chunks{0};
+    std::atomic<quint64> m_packets{0};
+    std::atomic<qint64> m_lastActivityMs{0};
+    std::atomic<quint64> m_cameraConnects{0};
+    std::atomic<quint64> m_cameraConnectTotalMs{0};
+    std::atomic<qint64> m_lastCameraConnectMs{0};
+    std::atomic<quint64> m_warmHandouts{0};
+};
+
+#endif // TRAFFICCOUNTERS_H
@@ -0,0 +1,101 @@
+#ifndef UDPECHOSERVER_H
+#define UDPECHOSERVER_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QSocketNotifier>
+
+// Header of a UDP echo probe, in network byte order:
+//
+//   0  magic "VUEP"          20  server receive time
+//   4  version (1)           28  server transmit time
+//   5  flags                 36  padding up to the probe size
+//   8  sequence number
+//  12  client send time
+//
+// Times are nanoseconds since the Unix epoch, each taken on the clock of the
+// host that wrote it. The client fills in the sequence and its send time;
+// the server fills in both of its times and sends the datagram back.
+struct UdpEchoProbe
+{
+    enum Flag {
+        Reply = 0x01,
+        KernelReceiveTime = 0x02   // Receive time is the kernel's, not read() returning
+    };
+
+    quint8 flags = 0;
+    quint32 sequence = 0;
+    qint64 clientSendNs = 0;
+    qint64 serverReceiveNs = 0;
+    qint64 serverTransmitNs = 0;
+
+    // False for datagrams that are not probes
+    static bool parse(const char* data, int size, UdpEchoProbe* probe);
+    void write(char* data) const;     // HEADER_SIZE bytes
+
+    // Wall clock in nanoseconds since the Unix epoch
+    static qint64 nowNs();
+
+    static const quint32 MAGIC = 0x56554550;
+    static const quint8 VERSION = 1;
+    static const int HEADER_SIZE = 36;
+    static const int MAX_SIZE = 1472;  // One Ethernet frame over IPv4
+};
+
+// UDP echo listener for measuring RTT, jitter and loss over the tunnel
+// without TCP retransmits and Nagle in the way.
+//
+// Runs next to the TCP EchoServer on its own port and answers only
+// datagrams that parse as UdpEchoProbe, so it cannot be used to reflect
+// arbitrary traffic; replies are never larger than the probe. On Linux the
+// receive time comes from the kernel (SO_TIMESTAMPING software receive
+// timestamps, or SO_TIMESTAMPNS); elsewhere it is read when the datagram is
+// picked up. The transmit time is read just before the reply is sent.
+class UdpEchoServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UdpEchoServer(QObject *parent = nullptr);
+    ~UdpEchoServer();
+
+    bool startServer(quint16 port = 7778, const QHostAddress& address = QHostAddress::Any);
+    void stopServer();
+    bool isRunning() const { return m_descriptor >= 0; }
+
+    quint16 serverPort() const { return m_port; }
+    bool hasKernelTimestamps() const { return m_kernelTimestamps; }
+
+    // Statistics
+    quint64 totalProbes() const { return m_totalProbes; }
+    quint64 totalInvalid() const { return m_totalInvalid; }
+    quint64 totalBytesReceived() const { return m_totalBytesReceived; }
+    quint64 totalBytesSent() const { return m_totalBytesSent; }
+
+signals:
+    void serverStarted(quint16 port);
+    void serverStopped();
+    void errorOccurred(const QString& error);
+
+private slots:
+    void handleReadable();
+
+private:
+    bool openSocket(quint16 port, const QHostAddress& address, QString* errorString);
+    void enableKernelTimestamps();
+    void closeSocket();
+
+    qintptr m_descriptor;
+    QSocketNotifier* m_notifier;
+    quint16 m_port;
+    bool m_kernelTimestamps;
+
+    quint64 m_totalProbes;
+    quint64 m_totalInvalid;
+    quint64 m_totalBytesReceived;
+    quint64 m_totalBytesSent;
+
+    static const int MAX_DATAGRAMS_PER_WAKEUP = 256;
+};
+
+#endif // UDPECHOSERVER_H
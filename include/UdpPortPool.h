@@ -0,0 +1,37 @@
+#ifndef UDPPORTPOOL_H
+#define UDPPORTPOOL_H
+
+#include <QMutex>
+#include <QSet>
+#include <QtGlobal>
+
+// Hands out even/odd UDP port pairs (RTP, RTCP) from a fixed range.
+//
+// Shared by all ForwardingWorkers through a QSharedPointer, hence the mutex.
+// Pairs are handed out round robin, so a port that was just released is not
+// reused right away while stray packets for the old stream may still arrive.
+// The pool only tracks reservations; binding is left to UdpRelay, which asks
+// for the next pair when a port turns out to be taken by another program.
+class UdpPortPool
+{
+public:
+    UdpPortPool(quint16 firstPort, quint16 lastPort);
+
+    // Returns the even RTP port of a free pair, 0 if every pair is in use
+    quint16 acquirePair();
+    void releasePair(quint16 rtpPort);
+
+    quint16 firstPort() const { return m_firstPort; }
+    quint16 lastPort() const { return m_lastPort; }
+    int pairCount() const;
+    int pairsInUse() const;
+
+private:
+    quint16 m_firstPort;     // Even
+    quint16 m_lastPort;      // Odd, the RTCP port of the last pair
+    quint16 m_nextPort;
+    QSet<quint16> m_inUse;   // RTP ports of reserved pairs
+    mutable QMutex m_mutex;
+};
+
+#endif // UDPPORTPOOL_H
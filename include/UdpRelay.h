@@ -0,0 +1,111 @@
+#ifndef UDPRELAY_H
+#define UDPRELAY_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QSharedPointer>
+#include <QSocketNotifier>
+#include "RelayBufferPool.h"
+#include "TrafficCounters.h"
+
+class UdpPortPool;
+
+// Relays one RTP stream and its RTCP between a camera and a viewer over UDP.
+//
+// Two port pairs are taken from the UdpPortPool. The camera side pair is
+// what the camera is told the client ports are, the client side pair is what
+// the viewer is told the server ports are. A datagram read on one side is
+// sent on from the socket of the same channel on the other side, so both
+// peers see symmetric RTP. Datagrams from any host but the expected peer are
+// dropped; the viewer's ports are re-learned from what it sends, which keeps
+// RTCP working through NAT.
+//
+// On Linux datagrams are received and sent in batches with recvmmsg() and
+// sendmmsg(), and runs of equal sized packets leave as one UDP GSO send where
+// the kernel supports it. Elsewhere one datagram is moved per call. The
+// relay owns its sockets and closes them, and returns its ports, on close().
+class UdpRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Channel {
+        Rtp = 0,
+        Rtcp = 1
+    };
+
+    UdpRelay(const QSharedPointer<UdpPortPool>& ports, RelayBufferPool& buffers, QObject *parent = nullptr);
+    ~UdpRelay();
+
+    // Binds both port pairs, each in the address family of its peer
+    bool open(const QHostAddress& cameraAddress, const QHostAddress& clientAddress, QString* errorString = nullptr);
+    void setClient(const QHostAddress& address, quint16 rtpPort, quint16 rtcpPort);
+    void setCamera(const QHostAddress& address, quint16 rtpPort, quint16 rtcpPort);
+    void start();
+    void close();
+    bool isActive() const { return m_active; }
+
+    quint16 cameraSidePort() const { return m_cameraSide[Rtp].port; }  // RTCP is one above
+    quint16 clientSidePort() const { return m_clientSide[Rtp].port; }
+    quint16 clientPort(Channel channel) const { return m_client[channel].port; }
+    quint16 cameraPort(Channel channel) const { return m_camera[channel].port; }
+    QSharedPointer<TrafficCounters> traffic() const { return m_traffic; }
+    quint64 droppedPackets() const { return m_droppedPackets; }
+
+    // RTSP Transport header helpers. Header names are matched without regard
+    // to case; parameters are those of the first transport spec.
+    static QByteArray headerValue(const QByteArray& headers, const QByteArray& name);
+    static QByteArray replaceHeaderValue(const QByteArray& headers, const QByteArray& name, const QByteArray& value);
+    static QByteArray firstTransport(const QByteArray& transport);
+    static QByteArray replaceFirstTransport(const QByteArray& transport, const QByteArray& spec); // Keeps the alternatives
+    static bool isUdpUnicast(const QByteArray& transport);
+    static QByteArray transportParameter(const QByteArray& transport, const QByteArray& name);
+    static QByteArray setTransportParameter(const QByteArray& transport, const QByteArray& name, const QByteArray& value);
+    static bool parsePortPair(const QByteArray& value, quint16* rtpPort, quint16* rtcpPort);
+    static QByteArray portPair(quint16 rtpPort);
+
+signals:
+    void bytesRelayed(qint64 bytes, int packets, bool clientToTarget);
+
+private slots:
+    void handleCameraRtpReadable();
+    void handleCameraRtcpReadable();
+    void handleClientRtpReadable();
+    void handleClientRtcpReadable();
+
+private:
+    struct Socket {
+        qintptr descriptor = -1;
+        quint16 port = 0;
+        QSocketNotifier* notifier = nullptr;
+    };
+
+    struct Endpoint {
+        QHostAddress address;
+        quint16 port = 0;
+    };
+
+    bool bindPair(Socket* pair, const QHostAddress& peer, QString* errorString);
+    void closePair(Socket* pair);
+    void pump(Channel channel, bool clientToTarget);
+
+    QSharedPointer<UdpPortPool> m_ports;
+    RelayBufferPool& m_buffers;
+    Socket m_cameraSide[2];
+    Socket m_clientSide[2];
+    Endpoint m_camera[2];
+    Endpoint m_client[2];
+    QSharedPointer<TrafficCounters> m_traffic;
+    quint64 m_droppedPackets;
+    bool m_useGso;
+    bool m_active;
+
+    static const int MAX_BATCH = 32;             // Datagrams per recvmmsg()/sendmmsg()
+    static const int MAX_BATCHES_PER_WAKEUP = 8; // Yields to the event loop under a flood
+    static const int DATAGRAM_SLOT_SIZE = 2048;  // Larger datagrams are dropped, RTP stays below the MTU
+    static const int RTP_SOCKET_BUFFER_SIZE = 1024 * 1024;
+    static const int BIND_ATTEMPTS = 16;
+};
+
+#endif // UDPRELAY_H
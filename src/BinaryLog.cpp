@@ -0,0 +1,348 @@
+#include "BinaryLog.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <cstring>
+
+const char BinaryLog::FILE_MAGIC[8] = { 'V', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+
+QMutex BinaryLog::s_formatMutex;
+QVector<BinaryLog::FormatDefinition> BinaryLog::s_formats;
+std::atomic<int> BinaryLog::s_logLevel{static_cast<int>(LogLevel::Error) + 1};  // Off until open()
+
+BinaryLog::BinaryLog()
+    : m_fileBytes(0)
+    , m_open(false)
+    , m_records(0)
+    , m_dropped(0)
+{
+}
+
+BinaryLog::~BinaryLog()
+{
+    close();
+}
+
+BinaryLog& BinaryLog::instance()
+{
+    static BinaryLog instance;
+    return instance;
+}
+
+bool BinaryLog::open(const QString& filePath, LogLevel level)
+{
+    close();
+
+    QMutexLocker fileLocker(&m_fileMutex);
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        LOG_ERROR(QString("Failed to open binary log %1: %2").arg(filePath, m_file.errorString()), "Logger");
+        return false;
+    }
+    m_fileBytes = m_file.size();
+    if (m_fileBytes == 0) {
+        m_fileBytes = m_file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    }
+
+    {
+        QMutexLocker bufferLocker(&m_bufferMutex);
+        m_buffer.reserve(SYNC_FLUSH_BYTES * 2);
+        m_spare.reserve(SYNC_FLUSH_BYTES * 2);
+        m_defined.clear();
+        m_open = true;
+    }
+    s_logLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    return true;
+}
+
+void BinaryLog::close()
+{
+    s_logLevel.store(static_cast<int>(LogLevel::Error) + 1, std::memory_order_relaxed);
+
+    QMutexLocker fileLocker(&m_fileMutex);
+    writeBuffered();
+    {
+        QMutexLocker bufferLocker(&m_bufferMutex);
+        m_open = false;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void BinaryLog::flush()
+{
+    QMutexLocker fileLocker(&m_fileMutex);
+    writeBuffered();
+}
+
+void BinaryLog::flushAfterCrash()
+{
+    if (!m_fileMutex.tryLock()) {
+        return;
+    }
+    if (m_bufferMutex.tryLock()) {
+        if (m_file.isOpen() && !m_buffer.isEmpty()) {
+            m_file.write(m_buffer);
+            m_buffer.clear();
+        }
+        m_bufferMutex.unlock();
+    }
+    m_file.flush();
+    m_fileMutex.unlock();
+}
+
+int BinaryLog::registerFormat(LogLevel level, LogCategory category, const char* format)
+{
+    QMutexLocker locker(&s_formatMutex);
+    FormatDefinition definition;
+    definition.level = level;
+    definition.category = category;
+    definition.format = format;
+    s_formats.append(definition);
+    return s_formats.size() - 1;
+}
+
+void BinaryLog::appendDefinition(int formatId)
+{
+    FormatDefinition definition;
+    {
+        QMutexLocker locker(&s_formatMutex);
+        definition = s_formats.at(formatId);
+    }
+
+    const qsizetype formatLength = qMin<qsizetype>(static_cast<qsizetype>(std::strlen(definition.format)), 0xFFFF);
+    const qsizetype categoryLength = qMin<qsizetype>(static_cast<qsizetype>(definition.category.size()), 0xFFFF);
+
+    m_buffer.append(static_cast<char>(Definition));
+    appendInt(m_buffer, static_cast<quint32>(formatId), 4);
+    m_buffer.append(static_cast<char>(definition.level));
+    appendInt(m_buffer, static_cast<quint64>(categoryLength), 2);
+    m_buffer.append(definition.category.name(), categoryLength);
+    appendInt(m_buffer, static_cast<quint64>(formatLength), 2);
+    m_buffer.append(definition.format, formatLength);
+
+    if (formatId >= m_defined.size()) {
+        m_defined.resize(formatId + 1);
+    }
+    m_defined[formatId] = true;
+}
+
+void BinaryLog::writeBuffered()
+{
+    bool rotate = false;
+    {
+        QMutexLocker bufferLocker(&m_bufferMutex);
+        if (m_buffer.isEmpty()) {
+            return;
+        }
+        m_buffer.swap(m_spare);
+        
+        // Decided under the buffer lock, so every record after the swap
+        // defines its id again for the new file
+        if (m_fileBytes + m_spare.size() >= MAX_FILE_BYTES) {
+            rotate = true;
+            m_defined.clear();
+        }
+    }
+
+    if (m_file.isOpen()) {
+        const qint64 written = m_file.write(m_spare);
+        if (written > 0) {
+            m_fileBytes += written;
+        }
+        m_file.flush();
+    }
+    m_spare.clear();  // Keeps the capacity
+
+    if (rotate) {
+        rotateFile();
+    }
+}
+
+void BinaryLog::rotateFile()
+{
+    const QString filePath = m_file.fileName();
+    const QString previousPath = filePath + ".1";
+
+    m_file.close();
+    QFile::remove(previousPath);
+    QFile::rename(filePath, previousPath);
+
+    m_file.setFileName(filePath);
+    if (m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_fileBytes = m_file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    } else {
+        m_fileBytes = 0;
+    }
+}
+
+void BinaryLog::appendInt(QByteArray& buffer, quint64 value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        buffer.append(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+void BinaryLog::appendArgument(QByteArray& buffer, const QString& value)
+{
+    appendArgument(buffer, value.toUtf8());
+}
+
+void BinaryLog::appendArgument(QByteArray& buffer, const QByteArray& value)
+{
+    const qsizetype length = qMin<qsizetype>(value.size(), 0xFFFF);
+    buffer.append(static_cast<char>(String));
+    appendInt(buffer, static_cast<quint64>(length), 2);
+    buffer.append(value.constData(), length);
+}
+
+void BinaryLog::appendArgument(QByteArray& buffer, const char* value)
+{
+    const qsizetype length = qMin<qsizetype>(static_cast<qsizetype>(std::strlen(value)), 0xFFFF);
+    buffer.append(static_cast<char>(String));
+    appendInt(buffer, static_cast<quint64>(length), 2);
+    buffer.append(value, length);
+}
+
+void BinaryLog::appendArgument(QByteArray& buffer, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    buffer.append(static_cast<char>(Double));
+    appendInt(buffer, bits, 8);
+}
+
+BinaryLogReader::BinaryLogReader(QIODevice* device)
+    : m_device(device)
+{
+}
+
+bool BinaryLogReader::readHeader()
+{
+    char magic[sizeof(BinaryLog::FILE_MAGIC)];
+    if (!readBytes(magic, sizeof(magic)) || std::memcmp(magic, BinaryLog::FILE_MAGIC, sizeof(magic)) != 0) {
+        m_errorString = "Not a Visco Connect binary log";
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogReader::next(Line* line)
+{
+    for (;;) {
+        char type;
+        if (m_device->read(&type, 1) != 1) {
+            return false;  // Clean end of file
+        }
+
+        quint64 id;
+        if (!readUInt(&id, 4)) {
+            return false;
+        }
+
+        if (static_cast<quint8>(type) == BinaryLog::Definition) {
+            char level;
+            Definition definition;
+            if (!readBytes(&level, 1) || !readString(&definition.category) || !readString(&definition.format)) {
+                return false;
+            }
+            definition.level = static_cast<LogLevel>(level);
+            m_definitions.insert(static_cast<quint32>(id), definition);
+            continue;
+        }
+
+        if (static_cast<quint8>(type) != BinaryLog::Entry) {
+            m_errorString = QString("Unknown record type %1 at offset %2").arg(int(type)).arg(m_device->pos() - 5);
+            return false;
+        }
+
+        const auto definition = m_definitions.constFind(static_cast<quint32>(id));
+        if (definition == m_definitions.constEnd()) {
+            m_errorString = QString("Record uses undefined format %1").arg(id);
+            return false;
+        }
+
+        quint64 timestamp;
+        char argumentCount;
+        if (!readUInt(&timestamp, 8) || !readBytes(&argumentCount, 1)) {
+            return false;
+        }
+
+        // Same .arg() overloads the text sink uses, so the text matches
+        QString message = definition->format;
+        for (int i = 0; i < static_cast<quint8>(argumentCount); ++i) {
+            char tag;
+            if (!readBytes(&tag, 1)) {
+                return false;
+            }
+            quint64 value;
+            QString text;
+            switch (static_cast<quint8>(tag)) {
+            case BinaryLog::Int:
+                if (!readUInt(&value, 8)) return false;
+                message = message.arg(static_cast<qlonglong>(value));
+                break;
+            case BinaryLog::UInt:
+                if (!readUInt(&value, 8)) return false;
+                message = message.arg(static_cast<qulonglong>(value));
+                break;
+            case BinaryLog::Double: {
+                if (!readUInt(&value, 8)) return false;
+                double number;
+                std::memcpy(&number, &value, sizeof(number));
+                message = message.arg(number);
+                break;
+            }
+            case BinaryLog::String:
+                if (!readString(&text)) return false;
+                message = message.arg(text);
+                break;
+            default:
+                m_errorString = QString("Unknown argument type %1").arg(int(tag));
+                return false;
+            }
+        }
+
+        line->timestampMs = static_cast<qint64>(timestamp);
+        line->level = definition->level;
+        line->category = definition->category;
+        line->message = message;
+        return true;
+    }
+}
+
+bool BinaryLogReader::readBytes(char* data, qint64 size)
+{
+    if (m_device->read(data, size) != size) {
+        m_errorString = "Truncated record";
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogReader::readUInt(quint64* value, int bytes)
+{
+    unsigned char data[8];
+    if (!readBytes(reinterpret_cast<char*>(data), bytes)) {
+        return false;
+    }
+    *value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        *value = (*value << 8) | data[i];
+    }
+    return true;
+}
+
+bool BinaryLogReader::readString(QString* value)
+{
+    quint64 length;
+    if (!readUInt(&length, 2)) {
+        return false;
+    }
+    QByteArray data(static_cast<qsizetype>(length), Qt::Uninitialized);
+    if (!readBytes(data.data(), data.size())) {
+        return false;
+    }
+    *value = QString::fromUtf8(data);
+    return true;
+}
@@ -8,6 +8,8 @@ CameraConfig::CameraConfig()
     , m_enabled(true)
     , m_externalPort(8551)
     , m_brand("Generic")
+    , m_fanOutEnabled(false)
+    , m_warmConnections(0)
 {
     m_id = QUuid::createUuid().toString(QUuid::WithoutBraces);
 }
@@ -22,6 +24,8 @@ CameraConfig::CameraConfig(const QString& name, const QString& ipAddress, int po
     , m_enabled(enabled)
     , m_externalPort(8551)
     , m_brand("Generic")
+    , m_fanOutEnabled(false)
+    , m_warmConnections(0)
 {
     m_id = QUuid::createUuid().toString(QUuid::WithoutBraces);
 }
@@ -39,6 +43,8 @@ QJsonObject CameraConfig::toJson() const
     json["externalPort"] = m_externalPort;
     json["brand"] = m_brand;
     json["model"] = m_model;
+    json["fanOut"] = m_fanOutEnabled;
+    json["warmConnections"] = m_warmConnections;
     return json;
 }
 
@@ -54,6 +60,8 @@ void CameraConfig::fromJson(const QJsonObject& json)
     m_externalPort = json["externalPort"].toInt(8551);
     m_brand = json["brand"].toString("Generic");
     m_model = json["model"].toString();
+    m_fanOutEnabled = json["fanOut"].toBool(false);
+    setWarmConnections(json["warmConnections"].toInt(0));
     
     // Generate ID if not present (for backward compatibility)
     if (m_id.isEmpty()) {
@@ -8,7 +8,7 @@
 #include <QJsonObject>
 #include <QXmlStreamReader>
 #include <QEventLoop>
-#include <QApplication>
+#include <QCoreApplication>
 #include <QThread>
 #include <QThreadPool>
 #include <QRunnable>
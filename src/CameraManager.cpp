@@ -29,6 +29,7 @@ CameraManager::~CameraManager()
 void CameraManager::initialize()
 {
     loadConfiguration();
+    applyForwarderSettings();
     
     // Auto-start enabled cameras
     for (const CameraConfig& camera : m_cameras.values()) {
@@ -240,6 +241,27 @@ void CameraManager::loadConfiguration()
     }
 }
 
+void CameraManager::applyForwarderSettings()
+{
+    const ConfigManager& config = ConfigManager::instance();
+    
+    m_portForwarder->setRelayBackend(config.getRelayBackend() == "splice"
+                                     ? PortForwarder::RelayBackend::Splice
+                                     : PortForwarder::RelayBackend::UserSpace);
+    m_portForwarder->setPayloadInspectionEnabled(config.isRelayPayloadInspectionEnabled());
+    m_portForwarder->setUdpRelay(config.isUdpRelayEnabled(), config.getUdpRelayPortMin(), config.getUdpRelayPortMax());
+    
+    // -1 picks a thread count from the CPU count, 0 relays on the GUI thread
+    int threads = config.getForwardingThreads();
+    if (threads < 0) {
+        threads = ForwardingEngine::defaultThreadCount();
+    }
+    m_portForwarder->configureEngine(threads,
+                                     ForwardingEngine::shardModeFromString(config.getForwardingShardMode()),
+                                     config.isForwardingCpuPinningEnabled());
+    m_portForwarder->setStatsUpdateInterval(config.getStatsUpdateIntervalMs());
+}
+
 void CameraManager::saveConfiguration()
 {
     // Configuration is automatically saved by ConfigManager
@@ -0,0 +1,433 @@
+#include "CameraTableModel.h"
+#include "CameraManager.h"
+#include "ConfigManager.h"
+#include "ThroughputChart.h"
+#include <QApplication>
+#include <QColor>
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOption>
+#include <QToolTip>
+
+CameraTableModel::CameraTableModel(CameraManager* cameraManager, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_cameraManager(cameraManager)
+{
+}
+
+int CameraTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int CameraTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant CameraTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const Row& row = m_rows.at(index.row());
+    const CameraConfig& camera = row.camera;
+
+    switch (role) {
+    case CameraIdRole:
+        return camera.id();
+    case RunningRole:
+        return row.running;
+    case EnabledRole:
+        return camera.isEnabled();
+    case Qt::TextAlignmentRole:
+        if (index.column() == ConnectionsColumn || index.column() == DataColumn) {
+            return static_cast<int>(Qt::AlignCenter);
+        }
+        if (index.column() == ThroughputColumn) {
+            return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        return QVariant();
+    case Qt::ToolTipRole:
+        if (index.column() == ThroughputColumn) {
+            return QString("Received in the last %1 seconds; double-click for the last %2 minutes")
+                   .arg(SPARKLINE_SECONDS).arg(ThroughputHistory::CAPACITY / 60);
+        }
+        return QVariant();
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case IndexColumn:        return index.row() + 1;
+        case NameColumn:         return camera.name();
+        case BrandColumn:        return camera.brand();
+        case ModelColumn:        return camera.model().isEmpty() ? QString("Unknown") : camera.model();
+        case IpAddressColumn:    return camera.ipAddress();
+        case PortColumn:         return camera.port();
+        case ExternalPortColumn: return camera.externalPort();
+        case StatusColumn:
+            if (!camera.isEnabled()) {
+                return QString("Disabled");
+            }
+            return row.running ? QString("Running") : QString("Stopped");
+        case ConnectionsColumn:
+            switch (row.testState) {
+            case Testing: return QString("Testing...");
+            case Online:  return QString("✓ Online");
+            case Offline: return QString("✗ Offline");
+            default:      return row.connections;
+            }
+        case DataColumn:
+            return formatBytes(row.bytes);
+        case ThroughputColumn: {
+            const ThroughputHistory* history = throughputHistory(index.row());
+            if (!history) {
+                return QString("-");
+            }
+            const ThroughputHistory::Sample latest = history->latest();
+            return QString("%1 Mbit/s").arg(
+                ThroughputHistory::toMbitPerSecond(quint64(latest.receivedBytes) + latest.sentBytes), 0, 'f', 2);
+        }
+        default:
+            return QVariant();
+        }
+    case Qt::BackgroundRole:
+        switch (index.column()) {
+        case BrandColumn:
+            if (camera.brand() == "Hikvision") {
+                return QColor(230, 250, 230); // Light green
+            } else if (camera.brand() == "CP Plus") {
+                return QColor(230, 230, 250); // Light blue
+            } else if (camera.brand() == "Generic") {
+                return QColor(250, 250, 230); // Light yellow
+            }
+            return QVariant();
+        case StatusColumn:
+            if (row.running) {
+                return QColor(144, 238, 144); // Light green
+            } else if (!camera.isEnabled()) {
+                return QColor(211, 211, 211); // Light gray
+            }
+            return QColor(255, 182, 193); // Light red
+        case ConnectionsColumn:
+            switch (row.testState) {
+            case Testing: return QColor(255, 255, 0);   // Yellow
+            case Online:  return QColor(144, 238, 144); // Light green
+            case Offline: return QColor(255, 182, 193); // Light red
+            default:
+                return row.connections > 0 ? QVariant(QColor(144, 238, 144)) : QVariant();
+            }
+        default:
+            return QVariant();
+        }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant CameraTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    static const QStringList headers = {"#", "Name", "Brand", "Model", "IP Address", "Port", "External Port",
+                                        "Status", "Connections", "Data Transferred", "Throughput",
+                                        "Actions"};
+    return headers.value(section);
+}
+
+QString CameraTableModel::cameraId(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows.at(row).camera.id() : QString();
+}
+
+CameraConfig CameraTableModel::camera(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows.at(row).camera : CameraConfig();
+}
+
+const ThroughputHistory* CameraTableModel::throughputHistory(int row) const
+{
+    if (row < 0 || row >= m_rows.size() || !m_rows.at(row).running) {
+        return nullptr;
+    }
+    return m_cameraManager->getPortForwarder()->getThroughputHistory(m_rows.at(row).camera.id());
+}
+
+void CameraTableModel::reload()
+{
+    const QList<CameraConfig> cameras = ConfigManager::instance().getAllCameras();
+
+    bool sameCameras = cameras.size() == m_rows.size();
+    for (int i = 0; sameCameras && i < cameras.size(); ++i) {
+        sameCameras = cameras.at(i).id() == m_rows.at(i).camera.id();
+    }
+
+    // Same cameras in the same order: keep the rows, and with them the
+    // selection and scroll position, and only repaint edited ones
+    if (sameCameras) {
+        for (int i = 0; i < cameras.size(); ++i) {
+            const CameraConfig& previous = m_rows.at(i).camera;
+            const CameraConfig& camera = cameras.at(i);
+            const bool edited = camera.name() != previous.name() || camera.brand() != previous.brand()
+                || camera.model() != previous.model() || camera.ipAddress() != previous.ipAddress()
+                || camera.port() != previous.port() || camera.externalPort() != previous.externalPort()
+                || camera.isEnabled() != previous.isEnabled();
+            m_rows[i].camera = camera;
+            if (edited) {
+                emitRowChanged(i, NameColumn, ActionsColumn);
+            }
+            refreshRow(i, nullptr);
+        }
+        return;
+    }
+
+    beginResetModel();
+    m_rows.clear();
+    m_rowById.clear();
+    m_rows.reserve(cameras.size());
+    for (const CameraConfig& camera : cameras) {
+        Row row;
+        row.camera = camera;
+        m_rowById.insert(camera.id(), m_rows.size());
+        m_rows.append(row);
+    }
+    for (int i = 0; i < m_rows.size(); ++i) {
+        Row& row = m_rows[i];
+        const QString id = row.camera.id();
+        row.running = m_cameraManager->isCameraRunning(id);
+        if (row.running) {
+            row.connections = m_cameraManager->getPortForwarder()->getConnectionCount(id);
+            row.bytes = static_cast<quint64>(m_cameraManager->getPortForwarder()->getBytesTransferred(id));
+        }
+    }
+    endResetModel();
+}
+
+void CameraTableModel::refreshCamera(const QString& cameraId)
+{
+    const int row = rowOf(cameraId);
+    if (row >= 0) {
+        refreshRow(row, nullptr);
+    }
+}
+
+void CameraTableModel::updateStatistics(const QHash<QString, TrafficSnapshot>& snapshots)
+{
+    for (int i = 0; i < m_rows.size(); ++i) {
+        // A finished test result stays up until the next statistics update
+        if (m_rows.at(i).testState == Online || m_rows.at(i).testState == Offline) {
+            m_rows[i].testState = NotTested;
+            emitRowChanged(i, ConnectionsColumn, ConnectionsColumn);
+        }
+        refreshRow(i, &snapshots);
+    }
+}
+
+void CameraTableModel::updateThroughput()
+{
+    for (int i = 0; i < m_rows.size(); ++i) {
+        const ThroughputHistory* history = throughputHistory(i);
+        // Once the sparkline is flat at zero a new empty sample changes nothing
+        if (history && history->idleSeconds() <= SPARKLINE_SECONDS) {
+            emitRowChanged(i, ThroughputColumn, ThroughputColumn);
+        }
+    }
+}
+
+void CameraTableModel::setTestState(const QString& cameraId, TestState state)
+{
+    const int row = rowOf(cameraId);
+    if (row < 0 || m_rows.at(row).testState == state) {
+        return;
+    }
+    m_rows[row].testState = state;
+    emitRowChanged(row, ConnectionsColumn, ConnectionsColumn);
+}
+
+QString CameraTableModel::formatBytes(quint64 bytes)
+{
+    if (bytes >= 1024ULL * 1024 * 1024) {
+        return QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
+    } else if (bytes >= 1024 * 1024) {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
+    } else if (bytes >= 1024) {
+        return QString::number(bytes / 1024.0, 'f', 2) + " KB";
+    }
+    return QString::number(bytes) + " B";
+}
+
+void CameraTableModel::refreshRow(int row, const QHash<QString, TrafficSnapshot>* snapshots)
+{
+    Row& current = m_rows[row];
+    const QString id = current.camera.id();
+
+    const bool running = m_cameraManager->isCameraRunning(id);
+    int connections = 0;
+    quint64 bytes = 0;
+    if (running) {
+        PortForwarder* forwarder = m_cameraManager->getPortForwarder();
+        connections = forwarder->getConnectionCount(id);
+        bytes = snapshots ? snapshots->value(id).totalBytes()
+                          : static_cast<quint64>(forwarder->getBytesTransferred(id));
+    }
+
+    int firstColumn = ColumnCount;
+    int lastColumn = -1;
+    if (running != current.running) {
+        firstColumn = StatusColumn;
+        lastColumn = ActionsColumn;
+    }
+    if (connections != current.connections) {
+        firstColumn = qMin<int>(firstColumn, ConnectionsColumn);
+        lastColumn = qMax<int>(lastColumn, ConnectionsColumn);
+    }
+    // Traffic on an active camera changes every tick, the text less often
+    if (bytes != current.bytes && formatBytes(bytes) != formatBytes(current.bytes)) {
+        firstColumn = qMin<int>(firstColumn, DataColumn);
+        lastColumn = qMax<int>(lastColumn, DataColumn);
+    }
+
+    current.running = running;
+    current.connections = connections;
+    current.bytes = bytes;
+    if (lastColumn >= 0) {
+        emitRowChanged(row, firstColumn, lastColumn);
+    }
+}
+
+void CameraTableModel::emitRowChanged(int row, int firstColumn, int lastColumn)
+{
+    emit dataChanged(index(row, firstColumn), index(row, lastColumn));
+}
+
+CameraThroughputDelegate::CameraThroughputDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void CameraThroughputDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    // Rate as right-aligned text, the sparkline in the space left of it
+    QStyledItemDelegate::paint(painter, option, index);
+
+    const CameraTableModel* model = qobject_cast<const CameraTableModel*>(index.model());
+    const ThroughputHistory* history = model ? model->throughputHistory(index.row()) : nullptr;
+    if (!history) {
+        return;
+    }
+    const int textWidth = option.fontMetrics.horizontalAdvance("000.00 Mbit/s") + 6;
+    const QRect sparkline = option.rect.adjusted(4, 4, -textWidth, -4);
+    ThroughputChart::paintSparkline(painter, sparkline, *history, CameraTableModel::SPARKLINE_SECONDS);
+}
+
+const int CameraActionDelegate::BUTTON_WIDTHS[CameraActionDelegate::ButtonCount] = { 50, 30, 40 };
+
+CameraActionDelegate::CameraActionDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_pressedButton(-1)
+{
+}
+
+void CameraActionDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    // Cell background and selection only, the buttons are drawn on top
+    QStyledItemDelegate::paint(painter, option, index);
+
+    QStyle* style = option.widget ? option.widget->style() : QApplication::style();
+    const bool running = index.data(CameraTableModel::RunningRole).toBool();
+    for (int button = 0; button < ButtonCount; ++button) {
+        QStyleOptionButton buttonOption;
+        buttonOption.rect = buttonRect(option.rect, button);
+        buttonOption.fontMetrics = option.fontMetrics;
+        buttonOption.state = QStyle::State_Raised;
+        if (isButtonEnabled(index, button)) {
+            buttonOption.state |= QStyle::State_Enabled;
+        }
+        switch (button) {
+        case StartStopButton: buttonOption.text = running ? "Stop" : "Start"; break;
+        case RestartButton:   buttonOption.text = "↻"; break;
+        case TestButton:      buttonOption.text = "Test"; break;
+        }
+        style->drawControl(QStyle::CE_PushButton, &buttonOption, painter, option.widget);
+    }
+}
+
+QSize CameraActionDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    Q_UNUSED(index)
+    int width = BUTTON_MARGIN * 2 + BUTTON_SPACING * (ButtonCount - 1);
+    for (int button = 0; button < ButtonCount; ++button) {
+        width += BUTTON_WIDTHS[button];
+    }
+    return QSize(width, option.fontMetrics.height() + 10 + BUTTON_MARGIN * 2);
+}
+
+bool CameraActionDelegate::editorEvent(QEvent* event, QAbstractItemModel* model, const QStyleOptionViewItem& option,
+                                       const QModelIndex& index)
+{
+    if (event->type() != QEvent::MouseButtonPress && event->type() != QEvent::MouseButtonRelease) {
+        return QStyledItemDelegate::editorEvent(event, model, option, index);
+    }
+
+    const QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+    int button = -1;
+    for (int i = 0; i < ButtonCount; ++i) {
+        if (buttonRect(option.rect, i).contains(mouseEvent->position().toPoint()) && isButtonEnabled(index, i)) {
+            button = i;
+            break;
+        }
+    }
+
+    if (event->type() == QEvent::MouseButtonPress) {
+        m_pressedIndex = index;
+        m_pressedButton = button;
+        return button >= 0 ? false : QStyledItemDelegate::editorEvent(event, model, option, index);
+    }
+
+    // A click is a press and release on the same button
+    const bool clicked = button >= 0 && button == m_pressedButton && index == m_pressedIndex;
+    m_pressedIndex = QPersistentModelIndex();
+    m_pressedButton = -1;
+    if (!clicked) {
+        return false;
+    }
+
+    const QString cameraId = index.data(CameraTableModel::CameraIdRole).toString();
+    switch (button) {
+    case StartStopButton: emit startStopClicked(cameraId); break;
+    case RestartButton:   emit restartClicked(cameraId); break;
+    case TestButton:      emit testClicked(cameraId); break;
+    }
+    return true;
+}
+
+bool CameraActionDelegate::helpEvent(QHelpEvent* event, QAbstractItemView* view, const QStyleOptionViewItem& option,
+                                     const QModelIndex& index)
+{
+    if (event->type() == QEvent::ToolTip && buttonRect(option.rect, RestartButton).contains(event->pos())) {
+        QToolTip::showText(event->globalPos(), "Restart Port Forwarding", view);
+        return true;
+    }
+    return QStyledItemDelegate::helpEvent(event, view, option, index);
+}
+
+QRect CameraActionDelegate::buttonRect(const QRect& cell, int button)
+{
+    int left = cell.left() + BUTTON_MARGIN;
+    for (int i = 0; i < button; ++i) {
+        left += BUTTON_WIDTHS[i] + BUTTON_SPACING;
+    }
+    return QRect(left, cell.top() + BUTTON_MARGIN, BUTTON_WIDTHS[button], cell.height() - BUTTON_MARGIN * 2);
+}
+
+bool CameraActionDelegate::isButtonEnabled(const QModelIndex& index, int button)
+{
+    switch (button) {
+    case StartStopButton: return index.data(CameraTableModel::EnabledRole).toBool();
+    case RestartButton:   return index.data(CameraTableModel::RunningRole).toBool();
+    default:              return true;
+    }
+}
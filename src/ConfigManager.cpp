@@ -1,5 +1,6 @@
 #include "ConfigManager.h"
 #include "Logger.h"
+#include "BinaryLog.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -17,6 +18,24 @@ ConfigManager::ConfigManager()
     : m_autoStartEnabled(false)
     , m_echoServerEnabled(true)
     , m_echoServerPort(7777)
+    , m_echoServerMode("standard")
+    , m_echoServerMaxConnections(50)
+    , m_udpEchoServerEnabled(false)
+    , m_udpEchoServerPort(7778)
+    , m_relayBackend("userspace")
+    , m_relayPayloadInspection(false)
+    , m_forwardingThreads(-1)
+    , m_forwardingShardMode("camera")
+    , m_forwardingCpuPinning(false)
+    , m_statsUpdateIntervalMs(2000)
+    , m_udpRelayEnabled(false)
+    , m_udpRelayPortMin(40000)
+    , m_udpRelayPortMax(40999)
+    , m_logMaxFileSizeMb(10)
+    , m_logRotationHours(24)
+    , m_logRetainedFiles(10)
+    , m_logCompressionEnabled(true)
+    , m_binaryDebugLogEnabled(false)
 {
     // Set up file paths
     QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
@@ -24,6 +43,7 @@ ConfigManager::ConfigManager()
     
     m_configFilePath = appDataPath + "/config.json";
     m_logFilePath = appDataPath + "/visco-connect.log";
+    m_binaryLogFilePath = appDataPath + "/visco-connect.vlog";
 }
 
 ConfigManager::~ConfigManager()
@@ -67,6 +87,26 @@ bool ConfigManager::loadConfig()
     m_autoStartEnabled = root["autoStart"].toBool(false);
     m_echoServerEnabled = root["echoServerEnabled"].toBool(true);
     m_echoServerPort = root["echoServerPort"].toInt(7777);
+    m_echoServerMode = root["echoServerMode"].toString("standard");
+    m_echoServerMaxConnections = root["echoServerMaxConnections"].toInt(50);
+    m_udpEchoServerEnabled = root["udpEchoServerEnabled"].toBool(false);
+    m_udpEchoServerPort = root["udpEchoServerPort"].toInt(7778);
+    m_relayBackend = root["relayBackend"].toString("userspace");
+    m_relayPayloadInspection = root["relayPayloadInspection"].toBool(false);
+    m_forwardingThreads = root["forwardingThreads"].toInt(-1);
+    m_forwardingShardMode = root["forwardingShardMode"].toString("camera");
+    m_forwardingCpuPinning = root["forwardingCpuPinning"].toBool(false);
+    m_statsUpdateIntervalMs = root["statsUpdateIntervalMs"].toInt(2000);
+    m_udpRelayEnabled = root["udpRelayEnabled"].toBool(false);
+    m_udpRelayPortMin = root["udpRelayPortMin"].toInt(40000);
+    m_udpRelayPortMax = root["udpRelayPortMax"].toInt(40999);
+    m_logMaxFileSizeMb = root["logMaxFileSizeMb"].toInt(10);
+    m_logRotationHours = root["logRotationHours"].toInt(24);
+    m_logRetainedFiles = root["logRetainedFiles"].toInt(10);
+    m_logCompressionEnabled = root["logCompression"].toBool(true);
+    m_binaryDebugLogEnabled = root["binaryDebugLog"].toBool(false);
+    applyLogRotation();
+    applyBinaryDebugLog();
     
     // Load cameras
     m_cameras.clear();
@@ -88,6 +128,24 @@ bool ConfigManager::saveConfig()
     root["autoStart"] = m_autoStartEnabled;
     root["echoServerEnabled"] = m_echoServerEnabled;
     root["echoServerPort"] = m_echoServerPort;
+    root["echoServerMode"] = m_echoServerMode;
+    root["echoServerMaxConnections"] = m_echoServerMaxConnections;
+    root["udpEchoServerEnabled"] = m_udpEchoServerEnabled;
+    root["udpEchoServerPort"] = m_udpEchoServerPort;
+    root["relayBackend"] = m_relayBackend;
+    root["relayPayloadInspection"] = m_relayPayloadInspection;
+    root["forwardingThreads"] = m_forwardingThreads;
+    root["forwardingShardMode"] = m_forwardingShardMode;
+    root["forwardingCpuPinning"] = m_forwardingCpuPinning;
+    root["statsUpdateIntervalMs"] = m_statsUpdateIntervalMs;
+    root["udpRelayEnabled"] = m_udpRelayEnabled;
+    root["udpRelayPortMin"] = m_udpRelayPortMin;
+    root["udpRelayPortMax"] = m_udpRelayPortMax;
+    root["logMaxFileSizeMb"] = m_logMaxFileSizeMb;
+    root["logRotationHours"] = m_logRotationHours;
+    root["logRetainedFiles"] = m_logRetainedFiles;
+    root["logCompression"] = m_logCompressionEnabled;
+    root["binaryDebugLog"] = m_binaryDebugLogEnabled;
     
     // Save cameras
     QJsonArray camerasArray;
@@ -213,6 +271,214 @@ void ConfigManager::setEchoServerPort(int port)
     }
 }
 
+void ConfigManager::setEchoServerMode(const QString& mode)
+{
+    if (mode != "standard" && mode != "scalable") {
+        LOG_WARNING(QString("Invalid echo server mode: %1").arg(mode), "Config");
+        return;
+    }
+    
+    if (m_echoServerMode != mode) {
+        m_echoServerMode = mode;
+        saveConfig();
+        
+        LOG_INFO(QString("Echo server mode changed to %1").arg(mode), "Config");
+    }
+}
+
+void ConfigManager::setEchoServerMaxConnections(int maxConnections)
+{
+    if (maxConnections < 1 || maxConnections > 100000) {
+        LOG_WARNING(QString("Invalid echo server connection limit: %1").arg(maxConnections), "Config");
+        return;
+    }
+    
+    if (m_echoServerMaxConnections != maxConnections) {
+        m_echoServerMaxConnections = maxConnections;
+        saveConfig();
+        
+        LOG_INFO(QString("Echo server connection limit changed to %1").arg(maxConnections), "Config");
+    }
+}
+
+void ConfigManager::setUdpEchoServerEnabled(bool enabled)
+{
+    if (m_udpEchoServerEnabled != enabled) {
+        m_udpEchoServerEnabled = enabled;
+        saveConfig();
+        
+        LOG_INFO(QString("UDP echo server %1").arg(enabled ? "enabled" : "disabled"), "Config");
+        emit configChanged();
+    }
+}
+
+void ConfigManager::setUdpEchoServerPort(int port)
+{
+    if (port < 1 || port > 65535) {
+        LOG_WARNING(QString("Invalid UDP echo server port: %1").arg(port), "Config");
+        return;
+    }
+    
+    if (m_udpEchoServerPort != port) {
+        m_udpEchoServerPort = port;
+        saveConfig();
+        
+        LOG_INFO(QString("UDP echo server port changed to %1").arg(port), "Config");
+        emit configChanged();
+    }
+}
+
+void ConfigManager::setRelayBackend(const QString& backend)
+{
+    if (backend != "userspace" && backend != "splice") {
+        LOG_WARNING(QString("Invalid relay backend: %1").arg(backend), "Config");
+        return;
+    }
+    
+    if (m_relayBackend != backend) {
+        m_relayBackend = backend;
+        saveConfig();
+        
+        LOG_INFO(QString("Relay backend changed to %1").arg(backend), "Config");
+    }
+}
+
+void ConfigManager::setRelayPayloadInspectionEnabled(bool enabled)
+{
+    if (m_relayPayloadInspection != enabled) {
+        m_relayPayloadInspection = enabled;
+        saveConfig();
+        
+        LOG_INFO(QString("Relay payload inspection %1").arg(enabled ? "enabled" : "disabled"), "Config");
+    }
+}
+
+void ConfigManager::setForwardingThreads(int threads)
+{
+    if (threads < -1) {
+        LOG_WARNING(QString("Invalid forwarding thread count: %1").arg(threads), "Config");
+        return;
+    }
+    
+    if (m_forwardingThreads != threads) {
+        m_forwardingThreads = threads;
+        saveConfig();
+        
+        LOG_INFO(QString("Forwarding threads changed to %1").arg(threads), "Config");
+    }
+}
+
+void ConfigManager::setForwardingShardMode(const QString& mode)
+{
+    if (mode != "camera" && mode != "connection") {
+        LOG_WARNING(QString("Invalid forwarding shard mode: %1").arg(mode), "Config");
+        return;
+    }
+    
+    if (m_forwardingShardMode != mode) {
+        m_forwardingShardMode = mode;
+        saveConfig();
+        
+        LOG_INFO(QString("Forwarding shard mode changed to %1").arg(mode), "Config");
+    }
+}
+
+void ConfigManager::setForwardingCpuPinningEnabled(bool enabled)
+{
+    if (m_forwardingCpuPinning != enabled) {
+        m_forwardingCpuPinning = enabled;
+        saveConfig();
+        
+        LOG_INFO(QString("Forwarding CPU pinning %1").arg(enabled ? "enabled" : "disabled"), "Config");
+    }
+}
+
+void ConfigManager::setStatsUpdateIntervalMs(int intervalMs)
+{
+    if (intervalMs <= 0) {
+        LOG_WARNING(QString("Invalid statistics update interval: %1 ms").arg(intervalMs), "Config");
+        return;
+    }
+    
+    if (m_statsUpdateIntervalMs != intervalMs) {
+        m_statsUpdateIntervalMs = intervalMs;
+        saveConfig();
+        
+        LOG_INFO(QString("Statistics update interval changed to %1 ms").arg(intervalMs), "Config");
+    }
+}
+
+void ConfigManager::setUdpRelayEnabled(bool enabled)
+{
+    if (m_udpRelayEnabled != enabled) {
+        m_udpRelayEnabled = enabled;
+        saveConfig();
+        
+        LOG_INFO(QString("UDP media relay %1").arg(enabled ? "enabled" : "disabled"), "Config");
+    }
+}
+
+void ConfigManager::setUdpRelayPortRange(int minPort, int maxPort)
+{
+    // Each stream takes two RTP/RTCP pairs
+    if (minPort < 1024 || maxPort > 65535 || maxPort - minPort < 3) {
+        LOG_WARNING(QString("Invalid UDP relay port range: %1-%2").arg(minPort).arg(maxPort), "Config");
+        return;
+    }
+    
+    if (m_udpRelayPortMin != minPort || m_udpRelayPortMax != maxPort) {
+        m_udpRelayPortMin = minPort;
+        m_udpRelayPortMax = maxPort;
+        saveConfig();
+        
+        LOG_INFO(QString("UDP relay port range changed to %1-%2").arg(minPort).arg(maxPort), "Config");
+    }
+}
+
+void ConfigManager::setLogRotation(int maxFileSizeMb, int rotationHours, int retainedFiles)
+{
+    // 0 turns size or time based rotation off
+    if (maxFileSizeMb < 0 || rotationHours < 0 || retainedFiles < 0) {
+        LOG_WARNING(QString("Invalid log rotation settings: %1 MB, %2 hours, %3 files")
+                    .arg(maxFileSizeMb).arg(rotationHours).arg(retainedFiles), "Config");
+        return;
+    }
+    
+    if (m_logMaxFileSizeMb != maxFileSizeMb || m_logRotationHours != rotationHours ||
+        m_logRetainedFiles != retainedFiles) {
+        m_logMaxFileSizeMb = maxFileSizeMb;
+        m_logRotationHours = rotationHours;
+        m_logRetainedFiles = retainedFiles;
+        saveConfig();
+        applyLogRotation();
+        
+        LOG_INFO(QString("Log rotation changed to %1 MB / %2 hours, keeping %3 files")
+                 .arg(maxFileSizeMb).arg(rotationHours).arg(retainedFiles), "Config");
+    }
+}
+
+void ConfigManager::setLogCompressionEnabled(bool enabled)
+{
+    if (m_logCompressionEnabled != enabled) {
+        m_logCompressionEnabled = enabled;
+        saveConfig();
+        applyLogRotation();
+        
+        LOG_INFO(QString("Rotated log compression %1").arg(enabled ? "enabled" : "disabled"), "Config");
+    }
+}
+
+void ConfigManager::setBinaryDebugLogEnabled(bool enabled)
+{
+    if (m_binaryDebugLogEnabled != enabled) {
+        m_binaryDebugLogEnabled = enabled;
+        saveConfig();
+        applyBinaryDebugLog();
+        
+        LOG_INFO(QString("Binary debug log %1").arg(enabled ? "enabled" : "disabled"), "Config");
+    }
+}
+
 int ConfigManager::getNextExternalPort() const
 {
     int maxPort = 8550; // Start from 8551
@@ -231,17 +497,47 @@ QString ConfigManager::getConfigFilePath() const
     return m_configFilePath;
 }
 
+void ConfigManager::setConfigFilePath(const QString& filePath)
+{
+    m_configFilePath = filePath;
+}
+
 QString ConfigManager::getLogFilePath() const
 {
     return m_logFilePath;
 }
 
+QString ConfigManager::getBinaryLogFilePath() const
+{
+    return m_binaryLogFilePath;
+}
+
 void ConfigManager::createDefaultConfig()
 {
     m_cameras.clear();
     m_autoStartEnabled = false;
     m_echoServerEnabled = true;
     m_echoServerPort = 7777;
+    m_echoServerMode = "standard";
+    m_echoServerMaxConnections = 50;
+    m_udpEchoServerEnabled = false;
+    m_udpEchoServerPort = 7778;
+    m_relayBackend = "userspace";
+    m_relayPayloadInspection = false;
+    m_forwardingThreads = -1;
+    m_forwardingShardMode = "camera";
+    m_forwardingCpuPinning = false;
+    m_statsUpdateIntervalMs = 2000;
+    m_udpRelayEnabled = false;
+    m_udpRelayPortMin = 40000;
+    m_udpRelayPortMax = 40999;
+    m_logMaxFileSizeMb = 10;
+    m_logRotationHours = 24;
+    m_logRetainedFiles = 10;
+    m_logCompressionEnabled = true;
+    m_binaryDebugLogEnabled = false;
+    applyLogRotation();
+    applyBinaryDebugLog();
     
     LOG_INFO("Created default configuration", "Config");
 }
@@ -260,3 +556,19 @@ void ConfigManager::updateWindowsAutoStart()
     }
 #endif
 }
+
+void ConfigManager::applyLogRotation()
+{
+    Logger::instance().setRotation(static_cast<qint64>(m_logMaxFileSizeMb) * 1024 * 1024,
+                                   static_cast<qint64>(m_logRotationHours) * 60 * 60 * 1000,
+                                   m_logRetainedFiles, m_logCompressionEnabled);
+}
+
+void ConfigManager::applyBinaryDebugLog()
+{
+    if (m_binaryDebugLogEnabled) {
+        BinaryLog::instance().open(m_binaryLogFilePath, LogLevel::Debug);
+    } else {
+        BinaryLog::instance().close();
+    }
+}
@@ -1,10 +1,14 @@
 #include "EchoServer.h"
+#include "EpollEchoLoop.h"
 #include "Logger.h"
 #include <QDebug>
 
 EchoServer::EchoServer(QObject *parent)
     : QObject(parent)
     , m_server(new QTcpServer(this))
+    , m_epollLoop(nullptr)
+    , m_mode(Mode::Standard)
+    , m_maxConnections(DEFAULT_MAX_CONNECTIONS)
     , m_totalBytesReceived(0)
     , m_totalBytesSent(0)
     , m_totalConnections(0)
@@ -17,6 +21,26 @@ EchoServer::~EchoServer()
     stopServer();
 }
 
+void EchoServer::setMode(Mode mode)
+{
+    m_mode = mode;
+}
+
+void EchoServer::setMaxConnections(int maxConnections)
+{
+    m_maxConnections = qBound(1, maxConnections, int(MAX_CONNECTIONS_LIMIT));
+}
+
+QString EchoServer::modeToString(Mode mode)
+{
+    return mode == Mode::Scalable ? "scalable" : "standard";
+}
+
+EchoServer::Mode EchoServer::modeFromString(const QString& mode)
+{
+    return mode == "scalable" ? Mode::Scalable : Mode::Standard;
+}
+
 bool EchoServer::startServer(quint16 port, const QHostAddress& address)
 {
     if (isRunning()) {
@@ -24,6 +48,13 @@ bool EchoServer::startServer(quint16 port, const QHostAddress& address)
         return true;
     }
     
+    if (m_mode == Mode::Scalable) {
+        if (EpollEchoLoop::isSupported()) {
+            return startEpollLoop(port, address);
+        }
+        LOG_WARNING("Echo server: scalable mode needs Linux, using the standard mode", "EchoServer");
+    }
+    
     if (!m_server->listen(address, port)) {
         const QString error = QString("Failed to start echo server on %1:%2 - %3")
                               .arg(address.toString())
@@ -35,6 +66,8 @@ bool EchoServer::startServer(quint16 port, const QHostAddress& address)
     }
     
     resetStatistics();
+    delete m_epollLoop;  // Statistics come from the QTcpServer clients again
+    m_epollLoop = nullptr;
     
     LOG_INFO(QString("Echo server started on %1:%2")
              .arg(address.toString())
@@ -44,10 +77,52 @@ bool EchoServer::startServer(quint16 port, const QHostAddress& address)
     return true;
 }
 
+bool EchoServer::startEpollLoop(quint16 port, const QHostAddress& address)
+{
+    if (!m_epollLoop) {
+        m_epollLoop = new EpollEchoLoop(this);
+        // Emitted on the loop thread, delivered queued
+        connect(m_epollLoop, &EpollEchoLoop::clientConnected, this, &EchoServer::clientConnected);
+        connect(m_epollLoop, &EpollEchoLoop::clientDisconnected, this, &EchoServer::clientDisconnected);
+    }
+    
+    QString errorString;
+    if (!m_epollLoop->start(address, port, m_maxConnections, &errorString)) {
+        const QString error = QString("Failed to start echo server on %1:%2 - %3")
+                              .arg(address.toString())
+                              .arg(port)
+                              .arg(errorString);
+        LOG_ERROR(error, "EchoServer");
+        emit errorOccurred(error);
+        return false;
+    }
+    
+    LOG_INFO(QString("Echo server started on %1:%2 (scalable mode, up to %3 clients)")
+             .arg(address.toString())
+             .arg(m_epollLoop->serverPort())
+             .arg(m_maxConnections), "EchoServer");
+    
+    emit serverStarted(m_epollLoop->serverPort());
+    return true;
+}
+
 void EchoServer::stopServer()
 {
     if (!isRunning()) return;
     
+    if (m_epollLoop && m_epollLoop->isRunning()) {
+        m_epollLoop->stop();
+        
+        LOG_INFO(QString("Echo server stopped. Statistics: %1 connections, %2 rejected, %3 bytes received, %4 bytes sent")
+                 .arg(m_epollLoop->totalConnections())
+                 .arg(m_epollLoop->rejectedConnections())
+                 .arg(m_epollLoop->totalBytesReceived())
+                 .arg(m_epollLoop->totalBytesSent()), "EchoServer");
+        
+        emit serverStopped();
+        return;
+    }
+    
     // Disconnect all clients
     const auto clients = m_clients.keys();
     for (QTcpSocket* client : clients) {
@@ -68,37 +143,42 @@ void EchoServer::stopServer()
 
 bool EchoServer::isRunning() const
 {
-    return m_server->isListening();
+    return m_server->isListening() || (m_epollLoop && m_epollLoop->isRunning());
+}
+
+bool EchoServer::usesEpollLoop() const
+{
+    return m_epollLoop != nullptr;
 }
 
 quint16 EchoServer::serverPort() const
 {
-    return m_server->serverPort();
+    return usesEpollLoop() ? m_epollLoop->serverPort() : m_server->serverPort();
 }
 
 QHostAddress EchoServer::serverAddress() const
 {
-    return m_server->serverAddress();
+    return usesEpollLoop() ? m_epollLoop->serverAddress() : m_server->serverAddress();
 }
 
 int EchoServer::connectionCount() const
 {
-    return m_clients.size();
+    return usesEpollLoop() ? m_epollLoop->connectionCount() : m_clients.size();
 }
 
 quint64 EchoServer::totalBytesReceived() const
 {
-    return m_totalBytesReceived;
+    return usesEpollLoop() ? m_epollLoop->totalBytesReceived() : m_totalBytesReceived;
 }
 
 quint64 EchoServer::totalBytesSent() const
 {
-    return m_totalBytesSent;
+    return usesEpollLoop() ? m_epollLoop->totalBytesSent() : m_totalBytesSent;
 }
 
 quint64 EchoServer::totalConnections() const
 {
-    return m_totalConnections;
+    return usesEpollLoop() ? m_epollLoop->totalConnections() : m_totalConnections;
 }
 
 void EchoServer::handleNewConnection()
@@ -106,7 +186,7 @@ void EchoServer::handleNewConnection()
     while (m_server->hasPendingConnections()) {
         QTcpSocket* client = m_server->nextPendingConnection();
         
-        if (m_clients.size() >= MAX_CONCURRENT_CONNECTIONS) {
+        if (m_clients.size() >= m_maxConnections) {
             LOG_WARNING("Echo server: Maximum connections reached, rejecting client", "EchoServer");
             client->disconnectFromHost();
             client->deleteLater();
@@ -163,21 +243,28 @@ void EchoServer::handleClientDataReady()
     QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
     if (!client || !m_clients.contains(client)) return;
     
-    const QByteArray data = client->readAll();
-    if (data.isEmpty()) return;
-    
-    m_totalBytesReceived += data.size();
-    
-    // Echo the data back to the client
-    const qint64 bytesWritten = client->write(data);
-    if (bytesWritten > 0) {
-        m_totalBytesSent += bytesWritten;
+    // Echo the data back to the client, one pooled slab at a time
+    RelayBufferPool::Buffer buffer(m_bufferPool);
+    qint64 bytesEchoed = 0;
+    while (client->bytesAvailable() > 0) {
+        const qint64 bytesRead = client->read(buffer.data(), static_cast<qint64>(buffer.size()));
+        if (bytesRead <= 0) break;
         
+        m_totalBytesReceived += bytesRead;
+        
+        const qint64 bytesWritten = client->write(buffer.data(), bytesRead);
+        if (bytesWritten <= 0) break;
+        
+        m_totalBytesSent += bytesWritten;
+        bytesEchoed += bytesWritten;
+    }
+    
+    if (bytesEchoed > 0) {
         const QString clientAddress = m_clients[client];
-        emit dataEchoed(clientAddress, static_cast<int>(bytesWritten));
+        emit dataEchoed(clientAddress, static_cast<int>(bytesEchoed));
         
         LOG_DEBUG(QString("Echo server: Echoed %1 bytes to %2")
-                  .arg(bytesWritten)
+                  .arg(bytesEchoed)
                   .arg(clientAddress), "EchoServer");
     }
 }
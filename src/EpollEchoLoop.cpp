@@ -0,0 +1,464 @@
+#include "EpollEchoLoop.h"
+#include "Logger.h"
+#include <QThread>
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+qint64 steadyMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+EpollEchoLoop::EpollEchoLoop(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_listenFd(-1)
+    , m_epollFd(-1)
+    , m_wakeFd(-1)
+    , m_maxConnections(0)
+    , m_port(0)
+    , m_wheelPosition(0)
+    , m_lastRejectLogMs(0)
+    , m_connectionCount(0)
+    , m_totalBytesReceived(0)
+    , m_totalBytesSent(0)
+    , m_totalConnections(0)
+    , m_rejectedConnections(0)
+{
+}
+
+EpollEchoLoop::~EpollEchoLoop()
+{
+    stop();
+}
+
+bool EpollEchoLoop::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool EpollEchoLoop::start(const QHostAddress& address, quint16 port, int maxConnections, QString* errorString)
+{
+#ifdef Q_OS_LINUX
+    if (m_thread) {
+        return true;
+    }
+
+    auto fail = [this, errorString](const QString& step) {
+        if (errorString) {
+            *errorString = QString("%1: %2").arg(step, QString::fromLocal8Bit(strerror(errno)));
+        }
+        closeDescriptors();
+        return false;
+    };
+
+    // QHostAddress::Any listens on IPv6 and IPv4 like QTcpServer does
+    const bool dualStack = address == QHostAddress(QHostAddress::Any);
+    const bool ipv6 = dualStack || address.protocol() == QAbstractSocket::IPv6Protocol;
+    m_listenFd = ::socket(ipv6 ? AF_INET6 : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0 && dualStack) {
+        return start(QHostAddress::AnyIPv4, port, maxConnections, errorString);
+    }
+    if (m_listenFd < 0) {
+        return fail("socket");
+    }
+
+    const int on = 1;
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_storage storage;
+    memset(&storage, 0, sizeof(storage));
+    socklen_t length = 0;
+    if (ipv6) {
+        const int off = 0;
+        ::setsockopt(m_listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+        sockaddr_in6* address6 = reinterpret_cast<sockaddr_in6*>(&storage);
+        address6->sin6_family = AF_INET6;
+        address6->sin6_port = htons(port);
+        if (!dualStack) {
+            const Q_IPV6ADDR bytes = address.toIPv6Address();
+            memcpy(&address6->sin6_addr, &bytes, sizeof(bytes));
+        }
+        length = sizeof(sockaddr_in6);
+    } else {
+        sockaddr_in* address4 = reinterpret_cast<sockaddr_in*>(&storage);
+        address4->sin_family = AF_INET;
+        address4->sin_port = htons(port);
+        address4->sin_addr.s_addr = htonl(address.toIPv4Address());
+        length = sizeof(sockaddr_in);
+    }
+
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+        return fail("bind");
+    }
+    if (::listen(m_listenFd, LISTEN_BACKLOG) != 0) {
+        return fail("listen");
+    }
+    length = sizeof(storage);
+    if (::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&storage), &length) == 0) {
+        m_port = ntohs(storage.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&storage)->sin6_port
+                                                     : reinterpret_cast<sockaddr_in*>(&storage)->sin_port);
+    }
+    m_address = address;
+
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        return fail("epoll_create1");
+    }
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        return fail("eventfd");
+    }
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = &m_listenFd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) != 0) {
+        return fail("epoll_ctl");
+    }
+    event.events = EPOLLIN;
+    event.data.ptr = &m_wakeFd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) != 0) {
+        return fail("epoll_ctl");
+    }
+
+    m_maxConnections = qMax(maxConnections, 1);
+    m_wheel.assign(WHEEL_SLOTS, nullptr);
+    m_wheelPosition = 0;
+    m_readBuffer.resize(READ_BUFFER_SIZE);
+    m_connectionCount.store(0);
+    m_totalBytesReceived.store(0);
+    m_totalBytesSent.store(0);
+    m_totalConnections.store(0);
+    m_rejectedConnections.store(0);
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("EchoLoop");
+    m_thread->start();
+    return true;
+#else
+    Q_UNUSED(address);
+    Q_UNUSED(port);
+    Q_UNUSED(maxConnections);
+    if (errorString) {
+        *errorString = "epoll is only available on Linux";
+    }
+    return false;
+#endif
+}
+
+void EpollEchoLoop::stop()
+{
+#ifdef Q_OS_LINUX
+    if (!m_thread) {
+        return;
+    }
+
+    const quint64 one = 1;
+    const ssize_t written = ::write(m_wakeFd, &one, sizeof(one));
+    Q_UNUSED(written);
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    closeDescriptors();
+#endif
+}
+
+void EpollEchoLoop::run()
+{
+#ifdef Q_OS_LINUX
+    epoll_event events[MAX_EVENTS];
+    qint64 nextTickMs = steadyMs() + 1000;
+    bool running = true;
+
+    while (running) {
+        const int timeoutMs = static_cast<int>(qMax<qint64>(0, nextTickMs - steadyMs()));
+        const int count = ::epoll_wait(m_epollFd, events, MAX_EVENTS, timeoutMs);
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR(QString("Echo server: epoll_wait failed - %1").arg(strerror(errno)), "EchoServer");
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            void* tag = events[i].data.ptr;
+            if (tag == &m_wakeFd) {
+                running = false;
+            } else if (tag == &m_listenFd) {
+                acceptClients();
+            } else {
+                Client* client = static_cast<Client*>(tag);
+                const quint32 flags = events[i].events;
+                if (flags & EPOLLERR) {
+                    closeClient(client);
+                    continue;
+                }
+                if ((flags & EPOLLOUT) && !flushClient(client)) {
+                    continue;
+                }
+                if ((flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !client->readBlocked) {
+                    readClient(client);
+                }
+            }
+        }
+
+        const qint64 now = steadyMs();
+        if (now >= nextTickMs) {
+            while (now >= nextTickMs) {
+                m_wheelPosition = (m_wheelPosition + 1) % WHEEL_SLOTS;
+                expireSlot(m_wheelPosition);
+                nextTickMs += 1000;
+            }
+            // Edge-triggered: connections left queued after EMFILE are only
+            // picked up by another accept attempt
+            acceptClients();
+        }
+    }
+
+    // Quietly drop the remaining clients, as EchoServer::stopServer() does
+    for (int slot = 0; slot < WHEEL_SLOTS; ++slot) {
+        while (Client* client = m_wheel[slot]) {
+            m_wheel[slot] = client->wheelNext;
+            ::close(client->fd);
+            delete client;
+        }
+    }
+    m_connectionCount.store(0);
+#endif
+}
+
+void EpollEchoLoop::acceptClients()
+{
+#ifdef Q_OS_LINUX
+    for (;;) {
+        sockaddr_storage peer;
+        socklen_t peerLength = sizeof(peer);
+        const int fd = ::accept4(m_listenFd, reinterpret_cast<sockaddr*>(&peer), &peerLength,
+                                 SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARNING(QString("Echo server: accept failed - %1").arg(strerror(errno)), "EchoServer");
+            }
+            return;
+        }
+
+        if (m_connectionCount.load(std::memory_order_relaxed) >= m_maxConnections) {
+            ::close(fd);
+            m_rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+            const qint64 now = steadyMs();
+            if (now - m_lastRejectLogMs >= 1000) {
+                m_lastRejectLogMs = now;
+                LOG_WARNING(QString("Echo server: Maximum connections (%1) reached, rejecting clients (%2 so far)")
+                            .arg(m_maxConnections).arg(rejectedConnections()), "EchoServer");
+            }
+            continue;
+        }
+
+        const int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        Client* client = new Client;
+        client->fd = fd;
+        const quint16 peerPort = ntohs(peer.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&peer)->sin6_port
+                                                                  : reinterpret_cast<sockaddr_in*>(&peer)->sin_port);
+        client->address = QString("%1:%2")
+                          .arg(QHostAddress(reinterpret_cast<sockaddr*>(&peer)).toString())
+                          .arg(peerPort);
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = client;
+        if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG_WARNING(QString("Echo server: epoll_ctl failed - %1").arg(strerror(errno)), "EchoServer");
+            ::close(fd);
+            delete client;
+            continue;
+        }
+
+        // Expires when the wheel comes round to this slot, 30 to 31 seconds from now
+        const int slot = (m_wheelPosition + CLIENT_TIMEOUT_MS / 1000 + 1) % WHEEL_SLOTS;
+        client->wheelSlot = slot;
+        client->wheelNext = m_wheel[slot];
+        if (client->wheelNext) {
+            client->wheelNext->wheelPrev = client;
+        }
+        m_wheel[slot] = client;
+
+        const int connections = m_connectionCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        m_totalConnections.fetch_add(1, std::memory_order_relaxed);
+
+        LOG_DEBUG(QString("Echo server: New client connected from %1 (total: %2)")
+                  .arg(client->address)
+                  .arg(connections), "EchoServer");
+
+        emit clientConnected(client->address);
+    }
+#endif
+}
+
+bool EpollEchoLoop::readClient(Client* client)
+{
+#ifdef Q_OS_LINUX
+    // Edge-triggered: read until the socket is drained or the echo backs up
+    for (;;) {
+        if (client->pending.size() - client->pendingOffset >= static_cast<size_t>(MAX_PENDING_BYTES)) {
+            client->readBlocked = true;
+            return true;
+        }
+
+        const ssize_t bytesRead = ::read(client->fd, m_readBuffer.data(), m_readBuffer.size());
+        if (bytesRead == 0) {
+            client->peerClosed = true;
+            if (client->pending.size() == client->pendingOffset) {
+                closeClient(client);
+                return false;
+            }
+            return true;
+        }
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeClient(client);
+                return false;
+            }
+            return true;
+        }
+        m_totalBytesReceived.fetch_add(static_cast<quint64>(bytesRead), std::memory_order_relaxed);
+
+        ssize_t bytesSent = 0;
+        if (client->pending.size() == client->pendingOffset) {
+            bytesSent = ::send(client->fd, m_readBuffer.data(), static_cast<size_t>(bytesRead), MSG_NOSIGNAL);
+            if (bytesSent < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    closeClient(client);
+                    return false;
+                }
+                bytesSent = 0;
+            }
+            m_totalBytesSent.fetch_add(static_cast<quint64>(bytesSent), std::memory_order_relaxed);
+        }
+        if (bytesSent < bytesRead) {
+            client->pending.insert(client->pending.end(), m_readBuffer.data() + bytesSent,
+                                   m_readBuffer.data() + bytesRead);
+        }
+    }
+#else
+    Q_UNUSED(client);
+    return false;
+#endif
+}
+
+bool EpollEchoLoop::flushClient(Client* client)
+{
+#ifdef Q_OS_LINUX
+    while (client->pendingOffset < client->pending.size()) {
+        const ssize_t bytesSent = ::send(client->fd, client->pending.data() + client->pendingOffset,
+                                         client->pending.size() - client->pendingOffset, MSG_NOSIGNAL);
+        if (bytesSent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            closeClient(client);
+            return false;
+        }
+        client->pendingOffset += static_cast<size_t>(bytesSent);
+        m_totalBytesSent.fetch_add(static_cast<quint64>(bytesSent), std::memory_order_relaxed);
+    }
+
+    // Drained: give back large buffers and carry on where reading stopped
+    if (client->pending.capacity() > static_cast<size_t>(READ_BUFFER_SIZE)) {
+        std::vector<char>().swap(client->pending);
+    } else {
+        client->pending.clear();
+    }
+    client->pendingOffset = 0;
+    if (client->peerClosed) {
+        closeClient(client);
+        return false;
+    }
+    if (client->readBlocked) {
+        client->readBlocked = false;
+        return readClient(client);
+    }
+    return true;
+#else
+    Q_UNUSED(client);
+    return false;
+#endif
+}
+
+void EpollEchoLoop::closeClient(Client* client)
+{
+#ifdef Q_OS_LINUX
+    if (client->wheelPrev) {
+        client->wheelPrev->wheelNext = client->wheelNext;
+    } else {
+        m_wheel[client->wheelSlot] = client->wheelNext;
+    }
+    if (client->wheelNext) {
+        client->wheelNext->wheelPrev = client->wheelPrev;
+    }
+
+    // Closing removes the descriptor from the epoll set
+    ::close(client->fd);
+    const int remaining = m_connectionCount.fetch_sub(1, std::memory_order_relaxed) - 1;
+
+    LOG_DEBUG(QString("Echo server: Client disconnected from %1 (remaining: %2)")
+              .arg(client->address)
+              .arg(remaining), "EchoServer");
+
+    emit clientDisconnected(client->address);
+    delete client;
+#else
+    Q_UNUSED(client);
+#endif
+}
+
+void EpollEchoLoop::expireSlot(int slot)
+{
+    while (Client* client = m_wheel[slot]) {
+        LOG_DEBUG("Echo server: Client connection timed out", "EchoServer");
+        closeClient(client);
+    }
+}
+
+void EpollEchoLoop::closeDescriptors()
+{
+#ifdef Q_OS_LINUX
+    for (int* fd : {&m_listenFd, &m_epollFd, &m_wakeFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+#endif
+}
@@ -0,0 +1,130 @@
+#include "ForwardingEngine.h"
+#include "ForwardingWorker.h"
+#include "Logger.h"
+#include <QHash>
+
+ForwardingEngine::ForwardingEngine(QObject *parent)
+    : QObject(parent)
+    , m_shardMode(ShardMode::ByCamera)
+    , m_nextWorker(0)
+{
+}
+
+ForwardingEngine::~ForwardingEngine()
+{
+    shutdown();
+}
+
+void ForwardingEngine::start(int threadCount, ShardMode mode, bool pinThreads)
+{
+    if (isRunning()) {
+        LOG_WARNING("Forwarding engine is already running", "PortForwarder");
+        return;
+    }
+
+    m_shardMode = mode;
+    m_nextWorker = 0;
+
+    if (threadCount <= 0) {
+        // Legacy layout: relay on the caller's (GUI) thread
+        m_workers.append(new ForwardingWorker);
+        LOG_INFO("Forwarding engine started on the main thread", "PortForwarder");
+        return;
+    }
+
+    const int cpuCount = qMax(1, QThread::idealThreadCount());
+
+    for (int i = 0; i < threadCount; ++i) {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("Forwarder-%1").arg(i));
+
+        ForwardingWorker* worker = new ForwardingWorker;
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+
+        thread->start(QThread::HighPriority);
+
+        if (pinThreads) {
+            const int cpu = i % cpuCount;
+            QMetaObject::invokeMethod(worker, [worker, cpu]() { worker->pinToCpu(cpu); }, Qt::QueuedConnection);
+        }
+
+        m_threads.append(thread);
+        m_workers.append(worker);
+    }
+
+    LOG_INFO(QString("Forwarding engine started with %1 worker threads (sharding %2%3)")
+             .arg(threadCount)
+             .arg(shardModeToString(mode))
+             .arg(pinThreads ? ", CPU pinning" : ""), "PortForwarder");
+}
+
+void ForwardingEngine::shutdown()
+{
+    if (!isRunning()) return;
+
+    if (m_threads.isEmpty()) {
+        for (ForwardingWorker* worker : m_workers) {
+            delete worker;
+        }
+    } else {
+        // Sockets must be closed on the thread that owns them
+        for (ForwardingWorker* worker : m_workers) {
+            QMetaObject::invokeMethod(worker, [worker]() { worker->closeAll(); }, Qt::BlockingQueuedConnection);
+        }
+
+        for (QThread* thread : m_threads) {
+            thread->quit();
+            thread->wait();
+            delete thread;
+        }
+    }
+
+    m_threads.clear();
+    m_workers.clear();
+
+    LOG_INFO("Forwarding engine stopped", "PortForwarder");
+}
+
+ForwardingWorker* ForwardingEngine::workerFor(const QString& cameraId)
+{
+    if (m_workers.isEmpty()) {
+        return nullptr;
+    }
+
+    if (m_workers.size() == 1) {
+        return m_workers.first();
+    }
+
+    if (m_shardMode == ShardMode::ByCamera) {
+        return workerForCamera(cameraId);
+    }
+
+    ForwardingWorker* worker = m_workers.at(m_nextWorker);
+    m_nextWorker = (m_nextWorker + 1) % m_workers.size();
+    return worker;
+}
+
+ForwardingWorker* ForwardingEngine::workerForCamera(const QString& cameraId) const
+{
+    if (m_workers.isEmpty()) {
+        return nullptr;
+    }
+
+    return m_workers.at(static_cast<int>(qHash(cameraId) % static_cast<size_t>(m_workers.size())));
+}
+
+int ForwardingEngine::defaultThreadCount()
+{
+    return qBound(1, QThread::idealThreadCount() / 2, static_cast<int>(MAX_DEFAULT_THREADS));
+}
+
+QString ForwardingEngine::shardModeToString(ShardMode mode)
+{
+    return mode == ShardMode::ByConnection ? "connection" : "camera";
+}
+
+ForwardingEngine::ShardMode ForwardingEngine::shardModeFromString(const QString& mode)
+{
+    return mode == "connection" ? ShardMode::ByConnection : ShardMode::ByCamera;
+}
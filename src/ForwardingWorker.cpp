@@ -0,0 +1,1376 @@
+#include "ForwardingWorker.h"
+#include "Logger.h"
+#include "BinaryLog.h"
+#include "SpliceRelay.h"
+#include "RtspFanOut.h"
+#include "UdpRelay.h"
+#include <QNetworkProxy>
+#include <QTimer>
+#include <QThread>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ForwardingWorker::ForwardingWorker(QObject *parent)
+    : QObject(parent)
+    , m_useSplice(false)
+    , m_payloadInspection(false)
+    , m_lastPoolReportMs(0)
+{
+    // Room for the frames of a full read, so framing does not allocate either
+    m_demuxEvents.reserve(256);
+}
+
+ForwardingWorker::~ForwardingWorker()
+{
+    closeAll();
+
+    const RelayBufferPool::Stats& stats = m_bufferPool.stats();
+    LOG_DEBUG(QString("Relay buffer pool: %1 hits, %2 misses, high-water %3 slabs")
+              .arg(stats.hits).arg(stats.misses).arg(stats.highWater), "PortForwarder");
+}
+
+QString ForwardingWorker::directionName(Direction direction)
+{
+    return direction == Direction::ClientToTarget ? QStringLiteral("client->target")
+                                                  : QStringLiteral("target->client");
+}
+
+void ForwardingWorker::acceptConnection(const CameraConfig& camera, quint64 sessionId,
+                                        const QSharedPointer<TrafficCounters>& traffic, qintptr socketDescriptor)
+{
+    const QString cameraId = camera.id();
+    WorkerSession* session = sessionFor(camera, sessionId, traffic);
+
+    QTcpSocket* clientSocket = new QTcpSocket(this);
+    if (!clientSocket->setSocketDescriptor(socketDescriptor)) {
+        LOG_ERROR(QString("Failed to adopt client socket for camera %1: %2")
+                  .arg(cameraId).arg(clientSocket->errorString()), "PortForwarder");
+        delete clientSocket;
+        return;
+    }
+
+    QString clientAddress = QString("%1:%2")
+        .arg(clientSocket->peerAddress().toString())
+        .arg(clientSocket->peerPort());
+
+    LOG_INFO(QString("New client connection from %1 for camera '%2' [ID: %3]")
+             .arg(clientAddress).arg(session->camera.name()).arg(cameraId), "PortForwarder");
+
+    if (session->camera.isFanOutEnabled()) {
+        acceptFanOutViewer(session, clientSocket, clientAddress);
+        return;
+    }
+
+    // A viewer keeps the warm pool alive and takes one of its connections
+    if (session->warmLingerTimer) {
+        session->warmLingerTimer->stop();
+    }
+    session->warmPoolActive = session->camera.warmConnections() > 0;
+    QTcpSocket* warmSocket = takeWarmConnection(session);
+
+    // Create connection info structure
+    ConnectionInfo* connInfo = new ConnectionInfo;
+    connInfo->session = session;
+    connInfo->clientSocket = clientSocket;
+    connInfo->targetSocket = warmSocket ? warmSocket : new QTcpSocket(this);
+    connInfo->clientAddress = clientAddress;
+    connInfo->connectedTime = QDateTime::currentDateTime();
+    connInfo->connectStartedMs = TrafficCounters::nowMs();
+    connInfo->isTargetConnected = warmSocket != nullptr;
+    connInfo->spliceRelay = nullptr;
+    connInfo->rtspPlaySent = false;
+    connInfo->spliceHandoffPending = false;
+    connInfo->spliceDisabled = false;
+    connInfo->rewriteTransport = !m_udpPorts.isNull();
+
+    connInfo->clientContext = { clientSocket, connInfo->targetSocket, connInfo,
+                                Direction::ClientToTarget, false, 0, RtspDemuxer() };
+    connInfo->targetContext = { connInfo->targetSocket, clientSocket, connInfo,
+                                Direction::TargetToClient, false, 0, RtspDemuxer() };
+
+    // Store connection mapping
+    session->connections[clientSocket] = connInfo;
+    m_socketContexts[clientSocket] = &connInfo->clientContext;
+    m_socketContexts[connInfo->targetSocket] = &connInfo->targetContext;
+
+    // Optimize sockets for RTSP streaming, warm sockets already are
+    optimizeSocketForStreaming(clientSocket);
+    if (!warmSocket) {
+        optimizeSocketForStreaming(connInfo->targetSocket);
+    }
+
+    // Connect client socket signals
+    connect(clientSocket, &QTcpSocket::disconnected,
+            this, &ForwardingWorker::handleClientDisconnected);
+    connect(clientSocket, &QTcpSocket::readyRead,
+            this, &ForwardingWorker::handleClientDataReady);
+    connect(clientSocket, &QTcpSocket::bytesWritten,
+            this, &ForwardingWorker::handleBytesWritten);
+    connect(clientSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+            this, &ForwardingWorker::handleConnectionError);
+
+    // Connect target socket signals
+    connect(connInfo->targetSocket, &QTcpSocket::connected,
+            this, &ForwardingWorker::handleTargetConnected);
+    connect(connInfo->targetSocket, &QTcpSocket::disconnected,
+            this, &ForwardingWorker::handleTargetDisconnected);
+    connect(connInfo->targetSocket, &QTcpSocket::readyRead,
+            this, &ForwardingWorker::handleTargetDataReady);
+    connect(connInfo->targetSocket, &QTcpSocket::bytesWritten,
+            this, &ForwardingWorker::handleBytesWritten);
+    connect(connInfo->targetSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+            this, &ForwardingWorker::handleConnectionError);
+
+    if (warmSocket) {
+        if (session->traffic) {
+            session->traffic->recordWarmHandout();
+        }
+        LOG_INFO(QString("Client %1 took a warm connection to camera '%2', skipping the connect")
+                 .arg(clientAddress).arg(session->camera.name()), "PortForwarder");
+        emit connectionEstablished(cameraId, sessionId, clientAddress);
+        emit targetConnected(cameraId, sessionId);
+
+        // Anything the camera sent while the connection sat idle
+        if (warmSocket->bytesAvailable() > 0) {
+            forwardData(&connInfo->targetContext);
+        }
+        refillWarmPool(session);
+        return;
+    }
+
+    // Attempt connection to target camera
+    LOG_DEBUG(QString("Connecting to target camera %1:%2 for client %3")
+              .arg(session->camera.ipAddress())
+              .arg(session->camera.port())
+              .arg(clientAddress), "PortForwarder");
+    connInfo->targetSocket->connectToHost(session->camera.ipAddress(), session->camera.port());
+
+    // Set connection timeout to 30 seconds for RTSP cameras. The timer dies
+    // with the target socket, so it never outlives the connection.
+    QTcpSocket* targetSocket = connInfo->targetSocket;
+    QTimer::singleShot(TARGET_CONNECT_TIMEOUT_MS, targetSocket, [targetSocket, cameraId]() {
+        if (targetSocket->state() == QAbstractSocket::ConnectingState) {
+            LOG_WARNING(QString("Connection timeout to camera %1, aborting").arg(cameraId), "PortForwarder");
+            targetSocket->abort();
+        }
+    });
+
+    emit connectionEstablished(cameraId, sessionId, clientAddress);
+    refillWarmPool(session);
+}
+
+void ForwardingWorker::prewarmSession(const CameraConfig& camera, quint64 sessionId,
+                                      const QSharedPointer<TrafficCounters>& traffic)
+{
+    if (camera.warmConnections() <= 0 || camera.isFanOutEnabled()) return;
+
+    WorkerSession* session = sessionFor(camera, sessionId, traffic);
+    session->warmPoolActive = true;
+    refillWarmPool(session);
+
+    // Nobody may ever connect, the pool is only kept for the linger period
+    if (session->connections.isEmpty()) {
+        startWarmPoolLinger(session);
+    }
+}
+
+ForwardingWorker::WorkerSession* ForwardingWorker::sessionFor(const CameraConfig& camera, quint64 sessionId,
+                                                              const QSharedPointer<TrafficCounters>& traffic)
+{
+    const QString cameraId = camera.id();
+
+    // A connection for a restarted session retires whatever is left of the old one
+    WorkerSession* session = m_sessions.value(cameraId);
+    if (session && session->sessionId != sessionId) {
+        removeSession(cameraId);
+        session = nullptr;
+    }
+
+    if (!session) {
+        session = new WorkerSession;
+        session->camera = camera;
+        session->cameraId = cameraId;
+        session->sessionId = sessionId;
+        session->lastDataLogMs = 0;
+        session->traffic = traffic;
+        session->fanOut = nullptr;
+        session->warmPoolActive = false;
+        session->warmLingerTimer = nullptr;
+        m_sessions[cameraId] = session;
+    }
+    return session;
+}
+
+void ForwardingWorker::closeSession(const QString& cameraId, quint64 sessionId)
+{
+    WorkerSession* session = m_sessions.value(cameraId);
+    if (session && session->sessionId == sessionId) {
+        removeSession(cameraId);
+    }
+}
+
+void ForwardingWorker::closeAll()
+{
+    const QStringList cameraIds = m_sessions.keys();
+    for (const QString& cameraId : cameraIds) {
+        removeSession(cameraId);
+    }
+}
+
+void ForwardingWorker::removeSession(const QString& cameraId)
+{
+    WorkerSession* session = m_sessions.take(cameraId);
+    if (!session) return;
+
+    const QList<ConnectionInfo*> connections = session->connections.values();
+    for (ConnectionInfo* connInfo : connections) {
+        logConnectionDetails(connInfo, "Closing");
+        cleanupConnection(connInfo);
+    }
+
+    if (session->fanOut) {
+        disconnect(session->fanOut, nullptr, this, nullptr);
+        session->fanOut->closeAll();
+        session->fanOut->deleteLater();
+    }
+
+    drainWarmPool(session);
+    delete session->warmLingerTimer;
+
+    delete session;
+}
+
+void ForwardingWorker::pruneInactiveConnections(const QString& cameraId, quint64 sessionId)
+{
+    WorkerSession* session = m_sessions.value(cameraId);
+    if (!session || session->sessionId != sessionId) return;
+
+    QDateTime cutoff = QDateTime::currentDateTime().addSecs(-INACTIVE_CONNECTION_TIMEOUT_S);
+    QList<ConnectionInfo*> toRemove;
+
+    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
+        ConnectionInfo* info = it.value();
+        if (info && info->connectedTime < cutoff && info->traffic.snapshot().totalBytes() == 0) {
+            LOG_WARNING(QString("Removing inactive connection: %1").arg(info->clientAddress), "PortForwarder");
+            toRemove.append(info);
+        }
+    }
+
+    for (ConnectionInfo* info : toRemove) {
+        const QString clientAddress = info->clientAddress;
+        logConnectionDetails(info, "Cleanup");
+        cleanupConnection(info);
+        emit connectionClosed(cameraId, sessionId, clientAddress);
+    }
+}
+
+void ForwardingWorker::reportQueueDepths(const QString& cameraId, quint64 sessionId)
+{
+    WorkerSession* session = m_sessions.value(cameraId);
+    if (!session || session->sessionId != sessionId) return;
+
+    QHash<QString, qint64> depths;
+    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
+        ConnectionInfo* info = it.value();
+        if (info && info->clientSocket) {
+            depths[info->clientAddress] = info->clientSocket->bytesToWrite();
+        }
+    }
+
+    if (session->fanOut) {
+        depths.insert(session->fanOut->queueDepths());
+    }
+
+    emit queueDepthsReported(cameraId, sessionId, depths);
+}
+
+void ForwardingWorker::reportBufferPoolStats()
+{
+    // Every camera's health check asks, one line per interval is enough
+    const qint64 now = TrafficCounters::nowMs();
+    if (now - m_lastPoolReportMs < BUFFER_POOL_REPORT_INTERVAL_MS) {
+        return;
+    }
+    m_lastPoolReportMs = now;
+
+    const RelayBufferPool::Stats& stats = m_bufferPool.stats();
+    const quint64 requests = stats.hits + stats.misses;
+    LOG_DEBUG(QString("Relay buffer pool: %1 hits, %2 misses (%3% hit rate), %4 in use, high-water %5 slabs of %6 KB")
+              .arg(stats.hits)
+              .arg(stats.misses)
+              .arg(requests > 0 ? QString::number(100.0 * stats.hits / requests, 'f', 1) : QString("-"))
+              .arg(stats.inUse)
+              .arg(stats.highWater)
+              .arg(m_bufferPool.slabSize() / 1024), "PortForwarder");
+}
+
+void ForwardingWorker::setRelayOptions(bool useSplice, bool payloadInspection)
+{
+    m_useSplice = useSplice;
+    m_payloadInspection = payloadInspection;
+}
+
+void ForwardingWorker::setUdpRelayPorts(const QSharedPointer<UdpPortPool>& ports)
+{
+    // Applies to connections accepted from now on
+    m_udpPorts = ports;
+}
+
+void ForwardingWorker::pinToCpu(int cpu)
+{
+    // Runs on the worker's own thread, so the calling thread is the one pinned
+#ifdef Q_OS_WIN
+    if (SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0) {
+        LOG_WARNING(QString("Failed to pin forwarding thread to CPU %1").arg(cpu), "PortForwarder");
+        return;
+    }
+#elif defined(Q_OS_LINUX)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+        LOG_WARNING(QString("Failed to pin forwarding thread to CPU %1").arg(cpu), "PortForwarder");
+        return;
+    }
+#else
+    LOG_WARNING("CPU pinning is not supported on this platform", "PortForwarder");
+    return;
+#endif
+    LOG_DEBUG(QString("Forwarding thread pinned to CPU %1").arg(cpu), "PortForwarder");
+}
+
+void ForwardingWorker::handleClientDisconnected()
+{
+    QTcpSocket* clientSocket = qobject_cast<QTcpSocket*>(sender());
+    if (!clientSocket) {
+        LOG_ERROR("handleClientDisconnected called with invalid socket", "PortForwarder");
+        return;
+    }
+
+    SocketContext* context = m_socketContexts.value(clientSocket);
+    if (!context) {
+        LOG_DEBUG("Client disconnected for unknown camera", "PortForwarder");
+        clientSocket->deleteLater();
+        return;
+    }
+
+    ConnectionInfo* connInfo = context->connection;
+    WorkerSession* session = connInfo->session;
+    const QString clientAddress = connInfo->clientAddress;
+
+    LOG_INFO(QString("Client disconnected: %1 for camera '%2'")
+             .arg(clientAddress).arg(session->camera.name()), "PortForwarder");
+
+    // Log connection details before cleanup
+    logConnectionDetails(connInfo, "Client Disconnected");
+    cleanupConnection(connInfo);
+
+    emit connectionClosed(session->cameraId, session->sessionId, clientAddress);
+}
+
+void ForwardingWorker::handleClientDataReady()
+{
+    QTcpSocket* clientSocket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(clientSocket);
+    if (!context) {
+        LOG_DEBUG("Data ready for unknown camera connection", "PortForwarder");
+        return;
+    }
+
+    ConnectionInfo* connInfo = context->connection;
+    QTcpSocket* targetSocket = context->peer;
+    const QString& cameraId = connInfo->session->cameraId;
+
+    if (targetSocket->state() == QAbstractSocket::ConnectedState) {
+        forwardData(context);
+    } else if (targetSocket->state() == QAbstractSocket::ConnectingState) {
+        // Buffer initial RTSP request data while target is connecting. The
+        // buffer is allocated once at its limit (32KB is plenty for an RTSP
+        // handshake); once it is full the rest waits in the socket and is
+        // relayed after the camera answers.
+        QByteArray& pending = connInfo->pendingClientData;
+        const qint64 previousSize = pending.size();
+        const qint64 room = PENDING_CLIENT_DATA_LIMIT - previousSize;
+        if (room <= 0) {
+            return;
+        }
+
+        pending.reserve(PENDING_CLIENT_DATA_LIMIT);
+        pending.resize(PENDING_CLIENT_DATA_LIMIT);
+        const qint64 bytesRead = clientSocket->read(pending.data() + previousSize, room);
+        pending.resize(previousSize + qMax<qint64>(bytesRead, 0));
+
+        if (bytesRead > 0) {
+            LOG_DEBUG(QString("Buffered %1 bytes of client data while connecting to camera %2 (total buffered: %3)")
+                      .arg(bytesRead).arg(cameraId).arg(pending.size()), "PortForwarder");
+            if (pending.size() == PENDING_CLIENT_DATA_LIMIT) {
+                LOG_WARNING(QString("Pending data buffer full for camera %1, holding further client data until it connects")
+                            .arg(cameraId), "PortForwarder");
+            }
+        }
+    } else {
+        LOG_DEBUG(QString("Target not connected (state: %1), dropping data for camera: %2")
+                  .arg(static_cast<int>(targetSocket->state())).arg(cameraId), "PortForwarder");
+        clientSocket->skip(clientSocket->bytesAvailable()); // Discard data if not connecting
+    }
+}
+
+void ForwardingWorker::handleTargetConnected()
+{
+    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(targetSocket);
+    if (!context) {
+        LOG_ERROR("Target connected for unknown camera", "PortForwarder");
+        return;
+    }
+
+    ConnectionInfo* info = context->connection;
+    WorkerSession* session = info->session;
+    const QString& cameraId = session->cameraId;
+
+    info->isTargetConnected = true;
+
+    const qint64 connectMs = TrafficCounters::nowMs() - info->connectStartedMs;
+    if (session->traffic) {
+        session->traffic->recordCameraConnect(connectMs);
+    }
+
+    // Optimize the connected socket for streaming
+    optimizeSocketForStreaming(targetSocket);
+
+    // Send any buffered client data that arrived before target connection
+    if (!info->pendingClientData.isEmpty()) {
+        LOG_INFO(QString("Sending %1 bytes of buffered data to camera %2")
+                 .arg(info->pendingClientData.size()).arg(cameraId), "PortForwarder");
+
+        // Same path as live data, so the demuxer stays in step and a SETUP
+        // among the buffered requests is rewritten for the UDP relay. Data
+        // that is not RTSP can trigger a splice hand-off, which closes the
+        // connection if the relay fails to start.
+        const RelayResult result = relayChunk(&info->clientContext, info->pendingClientData.constData(),
+                                              info->pendingClientData.size());
+        if (result == RelayResult::Closed) {
+            return;
+        }
+        if (result == RelayResult::Failed) {
+            LOG_ERROR(QString("Failed to send buffered data to camera %1: %2")
+                      .arg(cameraId).arg(targetSocket->errorString()), "PortForwarder");
+        }
+
+        info->pendingClientData.clear(); // Clear buffer after sending
+    }
+
+    // Client data held back while the pending buffer was full
+    if (info->clientSocket->bytesAvailable() > 0 && !forwardData(&info->clientContext)) {
+        return;
+    }
+
+    LOG_INFO(QString("Successfully connected to camera '%1' at %2:%3 for client %4 in %5 ms")
+             .arg(session->camera.name())
+             .arg(session->camera.ipAddress())
+             .arg(session->camera.port())
+             .arg(info->clientAddress)
+             .arg(connectMs), "PortForwarder");
+
+    emit targetConnected(cameraId, session->sessionId);
+}
+
+void ForwardingWorker::handleTargetDisconnected()
+{
+    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(targetSocket);
+    if (!context) {
+        if (targetSocket) {
+            targetSocket->deleteLater();
+        }
+        return;
+    }
+
+    // Disconnect the corresponding client as well
+    ConnectionInfo* info = context->connection;
+    WorkerSession* session = info->session;
+    const QString clientAddress = info->clientAddress;
+
+    cleanupConnection(info);
+
+    emit connectionClosed(session->cameraId, session->sessionId, clientAddress);
+    emit targetDisconnected(session->cameraId, session->sessionId);
+}
+
+void ForwardingWorker::handleTargetDataReady()
+{
+    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(targetSocket);
+    if (!context) {
+        LOG_DEBUG("Target data ready for unknown camera", "PortForwarder");
+        return;
+    }
+
+    if (context->peer->state() == QAbstractSocket::ConnectedState) {
+        forwardData(context);
+    } else {
+        LOG_DEBUG(QString("Client not connected, dropping data for camera: %1")
+                  .arg(context->connection->session->cameraId), "PortForwarder");
+    }
+}
+
+void ForwardingWorker::handleConnectionError(QAbstractSocket::SocketError error)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(socket);
+    if (!context) return;
+
+    WorkerSession* session = context->connection->session;
+    const QString& cameraId = session->cameraId;
+    QString errorString = socket->errorString();
+
+    // Log different error types with appropriate severity
+    switch (error) {
+        case QAbstractSocket::ConnectionRefusedError:
+            LOG_ERROR(QString("Camera %1 connection refused: %2").arg(cameraId).arg(errorString), "PortForwarder");
+            break;
+        case QAbstractSocket::RemoteHostClosedError:
+            LOG_INFO(QString("Camera %1 remote host closed connection: %2").arg(cameraId).arg(errorString), "PortForwarder");
+            break;
+        case QAbstractSocket::HostNotFoundError:
+            LOG_ERROR(QString("Camera %1 host not found: %2").arg(cameraId).arg(errorString), "PortForwarder");
+            break;
+        case QAbstractSocket::SocketTimeoutError:
+            LOG_WARNING(QString("Camera %1 connection timeout: %2").arg(cameraId).arg(errorString), "PortForwarder");
+            break;
+        case QAbstractSocket::NetworkError:
+            LOG_WARNING(QString("Camera %1 network error: %2").arg(cameraId).arg(errorString), "PortForwarder");
+            break;
+        default:
+            LOG_WARNING(QString("Camera %1 connection error (code %2): %3").arg(cameraId).arg(static_cast<int>(error)).arg(errorString), "PortForwarder");
+            break;
+    }
+
+    // Only report serious errors that should be shown to the user
+    if (error == QAbstractSocket::ConnectionRefusedError ||
+        error == QAbstractSocket::HostNotFoundError ||
+        error == QAbstractSocket::NetworkError) {
+        emit connectionError(cameraId, session->sessionId, errorString);
+    }
+}
+
+bool ForwardingWorker::forwardData(SocketContext* source)
+{
+    QTcpSocket* from = source->socket;
+    QTcpSocket* to = source->peer;
+    if (!from->isReadable() || !to->isWritable()) {
+        return true;
+    }
+
+    // Leave the data in the source's (bounded) read buffer while the receiver
+    // is backed up, so TCP flow control throttles the sender
+    if (source->readPaused) {
+        return true;
+    }
+
+    // Read available data in slab sized chunks from the worker's pool, so a
+    // steady stream reuses the same buffer instead of allocating per read
+    RelayBufferPool::Buffer buffer(m_bufferPool);
+    while (!source->readPaused && from->isReadable() && from->bytesAvailable() > 0) {
+        const qint64 dataSize = from->read(buffer.data(), static_cast<qint64>(buffer.size()));
+        if (dataSize <= 0) {
+            break;
+        }
+        const RelayResult result = relayChunk(source, buffer.data(), dataSize);
+        if (result == RelayResult::Closed) {
+            return false; // source was freed with its connection
+        }
+        if (result == RelayResult::Failed) {
+            break;
+        }
+    }
+    return true;
+}
+
+ForwardingWorker::RelayResult ForwardingWorker::relayChunk(SocketContext* source, const char* data, qint64 dataSize)
+{
+    QTcpSocket* from = source->socket;
+    QTcpSocket* to = source->peer;
+    ConnectionInfo* info = source->connection;
+    WorkerSession* session = info->session;
+    const QString& cameraId = session->cameraId;
+
+    // Header bytes the demuxer holds from earlier chunks were not written yet
+    // when transports are rewritten, see rewriteRtspTransport()
+    const size_t heldBefore = info->rewriteTransport ? source->demuxer.bufferedHeaderSize() : 0;
+    const int packets = inspectData(source, data, dataSize);
+
+    QByteArray rewritten;
+    if (info->rewriteTransport && rewriteRtspTransport(source, data, dataSize, heldBefore, &rewritten)) {
+        if (rewritten.isEmpty()) {
+            return RelayResult::Relayed; // All held back until the header block is complete
+        }
+        data = rewritten.constData();
+        dataSize = rewritten.size();
+    }
+
+    // QTcpSocket queues whatever the kernel does not take right away, the
+    // watermark check below keeps that queue bounded
+    qint64 totalWritten = to->write(data, dataSize);
+
+    if (totalWritten == -1) {
+        LOG_ERROR(QString("Failed to write data %1 for camera %2: %3")
+                  .arg(directionName(source->direction)).arg(cameraId).arg(to->errorString()), "PortForwarder");
+        return RelayResult::Failed;
+    }
+
+    const qint64 queuedBytes = to->bytesToWrite();
+    if (queuedBytes > WRITE_HIGH_WATERMARK) {
+        source->readPaused = true;
+        LOG_DEBUG_FMT("Pausing %1 for %2 on camera %3, %4 bytes queued", "PortForwarder",
+                      directionName(source->direction), info->clientAddress, cameraId, queuedBytes);
+        if (source->direction == Direction::TargetToClient) {
+            emit connectionBackpressure(cameraId, session->sessionId, info->clientAddress, true, queuedBytes);
+        }
+    }
+
+    // Try to flush data for real-time streaming, but don't spam logs if it fails
+    // Note: flush() failure is normal for high-throughput video streaming due to TCP buffering
+    if (totalWritten > 0) {
+        bool flushed = to->flush();
+
+        // flush() aborts the socket on a write error, and the disconnected()
+        // that follows cleans the connection up right away
+        if (!isConnectionOpen(from)) {
+            return RelayResult::Closed;
+        }
+
+        // Only log flush failures occasionally to avoid spam (every 5 seconds max)
+        if (!flushed) {
+            qint64 currentTime = TrafficCounters::nowMs();
+            if (currentTime - source->lastFlushWarningMs > 5000) {
+                LOG_DEBUG_FMT("TCP buffer full for %1 on camera %2 (normal for video streaming)", "PortForwarder",
+                              directionName(source->direction), cameraId);
+                source->lastFlushWarningMs = currentTime;
+            }
+        }
+    }
+
+    if (totalWritten > 0) {
+        // Counters only, PortForwarder publishes them periodically
+        recordTraffic(info, source->direction, totalWritten, packets);
+
+        // Throttled logging
+        qint64 currentTime = TrafficCounters::nowMs();
+        if (currentTime - session->lastDataLogMs > 5000) {
+            LOG_DEBUG_FMT("Data forwarded: %1 bytes %2 for camera %3", "PortForwarder",
+                          totalWritten, directionName(source->direction), cameraId);
+            session->lastDataLogMs = currentTime;
+        }
+
+        if (m_useSplice && !m_payloadInspection) {
+            // A hand-off whose relay fails to start, or finishes at once,
+            // cleans the connection up
+            trackSpliceHandoff(source);
+            if (!isConnectionOpen(from)) {
+                return RelayResult::Closed;
+            }
+        }
+        return RelayResult::Relayed;
+    }
+
+    LOG_ERROR(QString("Failed to forward %1 bytes %2 for camera %3")
+              .arg(dataSize).arg(directionName(source->direction)).arg(cameraId), "PortForwarder");
+    return RelayResult::Failed;
+}
+
+int ForwardingWorker::inspectData(SocketContext* source, const char* data, qint64 size)
+{
+    source->demuxer.feed(data, static_cast<size_t>(size), m_demuxEvents);
+
+    // Log detailed information for RTSP debugging. Interleaved frames are
+    // summarised per chunk, there can be hundreds of them.
+    int frames = 0;
+    const RtspDemuxer::Event* firstFrame = nullptr;
+    for (const RtspDemuxer::Event& event : m_demuxEvents) {
+        switch (event.type) {
+        case RtspDemuxer::EventType::Request:
+        case RtspDemuxer::EventType::Response:
+            LOG_INFO(QString("RTSP %1 %2: %3 header bytes, %4 body bytes - %5")
+                     .arg(directionName(source->direction))
+                     .arg(event.type == RtspDemuxer::EventType::Request ? "request" : "response")
+                     .arg(event.size)
+                     .arg(event.length)
+                     .arg(QString::fromLatin1(event.data, static_cast<int>(RtspDemuxer::startLineLength(event)))),
+                     "PortForwarder");
+            break;
+        case RtspDemuxer::EventType::Interleaved:
+            if (!firstFrame) {
+                firstFrame = &event;
+            }
+            ++frames;
+            break;
+        case RtspDemuxer::EventType::Unknown:
+            if (event.size > 100) {
+                LOG_DEBUG_FMT("Binary %1 data: %2 bytes", "PortForwarder", directionName(source->direction), event.size);
+            }
+            break;
+        }
+    }
+
+    if (firstFrame) {
+        LOG_DEBUG_FMT("RTP %1 data: %2 bytes, %3 frames [Channel: %4, Length: %5]", "PortForwarder",
+                      directionName(source->direction), size, frames, firstFrame->channel, firstFrame->length);
+    }
+    return frames;
+}
+
+void ForwardingWorker::recordTraffic(ConnectionInfo* info, Direction direction, qint64 bytes, int packets)
+{
+    const bool clientToTarget = (direction == Direction::ClientToTarget);
+    info->traffic.record(clientToTarget, bytes, packets);
+    if (info->session->traffic) {
+        info->session->traffic->record(clientToTarget, bytes, packets);
+    }
+}
+
+void ForwardingWorker::trackSpliceHandoff(SocketContext* source)
+{
+    ConnectionInfo* info = source->connection;
+    if (info->spliceRelay || info->spliceHandoffPending || info->spliceDisabled) {
+        return;
+    }
+
+    // The RTSP handshake stays in user space so it still shows up in the log,
+    // the media that follows PLAY goes through the kernel. Anything that is not
+    // RTSP (HTTP config pages, ONVIF, ...) is handed off straight away. Works
+    // on the events inspectData() left for this chunk.
+    bool handOff = false;
+    for (const RtspDemuxer::Event& event : m_demuxEvents) {
+        if (source->direction == Direction::ClientToTarget) {
+            if (event.type == RtspDemuxer::EventType::Request &&
+                event.size >= 5 && std::memcmp(event.data, "PLAY ", 5) == 0) {
+                info->rtspPlaySent = true;
+            } else if (event.type == RtspDemuxer::EventType::Unknown && !info->rtspPlaySent) {
+                handOff = true;
+            }
+        } else if (event.type == RtspDemuxer::EventType::Response && info->rtspPlaySent) {
+            handOff = true;
+        }
+    }
+
+    // trySpliceHandoff() may forward more data and refill m_demuxEvents
+    if (handOff) {
+        trySpliceHandoff(info);
+    }
+}
+
+bool ForwardingWorker::trySpliceHandoff(ConnectionInfo* info)
+{
+    QTcpSocket* clientSocket = info->clientSocket;
+    QTcpSocket* targetSocket = info->targetSocket;
+    const QString cameraId = info->session->cameraId;
+    if (clientSocket->state() != QAbstractSocket::ConnectedState ||
+        targetSocket->state() != QAbstractSocket::ConnectedState) {
+        return false;
+    }
+
+    // Header bytes held back for rewriting exist only in the demuxers, wait
+    // for the next complete message
+    if (info->clientContext.demuxer.bufferedHeaderSize() > 0 ||
+        info->targetContext.demuxer.bufferedHeaderSize() > 0) {
+        return false;
+    }
+
+    info->spliceHandoffPending = true;
+
+    // Push out everything Qt has already pulled into its own buffers, abort()
+    // below would discard it otherwise. Either step may close the connection.
+    if (clientSocket->bytesAvailable() > 0 && !forwardData(&info->clientContext)) {
+        return false;
+    }
+    if (targetSocket->bytesAvailable() > 0 && !forwardData(&info->targetContext)) {
+        return false;
+    }
+    clientSocket->flush();
+    targetSocket->flush();
+    if (!isConnectionOpen(clientSocket)) {
+        return false;
+    }
+
+    // Retried from handleBytesWritten() once the queues have drained
+    if (clientSocket->bytesToWrite() > 0 || targetSocket->bytesToWrite() > 0) {
+        return false;
+    }
+
+    const qintptr clientDescriptor = SpliceRelay::duplicateDescriptor(clientSocket->socketDescriptor());
+    const qintptr targetDescriptor = SpliceRelay::duplicateDescriptor(targetSocket->socketDescriptor());
+    if (clientDescriptor < 0 || targetDescriptor < 0) {
+        LOG_WARNING(QString("Could not duplicate socket descriptors for camera %1, staying on user space relay")
+                    .arg(cameraId), "PortForwarder");
+        SpliceRelay::closeDescriptor(clientDescriptor);
+        SpliceRelay::closeDescriptor(targetDescriptor);
+        info->spliceHandoffPending = false;
+        info->spliceDisabled = true;
+        return false;
+    }
+
+    // Detach the QTcpSockets. Closing them leaves the connections open since
+    // the duplicated descriptors still reference them. The socket objects stay
+    // alive as the connection key until the relay finishes.
+    disconnect(clientSocket, nullptr, this, nullptr);
+    disconnect(targetSocket, nullptr, this, nullptr);
+    clientSocket->abort();
+    targetSocket->abort();
+
+    SpliceRelay* relay = new SpliceRelay(clientDescriptor, targetDescriptor, this);
+    info->spliceRelay = relay;
+    info->spliceHandoffPending = false;
+    m_spliceRelays[relay] = info;
+
+    connect(relay, &SpliceRelay::bytesRelayed, this, &ForwardingWorker::handleSpliceBytesRelayed);
+    connect(relay, &SpliceRelay::finished, this, &ForwardingWorker::handleSpliceFinished);
+
+    LOG_DEBUG(QString("Client %1 on camera %2 handed off to splice() relay")
+              .arg(info->clientAddress).arg(cameraId), "PortForwarder");
+
+    QString errorString;
+    if (!relay->start(&errorString)) {
+        LOG_ERROR(QString("Failed to start splice() relay for camera %1: %2").arg(cameraId).arg(errorString), "PortForwarder");
+        const QString clientAddress = info->clientAddress;
+        const quint64 sessionId = info->session->sessionId;
+        logConnectionDetails(info, "Cleanup");
+        cleanupConnection(info);
+        emit connectionClosed(cameraId, sessionId, clientAddress);
+        return false;
+    }
+
+    // start() may already have seen both sides close, info is gone then
+    return true;
+}
+
+bool ForwardingWorker::rewriteRtspTransport(SocketContext* source, const char* data, qint64 size,
+                                            size_t heldBefore, QByteArray* out)
+{
+    // Incomplete header blocks at the end of a chunk are held back instead of
+    // written, so a SETUP split across reads can still be rewritten. The
+    // demuxer hands a completed block out of its own buffer; it stands for
+    // the held bytes plus the start of this chunk.
+    const size_t heldAfter = source->demuxer.bufferedHeaderSize();
+    bool changed = heldBefore > 0 || heldAfter > 0;
+    size_t stillHeld = heldBefore;
+    qint64 cursor = 0;
+
+    for (const RtspDemuxer::Event& event : m_demuxEvents) {
+        const bool inChunk = event.data >= data && event.data < data + size;
+        const bool message = event.type == RtspDemuxer::EventType::Request ||
+                             event.type == RtspDemuxer::EventType::Response;
+        if (inChunk && !message) {
+            continue;
+        }
+
+        QByteArray block;
+        if (source->direction == Direction::ClientToTarget && event.type == RtspDemuxer::EventType::Request &&
+            event.size >= 6 && std::memcmp(event.data, "SETUP ", 6) == 0) {
+            block = rewriteSetupRequest(source->connection, event);
+        } else if (source->direction == Direction::TargetToClient && event.type == RtspDemuxer::EventType::Response &&
+                   !source->connection->pendingUdpSetups.isEmpty()) {
+            block = rewriteSetupResponse(source->connection, event);
+        }
+
+        if (!inChunk) {
+            out->append(block.isNull() ? QByteArray(event.data, static_cast<int>(event.size)) : block);
+            cursor = static_cast<qint64>(event.size - stillHeld);
+            stillHeld = 0;
+            changed = true;
+        } else if (!block.isNull()) {
+            out->append(data + cursor, event.data - data - cursor);
+            out->append(block);
+            cursor = event.data + event.size - data;
+            changed = true;
+        }
+    }
+
+    if (!changed) {
+        return false;
+    }
+
+    // The held tail of this chunk waits for the rest of its header block
+    const qint64 tail = static_cast<qint64>(heldAfter - stillHeld);
+    out->append(data + cursor, size - tail - cursor);
+    return true;
+}
+
+QByteArray ForwardingWorker::rewriteSetupRequest(ConnectionInfo* info, const RtspDemuxer::Event& event)
+{
+    const QByteArray headers = QByteArray::fromRawData(event.data, static_cast<int>(event.size));
+    const QByteArray offered = UdpRelay::headerValue(headers, "Transport");
+    const QByteArray transport = UdpRelay::firstTransport(offered);
+    quint16 clientRtp = 0;
+    quint16 clientRtcp = 0;
+    if (!UdpRelay::isUdpUnicast(transport) ||
+        !UdpRelay::parsePortPair(UdpRelay::transportParameter(transport, "client_port"), &clientRtp, &clientRtcp)) {
+        return QByteArray();
+    }
+
+    const QString& cameraId = info->session->cameraId;
+    UdpRelay* relay = new UdpRelay(m_udpPorts, m_bufferPool, this);
+    QString errorString;
+    if (!relay->open(info->targetSocket->peerAddress(), info->clientSocket->peerAddress(), &errorString)) {
+        LOG_WARNING(QString("No UDP relay for client %1 on camera %2, passing SETUP through: %3")
+                    .arg(info->clientAddress).arg(cameraId).arg(errorString), "PortForwarder");
+        delete relay;
+        return QByteArray();
+    }
+    relay->setClient(info->clientSocket->peerAddress(), clientRtp, clientRtcp);
+
+    // A retransmitted SETUP replaces the relay opened for the first one
+    const QByteArray cseq = UdpRelay::headerValue(headers, "CSeq");
+    if (UdpRelay* previous = info->pendingUdpSetups.value(cseq)) {
+        closeUdpRelay(previous, false);
+    }
+    info->pendingUdpSetups.insert(cseq, relay);
+    m_udpRelays[relay] = info;
+    connect(relay, &UdpRelay::bytesRelayed, this, &ForwardingWorker::handleUdpBytesRelayed);
+
+    // The camera sends to the relay; destination= would point it elsewhere.
+    // The other transports offered, such as interleaved TCP, stay as they
+    // are for a camera that refuses UDP.
+    QByteArray rewritten = UdpRelay::setTransportParameter(transport, "client_port",
+                                                           UdpRelay::portPair(relay->cameraSidePort()));
+    rewritten = UdpRelay::setTransportParameter(rewritten, "destination", QByteArray());
+    return UdpRelay::replaceHeaderValue(headers, "Transport", UdpRelay::replaceFirstTransport(offered, rewritten));
+}
+
+QByteArray ForwardingWorker::rewriteSetupResponse(ConnectionInfo* info, const RtspDemuxer::Event& event)
+{
+    const QByteArray headers = QByteArray::fromRawData(event.data, static_cast<int>(event.size));
+    UdpRelay* relay = info->pendingUdpSetups.take(UdpRelay::headerValue(headers, "CSeq"));
+    if (!relay) {
+        return QByteArray();
+    }
+
+    const QString& cameraId = info->session->cameraId;
+    const bool success = headers.size() > 9 && headers.at(9) == '2'; // "RTSP/1.0 2xx"
+    const QByteArray transport = UdpRelay::firstTransport(UdpRelay::headerValue(headers, "Transport"));
+    quint16 serverRtp = 0;
+    quint16 serverRtcp = 0;
+    if (!success || !UdpRelay::isUdpUnicast(transport) ||
+        !UdpRelay::parsePortPair(UdpRelay::transportParameter(transport, "server_port"), &serverRtp, &serverRtcp)) {
+        // Rejected or answered with another transport, the viewer deals with it
+        LOG_DEBUG(QString("Camera %1 did not accept UDP for client %2, dropping its relay")
+                  .arg(cameraId).arg(info->clientAddress), "PortForwarder");
+        closeUdpRelay(relay, false);
+        return QByteArray();
+    }
+
+    // source= names the camera's media address when it differs from RTSP's
+    QHostAddress cameraAddress = info->targetSocket->peerAddress();
+    const QByteArray source = UdpRelay::transportParameter(transport, "source");
+    const QHostAddress sourceAddress(QString::fromLatin1(source));
+    if (!source.isEmpty() && !sourceAddress.isNull()) {
+        cameraAddress = sourceAddress;
+    }
+    relay->setCamera(cameraAddress, serverRtp, serverRtcp);
+
+    QByteArray rewritten = UdpRelay::setTransportParameter(transport, "client_port",
+        QByteArray::number(relay->clientPort(UdpRelay::Rtp)) + '-' + QByteArray::number(relay->clientPort(UdpRelay::Rtcp)));
+    rewritten = UdpRelay::setTransportParameter(rewritten, "server_port", UdpRelay::portPair(relay->clientSidePort()));
+    if (!source.isNull()) {
+        rewritten = UdpRelay::setTransportParameter(rewritten, "source",
+                                                    info->clientSocket->localAddress().toString().toLatin1());
+    }
+
+    relay->start();
+    info->udpRelays.append(relay);
+
+    LOG_INFO(QString("Relaying UDP media for client %1 on camera %2: viewer ports %3-%4 <-> relay %5/%6 <-> camera ports %7-%8")
+             .arg(info->clientAddress).arg(cameraId)
+             .arg(relay->clientPort(UdpRelay::Rtp)).arg(relay->clientPort(UdpRelay::Rtcp))
+             .arg(relay->clientSidePort()).arg(relay->cameraSidePort())
+             .arg(serverRtp).arg(serverRtcp), "PortForwarder");
+    emit udpStreamOpened(cameraId, info->session->sessionId, udpStreamName(info, relay), relay->traffic());
+
+    return UdpRelay::replaceHeaderValue(headers, "Transport", rewritten);
+}
+
+void ForwardingWorker::closeUdpRelay(UdpRelay* relay, bool announced)
+{
+    ConnectionInfo* info = m_udpRelays.take(relay);
+    if (info) {
+        info->udpRelays.removeOne(relay);
+        for (auto it = info->pendingUdpSetups.begin(); it != info->pendingUdpSetups.end(); ++it) {
+            if (it.value() == relay) {
+                info->pendingUdpSetups.erase(it);
+                break;
+            }
+        }
+
+        if (announced) {
+            const TrafficSnapshot traffic = relay->traffic()->snapshot();
+            LOG_INFO(QString("UDP media for client %1 on camera %2 closed: %3 packets, %4 bytes, %5 dropped")
+                     .arg(info->clientAddress).arg(info->session->cameraId)
+                     .arg(traffic.packets).arg(traffic.totalBytes()).arg(relay->droppedPackets()), "PortForwarder");
+            emit udpStreamClosed(info->session->cameraId, info->session->sessionId, udpStreamName(info, relay));
+        }
+    }
+
+    disconnect(relay, nullptr, this, nullptr);
+    relay->close();
+    relay->deleteLater();
+}
+
+QString ForwardingWorker::udpStreamName(const ConnectionInfo* info, const UdpRelay* relay)
+{
+    // The client socket may already be detached for splice(), use the saved address
+    return QString("%1 udp/%2").arg(info->clientAddress).arg(relay->clientSidePort());
+}
+
+void ForwardingWorker::handleUdpBytesRelayed(qint64 bytes, int packets, bool clientToTarget)
+{
+    ConnectionInfo* info = m_udpRelays.value(qobject_cast<UdpRelay*>(sender()));
+    if (!info) return;
+
+    recordTraffic(info, clientToTarget ? Direction::ClientToTarget : Direction::TargetToClient, bytes, packets);
+}
+
+void ForwardingWorker::handleBytesWritten()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    SocketContext* context = m_socketContexts.value(socket);
+    if (!context) return;
+
+    // Resume the paused direction that writes into this socket
+    ConnectionInfo* info = context->connection;
+    SocketContext* source = (context == &info->clientContext) ? &info->targetContext : &info->clientContext;
+    const bool resume = source->readPaused && socket->bytesToWrite() <= WRITE_LOW_WATERMARK;
+    if (resume) {
+        source->readPaused = false;
+        LOG_DEBUG_FMT("Resuming %1 for %2 on camera %3", "PortForwarder",
+                      directionName(source->direction), info->clientAddress, info->session->cameraId);
+        if (source->direction == Direction::TargetToClient) {
+            emit connectionBackpressure(info->session->cameraId, info->session->sessionId,
+                                        info->clientAddress, false, socket->bytesToWrite());
+        }
+    }
+
+    // Both calls below may delete info
+    if (info->spliceHandoffPending) {
+        trySpliceHandoff(info);
+    } else if (resume && source->socket->bytesAvailable() > 0) {
+        // readyRead is not emitted again for data that is already buffered
+        forwardData(source);
+    }
+}
+
+void ForwardingWorker::handleSpliceBytesRelayed(qint64 bytes, bool clientToTarget)
+{
+    SpliceRelay* relay = qobject_cast<SpliceRelay*>(sender());
+    ConnectionInfo* info = m_spliceRelays.value(relay);
+    if (!info) return;
+
+    recordTraffic(info, clientToTarget ? Direction::ClientToTarget : Direction::TargetToClient, bytes, 0);
+}
+
+void ForwardingWorker::handleSpliceFinished()
+{
+    SpliceRelay* relay = qobject_cast<SpliceRelay*>(sender());
+    ConnectionInfo* info = m_spliceRelays.value(relay);
+    if (!info) return;
+
+    WorkerSession* session = info->session;
+    const QString clientAddress = info->clientAddress;
+
+    LOG_INFO(QString("Client disconnected: %1 for camera '%2' (splice relay)")
+             .arg(clientAddress).arg(session->camera.name()), "PortForwarder");
+
+    logConnectionDetails(info, "Client Disconnected");
+    cleanupConnection(info);
+    emit connectionClosed(session->cameraId, session->sessionId, clientAddress);
+}
+
+void ForwardingWorker::acceptFanOutViewer(WorkerSession* session, QTcpSocket* clientSocket, const QString& clientAddress)
+{
+    if (!session->fanOut) {
+        session->fanOut = new RtspFanOut(session->camera, this);
+        connect(session->fanOut, &RtspFanOut::viewerClosed, this, &ForwardingWorker::handleFanOutViewerClosed);
+        connect(session->fanOut, &RtspFanOut::bytesRelayed, this, &ForwardingWorker::handleFanOutBytesRelayed);
+        connect(session->fanOut, &RtspFanOut::upstreamConnected, this, &ForwardingWorker::handleFanOutUpstreamConnected);
+        connect(session->fanOut, &RtspFanOut::upstreamDisconnected, this, &ForwardingWorker::handleFanOutUpstreamDisconnected);
+        connect(session->fanOut, &RtspFanOut::upstreamError, this, &ForwardingWorker::handleFanOutUpstreamError);
+    }
+
+    optimizeSocketForStreaming(clientSocket);
+    session->fanOut->addViewer(clientSocket, clientAddress);
+
+    emit connectionEstablished(session->cameraId, session->sessionId, clientAddress);
+}
+
+ForwardingWorker::WorkerSession* ForwardingWorker::fanOutSession(QObject* fanOut) const
+{
+    // Only a handful of cameras per worker, a scan is cheaper than another map
+    for (WorkerSession* session : m_sessions) {
+        if (session->fanOut && session->fanOut == fanOut) {
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+void ForwardingWorker::handleFanOutViewerClosed(const QString& clientAddress)
+{
+    WorkerSession* session = fanOutSession(sender());
+    if (!session) return;
+
+    LOG_INFO(QString("Client disconnected: %1 for camera '%2' (shared stream)")
+             .arg(clientAddress).arg(session->camera.name()), "PortForwarder");
+    emit connectionClosed(session->cameraId, session->sessionId, clientAddress);
+}
+
+void ForwardingWorker::handleFanOutBytesRelayed(qint64 bytes, bool clientToTarget)
+{
+    WorkerSession* session = fanOutSession(sender());
+    if (!session || !session->traffic) return;
+
+    session->traffic->record(clientToTarget, bytes);
+}
+
+void ForwardingWorker::handleFanOutUpstreamConnected()
+{
+    WorkerSession* session = fanOutSession(sender());
+    if (!session) return;
+
+    emit targetConnected(session->cameraId, session->sessionId);
+}
+
+void ForwardingWorker::handleFanOutUpstreamDisconnected()
+{
+    WorkerSession* session = fanOutSession(sender());
+    if (!session) return;
+
+    emit targetDisconnected(session->cameraId, session->sessionId);
+}
+
+void ForwardingWorker::handleFanOutUpstreamError(const QString& error)
+{
+    WorkerSession* session = fanOutSession(sender());
+    if (!session) return;
+
+    emit connectionError(session->cameraId, session->sessionId, error);
+}
+
+QTcpSocket* ForwardingWorker::takeWarmConnection(WorkerSession* session)
+{
+    for (int i = 0; i < session->warmSockets.size(); ++i) {
+        QTcpSocket* socket = session->warmSockets.at(i);
+        if (socket->state() != QAbstractSocket::ConnectedState) continue;
+
+        session->warmSockets.removeAt(i);
+        m_warmConnections.remove(socket);
+        disconnect(socket, nullptr, this, nullptr);
+        return socket;
+    }
+    return nullptr;
+}
+
+void ForwardingWorker::refillWarmPool(WorkerSession* session)
+{
+    if (!session->warmPoolActive || session->camera.isFanOutEnabled()) return;
+
+    while (session->warmSockets.size() < session->camera.warmConnections()) {
+        openWarmConnection(session);
+    }
+}
+
+void ForwardingWorker::openWarmConnection(WorkerSession* session)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    optimizeSocketForStreaming(socket);
+
+    m_warmConnections[socket] = { session, TrafficCounters::nowMs(), false };
+    session->warmSockets.append(socket);
+
+    connect(socket, &QTcpSocket::connected,
+            this, &ForwardingWorker::handleWarmConnected);
+    connect(socket, &QTcpSocket::disconnected,
+            this, &ForwardingWorker::handleWarmDisconnected);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+            this, &ForwardingWorker::handleWarmError);
+
+    socket->connectToHost(session->camera.ipAddress(), session->camera.port());
+
+    QTimer::singleShot(TARGET_CONNECT_TIMEOUT_MS, socket, [socket]() {
+        if (socket->state() == QAbstractSocket::ConnectingState) {
+            socket->abort();
+        }
+    });
+}
+
+void ForwardingWorker::dropWarmConnection(QTcpSocket* socket)
+{
+    const WarmConnection warm = m_warmConnections.take(socket);
+    WorkerSession* session = warm.session;
+
+    session->warmSockets.removeOne(socket);
+    disconnect(socket, nullptr, this, nullptr);
+    socket->abort();
+    socket->deleteLater();
+
+    // Try again later rather than hammering a camera that is down
+    const QString cameraId = session->cameraId;
+    const quint64 sessionId = session->sessionId;
+    QTimer::singleShot(WARM_POOL_RETRY_MS, this, [this, cameraId, sessionId]() {
+        WorkerSession* current = m_sessions.value(cameraId);
+        if (current && current->sessionId == sessionId) {
+            refillWarmPool(current);
+        }
+    });
+}
+
+void ForwardingWorker::drainWarmPool(WorkerSession* session)
+{
+    session->warmPoolActive = false;
+
+    const QList<QTcpSocket*> sockets = session->warmSockets;
+    for (QTcpSocket* socket : sockets) {
+        m_warmConnections.remove(socket);
+        disconnect(socket, nullptr, this, nullptr);
+        socket->disconnectFromHost();
+        socket->deleteLater();
+    }
+    session->warmSockets.clear();
+}
+
+void ForwardingWorker::startWarmPoolLinger(WorkerSession* session)
+{
+    if (!session->warmPoolActive) return;
+
+    if (!session->warmLingerTimer) {
+        session->warmLingerTimer = new QTimer(this);
+        session->warmLingerTimer->setSingleShot(true);
+
+        const QString cameraId = session->cameraId;
+        const quint64 sessionId = session->sessionId;
+        connect(session->warmLingerTimer, &QTimer::timeout, this, [this, cameraId, sessionId]() {
+            WorkerSession* current = m_sessions.value(cameraId);
+            if (!current || current->sessionId != sessionId || !current->connections.isEmpty()) return;
+
+            LOG_INFO(QString("No viewers for camera %1 in %2 s, closing %3 warm connection(s)")
+                     .arg(cameraId).arg(WARM_POOL_LINGER_MS / 1000).arg(current->warmSockets.size()),
+                     "PortForwarder");
+            drainWarmPool(current);
+        });
+    }
+
+    session->warmLingerTimer->start(WARM_POOL_LINGER_MS);
+}
+
+void ForwardingWorker::handleWarmConnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    auto it = m_warmConnections.find(socket);
+    if (it == m_warmConnections.end()) return;
+
+    it->connected = true;
+    WorkerSession* session = it->session;
+    const qint64 connectMs = TrafficCounters::nowMs() - it->connectStartedMs;
+    if (session->traffic) {
+        session->traffic->recordCameraConnect(connectMs);
+    }
+
+    LOG_DEBUG(QString("Warm connection to camera %1 ready in %2 ms (%3/%4 pooled)")
+              .arg(session->cameraId).arg(connectMs)
+              .arg(session->warmSockets.size()).arg(session->camera.warmConnections()), "PortForwarder");
+}
+
+void ForwardingWorker::handleWarmDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!m_warmConnections.contains(socket)) return;
+
+    LOG_DEBUG(QString("Camera %1 closed an idle warm connection")
+              .arg(m_warmConnections.value(socket).session->cameraId), "PortForwarder");
+    dropWarmConnection(socket);
+}
+
+void ForwardingWorker::handleWarmError(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error)
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!m_warmConnections.contains(socket)) return;
+
+    LOG_DEBUG(QString("Warm connection to camera %1 failed: %2")
+              .arg(m_warmConnections.value(socket).session->cameraId).arg(socket->errorString()), "PortForwarder");
+    dropWarmConnection(socket);
+}
+
+void ForwardingWorker::logConnectionDetails(const ConnectionInfo* info, const QString& event)
+{
+    if (!info) return;
+
+    qint64 durationMs = info->connectedTime.msecsTo(QDateTime::currentDateTime());
+    double durationSec = durationMs / 1000.0;
+
+    LOG_INFO(QString("%1 - Camera: %2, Client: %3, Duration: %4s, Bytes: %5")
+             .arg(event)
+             .arg(info->session->cameraId)
+             .arg(info->clientAddress)
+             .arg(QString::number(durationSec, 'f', 1))
+             .arg(info->traffic.snapshot().totalBytes()), "PortForwarder");
+}
+
+void ForwardingWorker::cleanupConnection(ConnectionInfo* info)
+{
+    info->session->connections.remove(info->clientSocket);
+    if (info->session->connections.isEmpty()) {
+        startWarmPoolLinger(info->session);
+    }
+
+    if (info->spliceRelay) {
+        m_spliceRelays.remove(info->spliceRelay);
+        info->spliceRelay->close();
+        info->spliceRelay->deleteLater();
+    }
+
+    const QList<UdpRelay*> pendingRelays = info->pendingUdpSetups.values();
+    for (UdpRelay* relay : pendingRelays) {
+        closeUdpRelay(relay, false);
+    }
+    const QList<UdpRelay*> udpRelays = info->udpRelays;
+    for (UdpRelay* relay : udpRelays) {
+        closeUdpRelay(relay, true);
+    }
+
+    // Detach first, disconnectFromHost() may emit disconnected() synchronously
+    for (QTcpSocket* socket : {info->clientSocket, info->targetSocket}) {
+        m_socketContexts.remove(socket);
+        disconnect(socket, nullptr, this, nullptr);
+        socket->disconnectFromHost();
+        socket->deleteLater();
+    }
+
+    delete info;
+}
+
+void ForwardingWorker::optimizeSocketForStreaming(QTcpSocket* socket)
+{
+    if (!socket) return;
+
+    // Set socket options for optimal RTSP streaming performance
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);  // TCP_NODELAY equivalent - critical for RTSP
+    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);  // SO_KEEPALIVE to detect dead connections
+
+    // Set larger buffer sizes for streaming data
+    socket->setReadBufferSize(128 * 1024);  // 128KB read buffer for video data
+    socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 256 * 1024);  // 256KB send buffer
+    socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 256 * 1024);  // 256KB receive buffer
+
+    // Disable proxy for direct connection
+    socket->setProxy(QNetworkProxy::NoProxy);
+
+    // Set type of service for real-time data (if supported)
+    socket->setSocketOption(QAbstractSocket::TypeOfServiceOption, 0x10); // IPTOS_LOWDELAY
+
+    LOG_DEBUG("Socket optimized for RTSP streaming with enhanced buffer sizes", "PortForwarder");
+}
@@ -0,0 +1,175 @@
+#include "LogModel.h"
+#include <QBrush>
+#include <QColor>
+
+LogModel::LogModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_lines(MAX_LINES)
+    , m_first(0)
+    , m_count(0)
+{
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setInterval(BATCH_INTERVAL_MS);
+    connect(&m_batchTimer, &QTimer::timeout, this, &LogModel::addPending);
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count) {
+        return QVariant();
+    }
+
+    const Line& line = lineAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return line.text;
+    case Qt::ForegroundRole:
+        if (line.level == LogLevel::Error) {
+            return QBrush(QColor(200, 0, 0));
+        }
+        if (line.level == LogLevel::Warning) {
+            return QBrush(QColor(180, 100, 0));
+        }
+        return QVariant();
+    case LevelRole:
+        return static_cast<int>(line.level);
+    case CategoryRole:
+        return line.category >= 0 ? m_categories.at(line.category) : QString();
+    default:
+        return QVariant();
+    }
+}
+
+void LogModel::append(const QString& line)
+{
+    m_pending.append(line);
+    if (!m_batchTimer.isActive()) {
+        m_batchTimer.start();
+    }
+}
+
+void LogModel::clear()
+{
+    m_batchTimer.stop();
+    m_pending.clear();
+
+    beginResetModel();
+    for (int row = 0; row < m_count; ++row) {
+        m_lines[(m_first + row) % MAX_LINES] = Line();
+    }
+    m_first = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+void LogModel::addPending()
+{
+    QStringList pending;
+    pending.swap(m_pending);
+
+    // Lines that would scroll out within the same batch are never shown
+    if (pending.size() > MAX_LINES) {
+        pending = pending.mid(pending.size() - MAX_LINES);
+    }
+    const int added = pending.size();
+    if (added == 0) {
+        return;
+    }
+
+    const int overflow = m_count + added - MAX_LINES;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_first = (m_first + overflow) % MAX_LINES;
+        m_count -= overflow;
+        endRemoveRows();
+    }
+
+    const int knownCategories = m_categories.size();
+    beginInsertRows(QModelIndex(), m_count, m_count + added - 1);
+    for (const QString& text : pending) {
+        m_lines[(m_first + m_count) % MAX_LINES] = parse(text);
+        ++m_count;
+    }
+    endInsertRows();
+
+    for (int i = knownCategories; i < m_categories.size(); ++i) {
+        emit categoryAdded(m_categories.at(i));
+    }
+}
+
+LogModel::Line LogModel::parse(const QString& text)
+{
+    Line line;
+    line.text = text;
+
+    // "[yyyy-MM-dd hh:mm:ss.zzz] [LEVEL] [category] message"; other lines,
+    // such as VPN output, count as Info without a category
+    const int levelStart = text.indexOf("] [");
+    if (!text.startsWith('[') || levelStart < 0) {
+        return line;
+    }
+    const int categoryStart = text.indexOf("] [", levelStart + 3);
+    if (categoryStart < 0) {
+        return line;
+    }
+
+    const QStringView level = QStringView(text).mid(levelStart + 3, categoryStart - levelStart - 3).trimmed();
+    if (level == QLatin1String("DEBUG")) {
+        line.level = LogLevel::Debug;
+    } else if (level == QLatin1String("WARN")) {
+        line.level = LogLevel::Warning;
+    } else if (level == QLatin1String("ERROR")) {
+        line.level = LogLevel::Error;
+    }
+
+    const int categoryEnd = text.indexOf(']', categoryStart + 3);
+    if (categoryEnd < 0) {
+        return line;
+    }
+    const QString category = text.mid(categoryStart + 3, categoryEnd - categoryStart - 3);
+    line.category = m_categoryIndex.value(category, -1);
+    if (line.category < 0) {
+        line.category = m_categories.size();
+        m_categoryIndex.insert(category, line.category);
+        m_categories.append(category);
+    }
+    return line;
+}
+
+LogFilterModel::LogFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_minimumLevel(LogLevel::Debug)
+{
+}
+
+void LogFilterModel::setMinimumLevel(LogLevel level)
+{
+    if (level == m_minimumLevel) {
+        return;
+    }
+    m_minimumLevel = level;
+    invalidateFilter();
+}
+
+void LogFilterModel::setCategory(const QString& category)
+{
+    if (category == m_category) {
+        return;
+    }
+    m_category = category;
+    invalidateFilter();
+}
+
+bool LogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+    const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (index.data(LogModel::LevelRole).toInt() < static_cast<int>(m_minimumLevel)) {
+        return false;
+    }
+    return m_category.isEmpty() || index.data(LogModel::CategoryRole).toString() == m_category;
+}
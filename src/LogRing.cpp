@@ -0,0 +1,73 @@
+#include "LogRing.h"
+
+LogRing::LogRing(size_t capacity)
+    : m_mask(0)
+    , m_pushPosition(0)
+    , m_popPosition(0)
+{
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+
+    m_slots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogRing::tryPush(LogRecord& record)
+{
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[position & m_mask];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+        if (difference == 0) {
+            // Slot is free for this position, claim it
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.record = std::move(record);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            // Still holds the record from one lap ago: full
+            return false;
+        } else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRing::tryPop(LogRecord* record)
+{
+    size_t position = m_popPosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[position & m_mask];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+        if (difference == 0) {
+            if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                *record = std::move(slot.record);
+                slot.record.message = QString();
+                // Free the slot for the producer one lap ahead
+                slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = m_popPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t LogRing::depth() const
+{
+    const size_t popped = m_popPosition.load(std::memory_order_relaxed);
+    const size_t pushed = m_pushPosition.load(std::memory_order_relaxed);
+    return pushed > popped ? pushed - popped : 0;
+}
@@ -1,13 +1,108 @@
 #include "Logger.h"
+#include "LogRing.h"
+#include "BinaryLog.h"
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
 #include <QMutexLocker>
+#include <QThread>
+#include <array>
+#include <csignal>
+#include <exception>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+std::atomic<int> Logger::s_logLevel{static_cast<int>(LogLevel::Info)};
+
+namespace {
+
+std::terminate_handler g_previousTerminateHandler = nullptr;
+
+// Member header: deflate, no flags, no mtime, unknown OS
+const char GZIP_MEMBER_HEADER[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+
+quint32 crc32(const QByteArray& data)
+{
+    static const std::array<quint32, 256> table = []() {
+        std::array<quint32, 256> entries{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (const char byte : data) {
+        crc = table[(crc ^ static_cast<quint8>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLittleEndian32(QByteArray& data, quint32 value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        data.append(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void handleCrashSignal(int signalNumber)
+{
+    std::signal(signalNumber, SIG_DFL);
+    Logger::instance().flushAfterCrash();
+    std::raise(signalNumber);
+}
+
+void handleTerminate()
+{
+    Logger::instance().flushAfterCrash();
+    if (g_previousTerminateHandler) {
+        g_previousTerminateHandler();
+    }
+    std::abort();
+}
+
+#ifdef Q_OS_WIN
+LONG WINAPI handleUnhandledException(EXCEPTION_POINTERS*)
+{
+    Logger::instance().flushAfterCrash();
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+} // namespace
 
 Logger::Logger()
-    : m_logLevel(LogLevel::Info)
-    , m_logToFile(false)
+    : m_logToFile(false)
+    , m_cachedSecond(-1)
+    , m_fileBytes(0)
+    , m_fileOpenedMs(0)
+    , m_maxFileBytes(DEFAULT_MAX_FILE_BYTES)
+    , m_maxFileAgeMs(DEFAULT_MAX_FILE_AGE_MS)
+    , m_retainedFiles(DEFAULT_RETAINED_FILES)
+    , m_compressRotated(true)
+    , m_lastSummaryMs(0)
+    , m_stormSuppression(true)
+    , m_writerThread(nullptr)
+    , m_wakeRequested(false)
+    , m_asyncRunning(false)
+    , m_droppedMessages(0)
+    , m_reportedDrops(0)
+    , m_flushIntervalMs(DEFAULT_FLUSH_INTERVAL_MS)
+    , m_overflowPolicy(LogOverflowPolicy::Drop)
 {
+    // Constructed first so it is destroyed after the logger, whose writer
+    // thread flushes it
+    BinaryLog::instance();
+    
+    m_rotationPool.setMaxThreadCount(1);
+    
     // Set default log file path
     QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
     QDir().mkpath(appDataPath);
@@ -16,7 +111,19 @@ Logger::Logger()
 
 Logger::~Logger()
 {
+    stopAsync();
+    
+    // A rotated file left uncompressed is picked up on the next start
+    m_rotationPool.clear();
+    m_rotationPool.waitForDone();
+    
+    QMutexLocker locker(&m_mutex);
+    if (m_ring) {
+        writeQueued();
+    }
+    writeSuppressionSummaries(QDateTime::currentMSecsSinceEpoch(), true);
     if (m_logFile.isOpen()) {
+        m_logStream.flush();
         m_logFile.close();
     }
 }
@@ -32,77 +139,547 @@ void Logger::setLogFile(const QString& filePath)
     QMutexLocker locker(&m_mutex);
     
     if (m_logFile.isOpen()) {
+        m_logStream.flush();
         m_logFile.close();
     }
     
     m_logFile.setFileName(filePath);
-    if (m_logFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
-        m_logStream.setDevice(&m_logFile);
-        m_logToFile = true;
-    } else {
-        m_logToFile = false;
-    }
+    openLogFile();
 }
 
-void Logger::setLogLevel(LogLevel level)
+void Logger::setRotation(qint64 maxFileBytes, qint64 maxFileAgeMs, int retainedFiles, bool compress)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    m_maxFileBytes = qMax<qint64>(maxFileBytes, 0);
+    m_maxFileAgeMs = qMax<qint64>(maxFileAgeMs, 0);
+    m_retainedFiles = qMax(retainedFiles, 0);
+    m_compressRotated = compress;
+    
+    // Applies the new retention and compresses files a previous run left
+    queueRotatedFileCleanup();
+}
+
+void Logger::setStormSuppression(bool enabled)
 {
     QMutexLocker locker(&m_mutex);
-    m_logLevel = level;
+    m_stormSuppression = enabled;
 }
 
-void Logger::log(LogLevel level, const QString& message, const QString& category)
+void Logger::setLogLevel(LogLevel level)
 {
-    if (level < m_logLevel) {
+    s_logLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::startAsync(int queueCapacity, int flushIntervalMs, LogOverflowPolicy overflowPolicy)
+{
+    if (m_writerThread) {
         return;
     }
     
-    QMutexLocker locker(&m_mutex);
+    if (!m_ring) {
+        m_ring.reset(new LogRing(static_cast<size_t>(qMax(queueCapacity, 2))));
+    }
+    m_flushIntervalMs = qMax(flushIntervalMs, 1);
+    m_overflowPolicy = overflowPolicy;
+    installCrashHandlers();
     
-    QString formattedMessage = formatMessage(level, message, category);
+    m_asyncRunning.store(true, std::memory_order_release);
+    m_writerThread = QThread::create([this]() { runWriter(); });
+    m_writerThread->setObjectName("LogWriter");
+    m_writerThread->start(QThread::LowPriority);
+}
+
+void Logger::stopAsync()
+{
+    if (!m_writerThread) {
+        return;
+    }
     
-    // Emit signal for UI logging
-    emit logMessage(formattedMessage);
+    m_asyncRunning.store(false, std::memory_order_release);
+    {
+        QMutexLocker wakeLocker(&m_wakeMutex);
+        m_writerWake.wakeAll();
+    }
+    m_writerThread->wait();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+}
+
+int Logger::queueDepth() const
+{
+    return m_ring ? static_cast<int>(m_ring->depth()) : 0;
+}
+
+int Logger::queueCapacity() const
+{
+    return m_ring ? static_cast<int>(m_ring->capacity()) : 0;
+}
+
+void Logger::log(LogLevel level, const QString& message, LogCategory category)
+{
+    if (!isEnabled(level)) {
+        return;
+    }
     
-    // Write to file if enabled
+    if (m_asyncRunning.load(std::memory_order_acquire)) {
+        LogRecord record;
+        record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+        record.level = level;
+        record.category = category;
+        record.message = message;
+        if (enqueue(record)) {
+            return;
+        }
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    
+    // Lines queued just before the writer stopped go out first
+    if (m_ring) {
+        writeQueued();
+    }
+    
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (admitLine(level, now, message, category)) {
+        writeLine(level, now, message, category);
+    }
+    writeSuppressionSummaries(now, false);
     if (m_logToFile && m_logFile.isOpen()) {
-        m_logStream << formattedMessage << Qt::endl;
         m_logStream.flush();
     }
 }
 
-void Logger::debug(const QString& message, const QString& category)
+void Logger::debug(const QString& message, LogCategory category)
 {
     log(LogLevel::Debug, message, category);
 }
 
-void Logger::info(const QString& message, const QString& category)
+void Logger::info(const QString& message, LogCategory category)
 {
     log(LogLevel::Info, message, category);
 }
 
-void Logger::warning(const QString& message, const QString& category)
+void Logger::warning(const QString& message, LogCategory category)
 {
     log(LogLevel::Warning, message, category);
 }
 
-void Logger::error(const QString& message, const QString& category)
+void Logger::error(const QString& message, LogCategory category)
 {
     log(LogLevel::Error, message, category);
 }
 
-QString Logger::formatMessage(LogLevel level, const QString& message, const QString& category) const
+void Logger::flushAfterCrash()
+{
+    m_asyncRunning.store(false, std::memory_order_release);
+    BinaryLog::instance().flushAfterCrash();
+    
+    // The crash may have happened in the writer with the lock held
+    if (!m_mutex.tryLock(CRASH_FLUSH_LOCK_TIMEOUT_MS)) {
+        return;
+    }
+    if (m_ring) {
+        writeQueued();
+    }
+    if (m_logToFile && m_logFile.isOpen()) {
+        m_logStream.flush();
+        m_logFile.flush();
+    }
+    m_mutex.unlock();
+}
+
+bool Logger::enqueue(LogRecord& record)
+{
+    const bool urgent = record.level >= LogLevel::Warning;
+    
+    while (!m_ring->tryPush(record)) {
+        if (m_overflowPolicy == LogOverflowPolicy::Drop) {
+            m_droppedMessages.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (!m_asyncRunning.load(std::memory_order_acquire)) {
+            return false;  // Writer is gone, log() writes the line itself
+        }
+        wakeWriter();
+        QThread::yieldCurrentThread();
+    }
+    
+    // Other lines wait for the next flush interval unless the queue fills up
+    if (urgent || m_ring->depth() > m_ring->capacity() / 2) {
+        wakeWriter();
+    }
+    return true;
+}
+
+void Logger::wakeWriter()
+{
+    // Under the wake mutex, and remembered, so a wake that comes while the
+    // writer is busy or between its check and wait() is not lost
+    QMutexLocker wakeLocker(&m_wakeMutex);
+    m_wakeRequested = true;
+    m_writerWake.wakeOne();
+}
+
+void Logger::runWriter()
 {
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
+    while (m_asyncRunning.load(std::memory_order_acquire)) {
+        {
+            QMutexLocker locker(&m_mutex);
+            writeQueued();
+        }
+        BinaryLog::instance().flush();
+        
+        QMutexLocker wakeLocker(&m_wakeMutex);
+        if (m_asyncRunning.load(std::memory_order_acquire) && !m_wakeRequested &&
+            m_ring->depth() <= m_ring->capacity() / 2) {
+            m_writerWake.wait(&m_wakeMutex, m_flushIntervalMs);
+        }
+        m_wakeRequested = false;
+    }
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        writeQueued();
+    }
+    BinaryLog::instance().flush();
+}
+
+int Logger::writeQueued()
+{
+    int written = 0;
+    
+    LogRecord record;
+    while (m_ring->tryPop(&record)) {
+        if (admitLine(record.level, record.timestampMs, record.message, record.category)) {
+            writeLine(record.level, record.timestampMs, record.message, record.category);
+            ++written;
+        }
+    }
+    
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const quint64 dropped = m_droppedMessages.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDrops) {
+        writeLine(LogLevel::Warning, now,
+                  QString("%1 log messages dropped, queue full").arg(dropped - m_reportedDrops), "Logger");
+        m_reportedDrops = dropped;
+        ++written;
+    }
+    written += writeSuppressionSummaries(now, false);
+    
+    // One flush per batch instead of one per line
+    if (written > 0 && m_logToFile && m_logFile.isOpen()) {
+        m_logStream.flush();
+    }
+    return written;
+}
+
+void Logger::writeLine(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category)
+{
+    QString formattedMessage = formatMessage(level, timestampMs, message, category);
+    
+    // Emit signal for UI logging
+    emit logMessage(formattedMessage);
+    
+    // Write to file if enabled
+    if (m_logToFile && m_logFile.isOpen()) {
+        m_logStream << formattedMessage << '\n';
+        m_fileBytes += formattedMessage.size() + 1;
+        
+        if ((m_maxFileBytes > 0 && m_fileBytes >= m_maxFileBytes) ||
+            (m_maxFileAgeMs > 0 && timestampMs - m_fileOpenedMs >= m_maxFileAgeMs)) {
+            rotateLogFile();
+        }
+    }
+}
+
+bool Logger::admitLine(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category)
+{
+    if (!m_stormSuppression) {
+        return true;
+    }
+    
+    // Lines that differ only in their numbers count as repeats of each other
+    const quint64 key = templateKey(message, category);
+    auto repeated = m_repeatedLines.find(key);
+    if (repeated != m_repeatedLines.end()) {
+        if (timestampMs - repeated->windowStartMs < REPEAT_WINDOW_MS) {
+            ++repeated->repeats;
+            repeated->lastMessage = message;
+            return false;
+        }
+        if (repeated->repeats > 0) {
+            writeLine(repeated->level, timestampMs,
+                      QString("%1 (repeated %2 more times)").arg(repeated->lastMessage).arg(repeated->repeats),
+                      repeated->category);
+        }
+        m_repeatedLines.erase(repeated);
+    }
+    if (m_repeatedLines.size() < MAX_TRACKED_TEMPLATES) {
+        RepeatedLine line;
+        line.windowStartMs = timestampMs;
+        line.level = level;
+        line.category = category;
+        m_repeatedLines.insert(key, line);
+    }
+    
+    // Token bucket per category for storms of lines that all differ
+    const QByteArray categoryName = QByteArray::fromRawData(category.name(), static_cast<qsizetype>(category.size()));
+    auto budget = m_categoryBudgets.find(categoryName);
+    if (budget == m_categoryBudgets.end()) {
+        CategoryBudget fresh;
+        fresh.tokens = CATEGORY_BURST_LINES;
+        fresh.refilledMs = timestampMs;
+        budget = m_categoryBudgets.insert(QByteArray(category.name(), static_cast<qsizetype>(category.size())), fresh);
+    }
+    const qint64 elapsedMs = qMax<qint64>(timestampMs - budget->refilledMs, 0);
+    budget->tokens = qMin<double>(CATEGORY_BURST_LINES, budget->tokens + elapsedMs * CATEGORY_LINES_PER_SECOND / 1000.0);
+    budget->refilledMs = qMax(budget->refilledMs, timestampMs);
+    if (budget->tokens < 1) {
+        ++budget->suppressed;
+        return false;
+    }
+    budget->tokens -= 1;
+    return true;
+}
+
+int Logger::writeSuppressionSummaries(qint64 nowMs, bool all)
+{
+    if (!all && nowMs - m_lastSummaryMs < SUMMARY_INTERVAL_MS) {
+        return 0;
+    }
+    m_lastSummaryMs = nowMs;
+    
+    int written = 0;
+    for (auto it = m_repeatedLines.begin(); it != m_repeatedLines.end();) {
+        if (!all && nowMs - it->windowStartMs < REPEAT_WINDOW_MS) {
+            ++it;
+            continue;
+        }
+        if (it->repeats > 0) {
+            writeLine(it->level, nowMs,
+                      QString("%1 (repeated %2 more times)").arg(it->lastMessage).arg(it->repeats),
+                      it->category);
+            ++written;
+        }
+        it = m_repeatedLines.erase(it);
+    }
+    
+    for (auto it = m_categoryBudgets.begin(); it != m_categoryBudgets.end(); ++it) {
+        if (it->suppressed > 0 && (all || it->tokens >= 1)) {
+            writeLine(LogLevel::Warning, nowMs,
+                      QString("%1 lines in category %2 suppressed by the rate limit")
+                      .arg(it->suppressed).arg(QString::fromLatin1(it.key())),
+                      "Logger");
+            it->suppressed = 0;
+            ++written;
+        }
+    }
+    return written;
+}
+
+quint64 Logger::templateKey(const QString& message, LogCategory category)
+{
+    // FNV-1a over the category and the message, each run of digits hashed as
+    // one placeholder so ids, ports, addresses and counts do not matter
+    quint64 hash = 14695981039346656037ull;
+    const auto mix = [&hash](quint32 value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    
+    for (std::size_t i = 0; i < category.size(); ++i) {
+        mix(static_cast<quint8>(category.name()[i]));
+    }
+    mix(0);
+    
+    bool inNumber = false;
+    for (const QChar ch : message) {
+        if (ch.isDigit()) {
+            if (!inNumber) {
+                mix('#');
+                inNumber = true;
+            }
+            continue;
+        }
+        inNumber = false;
+        mix(ch.unicode());
+    }
+    return hash;
+}
+
+void Logger::openLogFile()
+{
+    if (m_logFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        m_logStream.setDevice(&m_logFile);
+        m_logToFile = true;
+        
+        // A file carried over from an earlier run keeps its age
+        m_fileBytes = m_logFile.size();
+        const QDateTime birthTime = m_logFile.fileTime(QFileDevice::FileBirthTime);
+        m_fileOpenedMs = (m_fileBytes > 0 && birthTime.isValid())
+                         ? birthTime.toMSecsSinceEpoch()
+                         : QDateTime::currentMSecsSinceEpoch();
+    } else {
+        m_logToFile = false;
+    }
+}
+
+void Logger::rotateLogFile()
+{
+    const QString logFilePath = m_logFile.fileName();
+    const QFileInfo info(logFilePath);
+    const QString rotatedPath = QString("%1/%2-%3.%4")
+                                .arg(info.absolutePath(), info.completeBaseName(),
+                                     QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz"),
+                                     info.suffix());
+    
+    // Runs under m_mutex, so every line lands in exactly one of the files
+    m_logStream.flush();
+    m_logFile.close();
+    const bool renamed = QFile::rename(logFilePath, rotatedPath);
+    openLogFile();
+    
+    // Also after a failed rename, so the next attempt waits for another full file
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_fileBytes = 0;
+    m_fileOpenedMs = now;
+    
+    if (!renamed) {
+        writeLine(LogLevel::Warning, now,
+                  QString("Could not rotate log file to %1, still writing to %2").arg(rotatedPath, logFilePath),
+                  "Logger");
+        return;
+    }
+    
+    writeLine(LogLevel::Info, now,
+              QString("Log file rotated, earlier lines are in %1").arg(QFileInfo(rotatedPath).fileName()),
+              "Logger");
+    queueRotatedFileCleanup();
+}
+
+void Logger::queueRotatedFileCleanup()
+{
+    const QString logFilePath = m_logFile.fileName();
+    const int retainedFiles = m_retainedFiles;
+    const bool compress = m_compressRotated;
+    
+    m_rotationPool.start([logFilePath, retainedFiles, compress]() {
+        cleanUpRotatedFiles(logFilePath, retainedFiles, compress);
+    });
+}
+
+void Logger::cleanUpRotatedFiles(const QString& logFilePath, int retainedFiles, bool compress)
+{
+    const QFileInfo info(logFilePath);
+    QDir dir(info.absolutePath());
+    const QString pattern = QString("%1-*.%2").arg(info.completeBaseName(), info.suffix());
+    
+    // Left by a compression cut short by exit or a crash
+    const QStringList partialFiles = dir.entryList(QStringList() << pattern + ".gz.part", QDir::Files);
+    for (const QString& name : partialFiles) {
+        dir.remove(name);
+    }
+    
+    if (compress) {
+        const QStringList plainFiles = dir.entryList(QStringList() << pattern, QDir::Files, QDir::Name);
+        for (const QString& name : plainFiles) {
+            const QString sourcePath = dir.filePath(name);
+            const QString targetPath = sourcePath + ".gz";
+            
+            // Written under a temporary name so a .gz file is always complete
+            if (gzipFile(sourcePath, targetPath + ".part") && QFile::rename(targetPath + ".part", targetPath)) {
+                QFile::remove(sourcePath);
+            } else {
+                QFile::remove(targetPath + ".part");
+                LOG_WARNING(QString("Failed to compress rotated log file %1").arg(name), "Logger");
+            }
+        }
+    }
+    
+    // Names start with the rotation time, so name order is age order
+    QStringList rotatedFiles = dir.entryList(QStringList() << pattern << pattern + ".gz", QDir::Files, QDir::Name);
+    while (rotatedFiles.size() > retainedFiles) {
+        dir.remove(rotatedFiles.takeFirst());
+    }
+}
+
+bool Logger::gzipFile(const QString& sourcePath, const QString& targetPath)
+{
+    QFile source(sourcePath);
+    QFile target(targetPath);
+    if (!source.open(QIODevice::ReadOnly) || !target.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    
+    // Each chunk becomes a gzip member of its own, gunzip reads them as one
+    // stream, and memory use stays at one chunk however big the file is
+    do {
+        const QByteArray chunk = source.read(GZIP_CHUNK_SIZE);
+        if (source.error() != QFileDevice::NoError) {
+            return false;
+        }
+        
+        QByteArray member(GZIP_MEMBER_HEADER, sizeof(GZIP_MEMBER_HEADER));
+        if (chunk.isEmpty()) {
+            member.append("\x03\x00", 2);  // Empty deflate block
+        } else {
+            // qCompress() output is a 4 byte length, then a zlib stream: a
+            // 2 byte header, the deflate data and a 4 byte Adler-32
+            const QByteArray zlib = qCompress(chunk, 6);
+            if (zlib.size() < 10) {
+                return false;
+            }
+            member.append(zlib.constData() + 6, zlib.size() - 10);
+        }
+        appendLittleEndian32(member, crc32(chunk));
+        appendLittleEndian32(member, static_cast<quint32>(chunk.size()));
+        
+        if (target.write(member) != member.size()) {
+            return false;
+        }
+    } while (!source.atEnd());
+    
+    return target.flush();
+}
+
+void Logger::installCrashHandlers()
+{
+    static bool installed = false;
+    if (installed) {
+        return;
+    }
+    installed = true;
+    
+    std::signal(SIGSEGV, handleCrashSignal);
+    std::signal(SIGABRT, handleCrashSignal);
+    std::signal(SIGFPE, handleCrashSignal);
+    std::signal(SIGILL, handleCrashSignal);
+    g_previousTerminateHandler = std::set_terminate(handleTerminate);
+#ifdef Q_OS_WIN
+    SetUnhandledExceptionFilter(handleUnhandledException);
+#endif
+}
+
+QString Logger::formatMessage(LogLevel level, qint64 timestampMs, const QString& message, LogCategory category)
+{
+    // Date and time are formatted once per second, the rest per line
+    const qint64 second = timestampMs / 1000;
+    if (second != m_cachedSecond) {
+        m_cachedSecond = second;
+        m_cachedSecondText = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("yyyy-MM-dd hh:mm:ss");
+    }
     QString levelStr = logLevelToString(level);
     
-    return QString("[%1] [%2] [%3] %4")
-           .arg(timestamp)
+    return QString("[%1.%2] [%3] [%4] %5")
+           .arg(m_cachedSecondText)
+           .arg(timestampMs % 1000, 3, 10, QChar('0'))
            .arg(levelStr)
-           .arg(category)
+           .arg(QLatin1String(category.name(), static_cast<qsizetype>(category.size())))
            .arg(message);
 }
 
-QString Logger::logLevelToString(LogLevel level) const
+QString Logger::logLevelToString(LogLevel level)
 {
     switch (level) {
         case LogLevel::Debug:   return "DEBUG";
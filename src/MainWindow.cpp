@@ -7,7 +7,9 @@
 #include "UserProfileWidget.h"
 #include "NetworkInterfaceManager.h"
 #include "EchoServer.h"
+#include "UdpEchoServer.h"
 #include "PingResponder.h"
+#include "ThroughputChart.h"
 #include <QApplication>
 #include <QScreen>
 #include <QMenuBar>
@@ -21,13 +23,12 @@
 #include <QSettings>
 #include <QSplitter>
 #include <QGroupBox>
-#include <QTableWidget>
+#include <QTableView>
 #include <QNetworkInterface>
-#include <QTableWidgetItem>
 #include <QPushButton>
 #include <QLabel>
 #include <QCheckBox>
-#include <QTextEdit>
+#include <QListView>
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QFormLayout>
@@ -139,6 +140,17 @@ private:    void setupUI()
         
         m_enabledCheckBox = new QCheckBox(this);
         m_enabledCheckBox->setChecked(true);
+        
+        m_fanOutCheckBox = new QCheckBox("Share one camera stream between all viewers", this);
+        m_fanOutCheckBox->setToolTip("Open a single RTSP session to the camera and replicate it to every viewer.\n"
+                                     "Use for cameras that only allow a few simultaneous streams.\n"
+                                     "Viewers must use RTSP over TCP.");
+        
+        m_warmConnectionsSpinBox = new QSpinBox(this);
+        m_warmConnectionsSpinBox->setRange(0, CameraConfig::MAX_WARM_CONNECTIONS);
+        m_warmConnectionsSpinBox->setSpecialValueText("Off");
+        m_warmConnectionsSpinBox->setToolTip("Camera connections to keep open ahead of time so new viewers start faster.\n"
+                                             "Each one counts against the camera's client limit while it waits.");
           layout->addRow("Camera Name:", m_nameEdit);
         layout->addRow("IP Address:", m_ipEdit);
         layout->addRow("Port:", m_portSpinBox);
@@ -147,6 +159,8 @@ private:    void setupUI()
         layout->addRow("Model:", m_modelEdit);
         layout->addRow(credentialsGroup);
         layout->addRow("Enabled:", m_enabledCheckBox);
+        layout->addRow("Stream Sharing:", m_fanOutCheckBox);
+        layout->addRow("Warm Connections:", m_warmConnectionsSpinBox);
         
         // RTSP URL preview
         m_rtspPreviewGroup = new QGroupBox("RTSP URL Preview", this);
@@ -189,6 +203,8 @@ private:    void setupUI()
         m_usernameEdit->setText(m_camera.username());
         m_passwordEdit->setText(m_camera.password());
         m_enabledCheckBox->setChecked(m_camera.isEnabled());
+        m_fanOutCheckBox->setChecked(m_camera.isFanOutEnabled());
+        m_warmConnectionsSpinBox->setValue(m_camera.warmConnections());
         
         // Update RTSP preview after loading
         updateRtspPreview();
@@ -204,6 +220,8 @@ private:    void setupUI()
         m_camera.setUsername(m_usernameEdit->text().trimmed());
         m_camera.setPassword(m_passwordEdit->text());
         m_camera.setEnabled(m_enabledCheckBox->isChecked());
+        m_camera.setFanOutEnabled(m_fanOutCheckBox->isChecked());
+        m_camera.setWarmConnections(m_warmConnectionsSpinBox->value());
     }CameraConfig m_camera;
     QLineEdit* m_nameEdit;
     QLineEdit* m_ipEdit;
@@ -215,6 +233,8 @@ private:    void setupUI()
     QLineEdit* m_usernameEdit;
     QLineEdit* m_passwordEdit;
     QCheckBox* m_enabledCheckBox;
+    QCheckBox* m_fanOutCheckBox;
+    QSpinBox* m_warmConnectionsSpinBox;
     
     // UI enhancement elements
     QPushButton* m_passwordVisibilityButton;
@@ -969,6 +989,7 @@ private:
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_logModel(nullptr)
     , m_isClosingToTray(false)
     , m_forceQuit(false)
     , m_pingProcess(nullptr)
@@ -988,6 +1009,7 @@ MainWindow::MainWindow(QWidget *parent)
       // Initialize echo server for ping testing
     LOG_INFO("Creating EchoServer...", "MainWindow");
     m_echoServer = new EchoServer(this);
+    m_udpEchoServer = new UdpEchoServer(this);
     
     // Initialize ping responder for ICMP ping replies
     LOG_INFO("Creating PingResponder...", "MainWindow");
@@ -1062,6 +1084,8 @@ MainWindow::MainWindow(QWidget *parent)
     LOG_INFO("Starting echo server...", "MainWindow");
     ConfigManager& config = ConfigManager::instance();
     if (config.isEchoServerEnabled()) {
+        m_echoServer->setMode(EchoServer::modeFromString(config.getEchoServerMode()));
+        m_echoServer->setMaxConnections(config.getEchoServerMaxConnections());
         if (m_echoServer->startServer(config.getEchoServerPort())) {
             LOG_INFO(QString("Echo server started on port %1").arg(m_echoServer->serverPort()), "MainWindow");
         } else {
@@ -1070,6 +1094,13 @@ MainWindow::MainWindow(QWidget *parent)
     } else {
         LOG_INFO("Echo server disabled in configuration", "MainWindow");
     }
+    if (config.isUdpEchoServerEnabled()) {
+        if (m_udpEchoServer->startServer(config.getUdpEchoServerPort())) {
+            LOG_INFO(QString("UDP echo server started on port %1").arg(m_udpEchoServer->serverPort()), "MainWindow");
+        } else {
+            LOG_WARNING("Failed to start UDP echo server", "MainWindow");
+        }
+    }
     
     // Start ping responder for ICMP ping replies
     LOG_INFO("Starting ping responder...", "MainWindow");
@@ -1081,15 +1112,16 @@ MainWindow::MainWindow(QWidget *parent)
         showMessage("Warning: ICMP ping responder failed to start. Run as administrator for ping functionality.");
     }
       LOG_INFO("Updating camera table...", "MainWindow");
-    updateCameraTable();
+    m_cameraModel->reload();
     LOG_INFO("Updating buttons...", "MainWindow");
     updateButtons();
     
-    // Initialize statistics refresh timer
-    m_statisticsRefreshTimer = new QTimer(this);
-    connect(m_statisticsRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshConnectionStatistics);
-    m_statisticsRefreshTimer->start(2000); // Refresh every 2 seconds
-    LOG_INFO("Connection statistics refresh timer started", "MainWindow");
+    // Statistics are refreshed whenever the port forwarder publishes its counters
+    connect(m_cameraManager->getPortForwarder(), &PortForwarder::statsUpdated,
+            this, &MainWindow::refreshConnectionStatistics);
+    connect(m_cameraManager->getPortForwarder(), &PortForwarder::throughputSampled,
+            m_cameraModel, &CameraTableModel::updateThroughput);
+    LOG_INFO("Connection statistics refresh connected", "MainWindow");
     
     statusBar()->showMessage("Ready", 2000);
     LOG_INFO("MainWindow initialized successfully", "MainWindow");
@@ -1107,20 +1139,9 @@ void MainWindow::showMessage(const QString& message)
 
 void MainWindow::appendLog(const QString& message)
 {
-    if (m_logTextEdit) {
-        m_logTextEdit->append(message);
-        
-        // Limit log size
-        if (m_logTextEdit->document()->blockCount() > 1000) {
-            QTextCursor cursor = m_logTextEdit->textCursor();
-            cursor.movePosition(QTextCursor::Start);
-            cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, 100);
-            cursor.removeSelectedText();
-        }
-        
-        // Auto-scroll to bottom
-        QScrollBar* scrollBar = m_logTextEdit->verticalScrollBar();
-        scrollBar->setValue(scrollBar->maximum());
+    // Shown with the next batch, see LogModel
+    if (m_logModel) {
+        m_logModel->append(message);
     }
 }
 
@@ -1256,13 +1277,10 @@ void MainWindow::discoverCameras()
 
 void MainWindow::editCamera()
 {
-    int row = m_cameraTable->currentRow();
-    if (row < 0) return;
+    QString cameraId = selectedCameraId();
+    if (cameraId.isEmpty()) return;
     
-    QTableWidgetItem* idItem = m_cameraTable->item(row, 0);
-    if (!idItem) return;
-      QString cameraId = idItem->data(Qt::UserRole).toString();
-    CameraConfig camera = ConfigManager::instance().getCamera(cameraId);
+    CameraConfig camera = m_cameraModel->camera(cameraId);
     
     if (camera.id().isEmpty()) {
         QMessageBox::warning(this, "Visco Connect - Error", "Camera not found");
@@ -1282,14 +1300,10 @@ void MainWindow::editCamera()
 
 void MainWindow::showCameraInfo()
 {
-    int row = m_cameraTable->currentRow();
-    if (row < 0) return;
+    QString cameraId = selectedCameraId();
+    if (cameraId.isEmpty()) return;
     
-    QTableWidgetItem* idItem = m_cameraTable->item(row, 0);
-    if (!idItem) return;
-    
-    QString cameraId = idItem->data(Qt::UserRole).toString();
-    CameraConfig camera = ConfigManager::instance().getCamera(cameraId);
+    CameraConfig camera = m_cameraModel->camera(cameraId);
       if (camera.id().isEmpty()) {
         QMessageBox::warning(this, "Visco Connect - Error", "Camera not found");
         return;
@@ -1299,17 +1313,40 @@ void MainWindow::showCameraInfo()
     dialog.exec();
 }
 
-void MainWindow::removeCamera()
+void MainWindow::showThroughputHistory(const QString& cameraId)
 {
-    int row = m_cameraTable->currentRow();
-    if (row < 0) return;
+    if (cameraId.isEmpty()) return;
+    
+    QDialog* dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle(QString("Visco Connect - Throughput of %1").arg(m_cameraModel->camera(cameraId).name()));
+    
+    QVBoxLayout* layout = new QVBoxLayout(dialog);
+    ThroughputChart* chart = new ThroughputChart;
+    layout->addWidget(chart);
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttonBox, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+    layout->addWidget(buttonBox);
+    
+    // Follows the live history; the last one stays up if the camera stops
+    PortForwarder* forwarder = m_cameraManager->getPortForwarder();
+    auto refresh = [forwarder, chart, cameraId]() {
+        if (const ThroughputHistory* history = forwarder->getThroughputHistory(cameraId)) {
+            chart->setHistory(*history);
+        }
+    };
+    refresh();
+    connect(forwarder, &PortForwarder::throughputSampled, chart, refresh);
     
-    QTableWidgetItem* nameItem = m_cameraTable->item(row, 1);
-    QTableWidgetItem* idItem = m_cameraTable->item(row, 0);
-    if (!nameItem || !idItem) return;
+    dialog->show();
+}
+
+void MainWindow::removeCamera()
+{
+    QString cameraId = selectedCameraId();
+    if (cameraId.isEmpty()) return;
     
-    QString cameraName = nameItem->text();
-    QString cameraId = idItem->data(Qt::UserRole).toString();
+    QString cameraName = m_cameraModel->camera(cameraId).name();
     
     int ret = QMessageBox::question(this, "Visco Connect - Confirm Removal",
                                    QString("Are you sure you want to remove camera '%1'?").arg(cameraName),
@@ -1326,13 +1363,8 @@ void MainWindow::removeCamera()
 
 void MainWindow::toggleCamera()
 {
-    int row = m_cameraTable->currentRow();
-    if (row < 0) return;
-    
-    QTableWidgetItem* idItem = m_cameraTable->item(row, 0);
-    if (!idItem) return;
-    
-    QString cameraId = idItem->data(Qt::UserRole).toString();
+    QString cameraId = selectedCameraId();
+    if (cameraId.isEmpty()) return;
     
     if (m_cameraManager->isCameraRunning(cameraId)) {
         m_cameraManager->stopCamera(cameraId);
@@ -1380,14 +1412,14 @@ void MainWindow::onCameraSelectionChanged()
 
 void MainWindow::onCameraStarted(const QString& id)
 {
-    updateCameraTable();
+    m_cameraModel->refreshCamera(id);
     updateButtons();    CameraConfig camera = ConfigManager::instance().getCamera(id);
     showMessage(QString("Camera '%1' started").arg(camera.name()));
 }
 
 void MainWindow::onCameraStopped(const QString& id)
 {
-    updateCameraTable();
+    m_cameraModel->refreshCamera(id);
     updateButtons();    CameraConfig camera = ConfigManager::instance().getCamera(id);
     showMessage(QString("Camera '%1' stopped").arg(camera.name()));
 }
@@ -1403,7 +1435,7 @@ void MainWindow::onCameraError(const QString& id, const QString& error)
 
 void MainWindow::onConfigurationChanged()
 {
-    updateCameraTable();
+    m_cameraModel->reload();
     updateButtons();
     
     // Restart echo server if configuration changed
@@ -1415,78 +1447,10 @@ void MainWindow::onLogMessage(const QString& message)
     appendLog(message);
 }
 
-void MainWindow::refreshConnectionStatistics()
+void MainWindow::refreshConnectionStatistics(const QHash<QString, TrafficSnapshot>& snapshots)
 {
-    // Only refresh if there are cameras and the table is visible
-    if (m_cameraTable->rowCount() == 0) {
-        return;
-    }
-    
-    // Update connection statistics for each camera row
-    for (int i = 0; i < m_cameraTable->rowCount(); ++i) {
-        QTableWidgetItem* idItem = m_cameraTable->item(i, 0);
-        if (!idItem) continue;
-        
-        QString cameraId = idItem->data(Qt::UserRole).toString();
-        bool isRunning = m_cameraManager->isCameraRunning(cameraId);
-        
-        // Update connections count (column 8)
-        int connectionCount = 0;
-        if (isRunning) {
-            connectionCount = m_cameraManager->getPortForwarder()->getConnectionCount(cameraId);
-        }
-        
-        QTableWidgetItem* connectionsItem = m_cameraTable->item(i, 8);
-        if (connectionsItem) {
-            connectionsItem->setText(QString::number(connectionCount));
-            if (connectionCount > 0) {
-                connectionsItem->setBackground(QColor(144, 238, 144)); // Light green
-            } else {
-                connectionsItem->setBackground(QColor(255, 255, 255)); // White
-            }
-        }
-        
-        // Update data transferred (column 9)
-        QString dataTransferred = "0 B";
-        if (isRunning) {
-            qint64 bytes = m_cameraManager->getPortForwarder()->getBytesTransferred(cameraId);
-            if (bytes > 0) {
-                if (bytes >= 1024 * 1024 * 1024) {
-                    dataTransferred = QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
-                } else if (bytes >= 1024 * 1024) {
-                    dataTransferred = QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
-                } else if (bytes >= 1024) {
-                    dataTransferred = QString::number(bytes / 1024.0, 'f', 2) + " KB";
-                } else {
-                    dataTransferred = QString::number(bytes) + " B";
-                }
-            }
-        }
-        
-        QTableWidgetItem* dataItem = m_cameraTable->item(i, 9);
-        if (dataItem) {
-            dataItem->setText(dataTransferred);
-        }
-        
-        // Update action buttons state
-        QWidget* actionWidget = m_cameraTable->cellWidget(i, 10);
-        if (actionWidget) {
-            // Find the start/stop button and update its state
-            QPushButton* startStopBtn = actionWidget->findChild<QPushButton*>();
-            if (startStopBtn) {
-                CameraConfig camera = ConfigManager::instance().getCamera(cameraId);
-                startStopBtn->setText(isRunning ? "Stop" : "Start");
-                startStopBtn->setEnabled(camera.isEnabled());
-            }
-            
-            // Find the restart button and update its state
-            QList<QPushButton*> buttons = actionWidget->findChildren<QPushButton*>();
-            if (buttons.size() > 1) {
-                QPushButton* restartBtn = buttons[1]; // Second button is restart
-                restartBtn->setEnabled(isRunning);
-            }
-        }
-    }
+    // Repaints only the cells whose values changed
+    m_cameraModel->updateStatistics(snapshots);
 }
 
 void MainWindow::onNetworkInterfacesChanged()
@@ -1535,44 +1499,30 @@ void MainWindow::onEchoClientDisconnected(const QString& clientAddress)
 
 void MainWindow::onEchoDataReceived(const QString& clientAddress, int bytesEchoed)
 {
-    // Log ping requests for debugging, but don't spam the UI for every ping
-    static QMap<QString, qint64> lastLogTime;
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    
-    if (!lastLogTime.contains(clientAddress) || 
-        currentTime - lastLogTime[clientAddress] > 30000) { // Log once every 30 seconds per client
-        LOG_DEBUG(QString("Echo server: Received %1 bytes from %2").arg(bytesEchoed).arg(clientAddress), "MainWindow");
-        lastLogTime[clientAddress] = currentTime;
-    }
+    // The logger collapses the repeats
+    LOG_DEBUG(QString("Echo server: Received %1 bytes from %2").arg(bytesEchoed).arg(clientAddress), "MainWindow");
 }
 
 void MainWindow::onPingReceived(const QString& sourceAddress, quint16 identifier, quint16 sequence)
 {
-    // Log ping requests for debugging, but don't spam the UI for every ping
-    static QMap<QString, qint64> lastLogTime;
+    LOG_DEBUG(QString("ICMP ping received from %1 (ID: %2, Seq: %3)")
+              .arg(sourceAddress).arg(identifier).arg(sequence), "MainWindow");
+    
+    // Don't spam the status bar for every ping
+    static QMap<QString, qint64> lastMessageTime;
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
     
-    if (!lastLogTime.contains(sourceAddress) || 
-        currentTime - lastLogTime[sourceAddress] > 10000) { // Log once every 10 seconds per source
-        LOG_DEBUG(QString("ICMP ping received from %1 (ID: %2, Seq: %3)")
-                  .arg(sourceAddress).arg(identifier).arg(sequence), "MainWindow");
+    if (!lastMessageTime.contains(sourceAddress) || 
+        currentTime - lastMessageTime[sourceAddress] > 10000) { // Once every 10 seconds per source
         showMessage(QString("Ping received from %1").arg(sourceAddress));
-        lastLogTime[sourceAddress] = currentTime;
+        lastMessageTime[sourceAddress] = currentTime;
     }
 }
 
 void MainWindow::onPingReplied(const QString& sourceAddress, quint16 identifier, quint16 sequence, quint32 responseTime)
 {
-    // Log successful ping replies occasionally
-    static QMap<QString, qint64> lastLogTime;
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    
-    if (!lastLogTime.contains(sourceAddress) || 
-        currentTime - lastLogTime[sourceAddress] > 10000) { // Log once every 10 seconds per source
-        LOG_DEBUG(QString("ICMP ping replied to %1 (ID: %2, Seq: %3, Time: %4ms)")
-                  .arg(sourceAddress).arg(identifier).arg(sequence).arg(responseTime), "MainWindow");
-        lastLogTime[sourceAddress] = currentTime;
-    }
+    LOG_DEBUG(QString("ICMP ping replied to %1 (ID: %2, Seq: %3, Time: %4ms)")
+              .arg(sourceAddress).arg(identifier).arg(sequence).arg(responseTime), "MainWindow");
 }
 
 void MainWindow::onPingResponderError(const QString& error)
@@ -1611,6 +1561,8 @@ void MainWindow::restartEchoServer()
     // Start with new configuration if enabled
     if (config.isEchoServerEnabled()) {
         LOG_INFO(QString("Starting echo server on port %1").arg(config.getEchoServerPort()), "MainWindow");
+        m_echoServer->setMode(EchoServer::modeFromString(config.getEchoServerMode()));
+        m_echoServer->setMaxConnections(config.getEchoServerMaxConnections());
         if (m_echoServer->startServer(config.getEchoServerPort())) {
             LOG_INFO(QString("Echo server restarted on port %1").arg(m_echoServer->serverPort()), "MainWindow");
             showMessage(QString("Echo server restarted on port %1").arg(m_echoServer->serverPort()));
@@ -1622,6 +1574,16 @@ void MainWindow::restartEchoServer()
         LOG_INFO("Echo server disabled in configuration", "MainWindow");
         showMessage("Echo server disabled");
     }
+    
+    // The UDP echo server follows its own settings
+    m_udpEchoServer->stopServer();
+    if (config.isUdpEchoServerEnabled()) {
+        if (m_udpEchoServer->startServer(config.getUdpEchoServerPort())) {
+            LOG_INFO(QString("UDP echo server restarted on port %1").arg(m_udpEchoServer->serverPort()), "MainWindow");
+        } else {
+            LOG_WARNING("Failed to restart UDP echo server", "MainWindow");
+        }
+    }
 }
 
 void MainWindow::createMenuBar()
@@ -1681,11 +1643,34 @@ void MainWindow::createCentralWidget()
     // Camera management group
     m_cameraGroupBox = new QGroupBox("Camera Configuration");
     QVBoxLayout* cameraLayout = new QVBoxLayout(m_cameraGroupBox);    // Camera table
-    m_cameraTable = new QTableWidget(0, 11);
-    QStringList headers = {"#", "Name", "Brand", "Model", "IP Address", "Port", "External Port", "Status", "Connections", "Data Transferred", "Actions"};
-    m_cameraTable->setHorizontalHeaderLabels(headers);
+    m_cameraModel = new CameraTableModel(m_cameraManager, this);
+    m_cameraTable = new QTableView;
+    m_cameraTable->setModel(m_cameraModel);
     m_cameraTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_cameraTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_cameraTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     m_cameraTable->setAlternatingRowColors(true);
+    m_cameraTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    
+    // Action buttons are painted by the delegate, not created per row
+    CameraActionDelegate* actionDelegate = new CameraActionDelegate(m_cameraTable);
+    m_cameraTable->setItemDelegateForColumn(CameraTableModel::ActionsColumn, actionDelegate);
+    m_cameraTable->setItemDelegateForColumn(CameraTableModel::ThroughputColumn,
+                                            new CameraThroughputDelegate(m_cameraTable));
+    connect(actionDelegate, &CameraActionDelegate::startStopClicked, this, [this](const QString& cameraId) {
+        if (m_cameraManager->isCameraRunning(cameraId)) {
+            m_cameraManager->stopCamera(cameraId);
+        } else {
+            m_cameraManager->startCamera(cameraId);
+        }
+    });
+    connect(actionDelegate, &CameraActionDelegate::restartClicked, this, [this](const QString& cameraId) {
+        m_cameraManager->getPortForwarder()->restartForwarding(cameraId);
+    });
+    connect(actionDelegate, &CameraActionDelegate::testClicked, this, [this](const QString& cameraId) {
+        m_cameraTable->selectRow(m_cameraModel->rowOf(cameraId));
+        testCamera();
+    });
     
     // Set specific column widths for better text display
     m_cameraTable->setColumnWidth(0, 35);   // #
@@ -1698,6 +1683,7 @@ void MainWindow::createCentralWidget()
     m_cameraTable->setColumnWidth(7, 80);   // Status
     m_cameraTable->setColumnWidth(8, 90);   // Connections
     m_cameraTable->setColumnWidth(9, 120);  // Data Transferred
+    m_cameraTable->setColumnWidth(10, 170); // Throughput
     // Actions column will stretch to fill remaining space
     m_cameraTable->horizontalHeader()->setStretchLastSection(true);
     
@@ -1744,18 +1730,65 @@ void MainWindow::createCentralWidget()
     
     // Log viewer group
     m_logGroupBox = new QGroupBox("Application Log");
-    QVBoxLayout* logLayout = new QVBoxLayout(m_logGroupBox);    m_logTextEdit = new QTextEdit;
-    m_logTextEdit->setMaximumHeight(300);
-    m_logTextEdit->setMinimumHeight(180);
-    m_logTextEdit->setReadOnly(true);
-    m_logTextEdit->setFont(QFont("Consolas", 9));
+    QVBoxLayout* logLayout = new QVBoxLayout(m_logGroupBox);
+    
+    // Only the visible rows are laid out, so the view stays cheap however
+    // many lines the model holds
+    m_logModel = new LogModel(this);
+    m_logFilterModel = new LogFilterModel(this);
+    m_logFilterModel->setSourceModel(m_logModel);
+    m_logView = new QListView;
+    m_logView->setModel(m_logFilterModel);
+    m_logView->setUniformItemSizes(true);
+    m_logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_logView->setMaximumHeight(300);
+    m_logView->setMinimumHeight(180);
+    m_logView->setFont(QFont("Consolas", 9));
+    
+    // Follow new lines only while the user has not scrolled up
+    m_logFollowTail = true;
+    connect(m_logFilterModel, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar* scrollBar = m_logView->verticalScrollBar();
+        m_logFollowTail = scrollBar->value() == scrollBar->maximum();
+    });
+    connect(m_logFilterModel, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (m_logFollowTail) {
+            m_logView->scrollToBottom();
+        }
+    });
     
-    logLayout->addWidget(m_logTextEdit);
+    logLayout->addWidget(m_logView);
     
     QHBoxLayout* logButtonLayout = new QHBoxLayout;
+    m_logLevelFilter = new QComboBox;
+    m_logLevelFilter->addItem("Debug", static_cast<int>(LogLevel::Debug));
+    m_logLevelFilter->addItem("Info", static_cast<int>(LogLevel::Info));
+    m_logLevelFilter->addItem("Warning", static_cast<int>(LogLevel::Warning));
+    m_logLevelFilter->addItem("Error", static_cast<int>(LogLevel::Error));
+    connect(m_logLevelFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        m_logFilterModel->setMinimumLevel(static_cast<LogLevel>(m_logLevelFilter->itemData(index).toInt()));
+        m_logView->scrollToBottom();
+    });
+    
+    m_logCategoryFilter = new QComboBox;
+    m_logCategoryFilter->addItem("All categories", QString());
+    m_logCategoryFilter->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    connect(m_logModel, &LogModel::categoryAdded, this, [this](const QString& category) {
+        m_logCategoryFilter->addItem(category, category);
+    });
+    connect(m_logCategoryFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        m_logFilterModel->setCategory(m_logCategoryFilter->itemData(index).toString());
+        m_logView->scrollToBottom();
+    });
+    
     m_clearLogButton = new QPushButton("Clear Log");
-    connect(m_clearLogButton, &QPushButton::clicked, m_logTextEdit, &QTextEdit::clear);
+    connect(m_clearLogButton, &QPushButton::clicked, m_logModel, &LogModel::clear);
     
+    logButtonLayout->addWidget(new QLabel("Level:"));
+    logButtonLayout->addWidget(m_logLevelFilter);
+    logButtonLayout->addWidget(new QLabel("Category:"));
+    logButtonLayout->addWidget(m_logCategoryFilter);
     logButtonLayout->addWidget(m_clearLogButton);
     logButtonLayout->addStretch();
     
@@ -1798,10 +1831,15 @@ void MainWindow::createCentralWidget()
 void MainWindow::setupConnections()
 {
     // Camera table
-    connect(m_cameraTable, &QTableWidget::itemSelectionChanged,
+    connect(m_cameraTable->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &MainWindow::onCameraSelectionChanged);
-    connect(m_cameraTable, &QTableWidget::itemDoubleClicked,
-            this, &MainWindow::showCameraInfo);// Camera buttons
+    connect(m_cameraTable, &QTableView::doubleClicked, this, [this](const QModelIndex& index) {
+        if (index.column() == CameraTableModel::ThroughputColumn) {
+            showThroughputHistory(m_cameraModel->cameraId(index.row()));
+        } else {
+            showCameraInfo();
+        }
+    });// Camera buttons
     connect(m_addButton, &QPushButton::clicked, this, &MainWindow::addCamera);
     connect(m_discoverButton, &QPushButton::clicked, this, &MainWindow::discoverCameras);
     connect(m_editButton, &QPushButton::clicked, this, &MainWindow::editCamera);
@@ -1857,150 +1895,17 @@ void MainWindow::setupConnections()
             this, &MainWindow::onLogMessage);
 }
 
-void MainWindow::updateCameraTable()
+QString MainWindow::selectedCameraId() const
 {
-    m_cameraTable->setRowCount(0);
-    
-    QList<CameraConfig> cameras = ConfigManager::instance().getAllCameras();
-    for (int i = 0; i < cameras.size(); ++i) {
-        const CameraConfig& camera = cameras[i];
-        
-        m_cameraTable->insertRow(i);
-        
-        // Index (hidden, stores camera ID)
-        QTableWidgetItem* indexItem = new QTableWidgetItem(QString::number(i + 1));
-        indexItem->setData(Qt::UserRole, camera.id());
-        m_cameraTable->setItem(i, 0, indexItem);
-        
-        // Name
-        m_cameraTable->setItem(i, 1, new QTableWidgetItem(camera.name()));
-        
-        // Brand
-        QTableWidgetItem* brandItem = new QTableWidgetItem(camera.brand());
-        if (camera.brand() == "Hikvision") {
-            brandItem->setBackground(QColor(230, 250, 230)); // Light green
-        } else if (camera.brand() == "CP Plus") {
-            brandItem->setBackground(QColor(230, 230, 250)); // Light blue
-        } else if (camera.brand() == "Generic") {
-            brandItem->setBackground(QColor(250, 250, 230)); // Light yellow
-        }
-        m_cameraTable->setItem(i, 2, brandItem);
-        
-        // Model
-        m_cameraTable->setItem(i, 3, new QTableWidgetItem(camera.model().isEmpty() ? "Unknown" : camera.model()));
-        
-        // IP Address
-        m_cameraTable->setItem(i, 4, new QTableWidgetItem(camera.ipAddress()));
-        
-        // Port
-        m_cameraTable->setItem(i, 5, new QTableWidgetItem(QString::number(camera.port())));
-        
-        // External Port
-        m_cameraTable->setItem(i, 6, new QTableWidgetItem(QString::number(camera.externalPort())));
-        
-        // Status
-        bool isRunning = m_cameraManager->isCameraRunning(camera.id());
-        QString status;
-        if (!camera.isEnabled()) {
-            status = "Disabled";
-        } else if (isRunning) {
-            status = "Running";
-        } else {
-            status = "Stopped";
-        }
-        
-        QTableWidgetItem* statusItem = new QTableWidgetItem(status);
-        if (isRunning) {
-            statusItem->setBackground(QColor(144, 238, 144)); // Light green
-        } else if (!camera.isEnabled()) {
-            statusItem->setBackground(QColor(211, 211, 211)); // Light gray        } else {
-            statusItem->setBackground(QColor(255, 182, 193)); // Light red
-        }
-        m_cameraTable->setItem(i, 7, statusItem);
-        
-        // Connections column - shows active connection count
-        int connectionCount = 0;
-        if (isRunning) {
-            connectionCount = m_cameraManager->getPortForwarder()->getConnectionCount(camera.id());
-        }
-        QTableWidgetItem* connectionsItem = new QTableWidgetItem(QString::number(connectionCount));
-        connectionsItem->setTextAlignment(Qt::AlignCenter);
-        if (connectionCount > 0) {
-            connectionsItem->setBackground(QColor(144, 238, 144)); // Light green
-        }
-        m_cameraTable->setItem(i, 8, connectionsItem);
-        
-        // Data Transferred column - shows bytes transferred
-        QString dataTransferred = "0 B";
-        if (isRunning) {
-            qint64 bytes = m_cameraManager->getPortForwarder()->getBytesTransferred(camera.id());
-            if (bytes > 0) {
-                if (bytes >= 1024 * 1024 * 1024) {
-                    dataTransferred = QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
-                } else if (bytes >= 1024 * 1024) {
-                    dataTransferred = QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
-                } else if (bytes >= 1024) {
-                    dataTransferred = QString::number(bytes / 1024.0, 'f', 2) + " KB";
-                } else {
-                    dataTransferred = QString::number(bytes) + " B";
-                }
-            }
-        }
-        QTableWidgetItem* dataItem = new QTableWidgetItem(dataTransferred);
-        dataItem->setTextAlignment(Qt::AlignCenter);
-        m_cameraTable->setItem(i, 9, dataItem);
-        
-        // Actions column - control buttons for each camera
-        QWidget* actionWidget = new QWidget();
-        QHBoxLayout* actionLayout = new QHBoxLayout(actionWidget);
-        actionLayout->setContentsMargins(2, 2, 2, 2);
-        actionLayout->setSpacing(2);
-        
-        QPushButton* startStopBtn = new QPushButton(isRunning ? "Stop" : "Start");
-        startStopBtn->setMaximumWidth(50);
-        startStopBtn->setEnabled(camera.isEnabled());
-        connect(startStopBtn, &QPushButton::clicked, [this, camera]() {
-            if (m_cameraManager->isCameraRunning(camera.id())) {
-                m_cameraManager->stopCamera(camera.id());
-            } else {
-                m_cameraManager->startCamera(camera.id());
-            }
-        });
-        
-        QPushButton* restartBtn = new QPushButton("↻");
-        restartBtn->setToolTip("Restart Port Forwarding");
-        restartBtn->setMaximumWidth(30);
-        restartBtn->setEnabled(isRunning);
-        connect(restartBtn, &QPushButton::clicked, [this, camera]() {
-            m_cameraManager->getPortForwarder()->restartForwarding(camera.id());
-        });
-        
-        QPushButton* testBtn = new QPushButton("Test");
-        testBtn->setMaximumWidth(40);
-        connect(testBtn, &QPushButton::clicked, [this, camera]() {
-            // Set the current camera ID for testing
-            QTableWidgetItem* idItem = m_cameraTable->item(m_cameraTable->currentRow(), 0);
-            if (idItem) {
-                testCamera();
-            }
-        });
-        
-        actionLayout->addWidget(startStopBtn);
-        actionLayout->addWidget(restartBtn);
-        actionLayout->addWidget(testBtn);
-        actionLayout->addStretch();
-        
-        m_cameraTable->setCellWidget(i, 10, actionWidget);
-    }
-    
-    // Resize columns to content
-    m_cameraTable->resizeColumnsToContents();
+    const QModelIndexList rows = m_cameraTable->selectionModel()->selectedRows();
+    return rows.isEmpty() ? QString() : m_cameraModel->cameraId(rows.first().row());
 }
 
 void MainWindow::updateButtons()
 {
-    bool hasSelection = m_cameraTable->currentRow() >= 0;
-    bool hasCamera = m_cameraTable->rowCount() > 0;
+    QString selectedId = selectedCameraId();
+    bool hasSelection = !selectedId.isEmpty();
+    bool hasCamera = m_cameraModel->rowCount() > 0;
       m_editButton->setEnabled(hasSelection);
     m_removeButton->setEnabled(hasSelection);
     m_toggleButton->setEnabled(hasSelection);
@@ -2011,12 +1916,8 @@ void MainWindow::updateButtons()
     
     // Update toggle button text
     if (hasSelection) {
-        QTableWidgetItem* idItem = m_cameraTable->item(m_cameraTable->currentRow(), 0);
-        if (idItem) {
-            QString cameraId = idItem->data(Qt::UserRole).toString();
-            bool isRunning = m_cameraManager->isCameraRunning(cameraId);
-            m_toggleButton->setText(isRunning ? "Stop Camera" : "Start Camera");
-        }
+        bool isRunning = m_cameraManager->isCameraRunning(selectedId);
+        m_toggleButton->setText(isRunning ? "Stop Camera" : "Start Camera");
     } else {
         m_toggleButton->setText("Start/Stop");
     }
@@ -2075,17 +1976,10 @@ void MainWindow::saveSettings()
 
 void MainWindow::testCamera()
 {
-    int row = m_cameraTable->currentRow();
-    if (row < 0) return;
-    
-    QTableWidgetItem* idItem = m_cameraTable->item(row, 0);
-    QTableWidgetItem* ipItem = m_cameraTable->item(row, 4);  // IP Address column
-    QTableWidgetItem* testItem = m_cameraTable->item(row, 8); // Test column
-    
-    if (!idItem || !ipItem || !testItem) return;
+    QString cameraId = selectedCameraId();
+    if (cameraId.isEmpty()) return;
     
-    QString cameraId = idItem->data(Qt::UserRole).toString();
-    QString ipAddress = ipItem->text();
+    QString ipAddress = m_cameraModel->camera(cameraId).ipAddress();
     
     // Clean up previous ping process
     if (m_pingProcess) {
@@ -2094,8 +1988,7 @@ void MainWindow::testCamera()
     }
     
     // Update UI to show testing state
-    testItem->setText("Testing...");
-    testItem->setBackground(QColor(255, 255, 0)); // Yellow
+    m_cameraModel->setTestState(cameraId, CameraTableModel::Testing);
     m_testButton->setEnabled(false);
     
     // Store current testing camera
@@ -2129,35 +2022,20 @@ void MainWindow::onPingFinished(int exitCode, QProcess::ExitStatus exitStatus)
     // Re-enable test button
     m_testButton->setEnabled(true);
     
-    // Find the row for the current testing camera
-    int testRow = -1;
-    for (int i = 0; i < m_cameraTable->rowCount(); ++i) {
-        QTableWidgetItem* idItem = m_cameraTable->item(i, 0);
-        if (idItem && idItem->data(Qt::UserRole).toString() == m_currentTestingCameraId) {
-            testRow = i;
-            break;
-        }
-    }
-      if (testRow >= 0) {
-        QTableWidgetItem* testItem = m_cameraTable->item(testRow, 8); // Test column
-        QTableWidgetItem* ipItem = m_cameraTable->item(testRow, 4);   // IP Address column
+    // The camera may have been removed while the ping ran
+    if (m_cameraModel->rowOf(m_currentTestingCameraId) >= 0) {
+        QString ipAddress = m_cameraModel->camera(m_currentTestingCameraId).ipAddress();
         
-        if (testItem && ipItem) {
-            QString ipAddress = ipItem->text();
-            
-            if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                // Ping successful
-                testItem->setText("✓ Online");
-                testItem->setBackground(QColor(144, 238, 144)); // Light green
-                showMessage(QString("Camera at %1 is online and reachable").arg(ipAddress));
-                LOG_INFO(QString("Ping test successful for camera at %1").arg(ipAddress), "MainWindow");
-            } else {
-                // Ping failed
-                testItem->setText("✗ Offline");
-                testItem->setBackground(QColor(255, 182, 193)); // Light red
-                showMessage(QString("Camera at %1 is not reachable").arg(ipAddress));
-                LOG_WARNING(QString("Ping test failed for camera at %1 (exit code: %2)").arg(ipAddress).arg(exitCode), "MainWindow");
-            }
+        if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+            // Ping successful
+            m_cameraModel->setTestState(m_currentTestingCameraId, CameraTableModel::Online);
+            showMessage(QString("Camera at %1 is online and reachable").arg(ipAddress));
+            LOG_INFO(QString("Ping test successful for camera at %1").arg(ipAddress), "MainWindow");
+        } else {
+            // Ping failed
+            m_cameraModel->setTestState(m_currentTestingCameraId, CameraTableModel::Offline);
+            showMessage(QString("Camera at %1 is not reachable").arg(ipAddress));
+            LOG_WARNING(QString("Ping test failed for camera at %1 (exit code: %2)").arg(ipAddress).arg(exitCode), "MainWindow");
         }
     }
     
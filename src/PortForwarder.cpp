@@ -1,6 +1,9 @@
 #include "PortForwarder.h"
 #include "Logger.h"
 #include "NetworkInterfaceManager.h"
+#include "ForwardingServer.h"
+#include "SpliceRelay.h"
+#include "UdpPortPool.h"
 #include <QNetworkProxy>
 #include <QTimer>
 #include <QNetworkInterface>
@@ -8,12 +11,33 @@
 PortForwarder::PortForwarder(QObject *parent)
     : QObject(parent)
     , m_networkManager(nullptr)
-{
+    , m_relayBackend(RelayBackend::UserSpace)
+    , m_payloadInspection(false)
+    , m_engine(new ForwardingEngine(this))
+    , m_engineThreads(0)
+    , m_engineShardMode(ForwardingEngine::ShardMode::ByCamera)
+    , m_enginePinThreads(false)
+    , m_nextSessionId(1)
+    , m_statsTimer(new QTimer(this))
+    , m_throughputTimer(new QTimer(this))
+{
+    // Traffic counters are published on one timer instead of per relayed chunk
+    m_statsTimer->setInterval(DEFAULT_STATS_UPDATE_INTERVAL_MS);
+    connect(m_statsTimer, &QTimer::timeout, this, &PortForwarder::handleStatsTimer);
+    m_statsTimer->start();
+    
+    // Throughput is sampled at a fixed rate whatever the stats interval, so
+    // every sample covers the same time
+    m_throughputTimer->setTimerType(Qt::PreciseTimer);
+    m_throughputTimer->setInterval(ThroughputHistory::SAMPLE_INTERVAL_MS);
+    connect(m_throughputTimer, &QTimer::timeout, this, &PortForwarder::handleThroughputTimer);
+    m_throughputTimer->start();
 }
 
 PortForwarder::~PortForwarder()
 {
     stopAllForwarding();
+    m_engine->shutdown();
 }
 
 bool PortForwarder::startForwarding(const CameraConfig& camera)
@@ -47,11 +71,13 @@ bool PortForwarder::startForwarding(const CameraConfig& camera)
     // Create new session
     ForwardingSession* session = new ForwardingSession;
     session->camera = camera;
-    session->server = new QTcpServer(this);
+    session->server = new ForwardingServer(cameraId, this);
+    session->sessionId = m_nextSessionId++;
+    session->connectionCount = 0;
     session->isReconnecting = false;
     session->reconnectAttempts = 0;
-    session->totalBytesTransferred = 0;
-    session->lastActivity = QDateTime::currentDateTime();
+    session->traffic = QSharedPointer<TrafficCounters>::create();
+    session->traffic->touch();
     session->status = "Starting";
     
     // Set up reconnect timer
@@ -66,7 +92,7 @@ bool PortForwarder::startForwarding(const CameraConfig& camera)
     connect(session->healthCheckTimer, &QTimer::timeout, this, &PortForwarder::handleHealthCheck);
     
     // Connect server signals
-    connect(session->server, &QTcpServer::newConnection, this, &PortForwarder::handleNewConnection);
+    connect(session->server, &ForwardingServer::connectionPending, this, &PortForwarder::handleNewConnection);
     
     // Start listening on all interfaces
     LOG_DEBUG(QString("Attempting to bind to all interfaces on port %1").arg(externalPort), "PortForwarder");
@@ -87,6 +113,17 @@ bool PortForwarder::startForwarding(const CameraConfig& camera)
     
     // Store session
     m_sessions[cameraId] = session;
+    ensureEngine();
+    
+    // Open the camera's warm connections before the first viewer asks for one
+    if (camera.warmConnections() > 0 && !camera.isFanOutEnabled()) {
+        ForwardingWorker* worker = m_engine->workerForCamera(cameraId);
+        const quint64 sessionId = session->sessionId;
+        const QSharedPointer<TrafficCounters> traffic = session->traffic;
+        QMetaObject::invokeMethod(worker, [worker, camera, sessionId, traffic]() {
+            worker->prewarmSession(camera, sessionId, traffic);
+        });
+    }
     
     // Start health check timer
     session->healthCheckTimer->start();
@@ -131,33 +168,17 @@ void PortForwarder::stopForwarding(const QString& cameraId)
         session->reconnectTimer = nullptr;
     }
     
-    // Close all connections with detailed logging
-    int connectionCount = session->connections.size();
+    // Close all connections on the workers that own them
+    int connectionCount = session->connectionCount;
     LOG_INFO(QString("Closing %1 active connections for camera: %2")
              .arg(connectionCount).arg(session->camera.name()), "PortForwarder");
     
-    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-        QTcpSocket* clientSocket = it.key();
-        ConnectionInfo* connInfo = it.value();
-        
-        if (connInfo) {
-            logConnectionDetails(cameraId, connInfo, "Closing");
-            
-            if (connInfo->targetSocket) {
-                connInfo->targetSocket->disconnectFromHost();
-                connInfo->targetSocket->deleteLater();
-            }
-            
-            delete connInfo;
-        }
-        
-        if (clientSocket) {
-            m_socketToCameraMap.remove(clientSocket);
-            clientSocket->disconnectFromHost();
-            clientSocket->deleteLater();
-        }
+    const quint64 sessionId = session->sessionId;
+    for (ForwardingWorker* worker : m_engine->workers()) {
+        QMetaObject::invokeMethod(worker, [worker, cameraId, sessionId]() {
+            worker->closeSession(cameraId, sessionId);
+        });
     }
-    session->connections.clear();
     
     // Stop and cleanup server
     if (session->server) {
@@ -171,7 +192,7 @@ void PortForwarder::stopForwarding(const QString& cameraId)
     // Log final statistics
     LOG_INFO(QString("Final statistics for camera '%1': %2 bytes transferred, %3 connections handled")
              .arg(session->camera.name())
-             .arg(session->totalBytesTransferred)
+             .arg(session->traffic->snapshot().totalBytes())
              .arg(connectionCount), "PortForwarder");    delete session;
     m_sessions.remove(cameraId);
     
@@ -272,7 +293,7 @@ int PortForwarder::getConnectionCount(const QString& cameraId) const
     if (!m_sessions.contains(cameraId)) {
         return 0;
     }
-    return m_sessions[cameraId]->connections.size();
+    return m_sessions[cameraId]->connectionCount;
 }
 
 qint64 PortForwarder::getBytesTransferred(const QString& cameraId) const
@@ -280,304 +301,181 @@ qint64 PortForwarder::getBytesTransferred(const QString& cameraId) const
     if (!m_sessions.contains(cameraId)) {
         return 0;
     }
-    return m_sessions[cameraId]->totalBytesTransferred;
+    return static_cast<qint64>(m_sessions[cameraId]->traffic->snapshot().totalBytes());
 }
 
-QString PortForwarder::getConnectionStatus(const QString& cameraId) const
+TrafficSnapshot PortForwarder::getTrafficSnapshot(const QString& cameraId) const
 {
     if (!m_sessions.contains(cameraId)) {
-        return "Not Active";
+        return TrafficSnapshot();
     }
-    return m_sessions[cameraId]->status;
+    return m_sessions[cameraId]->traffic->snapshot();
 }
 
-void PortForwarder::handleNewConnection()
+QHash<QString, TrafficSnapshot> PortForwarder::getTrafficSnapshots() const
 {
-    QTcpServer* server = qobject_cast<QTcpServer*>(sender());
-    if (!server) {
-        LOG_ERROR("handleNewConnection called with invalid server", "PortForwarder");
-        return;
+    QHash<QString, TrafficSnapshot> snapshots;
+    snapshots.reserve(m_sessions.size());
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        snapshots.insert(it.key(), it.value()->traffic->snapshot());
     }
-    
-    // Find which camera this server belongs to
-    QString cameraId;
-    ForwardingSession* session = nullptr;
-    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
-        if (it.value()->server == server) {
-            cameraId = it.key();
-            session = it.value();
-            break;
-        }
+    return snapshots;
+}
+
+void PortForwarder::setStatsUpdateInterval(int intervalMs)
+{
+    if (intervalMs < MIN_STATS_UPDATE_INTERVAL_MS) {
+        LOG_WARNING(QString("Statistics update interval %1 ms too short, using %2 ms")
+                    .arg(intervalMs).arg(MIN_STATS_UPDATE_INTERVAL_MS), "PortForwarder");
+        intervalMs = MIN_STATS_UPDATE_INTERVAL_MS;
     }
-    
-    if (cameraId.isEmpty() || !session) {
-        LOG_ERROR("Received connection for unknown server", "PortForwarder");
+    m_statsTimer->setInterval(intervalMs);
+}
+
+int PortForwarder::statsUpdateInterval() const
+{
+    return m_statsTimer->interval();
+}
+
+void PortForwarder::handleStatsTimer()
+{
+    emit statsUpdated(getTrafficSnapshots());
+}
+
+const ThroughputHistory* PortForwarder::getThroughputHistory(const QString& cameraId) const
+{
+    const ForwardingSession* session = m_sessions.value(cameraId);
+    return session ? &session->throughput : nullptr;
+}
+
+void PortForwarder::handleThroughputTimer()
+{
+    if (m_sessions.isEmpty()) {
         return;
     }
-    
-    QTcpSocket* clientSocket = server->nextPendingConnection();
-    if (!clientSocket) {
-        LOG_ERROR("No pending connection available", "PortForwarder");
-        return;
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        ForwardingSession* session = it.value();
+        const TrafficSnapshot traffic = session->traffic->snapshot();
+        session->throughput.record(traffic.bytesTargetToClient, traffic.bytesClientToTarget);
     }
-    
-    QString clientAddress = QString("%1:%2")
-        .arg(clientSocket->peerAddress().toString())
-        .arg(clientSocket->peerPort());
-    
-    LOG_INFO(QString("New client connection from %1 for camera '%2' [ID: %3]")
-             .arg(clientAddress).arg(session->camera.name()).arg(cameraId), "PortForwarder");
-    
-    // Create connection info structure
-    ConnectionInfo* connInfo = new ConnectionInfo;
-    connInfo->clientSocket = clientSocket;
-    connInfo->targetSocket = new QTcpSocket(this);
-    connInfo->clientAddress = clientAddress;
-    connInfo->bytesTransferred = 0;
-    connInfo->connectedTime = QDateTime::currentDateTime();
-    connInfo->isTargetConnected = false;
-      // Store connection mapping
-    session->connections[clientSocket] = connInfo;
-    m_socketToCameraMap[clientSocket] = cameraId;
-    m_socketToCameraMap[connInfo->targetSocket] = cameraId;
-    
-    // Optimize sockets for RTSP streaming
-    optimizeSocketForStreaming(clientSocket);
-    optimizeSocketForStreaming(connInfo->targetSocket);
-    
-    // Connect client socket signals
-    connect(clientSocket, &QTcpSocket::disconnected, 
-            this, &PortForwarder::handleClientDisconnected);
-    connect(clientSocket, &QTcpSocket::readyRead, 
-            this, &PortForwarder::handleClientDataReady);
-    connect(clientSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
-            this, &PortForwarder::handleConnectionError);
-    
-    // Connect target socket signals
-    connect(connInfo->targetSocket, &QTcpSocket::connected, 
-            this, &PortForwarder::handleTargetConnected);
-    connect(connInfo->targetSocket, &QTcpSocket::disconnected, 
-            this, &PortForwarder::handleTargetDisconnected);
-    connect(connInfo->targetSocket, &QTcpSocket::readyRead, 
-            this, &PortForwarder::handleTargetDataReady);
-    connect(connInfo->targetSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
-            this, &PortForwarder::handleConnectionError);
-      // Attempt connection to target camera
-    LOG_DEBUG(QString("Connecting to target camera %1:%2 for client %3")
-              .arg(session->camera.ipAddress())
-              .arg(session->camera.port())
-              .arg(clientAddress), "PortForwarder");
-      // Set connection timeout for RTSP (extended timeout for better reliability)
-    connInfo->targetSocket->connectToHost(session->camera.ipAddress(), session->camera.port());
-    
-    // Set connection timeout to 30 seconds for RTSP cameras
-    QTimer::singleShot(30000, connInfo->targetSocket, [this, clientSocket, cameraId]() {
-        if (!m_sessions.contains(cameraId)) return;
-        
-        ForwardingSession* session = m_sessions[cameraId];
-        if (!session->connections.contains(clientSocket)) return;
-        
-        ConnectionInfo* info = session->connections[clientSocket];
-        if (info && info->targetSocket && 
-            info->targetSocket->state() == QAbstractSocket::ConnectingState) {
-            LOG_WARNING(QString("Connection timeout to camera %1, aborting").arg(cameraId), "PortForwarder");
-            info->targetSocket->abort();
-        }
-    });
-    
-    // Update session activity
-    session->lastActivity = QDateTime::currentDateTime();
-    updateSessionStatus(cameraId, QString("Active - %1 connections").arg(session->connections.size()));
-    
-    emit connectionEstablished(cameraId, clientAddress);
+    emit throughputSampled();
 }
 
-void PortForwarder::handleClientDisconnected()
+QHash<QString, qint64> PortForwarder::getConnectionQueueDepths(const QString& cameraId) const
 {
-    QTcpSocket* clientSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!clientSocket) {
-        LOG_ERROR("handleClientDisconnected called with invalid socket", "PortForwarder");
-        return;
+    if (!m_sessions.contains(cameraId)) {
+        return QHash<QString, qint64>();
     }
-    
-    QString cameraId = m_socketToCameraMap.value(clientSocket);
-    if (cameraId.isEmpty() || !m_sessions.contains(cameraId)) {
-        LOG_DEBUG("Client disconnected for unknown camera", "PortForwarder");
-        clientSocket->deleteLater();
-        return;
+    return m_sessions[cameraId]->queueDepths;
+}
+
+QString PortForwarder::getConnectionStatus(const QString& cameraId) const
+{
+    if (!m_sessions.contains(cameraId)) {
+        return "Not Active";
     }
-    
-    ForwardingSession* session = m_sessions[cameraId];
-    ConnectionInfo* connInfo = session->connections.value(clientSocket);
-    
-    if (!connInfo) {
-        LOG_ERROR("No connection info found for disconnecting client", "PortForwarder");
-        clientSocket->deleteLater();
-        return;
+    const ForwardingSession* session = m_sessions[cameraId];
+    if (session->udpStreams.isEmpty()) {
+        return session->status;
     }
     
-    QString clientAddress = connInfo->clientAddress;
-    LOG_INFO(QString("Client disconnected: %1 for camera '%2'")
-             .arg(clientAddress).arg(session->camera.name()), "PortForwarder");
-    
-    // Log connection details before cleanup
-    logConnectionDetails(cameraId, connInfo, "Client Disconnected");
-    
-    // Cleanup target socket
-    if (connInfo->targetSocket) {
-        m_socketToCameraMap.remove(connInfo->targetSocket);
-        connInfo->targetSocket->disconnectFromHost();
-        connInfo->targetSocket->deleteLater();
+    // Per-stream counters of the media relayed over UDP
+    QStringList streams;
+    for (auto it = session->udpStreams.constBegin(); it != session->udpStreams.constEnd(); ++it) {
+        const TrafficSnapshot traffic = it.value()->snapshot();
+        streams << QString("%1: %2 packets, %3 bytes")
+                   .arg(it.key()).arg(traffic.packets).arg(traffic.totalBytes());
     }
-    
-    // Remove from session
-    session->connections.remove(clientSocket);
-    m_socketToCameraMap.remove(clientSocket);
-    
-    // Update session status
-    updateSessionStatus(cameraId, QString("Active - %1 connections").arg(session->connections.size()));
-    
-    // Clean up connection info
-    delete connInfo;
-    
-    emit connectionClosed(cameraId, clientAddress);
-    clientSocket->deleteLater();
+    return QString("%1 | UDP %2").arg(session->status).arg(streams.join("; "));
 }
 
-void PortForwarder::handleClientDataReady()
+void PortForwarder::handleNewConnection(qintptr socketDescriptor)
 {
-    QTcpSocket* clientSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!clientSocket) {
-        LOG_ERROR("handleClientDataReady called with invalid socket", "PortForwarder");
+    ForwardingServer* server = qobject_cast<ForwardingServer*>(sender());
+    if (!server) {
+        LOG_ERROR("handleNewConnection called with invalid server", "PortForwarder");
         return;
     }
     
-    QString cameraId = m_socketToCameraMap.value(clientSocket);
-    if (cameraId.isEmpty() || !m_sessions.contains(cameraId)) {
-        LOG_DEBUG("Data ready for unknown camera connection", "PortForwarder");
+    // Find which camera this server belongs to
+    const QString cameraId = server->cameraId();
+    ForwardingSession* session = m_sessions.value(cameraId);
+    // A shared camera stream or a warm pool only works if all its viewers
+    // are on one worker
+    const bool pinnedToWorker = session && (session->camera.isFanOutEnabled() ||
+                                            session->camera.warmConnections() > 0);
+    ForwardingWorker* worker = pinnedToWorker
+                               ? m_engine->workerForCamera(cameraId)
+                               : m_engine->workerFor(cameraId);
+    
+    if (!session || session->server != server || !worker) {
+        LOG_ERROR("Received connection for unknown server", "PortForwarder");
+        QTcpSocket discard;
+        discard.setSocketDescriptor(socketDescriptor);
+        discard.abort();
         return;
     }
     
-    ForwardingSession* session = m_sessions[cameraId];
-    ConnectionInfo* connInfo = session->connections.value(clientSocket);
+    // The worker adopts the descriptor on its own thread
+    const CameraConfig camera = session->camera;
+    const quint64 sessionId = session->sessionId;
+    const QSharedPointer<TrafficCounters> traffic = session->traffic;
+    QMetaObject::invokeMethod(worker, [worker, camera, sessionId, traffic, socketDescriptor]() {
+        worker->acceptConnection(camera, sessionId, traffic, socketDescriptor);
+    });
     
-    if (!connInfo || !connInfo->targetSocket) {
-        LOG_ERROR("No target connection found for client data", "PortForwarder");
-        return;
-    }      if (connInfo->targetSocket->state() == QAbstractSocket::ConnectedState) {
-        forwardData(clientSocket, connInfo->targetSocket, cameraId, "client->target");
-    } else if (connInfo->targetSocket->state() == QAbstractSocket::ConnectingState) {
-        // Buffer initial RTSP request data while target is connecting
-        QByteArray data = clientSocket->readAll();
-        if (!data.isEmpty()) {
-            connInfo->pendingClientData.append(data);
-            
-            // Limit buffer size to prevent memory issues (32KB should be enough for RTSP handshake)
-            if (connInfo->pendingClientData.size() > 32768) {
-                LOG_WARNING(QString("Pending data buffer overflow for camera %1, discarding oldest data").arg(cameraId), "PortForwarder");
-                connInfo->pendingClientData = connInfo->pendingClientData.right(16384); // Keep last 16KB
-            }
-            
-            LOG_DEBUG(QString("Buffered %1 bytes of client data while connecting to camera %2 (total buffered: %3)")
-                      .arg(data.size()).arg(cameraId).arg(connInfo->pendingClientData.size()), "PortForwarder");
-        }
-    } else {
-        LOG_DEBUG(QString("Target not connected (state: %1), dropping data for camera: %2")
-                  .arg(static_cast<int>(connInfo->targetSocket->state())).arg(cameraId), "PortForwarder");
-        clientSocket->readAll(); // Discard data if not connecting
-    }
+    // Update session activity
+    session->traffic->touch();
 }
 
-void PortForwarder::handleTargetConnected()
+PortForwarder::ForwardingSession* PortForwarder::findSession(const QString& cameraId, quint64 sessionId) const
 {
-    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!targetSocket) {
-        LOG_ERROR("handleTargetConnected called with invalid socket", "PortForwarder");
-        return;
-    }
-    
-    QString cameraId = m_socketToCameraMap.value(targetSocket);
-    if (cameraId.isEmpty() || !m_sessions.contains(cameraId)) {
-        LOG_ERROR("Target connected for unknown camera", "PortForwarder");
-        return;
+    ForwardingSession* session = m_sessions.value(cameraId);
+    if (!session || session->sessionId != sessionId) {
+        return nullptr;
     }
+    return session;
+}
+
+void PortForwarder::handleWorkerConnectionEstablished(const QString& cameraId, quint64 sessionId, const QString& clientAddress)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    ForwardingSession* session = m_sessions[cameraId];      // Find the connection info and mark target as connected
-    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-        ConnectionInfo* info = it.value();
-        if (info && info->targetSocket == targetSocket) {
-            info->isTargetConnected = true;
-            
-            // Optimize the connected socket for streaming
-            optimizeSocketForStreaming(targetSocket);
-            
-            // Send any buffered client data that arrived before target connection
-            if (!info->pendingClientData.isEmpty()) {
-                LOG_INFO(QString("Sending %1 bytes of buffered data to camera %2")
-                         .arg(info->pendingClientData.size()).arg(cameraId), "PortForwarder");
-                
-                qint64 bytesWritten = targetSocket->write(info->pendingClientData);
-                if (bytesWritten == -1) {
-                    LOG_ERROR(QString("Failed to send buffered data to camera %1: %2")
-                              .arg(cameraId).arg(targetSocket->errorString()), "PortForwarder");
-                } else {
-                    if (bytesWritten != info->pendingClientData.size()) {
-                        LOG_WARNING(QString("Partial write of buffered data: %1/%2 bytes for camera %3")
-                                    .arg(bytesWritten).arg(info->pendingClientData.size()).arg(cameraId), "PortForwarder");
-                    }
-                    info->bytesTransferred += bytesWritten;
-                    session->totalBytesTransferred += bytesWritten;
-                    targetSocket->flush(); // Ensure data is sent immediately
-                }
-                
-                info->pendingClientData.clear(); // Clear buffer after sending
-            }
-            
-            LOG_INFO(QString("Successfully connected to camera '%1' at %2:%3 for client %4")
-                     .arg(session->camera.name())
-                     .arg(session->camera.ipAddress())
-                     .arg(session->camera.port())
-                     .arg(info->clientAddress), "PortForwarder");
-            break;
-        }
-    }
+    session->connectionCount++;
+    session->traffic->touch();
+    updateSessionStatus(cameraId, QString("Active - %1 connections").arg(session->connectionCount));
     
-    // Reset reconnect attempts on successful connection
-    session->reconnectAttempts = 0;
-    session->lastActivity = QDateTime::currentDateTime();
-    updateSessionStatus(cameraId, QString("Connected - %1 active connections").arg(session->connections.size()));
+    emit connectionEstablished(cameraId, clientAddress);
 }
 
-void PortForwarder::handleTargetDisconnected()
+void PortForwarder::handleWorkerConnectionClosed(const QString& cameraId, quint64 sessionId, const QString& clientAddress)
 {
-    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!targetSocket) return;
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    QString cameraId = m_socketToCameraMap.value(targetSocket);
-    if (cameraId.isEmpty() || !m_sessions.contains(cameraId)) {
-        targetSocket->deleteLater();
-        return;
-    }
+    session->connectionCount = qMax(0, session->connectionCount - 1);
+    session->queueDepths.remove(clientAddress);
+    updateSessionStatus(cameraId, QString("Active - %1 connections").arg(session->connectionCount));
     
-    ForwardingSession* session = m_sessions[cameraId];
-      // Find and disconnect corresponding client
-    QTcpSocket* clientSocket = nullptr;
-    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-        if (it.value()->targetSocket == targetSocket) {
-            clientSocket = it.key();
-            break;
-        }
-    }
-    
-    if (clientSocket) {
-        session->connections.remove(clientSocket);
-        m_socketToCameraMap.remove(clientSocket);
-        clientSocket->disconnectFromHost();
-        clientSocket->deleteLater();
-    }
+    emit connectionClosed(cameraId, clientAddress);
+}
+
+void PortForwarder::handleWorkerTargetConnected(const QString& cameraId, quint64 sessionId)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    m_socketToCameraMap.remove(targetSocket);
-    targetSocket->deleteLater();
+    // Reset reconnect attempts on successful connection
+    session->reconnectAttempts = 0;
+    session->traffic->touch();
+    updateSessionStatus(cameraId, QString("Connected - %1 active connections").arg(session->connectionCount));
+}
+
+void PortForwarder::handleWorkerTargetDisconnected(const QString& cameraId, quint64 sessionId)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
     // Setup reconnect if camera is still enabled
     if (session->camera.isEnabled() && !session->isReconnecting) {
@@ -585,85 +483,55 @@ void PortForwarder::handleTargetDisconnected()
     }
 }
 
-void PortForwarder::handleTargetDataReady()
+void PortForwarder::handleWorkerConnectionError(const QString& cameraId, quint64 sessionId, const QString& error)
 {
-    QTcpSocket* targetSocket = qobject_cast<QTcpSocket*>(sender());
-    if (!targetSocket) {
-        LOG_ERROR("handleTargetDataReady called with invalid socket", "PortForwarder");
-        return;
-    }
-    
-    QString cameraId = m_socketToCameraMap.value(targetSocket);
-    if (cameraId.isEmpty() || !m_sessions.contains(cameraId)) {
-        LOG_DEBUG("Target data ready for unknown camera", "PortForwarder");
-        return;
-    }
+    if (!findSession(cameraId, sessionId)) return;
     
-    ForwardingSession* session = m_sessions[cameraId];
+    emit forwardingError(cameraId, error);
+}
+
+void PortForwarder::handleWorkerConnectionBackpressure(const QString& cameraId, quint64 sessionId, const QString& clientAddress,
+                                                       bool paused, qint64 queuedBytes)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    // Find corresponding client socket
-    QTcpSocket* clientSocket = nullptr;
-    ConnectionInfo* connInfo = nullptr;
+    session->queueDepths[clientAddress] = queuedBytes;
     
-    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-        ConnectionInfo* info = it.value();
-        if (info && info->targetSocket == targetSocket) {
-            clientSocket = it.key();
-            connInfo = info;
-            break;
-        }
+    if (paused) {
+        LOG_DEBUG(QString("Slow viewer %1 on camera '%2': %3 bytes queued, camera stream paused")
+                  .arg(clientAddress).arg(session->camera.name()).arg(queuedBytes), "PortForwarder");
     }
     
-    if (!clientSocket || !connInfo) {
-        LOG_ERROR("No client connection found for target data", "PortForwarder");
-        return;
-    }
+    emit connectionBackpressure(cameraId, clientAddress, paused, queuedBytes);
+}
+
+void PortForwarder::handleWorkerQueueDepths(const QString& cameraId, quint64 sessionId, const QHash<QString, qint64>& depths)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-        forwardData(targetSocket, clientSocket, cameraId, "target->client");
-    } else {
-        LOG_DEBUG(QString("Client not connected, dropping data for camera: %1").arg(cameraId), "PortForwarder");
+    // Several workers may report for the same camera in per-connection sharding
+    for (auto it = depths.begin(); it != depths.end(); ++it) {
+        session->queueDepths[it.key()] = it.value();
     }
 }
 
-void PortForwarder::handleConnectionError(QAbstractSocket::SocketError error)
+void PortForwarder::handleWorkerUdpStreamOpened(const QString& cameraId, quint64 sessionId, const QString& stream,
+                                                const QSharedPointer<TrafficCounters>& traffic)
 {
-    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) return;
-    
-    QString cameraId = m_socketToCameraMap.value(socket);
-    if (cameraId.isEmpty()) return;
-    
-    QString errorString = socket->errorString();
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    // Log different error types with appropriate severity
-    switch (error) {
-        case QAbstractSocket::ConnectionRefusedError:
-            LOG_ERROR(QString("Camera %1 connection refused: %2").arg(cameraId).arg(errorString), "PortForwarder");
-            break;
-        case QAbstractSocket::RemoteHostClosedError:
-            LOG_INFO(QString("Camera %1 remote host closed connection: %2").arg(cameraId).arg(errorString), "PortForwarder");
-            break;
-        case QAbstractSocket::HostNotFoundError:
-            LOG_ERROR(QString("Camera %1 host not found: %2").arg(cameraId).arg(errorString), "PortForwarder");
-            break;
-        case QAbstractSocket::SocketTimeoutError:
-            LOG_WARNING(QString("Camera %1 connection timeout: %2").arg(cameraId).arg(errorString), "PortForwarder");
-            break;
-        case QAbstractSocket::NetworkError:
-            LOG_WARNING(QString("Camera %1 network error: %2").arg(cameraId).arg(errorString), "PortForwarder");
-            break;
-        default:
-            LOG_WARNING(QString("Camera %1 connection error (code %2): %3").arg(cameraId).arg(static_cast<int>(error)).arg(errorString), "PortForwarder");
-            break;
-    }
+    session->udpStreams[stream] = traffic;
+}
+
+void PortForwarder::handleWorkerUdpStreamClosed(const QString& cameraId, quint64 sessionId, const QString& stream)
+{
+    ForwardingSession* session = findSession(cameraId, sessionId);
+    if (!session) return;
     
-    // Only emit forwardingError for serious errors that should be reported to user
-    if (error == QAbstractSocket::ConnectionRefusedError || 
-        error == QAbstractSocket::HostNotFoundError ||
-        error == QAbstractSocket::NetworkError) {
-        emit forwardingError(cameraId, errorString);
-    }
+    session->udpStreams.remove(stream);
 }
 
 void PortForwarder::handleReconnectTimer()
@@ -701,122 +569,103 @@ void PortForwarder::setupReconnectTimer(const QString& cameraId)
     LOG_INFO(QString("Setup reconnect timer for camera: %1").arg(session->camera.name()), "PortForwarder");
 }
 
-void PortForwarder::forwardData(QTcpSocket* from, QTcpSocket* to, const QString& cameraId, const QString& direction)
+void PortForwarder::setRelayBackend(RelayBackend backend)
 {
-    if (!from || !to || !from->isReadable() || !to->isWritable()) {
-        return;
+    if (backend == RelayBackend::Splice && !SpliceRelay::isSupported()) {
+        LOG_WARNING("splice() relay backend is not supported on this platform, using user space relay", "PortForwarder");
+        backend = RelayBackend::UserSpace;
+    }
+    
+    m_relayBackend = backend;
+    LOG_INFO(QString("Relay backend: %1")
+             .arg(backend == RelayBackend::Splice ? "splice (zero-copy)" : "user space"), "PortForwarder");
+    applyRelayOptions();
+}
+
+void PortForwarder::setPayloadInspectionEnabled(bool enabled)
+{
+    m_payloadInspection = enabled;
+    LOG_INFO(QString("Relay payload inspection %1").arg(enabled ? "enabled" : "disabled"), "PortForwarder");
+    applyRelayOptions();
+}
+
+void PortForwarder::setUdpRelay(bool enabled, int firstPort, int lastPort)
+{
+    if (!enabled) {
+        m_udpPorts.reset();
+        LOG_INFO("UDP media relay disabled, UDP transports pass through unchanged", "PortForwarder");
+    } else if (!m_udpPorts || m_udpPorts->firstPort() != firstPort || m_udpPorts->lastPort() != lastPort) {
+        // Relays still running keep the old pool alive until they close
+        m_udpPorts = QSharedPointer<UdpPortPool>::create(static_cast<quint16>(firstPort), static_cast<quint16>(lastPort));
+        LOG_INFO(QString("UDP media relay on ports %1-%2 (%3 streams)")
+                 .arg(m_udpPorts->firstPort()).arg(m_udpPorts->lastPort()).arg(m_udpPorts->pairCount() / 2),
+                 "PortForwarder");
     }
+    applyRelayOptions();
+}
+
+void PortForwarder::configureEngine(int threadCount, ForwardingEngine::ShardMode shardMode, bool pinThreads)
+{
+    m_engineThreads = qMax(0, threadCount);
+    m_engineShardMode = shardMode;
+    m_enginePinThreads = pinThreads;
     
-    // Read available data in chunks to handle streaming properly
-    QByteArray data = from->readAll();
-    if (data.isEmpty()) {
+    if (!m_engine->isRunning()) {
         return;
     }
-      // Log detailed information for RTSP debugging
-    if (data.size() > 0) {
-        // Enhanced RTSP protocol detection
-        bool isRtspData = data.startsWith("RTSP/") || data.startsWith("OPTIONS ") || 
-                         data.startsWith("DESCRIBE ") || data.startsWith("SETUP ") ||
-                         data.startsWith("PLAY ") || data.startsWith("PAUSE ") ||
-                         data.startsWith("TEARDOWN ") || data.startsWith("RECORD ") ||
-                         data.startsWith("ANNOUNCE ") || data.startsWith("REDIRECT ") ||
-                         data.startsWith("GET_PARAMETER ") || data.startsWith("SET_PARAMETER ");
-        
-        // Also check for interleaved RTP data (binary data with $ prefix)
-        bool isRtpData = data.size() >= 4 && data[0] == '$';
-        
-        if (isRtspData) {
-            LOG_INFO(QString("RTSP %1 data: %2 bytes - %3")
-                      .arg(direction)
-                      .arg(data.size())
-                      .arg(QString::fromUtf8(data.left(150)).replace('\r', "\\r").replace('\n', "\\n")), 
-                      "PortForwarder");
-        } else if (isRtpData) {
-            LOG_DEBUG(QString("RTP %1 data: %2 bytes [Channel: %3, Length: %4]")
-                      .arg(direction)
-                      .arg(data.size())
-                      .arg(static_cast<unsigned char>(data[1]))
-                      .arg((static_cast<unsigned char>(data[2]) << 8) | static_cast<unsigned char>(data[3])),
-                      "PortForwarder");
-        } else if (data.size() > 100) {
-            LOG_DEBUG(QString("Binary %1 data: %2 bytes").arg(direction).arg(data.size()), "PortForwarder");
-        }
+    
+    if (m_sessions.isEmpty()) {
+        // Restarted lazily by the next startForwarding()
+        m_engine->shutdown();
+    } else {
+        LOG_INFO("Forwarding engine settings will apply once all cameras are stopped", "PortForwarder");
+    }
+}
+
+void PortForwarder::ensureEngine()
+{
+    if (m_engine->isRunning()) {
+        return;
     }
     
-    // Write data with proper error handling for streaming
-    qint64 totalWritten = 0;
-    qint64 dataSize = data.size();
+    m_engine->start(m_engineThreads, m_engineShardMode, m_enginePinThreads);
     
-    while (totalWritten < dataSize) {
-        qint64 bytesWritten = to->write(data.constData() + totalWritten, dataSize - totalWritten);
-        
-        if (bytesWritten == -1) {
-            LOG_ERROR(QString("Failed to write data %1 for camera %2: %3")
-                      .arg(direction).arg(cameraId).arg(to->errorString()), "PortForwarder");
-            return;
-        }
-          totalWritten += bytesWritten;
-        
-        // If we couldn't write all data at once, wait briefly
-        if (totalWritten < dataSize) {
-            to->waitForBytesWritten(100); // Wait up to 100ms
-        }
+    // Workers on other threads reach these slots as queued connections
+    for (ForwardingWorker* worker : m_engine->workers()) {
+        connect(worker, &ForwardingWorker::connectionEstablished,
+                this, &PortForwarder::handleWorkerConnectionEstablished);
+        connect(worker, &ForwardingWorker::connectionClosed,
+                this, &PortForwarder::handleWorkerConnectionClosed);
+        connect(worker, &ForwardingWorker::targetConnected,
+                this, &PortForwarder::handleWorkerTargetConnected);
+        connect(worker, &ForwardingWorker::targetDisconnected,
+                this, &PortForwarder::handleWorkerTargetDisconnected);
+        connect(worker, &ForwardingWorker::connectionError,
+                this, &PortForwarder::handleWorkerConnectionError);
+        connect(worker, &ForwardingWorker::connectionBackpressure,
+                this, &PortForwarder::handleWorkerConnectionBackpressure);
+        connect(worker, &ForwardingWorker::queueDepthsReported,
+                this, &PortForwarder::handleWorkerQueueDepths);
+        connect(worker, &ForwardingWorker::udpStreamOpened,
+                this, &PortForwarder::handleWorkerUdpStreamOpened);
+        connect(worker, &ForwardingWorker::udpStreamClosed,
+                this, &PortForwarder::handleWorkerUdpStreamClosed);
     }
     
-    // Try to flush data for real-time streaming, but don't spam logs if it fails
-    // Note: flush() failure is normal for high-throughput video streaming due to TCP buffering
-    if (totalWritten > 0) {
-        bool flushed = to->flush();
-        
-        // Only log flush failures occasionally to avoid spam (every 5 seconds max)
-        if (!flushed) {
-            static QHash<QString, qint64> lastFlushWarning;
-            qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-            QString key = cameraId + ":" + direction;
-            
-            if (!lastFlushWarning.contains(key) || currentTime - lastFlushWarning[key] > 5000) {
-                LOG_DEBUG(QString("TCP buffer full for %1 on camera %2 (normal for video streaming)")
-                          .arg(direction).arg(cameraId), "PortForwarder");
-                lastFlushWarning[key] = currentTime;
-            }
-        }
-    }
+    applyRelayOptions();
+}
+
+void PortForwarder::applyRelayOptions()
+{
+    const bool useSplice = (m_relayBackend == RelayBackend::Splice);
+    const bool payloadInspection = m_payloadInspection;
+    const QSharedPointer<UdpPortPool> udpPorts = m_udpPorts;
     
-    if (totalWritten > 0) {
-        // Update connection statistics
-        if (m_sessions.contains(cameraId)) {
-            ForwardingSession* session = m_sessions[cameraId];
-            session->totalBytesTransferred += totalWritten;
-            session->lastActivity = QDateTime::currentDateTime();
-            
-            // Update connection-specific stats
-            QString socketCameraId = m_socketToCameraMap.value(from);
-            if (socketCameraId == cameraId) {
-                // Find the connection info
-                for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-                    ConnectionInfo* info = it.value();
-                    if ((direction == "client->target" && info->clientSocket == from) ||
-                        (direction == "target->client" && info->targetSocket == from)) {
-                        info->bytesTransferred += totalWritten;
-                        break;
-                    }
-                }
-            }
-        }
-        
-        // Emit data transfer signal (throttled logging)
-        static QHash<QString, qint64> lastLogTime;
-        qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-        if (!lastLogTime.contains(cameraId) || currentTime - lastLogTime[cameraId] > 5000) {
-            LOG_DEBUG(QString("Data forwarded: %1 bytes %2 for camera %3")
-                      .arg(totalWritten).arg(direction).arg(cameraId), "PortForwarder");
-            lastLogTime[cameraId] = currentTime;
-        }
-        
-        emit dataTransferred(cameraId, totalWritten, direction);
-    } else {
-        LOG_ERROR(QString("Failed to forward %1 bytes %2 for camera %3")
-                  .arg(dataSize).arg(direction).arg(cameraId), "PortForwarder");
+    for (ForwardingWorker* worker : m_engine->workers()) {
+        QMetaObject::invokeMethod(worker, [worker, useSplice, payloadInspection, udpPorts]() {
+            worker->setRelayOptions(useSplice, payloadInspection);
+            worker->setUdpRelayPorts(udpPorts);
+        });
     }
 }
 
@@ -951,46 +800,6 @@ void PortForwarder::updateSessionStatus(const QString& cameraId, const QString&
     }
 }
 
-void PortForwarder::logConnectionDetails(const QString& cameraId, const ConnectionInfo* info, const QString& event)
-{
-    if (!info) return;
-    
-    qint64 durationMs = info->connectedTime.msecsTo(QDateTime::currentDateTime());
-    double durationSec = durationMs / 1000.0;
-    
-    LOG_INFO(QString("%1 - Camera: %2, Client: %3, Duration: %4s, Bytes: %5")
-             .arg(event)
-             .arg(cameraId)
-             .arg(info->clientAddress)
-             .arg(QString::number(durationSec, 'f', 1))
-             .arg(info->bytesTransferred), "PortForwarder");
-}
-
-void PortForwarder::cleanupConnection(const QString& cameraId, QTcpSocket* clientSocket)
-{
-    if (!m_sessions.contains(cameraId) || !clientSocket) {
-        return;
-    }
-    
-    ForwardingSession* session = m_sessions[cameraId];
-    ConnectionInfo* connInfo = session->connections.value(clientSocket);
-    
-    if (connInfo) {
-        logConnectionDetails(cameraId, connInfo, "Cleanup");
-        
-        if (connInfo->targetSocket) {
-            m_socketToCameraMap.remove(connInfo->targetSocket);
-            connInfo->targetSocket->deleteLater();
-        }
-        
-        delete connInfo;
-    }
-    
-    session->connections.remove(clientSocket);
-    m_socketToCameraMap.remove(clientSocket);
-    clientSocket->deleteLater();
-}
-
 void PortForwarder::setupHealthCheckTimer(const QString& cameraId)
 {
     if (!m_sessions.contains(cameraId)) {
@@ -1025,49 +834,26 @@ void PortForwarder::handleHealthCheck()
     ForwardingSession* session = m_sessions[cameraId];
     
     // Log health status
-    LOG_DEBUG(QString("Health check - Camera: %1, Connections: %2, Total bytes: %3, Status: %4")
+    const TrafficSnapshot traffic = session->traffic->snapshot();
+    LOG_DEBUG(QString("Health check - Camera: %1, Connections: %2, Total bytes: %3, Status: %4, "
+                      "Camera connect: %5 ms avg over %6, Warm hand-outs: %7")
               .arg(session->camera.name())
-              .arg(session->connections.size())
-              .arg(session->totalBytesTransferred)
-              .arg(session->status), "PortForwarder");
+              .arg(session->connectionCount)
+              .arg(traffic.totalBytes())
+              .arg(session->status)
+              .arg(traffic.averageCameraConnectMs())
+              .arg(traffic.cameraConnects)
+              .arg(traffic.warmHandouts), "PortForwarder");
     
     // Check for inactive connections (optional cleanup)
-    QDateTime cutoff = QDateTime::currentDateTime().addSecs(-300); // 5 minutes
-    QList<QTcpSocket*> toRemove;
-    
-    for (auto it = session->connections.begin(); it != session->connections.end(); ++it) {
-        ConnectionInfo* info = it.value();
-        if (info && info->connectedTime < cutoff && info->bytesTransferred == 0) {
-            LOG_WARNING(QString("Removing inactive connection: %1").arg(info->clientAddress), "PortForwarder");
-            toRemove.append(it.key());
-        }
+    const quint64 sessionId = session->sessionId;
+    for (ForwardingWorker* worker : m_engine->workers()) {
+        QMetaObject::invokeMethod(worker, [worker, cameraId, sessionId]() {
+            worker->pruneInactiveConnections(cameraId, sessionId);
+            worker->reportQueueDepths(cameraId, sessionId);
+            worker->reportBufferPoolStats();
+        });
     }
-    
-    for (QTcpSocket* socket : toRemove) {
-        cleanupConnection(cameraId, socket);
-    }
-}
-
-void PortForwarder::optimizeSocketForStreaming(QTcpSocket* socket)
-{
-    if (!socket) return;
-    
-    // Set socket options for optimal RTSP streaming performance
-    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);  // TCP_NODELAY equivalent - critical for RTSP
-    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);  // SO_KEEPALIVE to detect dead connections
-    
-    // Set larger buffer sizes for streaming data
-    socket->setReadBufferSize(128 * 1024);  // 128KB read buffer for video data
-    socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 256 * 1024);  // 256KB send buffer
-    socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 256 * 1024);  // 256KB receive buffer
-    
-    // Disable proxy for direct connection
-    socket->setProxy(QNetworkProxy::NoProxy);
-    
-    // Set type of service for real-time data (if supported)
-    socket->setSocketOption(QAbstractSocket::TypeOfServiceOption, 0x10); // IPTOS_LOWDELAY
-    
-    LOG_DEBUG("Socket optimized for RTSP streaming with enhanced buffer sizes", "PortForwarder");
 }
 
 QString PortForwarder::getBindingInfo(const QString& cameraId) const
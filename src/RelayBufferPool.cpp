@@ -0,0 +1,61 @@
+#include "RelayBufferPool.h"
+#include <new>
+
+RelayBufferPool::RelayBufferPool(size_t slabSize, size_t maxCachedSlabs)
+    : m_slabSize((slabSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+    , m_maxCachedSlabs(maxCachedSlabs)
+{
+    m_freeSlabs.reserve(m_maxCachedSlabs);
+}
+
+RelayBufferPool::~RelayBufferPool()
+{
+    for (char* slab : m_freeSlabs) {
+        freeSlab(slab);
+    }
+}
+
+char* RelayBufferPool::acquire()
+{
+    char* slab;
+    if (!m_freeSlabs.empty()) {
+        slab = m_freeSlabs.back();
+        m_freeSlabs.pop_back();
+        ++m_stats.hits;
+    } else {
+        slab = allocateSlab(m_slabSize);
+        ++m_stats.misses;
+    }
+
+    ++m_stats.inUse;
+    if (m_stats.inUse > m_stats.highWater) {
+        m_stats.highWater = m_stats.inUse;
+    }
+    m_stats.cached = m_freeSlabs.size();
+    return slab;
+}
+
+void RelayBufferPool::release(char* slab)
+{
+    if (!slab) {
+        return;
+    }
+
+    --m_stats.inUse;
+    if (m_freeSlabs.size() < m_maxCachedSlabs) {
+        m_freeSlabs.push_back(slab);
+    } else {
+        freeSlab(slab);
+    }
+    m_stats.cached = m_freeSlabs.size();
+}
+
+char* RelayBufferPool::allocateSlab(size_t size)
+{
+    return static_cast<char*>(::operator new(size, std::align_val_t(CACHE_LINE_SIZE)));
+}
+
+void RelayBufferPool::freeSlab(char* slab)
+{
+    ::operator delete(slab, std::align_val_t(CACHE_LINE_SIZE));
+}
@@ -0,0 +1,288 @@
+#include "RtspDemuxer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct StartToken {
+    const char* text;
+    size_t size;
+    bool response;
+};
+
+#define RTSP_TOKEN(text, response) { text, sizeof(text) - 1, response }
+
+const StartToken START_TOKENS[] = {
+    RTSP_TOKEN("RTSP/", true),
+    RTSP_TOKEN("OPTIONS ", false),
+    RTSP_TOKEN("DESCRIBE ", false),
+    RTSP_TOKEN("SETUP ", false),
+    RTSP_TOKEN("PLAY ", false),
+    RTSP_TOKEN("PAUSE ", false),
+    RTSP_TOKEN("TEARDOWN ", false),
+    RTSP_TOKEN("GET_PARAMETER ", false),
+    RTSP_TOKEN("SET_PARAMETER ", false),
+    RTSP_TOKEN("ANNOUNCE ", false),
+    RTSP_TOKEN("RECORD ", false),
+    RTSP_TOKEN("REDIRECT ", false),
+};
+
+#undef RTSP_TOKEN
+
+const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+} // namespace
+
+void RtspDemuxer::feed(const char* data, size_t size, std::vector<Event>& events)
+{
+    events.clear();
+
+    size_t pos = 0;
+    while (pos < size) {
+        switch (m_state) {
+        case State::Lost:
+            events.push_back({ EventType::Unknown, data + pos, size - pos, size - pos, -1 });
+            return;
+
+        case State::Skip: {
+            const size_t skipped = static_cast<size_t>(std::min<uint64_t>(m_remaining, size - pos));
+            pos += skipped;
+            m_remaining -= skipped;
+            if (m_remaining == 0) {
+                m_state = State::Start;
+            }
+            break;
+        }
+
+        case State::Start: {
+            const char c = data[pos];
+            if (c == '\r' || c == '\n') {
+                // Stray line ends between messages
+                ++pos;
+            } else if (c == '$') {
+                m_pending.clear();
+                m_state = State::FrameHeader;
+            } else {
+                m_pending.clear();
+                m_state = State::Headers;
+            }
+            break;
+        }
+
+        case State::FrameHeader: {
+            const char* header = data + pos;
+            if (!m_pending.empty() || size - pos < 4) {
+                const size_t taken = std::min(4 - m_pending.size(), size - pos);
+                m_pending.append(data + pos, taken);
+                pos += taken;
+                if (m_pending.size() < 4) {
+                    break;
+                }
+                header = m_pending.data();
+            } else {
+                pos += 4;
+            }
+
+            const size_t length = (static_cast<unsigned char>(header[2]) << 8) |
+                                  static_cast<unsigned char>(header[3]);
+            const size_t available = std::min(length, size - pos);
+            events.push_back({ EventType::Interleaved, data + pos, available, length,
+                               static_cast<unsigned char>(header[1]) });
+
+            pos += available;
+            m_remaining = length - available;
+            m_state = m_remaining > 0 ? State::Skip : State::Start;
+            m_pending.clear();
+            break;
+        }
+
+        case State::Headers: {
+            const char* block = nullptr;
+            size_t blockSize = 0;
+            size_t consumed = 0;
+
+            if (m_pending.empty()) {
+                // Common case, the whole header block is in this chunk
+                const size_t end = findHeaderEnd(data + pos, size - pos, 0);
+                if (end != NOT_FOUND) {
+                    block = data + pos;
+                    blockSize = end;
+                    consumed = end;
+                }
+            }
+
+            if (!block) {
+                // Sized for typical headers up front, so steady state
+                // reassembly does not reallocate
+                if (m_pending.capacity() < HEADER_BUFFER_RESERVE) {
+                    m_pending.reserve(HEADER_BUFFER_RESERVE);
+                }
+
+                const size_t previous = m_pending.size();
+                const size_t available = size - pos;
+                size_t end = NOT_FOUND; // Bytes of this chunk up to the end of the block
+
+                if (previous > 0) {
+                    // Terminator split across the chunk boundary
+                    const size_t window = std::min<size_t>(2, available);
+                    m_pending.append(data + pos, window);
+                    const size_t found = findHeaderEnd(m_pending.data(), m_pending.size(),
+                                                       previous >= 2 ? previous - 2 : 0);
+                    m_pending.resize(previous);
+                    if (found != NOT_FOUND) {
+                        end = found - previous;
+                    } else {
+                        end = findHeaderEnd(data + pos, available, 0);
+                    }
+                }
+
+                if (end == NOT_FOUND || previous + end > MAX_HEADER_SIZE) {
+                    const size_t taken = std::min(MAX_HEADER_SIZE - previous, available);
+                    m_pending.append(data + pos, taken);
+                    if (end != NOT_FOUND || m_pending.size() >= MAX_HEADER_SIZE ||
+                        classify(m_pending.data(), m_pending.size()) == Classification::Unknown) {
+                        // This chunk is reported by the Lost state, only the
+                        // bytes held from earlier chunks are released here
+                        m_pending.resize(previous);
+                        releasePending(events);
+                        m_state = State::Lost;
+                        break;
+                    }
+                    pos += taken;
+                    break;
+                }
+
+                // Hand the block out from a buffer the rest of this chunk cannot
+                // touch. The two buffers trade places, both keep their capacity.
+                m_pending.append(data + pos, end);
+                if (m_message.capacity() < HEADER_BUFFER_RESERVE) {
+                    m_message.reserve(HEADER_BUFFER_RESERVE);
+                }
+                m_message.swap(m_pending);
+                m_pending.clear();
+                block = m_message.data();
+                blockSize = m_message.size();
+                consumed = end;
+            }
+
+            const Classification classification = classify(block, blockSize);
+            if (classification != Classification::Request && classification != Classification::Response) {
+                if (block != data + pos && blockSize > consumed) {
+                    events.push_back({ EventType::Unknown, block, blockSize - consumed, blockSize - consumed, -1 });
+                }
+                m_state = State::Lost;
+                break;
+            }
+
+            const size_t length = contentLength(block, blockSize);
+            events.push_back({ classification == Classification::Request ? EventType::Request : EventType::Response,
+                               block, blockSize, length, -1 });
+
+            pos += consumed;
+            m_remaining = length;
+            m_state = m_remaining > 0 ? State::Skip : State::Start;
+            break;
+        }
+        }
+    }
+}
+
+void RtspDemuxer::releasePending(std::vector<Event>& events)
+{
+    if (m_pending.empty()) {
+        return;
+    }
+    if (m_message.capacity() < HEADER_BUFFER_RESERVE) {
+        m_message.reserve(HEADER_BUFFER_RESERVE);
+    }
+    m_message.swap(m_pending);
+    m_pending.clear();
+    events.push_back({ EventType::Unknown, m_message.data(), m_message.size(), m_message.size(), -1 });
+}
+
+void RtspDemuxer::reset()
+{
+    m_state = State::Start;
+    m_pending.clear();
+    m_message.clear();
+    m_remaining = 0;
+}
+
+size_t RtspDemuxer::startLineLength(const Event& event)
+{
+    const char* lineEnd = static_cast<const char*>(std::memchr(event.data, '\r', event.size));
+    return lineEnd ? static_cast<size_t>(lineEnd - event.data) : event.size;
+}
+
+RtspDemuxer::Classification RtspDemuxer::classify(const char* data, size_t size)
+{
+    bool incomplete = false;
+    for (const StartToken& token : START_TOKENS) {
+        const size_t compared = std::min(size, token.size);
+        if (std::memcmp(data, token.text, compared) != 0) {
+            continue;
+        }
+        if (compared < token.size) {
+            incomplete = true;
+            continue;
+        }
+        return token.response ? Classification::Response : Classification::Request;
+    }
+    return incomplete ? Classification::Incomplete : Classification::Unknown;
+}
+
+size_t RtspDemuxer::findHeaderEnd(const char* data, size_t size, size_t from)
+{
+    // memchr is vectorised in every C library we ship with, so the scan runs
+    // a word or more at a time and only stops on line ends
+    const char* end = data + size;
+    const char* p = data + from;
+    while (p < end) {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!p) {
+            break;
+        }
+        if (end - p >= 3 && p[1] == '\r' && p[2] == '\n') {
+            return static_cast<size_t>(p + 3 - data);
+        }
+        ++p;
+    }
+    return NOT_FOUND;
+}
+
+size_t RtspDemuxer::contentLength(const char* headers, size_t size)
+{
+    static const char name[] = "content-length:";
+    const size_t nameSize = sizeof(name) - 1;
+
+    const char* end = headers + size;
+    const char* line = headers;
+    while (line < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        if (static_cast<size_t>(lineEnd - line) > nameSize) {
+            size_t i = 0;
+            while (i < nameSize && (line[i] | 0x20) == name[i]) {
+                ++i;
+            }
+            if (i == nameSize) {
+                const char* value = line + nameSize;
+                while (value < lineEnd && (*value == ' ' || *value == '\t')) {
+                    ++value;
+                }
+                size_t length = 0;
+                while (value < lineEnd && *value >= '0' && *value <= '9' && length < MAX_BODY_SIZE) {
+                    length = length * 10 + static_cast<size_t>(*value - '0');
+                    ++value;
+                }
+                return length;
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1024 @@
+#include "RtspFanOut.h"
+#include "Logger.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QNetworkProxy>
+#include <QUrl>
+
+QByteArray RtspFanOut::RtspMessage::header(const QByteArray& name) const
+{
+    for (const auto& header : headers) {
+        if (header.first == name) {
+            return header.second;
+        }
+    }
+    return QByteArray();
+}
+
+QList<QByteArray> RtspFanOut::RtspMessage::headerValues(const QByteArray& name) const
+{
+    QList<QByteArray> values;
+    for (const auto& header : headers) {
+        if (header.first == name) {
+            values.append(header.second);
+        }
+    }
+    return values;
+}
+
+RtspFanOut::RtspFanOut(const CameraConfig& camera, QObject *parent)
+    : QObject(parent)
+    , m_camera(camera)
+    , m_housekeepingTimer(new QTimer(this))
+{
+    m_viewerNonce = QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+
+    m_housekeepingTimer->setInterval(HOUSEKEEPING_INTERVAL_MS);
+    connect(m_housekeepingTimer, &QTimer::timeout, this, &RtspFanOut::handleHousekeeping);
+    m_housekeepingTimer->start();
+}
+
+RtspFanOut::~RtspFanOut()
+{
+    closeAll();
+}
+
+void RtspFanOut::addViewer(QTcpSocket* socket, const QString& clientAddress)
+{
+    Viewer* viewer = new Viewer;
+    viewer->socket = socket;
+    viewer->clientAddress = clientAddress;
+    viewer->upstream = nullptr;
+    viewer->sessionId = QByteArray::number(QRandomGenerator::global()->generate64(), 16).toUpper();
+    viewer->authenticated = m_camera.username().isEmpty();
+    viewer->playing = false;
+    viewer->dropping = false;
+    viewer->droppedFrames = 0;
+
+    socket->setParent(this);
+    m_viewers[socket] = viewer;
+
+    connect(socket, &QTcpSocket::readyRead, this, &RtspFanOut::handleViewerReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this, &RtspFanOut::handleViewerDisconnected);
+
+    LOG_DEBUG(QString("Viewer %1 attached to RTSP fan-out for camera '%2'")
+              .arg(clientAddress).arg(m_camera.name()), "RtspFanOut");
+}
+
+void RtspFanOut::closeAll()
+{
+    const QList<Viewer*> viewers = m_viewers.values();
+    for (Viewer* viewer : viewers) {
+        removeViewer(viewer);
+    }
+
+    const QList<Upstream*> upstreams = m_upstreamsByPath.values();
+    for (Upstream* upstream : upstreams) {
+        closeUpstream(upstream, QString());
+    }
+}
+
+QHash<QString, qint64> RtspFanOut::queueDepths() const
+{
+    QHash<QString, qint64> depths;
+    for (const Viewer* viewer : m_viewers) {
+        depths[viewer->clientAddress] = viewer->socket->bytesToWrite();
+    }
+    return depths;
+}
+
+RtspFanOut::ParseResult RtspFanOut::parseNext(const QByteArray& buffer, int& offset, RtspMessage& message,
+                                              int& frameChannel, const char*& frameData, int& frameSize)
+{
+    const int available = buffer.size() - offset;
+    if (available <= 0) {
+        return ParseResult::NeedMore;
+    }
+
+    const char* data = buffer.constData() + offset;
+
+    // Interleaved frame: '$', channel, 16-bit big endian length, payload
+    if (data[0] == '$') {
+        if (available < 4) {
+            return ParseResult::NeedMore;
+        }
+        const int length = (static_cast<unsigned char>(data[2]) << 8) | static_cast<unsigned char>(data[3]);
+        if (available < 4 + length) {
+            return ParseResult::NeedMore;
+        }
+        frameChannel = static_cast<unsigned char>(data[1]);
+        frameData = data;
+        frameSize = 4 + length;
+        offset += frameSize;
+        return ParseResult::Frame;
+    }
+
+    const int headerEnd = buffer.indexOf("\r\n\r\n", offset);
+    if (headerEnd < 0) {
+        return available > MAX_MESSAGE_SIZE ? ParseResult::Error : ParseResult::NeedMore;
+    }
+
+    const QList<QByteArray> lines = buffer.mid(offset, headerEnd - offset).split('\n');
+    message = RtspMessage();
+    message.startLine = lines.value(0).trimmed();
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray& line = lines.at(i);
+        const int colon = line.indexOf(':');
+        if (colon > 0) {
+            message.headers.append(qMakePair(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed()));
+        }
+    }
+
+    const int contentLength = message.header("content-length").toInt();
+    if (contentLength < 0 || contentLength > MAX_MESSAGE_SIZE) {
+        return ParseResult::Error;
+    }
+
+    const int bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength) {
+        return ParseResult::NeedMore;
+    }
+
+    message.body = buffer.mid(bodyStart, contentLength);
+    offset = bodyStart + contentLength;
+    return ParseResult::Message;
+}
+
+// Upstream (camera) side
+
+RtspFanOut::Upstream* RtspFanOut::upstreamFor(const QString& path)
+{
+    Upstream* upstream = m_upstreamsByPath.value(path);
+    if (upstream) {
+        return upstream;
+    }
+
+    upstream = new Upstream;
+    upstream->path = path;
+    upstream->socket = new QTcpSocket(this);
+    upstream->state = UpstreamState::Connecting;
+    upstream->cseq = 0;
+    upstream->url = QString("rtsp://%1:%2%3").arg(m_camera.ipAddress()).arg(m_camera.port()).arg(path).toUtf8();
+    upstream->sessionTimeoutS = DEFAULT_SESSION_TIMEOUT_S;
+    upstream->setupIndex = 0;
+    upstream->authDigest = false;
+    upstream->authRetried = false;
+    upstream->openedMs = QDateTime::currentMSecsSinceEpoch();
+    upstream->idleSinceMs = 0;
+    upstream->lastKeepAliveMs = 0;
+    upstream->videoChannel = -1;
+    upstream->videoCodec = Codec::Other;
+
+    m_upstreams[upstream->socket] = upstream;
+    m_upstreamsByPath[path] = upstream;
+
+    upstream->socket->setProxy(QNetworkProxy::NoProxy);
+    upstream->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    upstream->socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    upstream->socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 256 * 1024);
+
+    connect(upstream->socket, &QTcpSocket::connected, this, &RtspFanOut::handleUpstreamConnected);
+    connect(upstream->socket, &QTcpSocket::readyRead, this, &RtspFanOut::handleUpstreamReadyRead);
+    connect(upstream->socket, &QTcpSocket::disconnected, this, &RtspFanOut::handleUpstreamDisconnected);
+    connect(upstream->socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
+            this, &RtspFanOut::handleUpstreamError);
+
+    LOG_INFO(QString("Opening shared upstream session for camera '%1' stream '%2'")
+             .arg(m_camera.name()).arg(path), "RtspFanOut");
+
+    upstream->socket->connectToHost(m_camera.ipAddress(), m_camera.port());
+    return upstream;
+}
+
+void RtspFanOut::sendUpstreamRequest(Upstream* upstream, const QByteArray& method, const QByteArray& url,
+                                     const QByteArray& extraHeaders)
+{
+    upstream->lastMethod = method;
+    upstream->lastUrl = url;
+    upstream->lastExtraHeaders = extraHeaders;
+
+    QByteArray request = method + ' ' + url + " RTSP/1.0\r\n";
+    request += "CSeq: " + QByteArray::number(++upstream->cseq) + "\r\n";
+    request += "User-Agent: ViscoConnect\r\n";
+    if (!upstream->authRealm.isEmpty()) {
+        request += "Authorization: " + authorizationHeader(upstream, method, url) + "\r\n";
+    }
+    if (!upstream->sessionHeader.isEmpty() && method != "OPTIONS" && method != "DESCRIBE") {
+        request += "Session: " + upstream->sessionHeader + "\r\n";
+    }
+    request += extraHeaders;
+    request += "\r\n";
+
+    upstream->socket->write(request);
+}
+
+void RtspFanOut::handleUpstreamConnected()
+{
+    Upstream* upstream = m_upstreams.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!upstream) return;
+
+    upstream->state = UpstreamState::Options;
+    sendUpstreamRequest(upstream, "OPTIONS", upstream->url);
+}
+
+void RtspFanOut::handleUpstreamReadyRead()
+{
+    Upstream* upstream = m_upstreams.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!upstream) return;
+
+    QTcpSocket* socket = upstream->socket;
+    upstream->buffer.append(socket->readAll());
+
+    int offset = 0;
+    qint64 bytesWritten = 0;
+    RtspMessage message;
+    int channel = 0;
+    const char* frame = nullptr;
+    int frameSize = 0;
+
+    while (true) {
+        const ParseResult result = parseNext(upstream->buffer, offset, message, channel, frame, frameSize);
+        if (result == ParseResult::NeedMore) {
+            break;
+        }
+        if (result == ParseResult::Error) {
+            closeUpstream(upstream, "Malformed RTSP data from camera");
+            return;
+        }
+        if (result == ParseResult::Frame) {
+            distributeFrame(upstream, channel, frame, frameSize, bytesWritten);
+            continue;
+        }
+
+        handleUpstreamResponse(upstream, message);
+        if (m_upstreams.value(socket) != upstream) {
+            return; // Closed while handling the response
+        }
+    }
+
+    upstream->buffer.remove(0, offset);
+
+    if (bytesWritten > 0) {
+        emit bytesRelayed(bytesWritten, false);
+    }
+}
+
+void RtspFanOut::handleUpstreamResponse(Upstream* upstream, const RtspMessage& response)
+{
+    const QList<QByteArray> status = response.startLine.split(' ');
+    if (status.size() < 2 || !status.at(0).startsWith("RTSP/")) {
+        return; // Server requests (rare) are not supported and ignored
+    }
+    const int code = status.at(1).toInt();
+
+    if (code == 401 && !upstream->authRetried && !m_camera.username().isEmpty()) {
+        // Prefer Digest, cameras usually offer both
+        QByteArray challenge;
+        for (const QByteArray& value : response.headerValues("www-authenticate")) {
+            if (challenge.isEmpty() || value.startsWith("Digest")) {
+                challenge = value;
+            }
+        }
+        upstream->authDigest = challenge.startsWith("Digest");
+        upstream->authRealm = authParam(challenge, "realm");
+        upstream->authNonce = authParam(challenge, "nonce");
+        upstream->authQop = authParam(challenge, "qop").contains("auth") ? QByteArray("auth") : QByteArray();
+        if (upstream->authRealm.isEmpty()) {
+            upstream->authRealm = "RTSP";
+        }
+        upstream->authRetried = true;
+        sendUpstreamRequest(upstream, upstream->lastMethod, upstream->lastUrl, upstream->lastExtraHeaders);
+        return;
+    }
+
+    if (upstream->state == UpstreamState::Playing) {
+        return; // Keep-alive answers
+    }
+
+    if (code != 200) {
+        closeUpstream(upstream, QString("Camera answered %1 with %2")
+                      .arg(QString::fromLatin1(upstream->lastMethod))
+                      .arg(QString::fromLatin1(response.startLine)));
+        return;
+    }
+
+    upstream->authRetried = false;
+
+    switch (upstream->state) {
+    case UpstreamState::Options:
+        upstream->state = UpstreamState::Describe;
+        sendUpstreamRequest(upstream, "DESCRIBE", upstream->url, "Accept: application/sdp\r\n");
+        break;
+
+    case UpstreamState::Describe: {
+        upstream->contentBase = response.header("content-base");
+        if (upstream->contentBase.isEmpty()) {
+            upstream->contentBase = response.header("content-location");
+        }
+        if (upstream->contentBase.isEmpty()) {
+            upstream->contentBase = upstream->url;
+        }
+
+        parseDescription(upstream, response.body);
+        if (upstream->tracks.isEmpty()) {
+            closeUpstream(upstream, "Camera SDP has no media tracks");
+            return;
+        }
+
+        for (Viewer* viewer : upstream->viewers) {
+            if (!viewer->pendingDescribeCSeq.isEmpty()) {
+                answerDescribe(viewer);
+            }
+        }
+
+        upstream->state = UpstreamState::Setup;
+        upstream->setupIndex = 0;
+        const Track& track = upstream->tracks.first();
+        sendUpstreamRequest(upstream, "SETUP", track.setupUrl,
+                            QString("Transport: RTP/AVP/TCP;unicast;interleaved=%1-%2\r\n")
+                            .arg(track.channel).arg(track.channel + 1).toLatin1());
+        break;
+    }
+
+    case UpstreamState::Setup: {
+        const QByteArray session = response.header("session");
+        const int separator = session.indexOf(';');
+        upstream->sessionHeader = separator < 0 ? session : session.left(separator);
+        const int timeoutPos = session.indexOf("timeout=");
+        if (timeoutPos >= 0) {
+            upstream->sessionTimeoutS = qMax(10, session.mid(timeoutPos + 8).toInt());
+        }
+
+        if (++upstream->setupIndex < upstream->tracks.size()) {
+            const Track& track = upstream->tracks.at(upstream->setupIndex);
+            sendUpstreamRequest(upstream, "SETUP", track.setupUrl,
+                                QString("Transport: RTP/AVP/TCP;unicast;interleaved=%1-%2\r\n")
+                                .arg(track.channel).arg(track.channel + 1).toLatin1());
+        } else {
+            upstream->state = UpstreamState::Play;
+            sendUpstreamRequest(upstream, "PLAY", upstream->contentBase, "Range: npt=0.000-\r\n");
+        }
+        break;
+    }
+
+    case UpstreamState::Play:
+        upstream->state = UpstreamState::Playing;
+        upstream->lastKeepAliveMs = QDateTime::currentMSecsSinceEpoch();
+        LOG_INFO(QString("Shared upstream session playing for camera '%1' stream '%2' (%3 tracks, %4 viewers)")
+                 .arg(m_camera.name()).arg(upstream->path)
+                 .arg(upstream->tracks.size()).arg(upstream->viewers.size()), "RtspFanOut");
+        emit upstreamConnected();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void RtspFanOut::parseDescription(Upstream* upstream, const QByteArray& sdp)
+{
+    upstream->tracks.clear();
+
+    QByteArray base = upstream->contentBase;
+    if (!base.endsWith('/')) {
+        base += '/';
+    }
+
+    QList<QByteArray> lines = sdp.split('\n');
+    QByteArray rewritten;
+    bool inMedia = false;
+
+    for (QByteArray line : lines) {
+        line = line.trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        if (line.startsWith("m=")) {
+            inMedia = true;
+            Track track;
+            track.channel = upstream->tracks.size() * 2;
+            track.control = "track" + QByteArray::number(upstream->tracks.size() + 1);
+            track.setupUrl = upstream->contentBase;
+            track.video = line.startsWith("m=video");
+            track.codec = Codec::Other;
+            upstream->tracks.append(track);
+        } else if (line.startsWith("a=rtpmap:") && inMedia) {
+            // a=rtpmap:96 H264/90000
+            const QByteArray encoding = line.mid(line.indexOf(' ') + 1).toUpper();
+            Track& track = upstream->tracks.last();
+            if (encoding.startsWith("H264/")) {
+                track.codec = Codec::H264;
+            } else if (encoding.startsWith("H265/")) {
+                track.codec = Codec::H265;
+            }
+        } else if (line.startsWith("a=control:")) {
+            const QByteArray control = line.mid(10).trimmed();
+
+            if (!inMedia) {
+                rewritten += "a=control:*\r\n";
+                continue;
+            }
+
+            Track& track = upstream->tracks.last();
+            if (control.startsWith("rtsp://") || control.startsWith("rtsps://")) {
+                track.setupUrl = control;
+                if (control.startsWith(base)) {
+                    track.control = control.mid(base.size());
+                } else if (control.lastIndexOf('/') >= 0) {
+                    track.control = control.mid(control.lastIndexOf('/') + 1);
+                }
+            } else if (control != "*") {
+                track.setupUrl = base + control;
+                track.control = control;
+            }
+
+            rewritten += "a=control:" + track.control + "\r\n";
+            continue;
+        }
+
+        rewritten += line + "\r\n";
+    }
+
+    upstream->sdp = rewritten;
+
+    upstream->videoChannel = -1;
+    upstream->videoCodec = Codec::Other;
+    for (const Track& track : upstream->tracks) {
+        if (track.video) {
+            upstream->videoChannel = track.channel;
+            upstream->videoCodec = track.codec;
+            break;
+        }
+    }
+}
+
+void RtspFanOut::distributeFrame(Upstream* upstream, int channel, const char* frame, int frameSize, qint64& bytesWritten)
+{
+    // Where this packet sits in the stream. RTP is on the even channels and
+    // RTCP on the odd ones; a packet starts a frame when the one before it on
+    // the same channel carried the marker bit.
+    const char* rtp = frame + 4;
+    const int rtpSize = frameSize - 4;
+    const bool isRtp = (channel % 2) == 0 && rtpSize >= RTP_HEADER_SIZE;
+    bool frameStart = false;
+    if (isRtp) {
+        frameStart = upstream->frameStart.value(channel, true);
+        upstream->frameStart[channel] = (static_cast<unsigned char>(rtp[1]) & 0x80) != 0;
+    }
+
+    // A slow viewer loses whole frames rather than holding up the camera
+    // stream for everybody else. Skipping starts at the beginning of a video
+    // frame and ends on a keyframe (H.264/H.265) or, for other codecs, at the
+    // beginning of a frame, so the viewer never gets a partial frame or a
+    // frame whose reference is missing. Audio only streams skip packets.
+    const bool videoFrameStart = upstream->videoChannel < 0 ? isRtp
+                                                            : channel == upstream->videoChannel && frameStart;
+    bool resumePoint = videoFrameStart;
+    if (upstream->videoChannel >= 0 && upstream->videoCodec != Codec::Other) {
+        resumePoint = channel == upstream->videoChannel && startsKeyframe(upstream->videoCodec, rtp, rtpSize, frameStart);
+    }
+
+    for (Viewer* viewer : upstream->viewers) {
+        if (!viewer->playing) {
+            continue;
+        }
+
+        const int viewerChannel = viewer->channelMap.value(channel, -1);
+        if (viewerChannel < 0) {
+            continue;
+        }
+
+        const qint64 queued = viewer->socket->bytesToWrite();
+        if (viewer->dropping && resumePoint && queued <= VIEWER_LOW_WATERMARK) {
+            LOG_DEBUG(QString("Viewer %1 caught up after %2 dropped frames")
+                      .arg(viewer->clientAddress).arg(viewer->droppedFrames), "RtspFanOut");
+            viewer->dropping = false;
+        } else if (!viewer->dropping && videoFrameStart && queued > VIEWER_HIGH_WATERMARK) {
+            LOG_DEBUG(QString("Viewer %1 too slow (%2 bytes queued), dropping frames")
+                      .arg(viewer->clientAddress).arg(queued), "RtspFanOut");
+            viewer->dropping = true;
+        }
+        if (viewer->dropping) {
+            if (videoFrameStart) {
+                viewer->droppedFrames++;
+            }
+            continue;
+        }
+
+        if (viewerChannel == channel) {
+            viewer->socket->write(frame, frameSize);
+        } else {
+            const char header[2] = { '$', static_cast<char>(viewerChannel) };
+            viewer->socket->write(header, 2);
+            viewer->socket->write(frame + 2, frameSize - 2);
+        }
+        bytesWritten += frameSize;
+    }
+}
+
+bool RtspFanOut::startsKeyframe(Codec codec, const char* rtp, int size, bool frameStart)
+{
+    // Skip the RTP header, CSRCs and header extension
+    const unsigned char* packet = reinterpret_cast<const unsigned char*>(rtp);
+    int offset = RTP_HEADER_SIZE + 4 * (packet[0] & 0x0f);
+    if (packet[0] & 0x10) {
+        if (offset + 4 > size) {
+            return false;
+        }
+        offset += 4 + 4 * ((packet[offset + 2] << 8) | packet[offset + 3]);
+    }
+    const unsigned char* payload = packet + offset;
+    const int length = size - offset;
+    if (length < 2) {
+        return false;
+    }
+
+    // Parameter sets only come in front of a keyframe, so they start one
+    // wherever they are. A keyframe slice has to start the frame as well,
+    // otherwise it is a later slice of a keyframe that is already half gone.
+    if (codec == Codec::H264) {
+        // RFC 6184: SPS 7, IDR slice 5, STAP-A 24, FU-A 28
+        const int type = payload[0] & 0x1f;
+        if (type == 24) {
+            for (int i = 1; i + 2 < length;) {
+                const int nalSize = (payload[i] << 8) | payload[i + 1];
+                if (nalSize == 0 || i + 2 + nalSize > length) {
+                    break;
+                }
+                const int nalType = payload[i + 2] & 0x1f;
+                if (nalType == 7 || (nalType == 5 && frameStart)) {
+                    return true;
+                }
+                i += 2 + nalSize;
+            }
+            return false;
+        }
+        if (type == 28) {
+            return frameStart && (payload[1] & 0x80) && (payload[1] & 0x1f) == 5;
+        }
+        return type == 7 || (type == 5 && frameStart);
+    }
+
+    // RFC 7798: VPS 32, SPS 33, IRAP slices 16-21, AP 48, FU 49
+    auto isIrap = [](int type) { return type >= 16 && type <= 21; };
+    const int type = (payload[0] >> 1) & 0x3f;
+    if (type == 48) {
+        for (int i = 2; i + 3 < length;) {
+            const int nalSize = (payload[i] << 8) | payload[i + 1];
+            if (nalSize < 2 || i + 2 + nalSize > length) {
+                break;
+            }
+            const int nalType = (payload[i + 2] >> 1) & 0x3f;
+            if (nalType == 32 || nalType == 33 || (isIrap(nalType) && frameStart)) {
+                return true;
+            }
+            i += 2 + nalSize;
+        }
+        return false;
+    }
+    if (type == 49) {
+        return length >= 3 && frameStart && (payload[2] & 0x80) && isIrap(payload[2] & 0x3f);
+    }
+    return type == 32 || type == 33 || (isIrap(type) && frameStart);
+}
+
+void RtspFanOut::handleUpstreamDisconnected()
+{
+    Upstream* upstream = m_upstreams.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!upstream) return;
+
+    closeUpstream(upstream, QString("Camera closed the shared session for stream '%1'").arg(upstream->path));
+}
+
+void RtspFanOut::handleUpstreamError(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error);
+
+    Upstream* upstream = m_upstreams.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!upstream) return;
+
+    closeUpstream(upstream, upstream->socket->errorString());
+}
+
+void RtspFanOut::closeUpstream(Upstream* upstream, const QString& reason)
+{
+    const bool wasPlaying = (upstream->state == UpstreamState::Playing);
+
+    m_upstreams.remove(upstream->socket);
+    m_upstreamsByPath.remove(upstream->path);
+
+    disconnect(upstream->socket, nullptr, this, nullptr);
+    if (upstream->socket->state() == QAbstractSocket::ConnectedState && !upstream->sessionHeader.isEmpty()) {
+        sendUpstreamRequest(upstream, "TEARDOWN", upstream->contentBase);
+    }
+    upstream->socket->disconnectFromHost();
+    upstream->socket->deleteLater();
+
+    // Viewers cannot outlive their stream, players reconnect on their own.
+    // Those still waiting for DESCRIBE are told why first.
+    const QList<Viewer*> viewers = upstream->viewers;
+    for (Viewer* viewer : viewers) {
+        if (!reason.isEmpty() && !viewer->pendingDescribeCSeq.isEmpty()) {
+            sendViewerResponse(viewer, 503, "Service Unavailable", viewer->pendingDescribeCSeq);
+        }
+        viewer->upstream = nullptr;
+        removeViewer(viewer);
+    }
+
+    if (!reason.isEmpty()) {
+        LOG_WARNING(QString("Shared upstream session for camera '%1' closed: %2")
+                    .arg(m_camera.name()).arg(reason), "RtspFanOut");
+        emit upstreamError(reason);
+    } else {
+        LOG_DEBUG(QString("Shared upstream session for camera '%1' stream '%2' closed")
+                  .arg(m_camera.name()).arg(upstream->path), "RtspFanOut");
+    }
+
+    if (wasPlaying) {
+        emit upstreamDisconnected();
+    }
+
+    delete upstream;
+}
+
+void RtspFanOut::handleHousekeeping()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    const QList<Upstream*> upstreams = m_upstreamsByPath.values();
+    for (Upstream* upstream : upstreams) {
+        // A camera that drops the connect or never answers would otherwise
+        // keep its viewers waiting on DESCRIBE for good
+        if (upstream->state != UpstreamState::Playing && now - upstream->openedMs > UPSTREAM_SETUP_TIMEOUT_MS) {
+            closeUpstream(upstream, QString("Camera did not start stream '%1' within %2 s")
+                          .arg(upstream->path).arg(UPSTREAM_SETUP_TIMEOUT_MS / 1000));
+            continue;
+        }
+
+        if (upstream->viewers.isEmpty()) {
+            if (now - upstream->idleSinceMs > UPSTREAM_LINGER_MS) {
+                closeUpstream(upstream, QString());
+            }
+            continue;
+        }
+
+        // Refresh the camera's session well before it times out
+        if (upstream->state == UpstreamState::Playing &&
+            now - upstream->lastKeepAliveMs > upstream->sessionTimeoutS * 1000 / 2) {
+            sendUpstreamRequest(upstream, "GET_PARAMETER", upstream->contentBase);
+            upstream->lastKeepAliveMs = now;
+        }
+    }
+}
+
+// Viewer side
+
+void RtspFanOut::handleViewerReadyRead()
+{
+    Viewer* viewer = m_viewers.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!viewer) return;
+
+    viewer->buffer.append(viewer->socket->readAll());
+
+    int offset = 0;
+    RtspMessage message;
+    int channel = 0;
+    const char* frame = nullptr;
+    int frameSize = 0;
+    QTcpSocket* socket = viewer->socket;
+
+    while (true) {
+        const ParseResult result = parseNext(viewer->buffer, offset, message, channel, frame, frameSize);
+        if (result == ParseResult::NeedMore) {
+            break;
+        }
+        if (result == ParseResult::Error) {
+            LOG_WARNING(QString("Malformed RTSP request from viewer %1").arg(viewer->clientAddress), "RtspFanOut");
+            removeViewer(viewer);
+            return;
+        }
+        if (result == ParseResult::Frame) {
+            continue; // Receiver reports, the camera does not need them
+        }
+
+        handleViewerRequest(viewer, message);
+        if (m_viewers.value(socket) != viewer) {
+            return; // Torn down while handling the request
+        }
+    }
+
+    viewer->buffer.remove(0, offset);
+}
+
+void RtspFanOut::handleViewerRequest(Viewer* viewer, const RtspMessage& request)
+{
+    const QList<QByteArray> requestLine = request.startLine.split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray url = requestLine.value(1);
+    const QByteArray cseq = request.header("cseq");
+
+    LOG_DEBUG(QString("Viewer %1: %2 %3").arg(viewer->clientAddress)
+              .arg(QString::fromLatin1(method)).arg(QString::fromLatin1(url)), "RtspFanOut");
+
+    if (method == "OPTIONS") {
+        sendViewerResponse(viewer, 200, "OK", cseq,
+                           "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n");
+        return;
+    }
+
+    if (!checkViewerAuthorization(viewer, method, request)) {
+        const QByteArray challenge = "WWW-Authenticate: Digest realm=\"ViscoConnect\", nonce=\"" + m_viewerNonce + "\"\r\n"
+                                     "WWW-Authenticate: Basic realm=\"ViscoConnect\"\r\n";
+        sendViewerResponse(viewer, 401, "Unauthorized", cseq, challenge);
+        return;
+    }
+
+    const QByteArray sessionHeader = "Session: " + viewer->sessionId + ";timeout="
+                                     + QByteArray::number(DEFAULT_SESSION_TIMEOUT_S) + "\r\n";
+
+    if (method == "DESCRIBE") {
+        Upstream* upstream = upstreamFor(pathFromUrl(url));
+        if (viewer->upstream != upstream) {
+            detachViewer(viewer);
+            viewer->upstream = upstream;
+            upstream->viewers.append(viewer);
+        }
+
+        viewer->pendingDescribeCSeq = cseq.isEmpty() ? QByteArray("0") : cseq;
+        viewer->pendingDescribeUrl = url;
+        if (!upstream->sdp.isEmpty()) {
+            answerDescribe(viewer);
+        }
+        return;
+    }
+
+    if (method == "SETUP") {
+        Upstream* upstream = viewer->upstream;
+        if (!upstream || upstream->sdp.isEmpty()) {
+            sendViewerResponse(viewer, 455, "Method Not Valid in This State", cseq);
+            return;
+        }
+
+        const QByteArray transport = request.header("transport");
+        if (!transport.contains("RTP/AVP/TCP")) {
+            sendViewerResponse(viewer, 461, "Unsupported Transport", cseq);
+            return;
+        }
+
+        // Match the control URL, fall back to the first track not set up yet
+        int trackIndex = -1;
+        for (int i = 0; i < upstream->tracks.size() && trackIndex < 0; ++i) {
+            const QByteArray& control = upstream->tracks.at(i).control;
+            if (url == control || url.endsWith('/' + control)) {
+                trackIndex = i;
+            }
+        }
+        for (int i = 0; i < upstream->tracks.size() && trackIndex < 0; ++i) {
+            if (!viewer->channelMap.contains(upstream->tracks.at(i).channel)) {
+                trackIndex = i;
+            }
+        }
+        if (trackIndex < 0) {
+            sendViewerResponse(viewer, 404, "Not Found", cseq);
+            return;
+        }
+
+        const Track& track = upstream->tracks.at(trackIndex);
+        int rtpChannel = track.channel;
+        int rtcpChannel = track.channel + 1;
+        const int interleavedPos = transport.indexOf("interleaved=");
+        if (interleavedPos >= 0) {
+            const QList<QByteArray> channels = transport.mid(interleavedPos + 12).split(';').first().split('-');
+            rtpChannel = channels.value(0).toInt();
+            rtcpChannel = channels.size() > 1 ? channels.at(1).toInt() : rtpChannel + 1;
+        }
+
+        viewer->channelMap[track.channel] = rtpChannel;
+        viewer->channelMap[track.channel + 1] = rtcpChannel;
+
+        sendViewerResponse(viewer, 200, "OK", cseq,
+                           QString("Transport: RTP/AVP/TCP;unicast;interleaved=%1-%2\r\n")
+                           .arg(rtpChannel).arg(rtcpChannel).toLatin1() + sessionHeader);
+        return;
+    }
+
+    if (method == "PLAY") {
+        if (!viewer->upstream || viewer->channelMap.isEmpty()) {
+            sendViewerResponse(viewer, 455, "Method Not Valid in This State", cseq);
+            return;
+        }
+        viewer->playing = true;
+        sendViewerResponse(viewer, 200, "OK", cseq, sessionHeader + "Range: npt=0.000-\r\n");
+        return;
+    }
+
+    if (method == "PAUSE") {
+        viewer->playing = false;
+        sendViewerResponse(viewer, 200, "OK", cseq, sessionHeader);
+        return;
+    }
+
+    if (method == "GET_PARAMETER" || method == "SET_PARAMETER") {
+        sendViewerResponse(viewer, 200, "OK", cseq, sessionHeader);
+        return;
+    }
+
+    if (method == "TEARDOWN") {
+        sendViewerResponse(viewer, 200, "OK", cseq, sessionHeader);
+        viewer->socket->flush();
+        removeViewer(viewer);
+        return;
+    }
+
+    sendViewerResponse(viewer, 501, "Not Implemented", cseq);
+}
+
+bool RtspFanOut::checkViewerAuthorization(Viewer* viewer, const QByteArray& method, const RtspMessage& request)
+{
+    if (viewer->authenticated) {
+        return true;
+    }
+
+    const QByteArray authorization = request.header("authorization");
+    const QByteArray username = m_camera.username().toUtf8();
+    const QByteArray password = m_camera.password().toUtf8();
+
+    if (authorization.startsWith("Basic ")) {
+        viewer->authenticated = (QByteArray::fromBase64(authorization.mid(6).trimmed()) == username + ':' + password);
+    } else if (authorization.startsWith("Digest ")) {
+        const QByteArray realm = authParam(authorization, "realm");
+        const QByteArray nonce = authParam(authorization, "nonce");
+        const QByteArray uri = authParam(authorization, "uri");
+        const QByteArray qop = authParam(authorization, "qop");
+
+        const QByteArray ha1 = md5Hex(username + ':' + realm + ':' + password);
+        const QByteArray ha2 = md5Hex(method + ':' + uri);
+        QByteArray expected;
+        if (qop.isEmpty()) {
+            expected = md5Hex(ha1 + ':' + nonce + ':' + ha2);
+        } else {
+            expected = md5Hex(ha1 + ':' + nonce + ':' + authParam(authorization, "nc") + ':'
+                              + authParam(authorization, "cnonce") + ':' + qop + ':' + ha2);
+        }
+
+        viewer->authenticated = (authParam(authorization, "username") == username &&
+                                 nonce == m_viewerNonce &&
+                                 authParam(authorization, "response") == expected);
+    }
+
+    if (!viewer->authenticated && !authorization.isEmpty()) {
+        LOG_WARNING(QString("Viewer %1 failed authentication for camera '%2'")
+                    .arg(viewer->clientAddress).arg(m_camera.name()), "RtspFanOut");
+    }
+
+    return viewer->authenticated;
+}
+
+void RtspFanOut::sendViewerResponse(Viewer* viewer, int code, const QByteArray& reason, const QByteArray& cseq,
+                                    const QByteArray& extraHeaders, const QByteArray& body)
+{
+    QByteArray response = "RTSP/1.0 " + QByteArray::number(code) + ' ' + reason + "\r\n";
+    if (!cseq.isEmpty()) {
+        response += "CSeq: " + cseq + "\r\n";
+    }
+    response += "Server: ViscoConnect\r\n";
+    response += extraHeaders;
+    if (!body.isEmpty()) {
+        response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    }
+    response += "\r\n";
+    response += body;
+
+    viewer->socket->write(response);
+}
+
+void RtspFanOut::answerDescribe(Viewer* viewer)
+{
+    QByteArray base = viewer->pendingDescribeUrl;
+    if (!base.endsWith('/')) {
+        base += '/';
+    }
+
+    sendViewerResponse(viewer, 200, "OK", viewer->pendingDescribeCSeq,
+                       "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n",
+                       viewer->upstream->sdp);
+
+    viewer->pendingDescribeCSeq.clear();
+    viewer->pendingDescribeUrl.clear();
+}
+
+void RtspFanOut::detachViewer(Viewer* viewer)
+{
+    Upstream* upstream = viewer->upstream;
+    if (!upstream) return;
+
+    upstream->viewers.removeOne(viewer);
+    if (upstream->viewers.isEmpty()) {
+        // Closed by the housekeeping timer unless another viewer shows up
+        upstream->idleSinceMs = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    viewer->upstream = nullptr;
+    viewer->channelMap.clear();
+    viewer->playing = false;
+}
+
+void RtspFanOut::handleViewerDisconnected()
+{
+    Viewer* viewer = m_viewers.value(qobject_cast<QTcpSocket*>(sender()));
+    if (!viewer) return;
+
+    removeViewer(viewer);
+}
+
+void RtspFanOut::removeViewer(Viewer* viewer)
+{
+    detachViewer(viewer);
+
+    m_viewers.remove(viewer->socket);
+    disconnect(viewer->socket, nullptr, this, nullptr);
+    viewer->socket->disconnectFromHost();
+    viewer->socket->deleteLater();
+
+    if (viewer->droppedFrames > 0) {
+        LOG_INFO(QString("Viewer %1 dropped %2 frames while it could not keep up")
+                 .arg(viewer->clientAddress).arg(viewer->droppedFrames), "RtspFanOut");
+    }
+
+    const QString clientAddress = viewer->clientAddress;
+    delete viewer;
+
+    emit viewerClosed(clientAddress);
+}
+
+QByteArray RtspFanOut::authorizationHeader(const Upstream* upstream, const QByteArray& method, const QByteArray& url) const
+{
+    const QByteArray username = m_camera.username().toUtf8();
+    const QByteArray password = m_camera.password().toUtf8();
+
+    if (!upstream->authDigest) {
+        return "Basic " + (username + ':' + password).toBase64();
+    }
+
+    const QByteArray ha1 = md5Hex(username + ':' + upstream->authRealm + ':' + password);
+    const QByteArray ha2 = md5Hex(method + ':' + url);
+
+    QByteArray header = "Digest username=\"" + username + "\", realm=\"" + upstream->authRealm
+                        + "\", nonce=\"" + upstream->authNonce + "\", uri=\"" + url + "\"";
+
+    if (upstream->authQop.isEmpty()) {
+        header += ", response=\"" + md5Hex(ha1 + ':' + upstream->authNonce + ':' + ha2) + "\"";
+    } else {
+        const QByteArray nc = QByteArray::number(upstream->cseq, 16).rightJustified(8, '0');
+        const QByteArray cnonce = QByteArray::number(QRandomGenerator::global()->generate(), 16);
+        header += ", qop=auth, nc=" + nc + ", cnonce=\"" + cnonce + "\", response=\""
+                  + md5Hex(ha1 + ':' + upstream->authNonce + ':' + nc + ':' + cnonce + ":auth:" + ha2) + "\"";
+    }
+
+    return header;
+}
+
+QByteArray RtspFanOut::md5Hex(const QByteArray& data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+QByteArray RtspFanOut::authParam(const QByteArray& header, const QByteArray& name)
+{
+    // name="value" or name=value, separated by commas
+    int pos = 0;
+    while ((pos = header.indexOf(name + '=', pos)) >= 0) {
+        const bool atStart = (pos == 0 || header.at(pos - 1) == ' ' || header.at(pos - 1) == ',');
+        pos += name.size() + 1;
+        if (!atStart) {
+            continue;
+        }
+
+        if (pos < header.size() && header.at(pos) == '"') {
+            const int end = header.indexOf('"', pos + 1);
+            return header.mid(pos + 1, end < 0 ? -1 : end - pos - 1);
+        }
+        const int end = header.indexOf(',', pos);
+        return header.mid(pos, end < 0 ? -1 : end - pos).trimmed();
+    }
+    return QByteArray();
+}
+
+QString RtspFanOut::pathFromUrl(const QByteArray& url)
+{
+    // rtsp://host:port/path?query -> /path?query, the host is ours, not the camera's
+    const QUrl parsed(QString::fromUtf8(url));
+    QString path = parsed.path(QUrl::FullyEncoded);
+    if (path.isEmpty()) {
+        path = "/";
+    }
+    if (parsed.hasQuery()) {
+        path += '?' + parsed.query(QUrl::FullyEncoded);
+    }
+    while (path.size() > 1 && path.endsWith('/')) {
+        path.chop(1);
+    }
+    return path;
+}
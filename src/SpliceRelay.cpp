@@ -0,0 +1,270 @@
+#include "SpliceRelay.h"
+#include "Logger.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
+SpliceRelay::SpliceRelay(qintptr clientDescriptor, qintptr targetDescriptor, QObject *parent)
+    : QObject(parent)
+    , m_clientDescriptor(clientDescriptor)
+    , m_targetDescriptor(targetDescriptor)
+    , m_active(false)
+{
+    m_clientToTarget.source = clientDescriptor;
+    m_clientToTarget.destination = targetDescriptor;
+    m_targetToClient.source = targetDescriptor;
+    m_targetToClient.destination = clientDescriptor;
+}
+
+SpliceRelay::~SpliceRelay()
+{
+    close();
+}
+
+bool SpliceRelay::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+qintptr SpliceRelay::duplicateDescriptor(qintptr descriptor)
+{
+#ifdef Q_OS_LINUX
+    if (descriptor < 0) {
+        return -1;
+    }
+    return ::fcntl(static_cast<int>(descriptor), F_DUPFD_CLOEXEC, 0);
+#else
+    Q_UNUSED(descriptor);
+    return -1;
+#endif
+}
+
+void SpliceRelay::closeDescriptor(qintptr descriptor)
+{
+#ifdef Q_OS_LINUX
+    if (descriptor >= 0) {
+        ::close(static_cast<int>(descriptor));
+    }
+#else
+    Q_UNUSED(descriptor);
+#endif
+}
+
+bool SpliceRelay::start(QString* errorString)
+{
+#ifdef Q_OS_LINUX
+    if (m_active) {
+        return true;
+    }
+
+    if (!openPipe(m_clientToTarget, errorString) || !openPipe(m_targetToClient, errorString)) {
+        close();
+        return false;
+    }
+
+    // The descriptors are dup()ed from QTcpSocket, which keeps them non-blocking,
+    // but make sure since a blocking splice() would stall the event loop
+    for (qintptr fd : {m_clientDescriptor, m_targetDescriptor}) {
+        const int flags = ::fcntl(static_cast<int>(fd), F_GETFL);
+        ::fcntl(static_cast<int>(fd), F_SETFL, flags | O_NONBLOCK);
+    }
+
+    m_clientToTarget.readNotifier = new QSocketNotifier(m_clientDescriptor, QSocketNotifier::Read, this);
+    m_clientToTarget.writeNotifier = new QSocketNotifier(m_targetDescriptor, QSocketNotifier::Write, this);
+    m_targetToClient.readNotifier = new QSocketNotifier(m_targetDescriptor, QSocketNotifier::Read, this);
+    m_targetToClient.writeNotifier = new QSocketNotifier(m_clientDescriptor, QSocketNotifier::Write, this);
+
+    m_clientToTarget.writeNotifier->setEnabled(false);
+    m_targetToClient.writeNotifier->setEnabled(false);
+
+    connect(m_clientToTarget.readNotifier, &QSocketNotifier::activated, this, &SpliceRelay::handleClientReadable);
+    connect(m_targetToClient.readNotifier, &QSocketNotifier::activated, this, &SpliceRelay::handleTargetReadable);
+    connect(m_targetToClient.writeNotifier, &QSocketNotifier::activated, this, &SpliceRelay::handleClientWritable);
+    connect(m_clientToTarget.writeNotifier, &QSocketNotifier::activated, this, &SpliceRelay::handleTargetWritable);
+
+    m_active = true;
+
+    // Data may already be sitting in the kernel buffers from before the hand-off
+    pump(m_clientToTarget, true);
+    if (m_active) {
+        pump(m_targetToClient, false);
+    }
+    return true;
+#else
+    if (errorString) {
+        *errorString = "splice() relay is only available on Linux";
+    }
+    return false;
+#endif
+}
+
+void SpliceRelay::close()
+{
+    for (Pump* pump : {&m_clientToTarget, &m_targetToClient}) {
+        // May be called from inside a notifier's activated() signal
+        if (pump->readNotifier) {
+            pump->readNotifier->setEnabled(false);
+            pump->readNotifier->deleteLater();
+            pump->readNotifier = nullptr;
+        }
+        if (pump->writeNotifier) {
+            pump->writeNotifier->setEnabled(false);
+            pump->writeNotifier->deleteLater();
+            pump->writeNotifier = nullptr;
+        }
+#ifdef Q_OS_LINUX
+        if (pump->pipeRead >= 0) {
+            ::close(pump->pipeRead);
+        }
+        if (pump->pipeWrite >= 0) {
+            ::close(pump->pipeWrite);
+        }
+#endif
+        pump->pipeRead = -1;
+        pump->pipeWrite = -1;
+        pump->pipeBytes = 0;
+    }
+
+    closeDescriptor(m_clientDescriptor);
+    closeDescriptor(m_targetDescriptor);
+    m_clientDescriptor = -1;
+    m_targetDescriptor = -1;
+    m_active = false;
+}
+
+void SpliceRelay::handleClientReadable()
+{
+    pump(m_clientToTarget, true);
+}
+
+void SpliceRelay::handleTargetReadable()
+{
+    pump(m_targetToClient, false);
+}
+
+void SpliceRelay::handleClientWritable()
+{
+    pump(m_targetToClient, false);
+}
+
+void SpliceRelay::handleTargetWritable()
+{
+    pump(m_clientToTarget, true);
+}
+
+bool SpliceRelay::openPipe(Pump& pump, QString* errorString)
+{
+#ifdef Q_OS_LINUX
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+        if (errorString) {
+            *errorString = QString("pipe2() failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        }
+        return false;
+    }
+
+    pump.pipeRead = fds[0];
+    pump.pipeWrite = fds[1];
+    pump.pipeBytes = 0;
+
+    // Best effort - unprivileged processes are capped by /proc/sys/fs/pipe-max-size
+    ::fcntl(pump.pipeWrite, F_SETPIPE_SZ, PIPE_CAPACITY);
+    return true;
+#else
+    Q_UNUSED(pump);
+    Q_UNUSED(errorString);
+    return false;
+#endif
+}
+
+void SpliceRelay::pump(Pump& pump, bool clientToTarget)
+{
+#ifdef Q_OS_LINUX
+    if (!m_active) {
+        return;
+    }
+
+    const unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+    // Socket -> pipe. EAGAIN means either the socket is drained or the pipe is full.
+    while (!pump.sourceClosed && pump.pipeBytes < PIPE_CAPACITY) {
+        const ssize_t n = ::splice(static_cast<int>(pump.source), nullptr, pump.pipeWrite, nullptr,
+                                   static_cast<size_t>(PIPE_CAPACITY - pump.pipeBytes), flags);
+        if (n > 0) {
+            pump.pipeBytes += n;
+        } else if (n == 0) {
+            pump.sourceClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN) {
+            break;
+        } else {
+            LOG_DEBUG(QString("splice() from socket failed: %1").arg(QString::fromLocal8Bit(strerror(errno))), "SpliceRelay");
+            finish();
+            return;
+        }
+    }
+
+    // Pipe -> socket. EAGAIN means the peer's send buffer is full.
+    qint64 moved = 0;
+    while (pump.pipeBytes > 0) {
+        const ssize_t n = ::splice(pump.pipeRead, nullptr, static_cast<int>(pump.destination), nullptr,
+                                   static_cast<size_t>(pump.pipeBytes), flags);
+        if (n > 0) {
+            pump.pipeBytes -= n;
+            moved += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            LOG_DEBUG(QString("splice() to socket failed: %1").arg(QString::fromLocal8Bit(strerror(errno))), "SpliceRelay");
+            finish();
+            return;
+        }
+    }
+
+    if (moved > 0) {
+        emit bytesRelayed(moved, clientToTarget);
+        if (!m_active) {
+            return;
+        }
+    }
+
+    // Stop reading while the pipe holds data the peer has not accepted yet,
+    // so a slow receiver throttles the sender through TCP flow control
+    pump.readNotifier->setEnabled(!pump.sourceClosed && pump.pipeBytes == 0);
+    pump.writeNotifier->setEnabled(pump.pipeBytes > 0);
+
+    if (pump.sourceClosed && pump.pipeBytes == 0 && !pump.destinationShutdown) {
+        ::shutdown(static_cast<int>(pump.destination), SHUT_WR);
+        pump.destinationShutdown = true;
+    }
+
+    if (m_clientToTarget.destinationShutdown && m_targetToClient.destinationShutdown) {
+        finish();
+    }
+#else
+    Q_UNUSED(pump);
+    Q_UNUSED(clientToTarget);
+#endif
+}
+
+void SpliceRelay::finish()
+{
+    if (!m_active) {
+        return;
+    }
+
+    close();
+    emit finished();
+}
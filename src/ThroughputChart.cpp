@@ -0,0 +1,139 @@
+#include "ThroughputChart.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <cmath>
+
+namespace {
+
+const QColor RECEIVED_COLOR(0, 140, 0);
+const QColor SENT_COLOR(30, 90, 200);
+
+// Smallest 1, 2 or 5 times a power of ten at or above value
+double niceCeiling(double value)
+{
+    if (value <= 0.0) {
+        return 1.0;
+    }
+    const double magnitude = std::pow(10.0, std::floor(std::log10(value)));
+    for (double step : {1.0, 2.0, 5.0, 10.0}) {
+        if (value <= step * magnitude) {
+            return step * magnitude;
+        }
+    }
+    return 10.0 * magnitude;
+}
+
+QPolygonF seriesPolygon(const ThroughputHistory& history, const QRectF& rect, int seconds, double maximum, bool received)
+{
+    QPolygonF points;
+    const int count = qMin(history.size(), seconds);
+    points.reserve(count);
+    const double step = seconds > 1 ? rect.width() / (seconds - 1) : 0.0;
+    for (int secondsAgo = count - 1; secondsAgo >= 0; --secondsAgo) {
+        const ThroughputHistory::Sample sample = history.at(secondsAgo);
+        const double mbit = ThroughputHistory::toMbitPerSecond(received ? sample.receivedBytes : sample.sentBytes);
+        points.append(QPointF(rect.right() - secondsAgo * step,
+                              rect.bottom() - qMin(mbit / maximum, 1.0) * rect.height()));
+    }
+    return points;
+}
+
+} // namespace
+
+ThroughputChart::ThroughputChart(QWidget *parent)
+    : QWidget(parent)
+{
+    setAutoFillBackground(true);
+    setBackgroundRole(QPalette::Base);
+}
+
+void ThroughputChart::setHistory(const ThroughputHistory& history)
+{
+    m_history = history;
+    update();
+}
+
+QSize ThroughputChart::sizeHint() const
+{
+    return QSize(640, 260);
+}
+
+QSize ThroughputChart::minimumSizeHint() const
+{
+    return QSize(320, 160);
+}
+
+void ThroughputChart::paintSparkline(QPainter* painter, const QRect& rect, const ThroughputHistory& history, int seconds)
+{
+    if (history.size() == 0 || rect.width() < 2 || rect.height() < 2) {
+        return;
+    }
+
+    // Scaled to its own peak: the shape matters here, the value is shown as text
+    quint32 peak = 0;
+    for (int secondsAgo = 0; secondsAgo < qMin(history.size(), seconds); ++secondsAgo) {
+        peak = qMax(peak, history.at(secondsAgo).receivedBytes);
+    }
+    const double maximum = peak > 0 ? ThroughputHistory::toMbitPerSecond(peak) : 1.0;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QPen(RECEIVED_COLOR, 1.0));
+    painter->drawPolyline(seriesPolygon(history, QRectF(rect), seconds, maximum, true));
+    painter->restore();
+}
+
+void ThroughputChart::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    const QFontMetrics metrics = fontMetrics();
+    const QRectF plot = QRectF(rect()).adjusted(metrics.horizontalAdvance("0000.0 Mbit/s") + 8, metrics.height() + 10,
+                                                -12, -(metrics.height() + 8));
+
+    quint32 peak = 0;
+    for (int secondsAgo = 0; secondsAgo < m_history.size(); ++secondsAgo) {
+        const ThroughputHistory::Sample sample = m_history.at(secondsAgo);
+        peak = qMax(peak, qMax(sample.receivedBytes, sample.sentBytes));
+    }
+    const double maximum = niceCeiling(ThroughputHistory::toMbitPerSecond(peak));
+
+    // Grid with the Mbit/s scale on the left
+    const int gridLines = 4;
+    for (int i = 0; i <= gridLines; ++i) {
+        const double y = plot.bottom() - plot.height() * i / gridLines;
+        painter.setPen(QPen(palette().color(QPalette::Mid), 0, i == 0 ? Qt::SolidLine : Qt::DotLine));
+        painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRectF(0, y - metrics.height() / 2.0, plot.left() - 6, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter,
+                         QString("%1 Mbit/s").arg(maximum * i / gridLines, 0, 'g', 3));
+    }
+
+    // Time axis, newest on the right
+    const int minutes = ThroughputHistory::CAPACITY / 60;
+    const QRectF axis(plot.left(), plot.bottom() + 4, plot.width(), metrics.height());
+    painter.drawText(axis, Qt::AlignLeft | Qt::AlignTop, QString("-%1 min").arg(minutes));
+    painter.drawText(axis, Qt::AlignHCenter | Qt::AlignTop, QString("-%1 min").arg(minutes / 2.0));
+    painter.drawText(axis, Qt::AlignRight | Qt::AlignTop, "now");
+
+    // Legend with the latest sample
+    const ThroughputHistory::Sample latest = m_history.latest();
+    const QRectF legend(plot.left(), 4, plot.width(), metrics.height());
+    painter.setPen(RECEIVED_COLOR);
+    painter.drawText(legend, Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Received %1 Mbit/s").arg(ThroughputHistory::toMbitPerSecond(latest.receivedBytes), 0, 'f', 2));
+    painter.setPen(SENT_COLOR);
+    painter.drawText(legend, Qt::AlignRight | Qt::AlignVCenter,
+                     QString("Sent %1 Mbit/s").arg(ThroughputHistory::toMbitPerSecond(latest.sentBytes), 0, 'f', 2));
+
+    if (m_history.size() == 0) {
+        return;
+    }
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(SENT_COLOR, 1.0));
+    painter.drawPolyline(seriesPolygon(m_history, plot, ThroughputHistory::CAPACITY, maximum, false));
+    painter.setPen(QPen(RECEIVED_COLOR, 1.5));
+    painter.drawPolyline(seriesPolygon(m_history, plot, ThroughputHistory::CAPACITY, maximum, true));
+}
@@ -0,0 +1,23 @@
+#include "TrafficCounters.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
+qint64 TrafficCounters::nowMs()
+{
+#if defined(Q_OS_WIN)
+    return static_cast<qint64>(GetTickCount64());
+#elif defined(Q_OS_LINUX)
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+#else
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
@@ -0,0 +1,421 @@
+#include "UdpEchoServer.h"
+#include "Logger.h"
+#include <QtEndian>
+#include <chrono>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#ifndef SIO_UDP_CONNRESET
+#define SIO_UDP_CONNRESET _WSAIOW(IOC_VENDOR, 12)
+#endif
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <time.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_WIN
+typedef SOCKET NativeSocket;
+#else
+typedef int NativeSocket;
+#endif
+
+bool toNative(const QHostAddress& address, quint16 port, sockaddr_storage* native, socklen_t* length)
+{
+    std::memset(native, 0, sizeof(*native));
+
+    bool isIpv4 = false;
+    const quint32 ipv4 = address.toIPv4Address(&isIpv4);
+    if (isIpv4) {
+        sockaddr_in* in = reinterpret_cast<sockaddr_in*>(native);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(ipv4);
+        *length = sizeof(sockaddr_in);
+        return true;
+    }
+
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(native);
+        const Q_IPV6ADDR ipv6 = address.toIPv6Address();
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        std::memcpy(&in6->sin6_addr, &ipv6, sizeof(ipv6));
+        *length = sizeof(sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+quint16 portOf(const sockaddr_storage& address)
+{
+    if (address.ss_family == AF_INET) {
+        return ntohs(reinterpret_cast<const sockaddr_in&>(address).sin_port);
+    }
+    if (address.ss_family == AF_INET6) {
+        return ntohs(reinterpret_cast<const sockaddr_in6&>(address).sin6_port);
+    }
+    return 0;
+}
+
+QString lastSocketErrorString()
+{
+#ifdef Q_OS_WIN
+    return QString("socket error %1").arg(WSAGetLastError());
+#else
+    return QString::fromLocal8Bit(strerror(errno));
+#endif
+}
+
+bool lastErrorWouldBlock()
+{
+#ifdef Q_OS_WIN
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+qint64 toNs(const timespec& time)
+{
+    return static_cast<qint64>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+}
+#endif
+
+// Reads one datagram. Returns its size, 0 once the socket is drained, -1 on
+// error. kernelNs is set when the kernel stamped the datagram on arrival.
+int receiveDatagram(qintptr descriptor, char* buffer, int size, sockaddr_storage* source, socklen_t* sourceLength,
+                    bool* truncated, qint64* kernelNs)
+{
+    *truncated = false;
+    *kernelNs = 0;
+
+#ifdef Q_OS_LINUX
+    iovec vector;
+    vector.iov_base = buffer;
+    vector.iov_len = static_cast<size_t>(size);
+    alignas(cmsghdr) char control[256];
+
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_name = source;
+    message.msg_namelen = sizeof(sockaddr_storage);
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    const ssize_t received = ::recvmsg(static_cast<int>(descriptor), &message, MSG_DONTWAIT);
+    if (received < 0) {
+        return lastErrorWouldBlock() ? 0 : -1;
+    }
+    *sourceLength = message.msg_namelen;
+    *truncated = (message.msg_flags & MSG_TRUNC) != 0;
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (header->cmsg_type == SCM_TIMESTAMPING) {
+            // ts[0] is the software timestamp, ts[2] the hardware one
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(header), sizeof(stamps));
+            if (stamps.ts[0].tv_sec != 0 || stamps.ts[0].tv_nsec != 0) {
+                *kernelNs = toNs(stamps.ts[0]);
+            }
+        } else if (header->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec stamp;
+            std::memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
+            *kernelNs = toNs(stamp);
+        }
+    }
+    return static_cast<int>(received);
+#else
+    *sourceLength = sizeof(sockaddr_storage);
+    const int received = ::recvfrom(static_cast<NativeSocket>(descriptor), buffer, size, 0,
+                                    reinterpret_cast<sockaddr*>(source), sourceLength);
+    if (received < 0) {
+#ifdef Q_OS_WIN
+        if (WSAGetLastError() == WSAEMSGSIZE) {
+            *truncated = true;
+            return size;
+        }
+#endif
+        return lastErrorWouldBlock() ? 0 : -1;
+    }
+    return received;
+#endif
+}
+
+} // namespace
+
+bool UdpEchoProbe::parse(const char* data, int size, UdpEchoProbe* probe)
+{
+    if (size < HEADER_SIZE || size > MAX_SIZE) {
+        return false;
+    }
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    if (qFromBigEndian<quint32>(bytes) != MAGIC || bytes[4] != VERSION) {
+        return false;
+    }
+    probe->flags = bytes[5];
+    probe->sequence = qFromBigEndian<quint32>(bytes + 8);
+    probe->clientSendNs = qFromBigEndian<qint64>(bytes + 12);
+    probe->serverReceiveNs = qFromBigEndian<qint64>(bytes + 20);
+    probe->serverTransmitNs = qFromBigEndian<qint64>(bytes + 28);
+    return true;
+}
+
+void UdpEchoProbe::write(char* data) const
+{
+    uchar* bytes = reinterpret_cast<uchar*>(data);
+    qToBigEndian<quint32>(MAGIC, bytes);
+    bytes[4] = VERSION;
+    bytes[5] = flags;
+    bytes[6] = 0;
+    bytes[7] = 0;
+    qToBigEndian<quint32>(sequence, bytes + 8);
+    qToBigEndian<qint64>(clientSendNs, bytes + 12);
+    qToBigEndian<qint64>(serverReceiveNs, bytes + 20);
+    qToBigEndian<qint64>(serverTransmitNs, bytes + 28);
+}
+
+qint64 UdpEchoProbe::nowNs()
+{
+    // Same clock as the kernel receive timestamps (CLOCK_REALTIME)
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+UdpEchoServer::UdpEchoServer(QObject *parent)
+    : QObject(parent)
+    , m_descriptor(-1)
+    , m_notifier(nullptr)
+    , m_port(0)
+    , m_kernelTimestamps(false)
+    , m_totalProbes(0)
+    , m_totalInvalid(0)
+    , m_totalBytesReceived(0)
+    , m_totalBytesSent(0)
+{
+}
+
+UdpEchoServer::~UdpEchoServer()
+{
+    stopServer();
+}
+
+bool UdpEchoServer::startServer(quint16 port, const QHostAddress& address)
+{
+    if (isRunning()) {
+        LOG_WARNING("UDP echo server is already running", "EchoServer");
+        return true;
+    }
+
+    QString errorString;
+    if (!openSocket(port, address, &errorString)) {
+        const QString error = QString("Failed to start UDP echo server on %1:%2 - %3")
+                              .arg(address.toString())
+                              .arg(port)
+                              .arg(errorString);
+        LOG_ERROR(error, "EchoServer");
+        emit errorOccurred(error);
+        return false;
+    }
+
+    enableKernelTimestamps();
+    m_totalProbes = 0;
+    m_totalInvalid = 0;
+    m_totalBytesReceived = 0;
+    m_totalBytesSent = 0;
+
+    m_notifier = new QSocketNotifier(m_descriptor, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UdpEchoServer::handleReadable);
+
+    LOG_INFO(QString("UDP echo server started on %1:%2 (%3 receive timestamps)")
+             .arg(address.toString())
+             .arg(m_port)
+             .arg(m_kernelTimestamps ? "kernel" : "userspace"), "EchoServer");
+
+    emit serverStarted(m_port);
+    return true;
+}
+
+void UdpEchoServer::stopServer()
+{
+    if (!isRunning()) return;
+
+    closeSocket();
+
+    LOG_INFO(QString("UDP echo server stopped. Statistics: %1 probes, %2 invalid datagrams, %3 bytes received, %4 bytes sent")
+             .arg(m_totalProbes)
+             .arg(m_totalInvalid)
+             .arg(m_totalBytesReceived)
+             .arg(m_totalBytesSent), "EchoServer");
+
+    emit serverStopped();
+}
+
+void UdpEchoServer::handleReadable()
+{
+    char buffer[UdpEchoProbe::MAX_SIZE + 1];
+    sockaddr_storage source;
+
+    // Bounded so a flood cannot starve the rest of the event loop
+    for (int i = 0; i < MAX_DATAGRAMS_PER_WAKEUP && m_descriptor >= 0; ++i) {
+        socklen_t sourceLength = 0;
+        bool truncated = false;
+        qint64 kernelNs = 0;
+        const int size = receiveDatagram(m_descriptor, buffer, sizeof(buffer), &source, &sourceLength,
+                                         &truncated, &kernelNs);
+        if (size == 0) {
+            return;
+        }
+        if (size < 0) {
+            // ICMP errors from clients that went away end up here, keep serving
+            LOG_DEBUG(QString("UDP echo server receive failed: %1").arg(lastSocketErrorString()), "EchoServer");
+            return;
+        }
+        const qint64 receiveNs = kernelNs != 0 ? kernelNs : UdpEchoProbe::nowNs();
+        m_totalBytesReceived += size;
+
+        // Replies are never answered, or two echo servers could bounce one
+        // datagram back and forth forever
+        UdpEchoProbe probe;
+        if (truncated || portOf(source) == 0 || !UdpEchoProbe::parse(buffer, size, &probe)
+            || (probe.flags & UdpEchoProbe::Reply)) {
+            ++m_totalInvalid;
+            continue;
+        }
+
+        probe.flags = UdpEchoProbe::Reply | (kernelNs != 0 ? UdpEchoProbe::KernelReceiveTime : 0);
+        probe.serverReceiveNs = receiveNs;
+        probe.serverTransmitNs = UdpEchoProbe::nowNs();
+        probe.write(buffer);
+
+        const int sent = ::sendto(static_cast<NativeSocket>(m_descriptor), buffer, size, 0,
+                                  reinterpret_cast<const sockaddr*>(&source), sourceLength);
+        ++m_totalProbes;
+        if (sent > 0) {
+            m_totalBytesSent += sent;
+        }
+    }
+}
+
+bool UdpEchoServer::openSocket(quint16 port, const QHostAddress& address, QString* errorString)
+{
+    // Any listens on both families through one IPv6 socket where it can
+    const bool dualStack = address == QHostAddress::Any;
+    const QList<QHostAddress> candidates = dualStack
+        ? QList<QHostAddress>{QHostAddress(QHostAddress::AnyIPv6), QHostAddress(QHostAddress::AnyIPv4)}
+        : QList<QHostAddress>{address};
+
+    for (const QHostAddress& candidate : candidates) {
+        sockaddr_storage native;
+        socklen_t length = 0;
+        if (!toNative(candidate, port, &native, &length)) {
+            *errorString = QString("unsupported address %1").arg(candidate.toString());
+            return false;
+        }
+
+#ifdef Q_OS_WIN
+        const SOCKET socket = ::socket(native.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        if (socket == INVALID_SOCKET) {
+            *errorString = QString("socket() failed: %1").arg(lastSocketErrorString());
+            continue;
+        }
+        const qintptr descriptor = static_cast<qintptr>(socket);
+
+        u_long nonBlocking = 1;
+        ::ioctlsocket(socket, FIONBIO, &nonBlocking);
+
+        // An ICMP port unreachable from a client that went away would
+        // otherwise fail the next receive with WSAECONNRESET
+        BOOL reportReset = FALSE;
+        DWORD returned = 0;
+        ::WSAIoctl(socket, SIO_UDP_CONNRESET, &reportReset, sizeof(reportReset), nullptr, 0, &returned, nullptr, nullptr);
+#else
+        int flags = SOCK_DGRAM;
+#ifdef Q_OS_LINUX
+        flags |= SOCK_NONBLOCK | SOCK_CLOEXEC;
+#endif
+        const int socket = ::socket(native.ss_family, flags, IPPROTO_UDP);
+        if (socket < 0) {
+            *errorString = QString("socket() failed: %1").arg(lastSocketErrorString());
+            continue;
+        }
+        const qintptr descriptor = socket;
+#ifndef Q_OS_LINUX
+        ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL) | O_NONBLOCK);
+        ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+#endif
+#endif
+
+        if (dualStack && native.ss_family == AF_INET6) {
+            const int v6Only = 0;
+            ::setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6Only), sizeof(v6Only));
+        }
+
+        if (::bind(socket, reinterpret_cast<const sockaddr*>(&native), length) != 0) {
+            *errorString = QString("bind() failed: %1").arg(lastSocketErrorString());
+            m_descriptor = descriptor;
+            closeSocket();
+            continue;
+        }
+
+        sockaddr_storage bound;
+        socklen_t boundLength = sizeof(bound);
+        ::getsockname(socket, reinterpret_cast<sockaddr*>(&bound), &boundLength);
+        m_descriptor = descriptor;
+        m_port = portOf(bound);
+        return true;
+    }
+    return false;
+}
+
+void UdpEchoServer::enableKernelTimestamps()
+{
+    m_kernelTimestamps = false;
+#ifdef Q_OS_LINUX
+    const int socket = static_cast<int>(m_descriptor);
+    const int timestamping = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping)) == 0) {
+        m_kernelTimestamps = true;
+        return;
+    }
+    const int enable = 1;
+    m_kernelTimestamps = ::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+#endif
+}
+
+void UdpEchoServer::closeSocket()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+
+    if (m_descriptor >= 0) {
+#ifdef Q_OS_WIN
+        ::closesocket(static_cast<SOCKET>(m_descriptor));
+#else
+        ::close(static_cast<int>(m_descriptor));
+#endif
+    }
+    m_descriptor = -1;
+    m_port = 0;
+    m_kernelTimestamps = false;
+}
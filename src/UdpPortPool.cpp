@@ -0,0 +1,47 @@
+#include "UdpPortPool.h"
+#include <QMutexLocker>
+
+UdpPortPool::UdpPortPool(quint16 firstPort, quint16 lastPort)
+    : m_firstPort(static_cast<quint16>((firstPort + 1) & ~1))
+    , m_lastPort(lastPort)
+{
+    // The range must hold at least one full pair
+    if (m_lastPort < m_firstPort + 1) {
+        m_lastPort = static_cast<quint16>(m_firstPort + 1);
+    }
+    m_nextPort = m_firstPort;
+}
+
+quint16 UdpPortPool::acquirePair()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const int pairs = pairCount();
+    for (int i = 0; i < pairs; ++i) {
+        const quint16 port = m_nextPort;
+        m_nextPort = (port + 3 > m_lastPort) ? m_firstPort : static_cast<quint16>(port + 2);
+
+        if (!m_inUse.contains(port)) {
+            m_inUse.insert(port);
+            return port;
+        }
+    }
+    return 0;
+}
+
+void UdpPortPool::releasePair(quint16 rtpPort)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inUse.remove(rtpPort);
+}
+
+int UdpPortPool::pairCount() const
+{
+    return (m_lastPort - m_firstPort + 1) / 2;
+}
+
+int UdpPortPool::pairsInUse() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inUse.size();
+}
@@ -0,0 +1,708 @@
+#include "UdpRelay.h"
+#include "UdpPortPool.h"
+#include "Logger.h"
+#include <QList>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#ifndef SIO_UDP_CONNRESET
+#define SIO_UDP_CONNRESET _WSAIOW(IOC_VENDOR, 12)
+#endif
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <netinet/udp.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103     // Linux 4.18+, older kernels reject the cmsg
+#endif
+#endif
+
+namespace {
+
+#ifdef Q_OS_WIN
+typedef SOCKET NativeSocket;
+#else
+typedef int NativeSocket;
+#endif
+
+const int BATCH_CAPACITY = 64;
+const int MAX_GSO_SEGMENTS = 64;
+const int MAX_GSO_BYTES = 60000;    // Below the 64 KiB UDP GSO limit
+
+struct Datagram {
+    char* data;
+    int size;
+    bool truncated;
+    sockaddr_storage source;
+};
+
+bool toNative(const QHostAddress& address, quint16 port, sockaddr_storage* native, socklen_t* length)
+{
+    std::memset(native, 0, sizeof(*native));
+
+    bool isIpv4 = false;
+    const quint32 ipv4 = address.toIPv4Address(&isIpv4);
+    if (isIpv4) {
+        sockaddr_in* in = reinterpret_cast<sockaddr_in*>(native);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(ipv4);
+        *length = sizeof(sockaddr_in);
+        return true;
+    }
+
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(native);
+        const Q_IPV6ADDR ipv6 = address.toIPv6Address();
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        std::memcpy(&in6->sin6_addr, &ipv6, sizeof(ipv6));
+        *length = sizeof(sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+// Compares addresses only, ports are checked by the caller
+bool sameHost(const sockaddr_storage& a, const sockaddr_storage& b)
+{
+    if (a.ss_family != b.ss_family) {
+        return false;
+    }
+    if (a.ss_family == AF_INET) {
+        return reinterpret_cast<const sockaddr_in&>(a).sin_addr.s_addr ==
+               reinterpret_cast<const sockaddr_in&>(b).sin_addr.s_addr;
+    }
+    if (a.ss_family == AF_INET6) {
+        return std::memcmp(&reinterpret_cast<const sockaddr_in6&>(a).sin6_addr,
+                           &reinterpret_cast<const sockaddr_in6&>(b).sin6_addr, sizeof(in6_addr)) == 0;
+    }
+    return false;
+}
+
+quint16 portOf(const sockaddr_storage& address)
+{
+    if (address.ss_family == AF_INET) {
+        return ntohs(reinterpret_cast<const sockaddr_in&>(address).sin_port);
+    }
+    if (address.ss_family == AF_INET6) {
+        return ntohs(reinterpret_cast<const sockaddr_in6&>(address).sin6_port);
+    }
+    return 0;
+}
+
+QString lastSocketErrorString()
+{
+#ifdef Q_OS_WIN
+    return QString("socket error %1").arg(WSAGetLastError());
+#else
+    return QString::fromLocal8Bit(strerror(errno));
+#endif
+}
+
+bool lastErrorWouldBlock()
+{
+#ifdef Q_OS_WIN
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+void closeSocket(qintptr descriptor)
+{
+    if (descriptor < 0) {
+        return;
+    }
+#ifdef Q_OS_WIN
+    ::closesocket(static_cast<SOCKET>(descriptor));
+#else
+    ::close(static_cast<int>(descriptor));
+#endif
+}
+
+qintptr openSocket(const QHostAddress& peer, quint16 port, int receiveBuffer, QString* errorString)
+{
+    bool isIpv4 = false;
+    peer.toIPv4Address(&isIpv4);
+    const int family = isIpv4 ? AF_INET : AF_INET6;
+
+#ifdef Q_OS_WIN
+    const SOCKET socket = ::socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket == INVALID_SOCKET) {
+        *errorString = QString("socket() failed: %1").arg(lastSocketErrorString());
+        return -1;
+    }
+    const qintptr descriptor = static_cast<qintptr>(socket);
+
+    u_long nonBlocking = 1;
+    ::ioctlsocket(socket, FIONBIO, &nonBlocking);
+
+    // An ICMP port unreachable from a viewer that went away would otherwise
+    // fail the next receive with WSAECONNRESET
+    BOOL reportReset = FALSE;
+    DWORD returned = 0;
+    ::WSAIoctl(socket, SIO_UDP_CONNRESET, &reportReset, sizeof(reportReset), nullptr, 0, &returned, nullptr, nullptr);
+#else
+    int flags = SOCK_DGRAM;
+#ifdef Q_OS_LINUX
+    flags |= SOCK_NONBLOCK | SOCK_CLOEXEC;
+#endif
+    const int socket = ::socket(family, flags, IPPROTO_UDP);
+    if (socket < 0) {
+        *errorString = QString("socket() failed: %1").arg(lastSocketErrorString());
+        return -1;
+    }
+    const qintptr descriptor = socket;
+#ifndef Q_OS_LINUX
+    ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL) | O_NONBLOCK);
+    ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+#endif
+#endif
+
+    if (receiveBuffer > 0) {
+        // Best effort, the system caps it (net.core.rmem_max on Linux)
+        ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+    }
+
+    sockaddr_storage address;
+    socklen_t length = 0;
+    toNative(isIpv4 ? QHostAddress(QHostAddress::AnyIPv4) : QHostAddress(QHostAddress::AnyIPv6), port, &address, &length);
+    if (::bind(socket, reinterpret_cast<const sockaddr*>(&address), length) != 0) {
+        *errorString = QString("bind() to UDP port %1 failed: %2").arg(port).arg(lastSocketErrorString());
+        closeSocket(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+// Reads up to count datagrams into slotSize slots of buffer. Returns the
+// number read, 0 once the socket is drained, -1 on error.
+int receiveBatch(qintptr descriptor, char* buffer, int slotSize, Datagram* datagrams, int count)
+{
+#ifdef Q_OS_LINUX
+    mmsghdr messages[BATCH_CAPACITY];
+    iovec vectors[BATCH_CAPACITY];
+    std::memset(messages, 0, sizeof(mmsghdr) * count);
+
+    for (int i = 0; i < count; ++i) {
+        vectors[i].iov_base = buffer + i * slotSize;
+        vectors[i].iov_len = slotSize;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &datagrams[i].source;
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    }
+
+    const int received = ::recvmmsg(static_cast<int>(descriptor), messages, count, MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+        return lastErrorWouldBlock() ? 0 : -1;
+    }
+
+    for (int i = 0; i < received; ++i) {
+        datagrams[i].data = buffer + i * slotSize;
+        datagrams[i].size = static_cast<int>(messages[i].msg_len);
+        datagrams[i].truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    }
+    return received;
+#else
+    int received = 0;
+    while (received < count) {
+        Datagram& datagram = datagrams[received];
+        socklen_t length = sizeof(datagram.source);
+        datagram.data = buffer + received * slotSize;
+        datagram.truncated = false;
+
+        const int n = ::recvfrom(static_cast<NativeSocket>(descriptor), datagram.data, slotSize, 0,
+                                 reinterpret_cast<sockaddr*>(&datagram.source), &length);
+        if (n < 0) {
+#ifdef Q_OS_WIN
+            if (WSAGetLastError() == WSAEMSGSIZE) {
+                datagram.size = slotSize;
+                datagram.truncated = true;
+                ++received;
+                continue;
+            }
+#endif
+            if (lastErrorWouldBlock() || received > 0) {
+                break;
+            }
+            return -1;
+        }
+        datagram.size = n;
+        ++received;
+    }
+    return received;
+#endif
+}
+
+// Sends the datagrams to target and returns how many left. A full socket
+// buffer drops the rest, as it would for any UDP sender.
+int sendBatch(qintptr descriptor, const sockaddr_storage& target, socklen_t targetLength,
+              const Datagram* datagrams, int count, bool* useGso)
+{
+#ifdef Q_OS_LINUX
+    mmsghdr messages[BATCH_CAPACITY];
+    iovec vectors[BATCH_CAPACITY];
+    int runs[BATCH_CAPACITY];
+    union {
+        char buffer[CMSG_SPACE(sizeof(uint16_t))];
+        cmsghdr align;
+    } control[BATCH_CAPACITY];
+
+    // Each message carries a run of datagrams. With GSO a run of equal sized
+    // datagrams, the last one possibly shorter, is split up by the kernel
+    // (or the NIC) and costs a single trip through the stack.
+    int messageCount = 0;
+    for (int i = 0; i < count;) {
+        const int segmentSize = datagrams[i].size;
+        int run = 1;
+        int runBytes = segmentSize;
+        if (*useGso) {
+            while (i + run < count && run < MAX_GSO_SEGMENTS && runBytes + segmentSize <= MAX_GSO_BYTES &&
+                   datagrams[i + run].size == segmentSize) {
+                runBytes += segmentSize;
+                ++run;
+            }
+            if (i + run < count && run < MAX_GSO_SEGMENTS && runBytes + datagrams[i + run].size <= MAX_GSO_BYTES &&
+                datagrams[i + run].size < segmentSize) {
+                runBytes += datagrams[i + run].size;
+                ++run;
+            }
+        }
+
+        for (int k = 0; k < run; ++k) {
+            vectors[i + k].iov_base = datagrams[i + k].data;
+            vectors[i + k].iov_len = datagrams[i + k].size;
+        }
+
+        mmsghdr& message = messages[messageCount];
+        std::memset(&message, 0, sizeof(message));
+        message.msg_hdr.msg_name = const_cast<sockaddr_storage*>(&target);
+        message.msg_hdr.msg_namelen = targetLength;
+        message.msg_hdr.msg_iov = &vectors[i];
+        message.msg_hdr.msg_iovlen = run;
+
+        if (run > 1) {
+            message.msg_hdr.msg_control = control[messageCount].buffer;
+            message.msg_hdr.msg_controllen = sizeof(control[messageCount].buffer);
+            cmsghdr* header = CMSG_FIRSTHDR(&message.msg_hdr);
+            header->cmsg_level = SOL_UDP;
+            header->cmsg_type = UDP_SEGMENT;
+            header->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t segment = static_cast<uint16_t>(segmentSize);
+            std::memcpy(CMSG_DATA(header), &segment, sizeof(segment));
+        }
+
+        runs[messageCount++] = run;
+        i += run;
+    }
+
+    int sentMessages = 0;
+    int sentDatagrams = 0;
+    while (sentMessages < messageCount) {
+        const int n = ::sendmmsg(static_cast<int>(descriptor), messages + sentMessages,
+                                 messageCount - sentMessages, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (runs[sentMessages] > 1 && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT)) {
+                // No GSO on this kernel or route, send the rest one by one
+                *useGso = false;
+                return sentDatagrams + sendBatch(descriptor, target, targetLength, datagrams + sentDatagrams,
+                                                 count - sentDatagrams, useGso);
+            }
+            break;
+        }
+        for (int j = 0; j < n; ++j) {
+            sentDatagrams += runs[sentMessages + j];
+        }
+        sentMessages += n;
+    }
+    return sentDatagrams;
+#else
+    Q_UNUSED(useGso);
+    int sent = 0;
+    for (; sent < count; ++sent) {
+        const int n = ::sendto(static_cast<NativeSocket>(descriptor), datagrams[sent].data, datagrams[sent].size, 0,
+                               reinterpret_cast<const sockaddr*>(&target), targetLength);
+        if (n < 0) {
+            break;
+        }
+    }
+    return sent;
+#endif
+}
+
+QList<QByteArray> transportParameters(const QByteArray& transport)
+{
+    QList<QByteArray> parameters = transport.split(';');
+    for (QByteArray& parameter : parameters) {
+        parameter = parameter.trimmed();
+    }
+    return parameters;
+}
+
+} // namespace
+
+UdpRelay::UdpRelay(const QSharedPointer<UdpPortPool>& ports, RelayBufferPool& buffers, QObject *parent)
+    : QObject(parent)
+    , m_ports(ports)
+    , m_buffers(buffers)
+    , m_traffic(QSharedPointer<TrafficCounters>::create())
+    , m_droppedPackets(0)
+    , m_useGso(true)
+    , m_active(false)
+{
+    static_assert(MAX_BATCH <= BATCH_CAPACITY, "batch arrays are sized by BATCH_CAPACITY");
+}
+
+UdpRelay::~UdpRelay()
+{
+    close();
+}
+
+bool UdpRelay::open(const QHostAddress& cameraAddress, const QHostAddress& clientAddress, QString* errorString)
+{
+    QString error;
+    if (!m_ports || !bindPair(m_cameraSide, cameraAddress, &error) || !bindPair(m_clientSide, clientAddress, &error)) {
+        if (!m_ports) {
+            error = "UDP relay is disabled";
+        }
+        close();
+        if (errorString) {
+            *errorString = error;
+        }
+        return false;
+    }
+    return true;
+}
+
+void UdpRelay::setClient(const QHostAddress& address, quint16 rtpPort, quint16 rtcpPort)
+{
+    m_client[Rtp] = { address, rtpPort };
+    m_client[Rtcp] = { address, rtcpPort };
+}
+
+void UdpRelay::setCamera(const QHostAddress& address, quint16 rtpPort, quint16 rtcpPort)
+{
+    m_camera[Rtp] = { address, rtpPort };
+    m_camera[Rtcp] = { address, rtcpPort };
+}
+
+void UdpRelay::start()
+{
+    if (m_active || m_cameraSide[Rtp].descriptor < 0 || m_clientSide[Rtp].descriptor < 0) {
+        return;
+    }
+    m_active = true;
+
+    m_cameraSide[Rtp].notifier = new QSocketNotifier(m_cameraSide[Rtp].descriptor, QSocketNotifier::Read, this);
+    m_cameraSide[Rtcp].notifier = new QSocketNotifier(m_cameraSide[Rtcp].descriptor, QSocketNotifier::Read, this);
+    m_clientSide[Rtp].notifier = new QSocketNotifier(m_clientSide[Rtp].descriptor, QSocketNotifier::Read, this);
+    m_clientSide[Rtcp].notifier = new QSocketNotifier(m_clientSide[Rtcp].descriptor, QSocketNotifier::Read, this);
+
+    connect(m_cameraSide[Rtp].notifier, &QSocketNotifier::activated, this, &UdpRelay::handleCameraRtpReadable);
+    connect(m_cameraSide[Rtcp].notifier, &QSocketNotifier::activated, this, &UdpRelay::handleCameraRtcpReadable);
+    connect(m_clientSide[Rtp].notifier, &QSocketNotifier::activated, this, &UdpRelay::handleClientRtpReadable);
+    connect(m_clientSide[Rtcp].notifier, &QSocketNotifier::activated, this, &UdpRelay::handleClientRtcpReadable);
+}
+
+void UdpRelay::close()
+{
+    m_active = false;
+    closePair(m_cameraSide);
+    closePair(m_clientSide);
+}
+
+void UdpRelay::handleCameraRtpReadable()
+{
+    pump(Rtp, false);
+}
+
+void UdpRelay::handleCameraRtcpReadable()
+{
+    pump(Rtcp, false);
+}
+
+void UdpRelay::handleClientRtpReadable()
+{
+    pump(Rtp, true);
+}
+
+void UdpRelay::handleClientRtcpReadable()
+{
+    pump(Rtcp, true);
+}
+
+bool UdpRelay::bindPair(Socket* pair, const QHostAddress& peer, QString* errorString)
+{
+    for (int attempt = 0; attempt < BIND_ATTEMPTS; ++attempt) {
+        const quint16 port = m_ports->acquirePair();
+        if (port == 0) {
+            *errorString = QString("all %1 UDP relay port pairs are in use").arg(m_ports->pairCount());
+            return false;
+        }
+
+        pair[Rtp].port = port;
+        pair[Rtcp].port = static_cast<quint16>(port + 1);
+        pair[Rtp].descriptor = openSocket(peer, pair[Rtp].port, RTP_SOCKET_BUFFER_SIZE, errorString);
+        if (pair[Rtp].descriptor >= 0) {
+            pair[Rtcp].descriptor = openSocket(peer, pair[Rtcp].port, 0, errorString);
+        }
+        if (pair[Rtcp].descriptor >= 0) {
+            return true;
+        }
+
+        // Taken by another program, try the next pair
+        LOG_DEBUG(QString("UDP relay ports %1-%2 unavailable: %3")
+                  .arg(pair[Rtp].port).arg(pair[Rtcp].port).arg(*errorString), "PortForwarder");
+        closePair(pair);
+    }
+    return false;
+}
+
+void UdpRelay::closePair(Socket* pair)
+{
+    for (int channel = Rtp; channel <= Rtcp; ++channel) {
+        delete pair[channel].notifier;
+        pair[channel].notifier = nullptr;
+        closeSocket(pair[channel].descriptor);
+        pair[channel].descriptor = -1;
+    }
+
+    if (pair[Rtp].port != 0 && m_ports) {
+        m_ports->releasePair(pair[Rtp].port);
+    }
+    pair[Rtp].port = 0;
+    pair[Rtcp].port = 0;
+}
+
+void UdpRelay::pump(Channel channel, bool clientToTarget)
+{
+    if (!m_active) {
+        return;
+    }
+
+    const Socket& from = clientToTarget ? m_clientSide[channel] : m_cameraSide[channel];
+    const Socket& to = clientToTarget ? m_cameraSide[channel] : m_clientSide[channel];
+    Endpoint& sender = clientToTarget ? m_client[channel] : m_camera[channel];
+    const Endpoint& receiver = clientToTarget ? m_camera[channel] : m_client[channel];
+
+    sockaddr_storage expected;
+    sockaddr_storage target;
+    socklen_t expectedLength = 0;
+    socklen_t targetLength = 0;
+    toNative(sender.address, sender.port, &expected, &expectedLength);
+    toNative(receiver.address, receiver.port, &target, &targetLength);
+
+    RelayBufferPool::Buffer buffer(m_buffers);
+    const int slots = qMin(MAX_BATCH, static_cast<int>(buffer.size() / DATAGRAM_SLOT_SIZE));
+    Datagram datagrams[MAX_BATCH];
+    qint64 bytes = 0;
+    int packets = 0;
+
+    // Bounded, the notifier fires again if a flood left datagrams queued
+    for (int batch = 0; batch < MAX_BATCHES_PER_WAKEUP; ++batch) {
+        const int received = receiveBatch(from.descriptor, buffer.data(), DATAGRAM_SLOT_SIZE, datagrams, slots);
+        if (received <= 0) {
+            break;
+        }
+
+        int accepted = 0;
+        for (int i = 0; i < received; ++i) {
+            const Datagram& datagram = datagrams[i];
+            if (datagram.truncated || !sameHost(datagram.source, expected)) {
+                ++m_droppedPackets;
+                continue;
+            }
+
+            // Follow the viewer's real source port, NAT may have changed it
+            const quint16 sourcePort = portOf(datagram.source);
+            if (clientToTarget && sourcePort != sender.port) {
+                LOG_DEBUG(QString("UDP relay %1: viewer %2 port %3 -> %4")
+                          .arg(m_clientSide[Rtp].port).arg(channel == Rtp ? "RTP" : "RTCP")
+                          .arg(sender.port).arg(sourcePort), "PortForwarder");
+                sender.port = sourcePort;
+            }
+
+            if (accepted != i) {
+                datagrams[accepted] = datagram;
+            }
+            ++accepted;
+        }
+
+        const bool usedGso = m_useGso;
+        const int sent = sendBatch(to.descriptor, target, targetLength, datagrams, accepted, &m_useGso);
+        if (usedGso && !m_useGso) {
+            LOG_DEBUG(QString("UDP GSO unavailable, relay %1 sends datagrams one by one")
+                      .arg(m_clientSide[Rtp].port), "PortForwarder");
+        }
+
+        m_droppedPackets += accepted - sent;
+        for (int i = 0; i < sent; ++i) {
+            bytes += datagrams[i].size;
+        }
+        packets += sent;
+
+        if (received < slots) {
+            break;
+        }
+    }
+
+    if (packets > 0) {
+        m_traffic->record(clientToTarget, bytes, packets);
+        emit bytesRelayed(bytes, packets, clientToTarget);
+    }
+}
+
+QByteArray UdpRelay::headerValue(const QByteArray& headers, const QByteArray& name)
+{
+    int lineStart = headers.indexOf('\n') + 1; // Skip the start line
+    while (lineStart > 0 && lineStart < headers.size()) {
+        int lineEnd = headers.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = headers.size();
+        }
+
+        const int colon = headers.indexOf(':', lineStart);
+        if (colon > lineStart && colon < lineEnd &&
+            headers.mid(lineStart, colon - lineStart).trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+            return headers.mid(colon + 1, lineEnd - colon - 1).trimmed();
+        }
+        lineStart = lineEnd + 1;
+    }
+    return QByteArray();
+}
+
+QByteArray UdpRelay::replaceHeaderValue(const QByteArray& headers, const QByteArray& name, const QByteArray& value)
+{
+    int lineStart = headers.indexOf('\n') + 1;
+    while (lineStart > 0 && lineStart < headers.size()) {
+        int lineEnd = headers.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = headers.size();
+        }
+
+        const int colon = headers.indexOf(':', lineStart);
+        if (colon > lineStart && colon < lineEnd &&
+            headers.mid(lineStart, colon - lineStart).trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+            const int valueEnd = (lineEnd > 0 && headers.at(lineEnd - 1) == '\r') ? lineEnd - 1 : lineEnd;
+            QByteArray result = headers.left(colon + 1);
+            result += ' ';
+            result += value;
+            result += headers.mid(valueEnd);
+            return result;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return headers;
+}
+
+QByteArray UdpRelay::firstTransport(const QByteArray& transport)
+{
+    const int comma = transport.indexOf(',');
+    return (comma < 0 ? transport : transport.left(comma)).trimmed();
+}
+
+QByteArray UdpRelay::replaceFirstTransport(const QByteArray& transport, const QByteArray& spec)
+{
+    const int comma = transport.indexOf(',');
+    return comma < 0 ? spec : spec + transport.mid(comma);
+}
+
+bool UdpRelay::isUdpUnicast(const QByteArray& transport)
+{
+    const QList<QByteArray> parameters = transportParameters(transport);
+    const QByteArray protocol = parameters.value(0).toUpper();
+    if (!protocol.startsWith("RTP/") || protocol.endsWith("/TCP")) {
+        return false;
+    }
+
+    for (const QByteArray& parameter : parameters) {
+        if (parameter.compare("multicast", Qt::CaseInsensitive) == 0 ||
+            parameter.toLower().startsWith("interleaved")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray UdpRelay::transportParameter(const QByteArray& transport, const QByteArray& name)
+{
+    const QList<QByteArray> parameters = transportParameters(transport);
+    for (int i = 1; i < parameters.size(); ++i) {
+        const int equals = parameters.at(i).indexOf('=');
+        const QByteArray key = equals < 0 ? parameters.at(i) : parameters.at(i).left(equals);
+        if (key.trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+            return equals < 0 ? QByteArray("") : parameters.at(i).mid(equals + 1).trimmed();
+        }
+    }
+    return QByteArray();
+}
+
+QByteArray UdpRelay::setTransportParameter(const QByteArray& transport, const QByteArray& name, const QByteArray& value)
+{
+    QList<QByteArray> parameters = transportParameters(transport);
+    bool replaced = false;
+    for (int i = parameters.size() - 1; i >= 1; --i) {
+        const int equals = parameters.at(i).indexOf('=');
+        const QByteArray key = equals < 0 ? parameters.at(i) : parameters.at(i).left(equals);
+        if (key.trimmed().compare(name, Qt::CaseInsensitive) != 0) {
+            continue;
+        }
+        // A null value removes the parameter
+        if (value.isNull() || replaced) {
+            parameters.removeAt(i);
+        } else {
+            parameters[i] = name + '=' + value;
+            replaced = true;
+        }
+    }
+
+    if (!replaced && !value.isNull()) {
+        parameters.append(name + '=' + value);
+    }
+    return parameters.join(';');
+}
+
+bool UdpRelay::parsePortPair(const QByteArray& value, quint16* rtpPort, quint16* rtcpPort)
+{
+    const int dash = value.indexOf('-');
+    bool ok = false;
+    const uint rtp = (dash < 0 ? value : value.left(dash)).trimmed().toUInt(&ok);
+    if (!ok || rtp == 0 || rtp > 65535) {
+        return false;
+    }
+
+    uint rtcp = rtp + 1;
+    if (dash >= 0) {
+        rtcp = value.mid(dash + 1).trimmed().toUInt(&ok);
+        if (!ok || rtcp == 0 || rtcp > 65535) {
+            return false;
+        }
+    }
+
+    *rtpPort = static_cast<quint16>(rtp);
+    *rtcpPort = static_cast<quint16>(rtcp);
+    return true;
+}
+
+QByteArray UdpRelay::portPair(quint16 rtpPort)
+{
+    return QByteArray::number(rtpPort) + '-' + QByteArray::number(rtpPort + 1);
+}
@@ -87,6 +87,12 @@ int main(int argc, char *argv[])
     Logger::instance().setLogFile(appDataPath + "/visco-connect.log");
     Logger::instance().setLogLevel(LogLevel::Info);
     
+    // Write log lines from a background thread, flushed on the way out
+    Logger::instance().startAsync();
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+        Logger::instance().stopAsync();
+    });
+    
     LOG_INFO("=== Visco Connect v2.1.5 Starting ===", "Main");
     LOG_INFO(QString("Version: %1").arg(app.applicationVersion()), "Main");
     LOG_INFO(QString("Run as service: %1").arg(runAsService ? "Yes" : "No"), "Main");
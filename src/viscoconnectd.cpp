@@ -0,0 +1,196 @@
+// viscoconnectd: the Visco Connect camera relay without a user interface.
+//
+// Runs the same forwarding core as the desktop application (cameras, port
+// forwarding, echo server, network monitoring) from the same config.json,
+// linked against Qt Core and Network only. Cameras are managed by editing
+// the configuration file; the daemon stops cleanly on SIGINT or SIGTERM
+// (Ctrl+C or console close on Windows).
+//
+// Usage: viscoconnectd [--config file] [--log-level debug|info|warning|error] [--stderr]
+
+#include "CameraManager.h"
+#include "ConfigManager.h"
+#include "EchoServer.h"
+#include "Logger.h"
+#include "NetworkInterfaceManager.h"
+#include "UdpEchoServer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_WIN
+BOOL WINAPI handleConsoleEvent(DWORD event)
+{
+    Q_UNUSED(event)
+    // Runs on a thread of its own; a queued call is safe from there
+    QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+    return TRUE;
+}
+
+void installQuitHandlers(QCoreApplication* app)
+{
+    Q_UNUSED(app)
+    SetConsoleCtrlHandler(handleConsoleEvent, TRUE);
+}
+#else
+int s_signalSockets[2] = { -1, -1 };
+
+void handleQuitSignal(int signal)
+{
+    // Only async-signal-safe calls here; the event loop picks the byte up
+    const char byte = static_cast<char>(signal);
+    const ssize_t written = ::write(s_signalSockets[0], &byte, 1);
+    Q_UNUSED(written)
+}
+
+void installQuitHandlers(QCoreApplication* app)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalSockets) != 0) {
+        LOG_WARNING("Could not create the signal socket pair, SIGTERM will not stop the daemon cleanly", "Daemon");
+        return;
+    }
+
+    QSocketNotifier* notifier = new QSocketNotifier(s_signalSockets[1], QSocketNotifier::Read, app);
+    QObject::connect(notifier, &QSocketNotifier::activated, app, [app]() {
+        char signal = 0;
+        if (::read(s_signalSockets[1], &signal, 1) == 1) {
+            LOG_INFO(QString("Received signal %1, shutting down").arg(int(signal)), "Daemon");
+        }
+        app->quit();
+    });
+
+    std::signal(SIGINT, handleQuitSignal);
+    std::signal(SIGTERM, handleQuitSignal);
+    std::signal(SIGHUP, handleQuitSignal);
+}
+#endif
+
+bool parseLevel(const QString& name, LogLevel* level)
+{
+    const QString lower = name.toLower();
+    if (lower == "debug") {
+        *level = LogLevel::Debug;
+    } else if (lower == "info") {
+        *level = LogLevel::Info;
+    } else if (lower == "warning" || lower == "warn") {
+        *level = LogLevel::Warning;
+    } else if (lower == "error") {
+        *level = LogLevel::Error;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Same names as the desktop application, so the same config.json and
+    // log directory are found
+    app.setApplicationName("ViscoConnect");
+    app.setApplicationVersion("2.1.5");
+    app.setOrganizationName("Visco Connect Team");
+    app.setOrganizationDomain("viscoconnect.local");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Visco Connect camera relay daemon");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption configOption("config", "Configuration file to use instead of the default config.json.", "file");
+    QCommandLineOption levelOption("log-level", "Lowest level written to the log: debug, info, warning or error.",
+                                   "level", "info");
+    QCommandLineOption stderrOption("stderr", "Also write log lines to standard error, for journald and the like.");
+    parser.addOption(configOption);
+    parser.addOption(levelOption);
+    parser.addOption(stderrOption);
+    parser.process(app);
+
+    LogLevel level = LogLevel::Info;
+    if (!parseLevel(parser.value(levelOption), &level)) {
+        QTextStream(stderr) << "Unknown log level: " << parser.value(levelOption) << Qt::endl;
+        return 2;
+    }
+
+    ConfigManager& config = ConfigManager::instance();
+    if (parser.isSet(configOption)) {
+        config.setConfigFilePath(QFileInfo(parser.value(configOption)).absoluteFilePath());
+    }
+
+    // Initialize logger
+    QDir().mkpath(QFileInfo(config.getLogFilePath()).absolutePath());
+    Logger::instance().setLogFile(config.getLogFilePath());
+    Logger::instance().setLogLevel(level);
+    if (parser.isSet(stderrOption)) {
+        QObject::connect(&Logger::instance(), &Logger::logMessage, &app, [](const QString& line) {
+            QTextStream(stderr) << line << Qt::endl;
+        });
+    }
+    Logger::instance().startAsync();
+
+    LOG_INFO("=== Visco Connect daemon v2.1.5 Starting ===", "Daemon");
+    LOG_INFO(QString("Configuration: %1").arg(config.getConfigFilePath()), "Daemon");
+
+    if (!config.loadConfig()) {
+        LOG_ERROR("Failed to load configuration", "Daemon");
+        Logger::instance().stopAsync();
+        return 1;
+    }
+
+    installQuitHandlers(&app);
+
+    // Forwarding core, wired up as MainWindow does it
+    NetworkInterfaceManager networkManager;
+    CameraManager cameraManager;
+    EchoServer echoServer;
+    UdpEchoServer udpEchoServer;
+
+    cameraManager.initialize();
+    cameraManager.getPortForwarder()->setNetworkInterfaceManager(&networkManager);
+    networkManager.startMonitoring();
+
+    if (config.isEchoServerEnabled()) {
+        echoServer.setMode(EchoServer::modeFromString(config.getEchoServerMode()));
+        echoServer.setMaxConnections(config.getEchoServerMaxConnections());
+        if (echoServer.startServer(config.getEchoServerPort())) {
+            LOG_INFO(QString("Echo server started on port %1").arg(echoServer.serverPort()), "Daemon");
+        } else {
+            LOG_WARNING("Failed to start echo server", "Daemon");
+        }
+    }
+    if (config.isUdpEchoServerEnabled()) {
+        if (udpEchoServer.startServer(config.getUdpEchoServerPort())) {
+            LOG_INFO(QString("UDP echo server started on port %1").arg(udpEchoServer.serverPort()), "Daemon");
+        } else {
+            LOG_WARNING("Failed to start UDP echo server", "Daemon");
+        }
+    }
+
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, [&]() {
+        LOG_INFO("=== Visco Connect daemon Shutting Down ===", "Daemon");
+        echoServer.stopServer();
+        udpEchoServer.stopServer();
+        networkManager.stopMonitoring();
+        cameraManager.shutdown();
+        Logger::instance().stopAsync();
+    });
+
+    LOG_INFO(QString("Relaying %1 cameras").arg(cameraManager.getRunningCameras().size()), "Daemon");
+    return app.exec();
+}
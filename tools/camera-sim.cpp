@@ -0,0 +1,711 @@
+// camera-sim: impersonates RTSP cameras for load tests without hardware.
+//
+// Every simulated camera answers OPTIONS, DESCRIBE, SETUP, PLAY,
+// GET_PARAMETER and TEARDOWN the way the common IP cameras do and, once
+// playing, streams H.264 shaped RTP over the RTSP connection (interleaved,
+// RTP/AVP/TCP): SPS and PPS before every IDR frame, FU-A fragments, a large
+// IDR frame every --gop frames and an RTCP sender report every 5 seconds.
+// Payload bytes are filler, so players connect but show no picture.
+//
+// Cameras listen on --address with consecutive ports from --port, or with
+// --spread on consecutive addresses from --address, all on --port. On Linux
+// the whole of 127.0.0.0/8 is loopback, so --address 127.0.1.1 --spread
+// needs no setup; other ranges need the addresses added to an interface.
+// With --http-port each camera also serves a web page carrying the
+// Hikvision, CP Plus or generic fingerprints that camera discovery matches.
+//
+// Usage: camera-sim [--cameras n] [--address ip] [--port port] [--spread]
+//            [--http-port port] [--brand hikvision|cpplus|generic|mixed]
+//            [--bitrate kbit/s] [--fps n] [--gop frames] [--packet bytes]
+//            [--jitter ms] [--threads n] [--seed n] [--duration s]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <chrono>
+
+namespace {
+
+enum class Brand { Hikvision, CPPlus, Generic };
+
+struct Options {
+    int cameras = 16;
+    QHostAddress address = QHostAddress(QHostAddress::LocalHost);
+    int port = 8554;
+    bool spread = false;
+    int httpPort = 0;            // 0 disables the web pages
+    QString brand = "mixed";
+    int bitrateKbps = 2048;
+    int fps = 25;
+    int gop = 50;
+    int packetBytes = 1400;      // RTP header and payload
+    int jitterMs = 0;
+    int threads = 2;
+    quint32 seed = 1;
+};
+
+const int RTP_HEADER_BYTES = 12;
+const int RTP_PAYLOAD_TYPE = 96;
+const int RTP_CLOCK_RATE = 90000;
+const int IDR_WEIGHT = 8;                     // IDR frame size relative to a P frame
+const qint64 MAX_QUEUED_BYTES = 4 * 1024 * 1024;  // Frames are dropped beyond this, as an encoder would
+const qint64 SENDER_REPORT_INTERVAL_NS = 5000000000LL;
+const int SESSION_TIMEOUT_SECONDS = 60;
+const int MAX_REQUEST_BYTES = 64 * 1024;
+const quint64 NTP_UNIX_OFFSET = 2208988800ULL;
+
+// 1080p High profile parameter sets, also announced in the SDP
+const char SPROP_PARAMETER_SETS[] = "Z2QAKKwbGoB4AiflwFuAgICgAAB9AAAOpgCA,aO44gA==";
+
+const char* const HIKVISION_MODELS[] = { "DS-2CD2143G2-I", "DS-2CD1023G0E-I", "DS-2DE4425IW-DE" };
+const char* const CPPLUS_MODELS[] = { "CP-UNC-TA21PL3", "CP-UNC-DA41ZL4C", "CP-VNC-T21R3" };
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Brand brandOf(const QString& name, int index)
+{
+    if (name == "hikvision") {
+        return Brand::Hikvision;
+    }
+    if (name == "cpplus") {
+        return Brand::CPPlus;
+    }
+    if (name == "generic") {
+        return Brand::Generic;
+    }
+    return static_cast<Brand>(index % 3);
+}
+
+QString streamPath(Brand brand)
+{
+    switch (brand) {
+    case Brand::Hikvision:
+        return "/Streaming/Channels/101";
+    case Brand::CPPlus:
+        return "/cam/realmonitor?channel=1&subtype=0";
+    case Brand::Generic:
+        break;
+    }
+    return "/stream1";
+}
+
+QString modelOf(Brand brand, int index)
+{
+    switch (brand) {
+    case Brand::Hikvision:
+        return HIKVISION_MODELS[index % 3];
+    case Brand::CPPlus:
+        return CPPLUS_MODELS[index % 3];
+    case Brand::Generic:
+        break;
+    }
+    return "SIM-1000";
+}
+
+void appendBigEndian(QByteArray& out, quint64 value, int bytes)
+{
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.append(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+struct Camera {
+    int index = 0;
+    Brand brand = Brand::Generic;
+    QString model;
+    QHostAddress address;
+    quint16 rtspPort = 0;
+    quint16 httpPort = 0;
+};
+
+struct Session {
+    QTcpSocket* socket = nullptr;
+    const Camera* camera = nullptr;
+    QByteArray input;
+    QString id;
+    int channel = 0;             // Interleaved RTP channel, RTCP on channel + 1
+    bool playing = false;
+    quint32 ssrc = 0;
+    quint16 sequence = 0;
+    quint32 timestampBase = 0;
+    qint64 frame = 0;
+    qint64 nominalNs = 0;        // Frame time without jitter
+    qint64 dueNs = 0;
+    qint64 lastReportNs = 0;
+    quint32 packets = 0;
+    quint32 octets = 0;
+};
+
+// Cameras served by one thread, paced by one timer
+class CameraGroup : public QObject
+{
+public:
+    CameraGroup(const Options& options, quint32 seed)
+        : m_options(options)
+        , m_random(seed)
+        , m_frameIntervalNs(1000000000LL / options.fps)
+        , m_filler(65536, '\x5a')
+    {
+        // Per-frame sizes that average out to the bitrate over a GOP
+        const double bytesPerGop = options.bitrateKbps * 1000.0 / 8.0 * options.gop / options.fps;
+        m_pFrameBytes = qMax(1, static_cast<int>(bytesPerGop / (options.gop - 1 + IDR_WEIGHT)));
+        m_idrFrameBytes = m_pFrameBytes * IDR_WEIGHT;
+        const QList<QByteArray> sets = QByteArray(SPROP_PARAMETER_SETS).split(',');
+        m_sps = QByteArray::fromBase64(sets.at(0));
+        m_pps = QByteArray::fromBase64(sets.at(1));
+    }
+
+    std::atomic<quint64> bytesSent{0};
+    std::atomic<int> sessions{0};
+    std::atomic<quint64> framesDropped{0};
+
+    // Runs on the group thread; returns an error, empty on success
+    QString start(const QList<Camera>& cameras)
+    {
+        m_cameras = cameras;
+        for (int i = 0; i < m_cameras.size(); ++i) {
+            const Camera* camera = &m_cameras.at(i);
+            QTcpServer* rtsp = new QTcpServer(this);
+            if (!rtsp->listen(camera->address, camera->rtspPort)) {
+                return QString("%1:%2: %3").arg(camera->address.toString()).arg(camera->rtspPort).arg(rtsp->errorString());
+            }
+            connect(rtsp, &QTcpServer::newConnection, this, [this, rtsp, camera]() {
+                while (QTcpSocket* socket = rtsp->nextPendingConnection()) {
+                    acceptRtsp(socket, camera);
+                }
+            });
+
+            if (camera->httpPort != 0) {
+                QTcpServer* http = new QTcpServer(this);
+                if (!http->listen(camera->address, camera->httpPort)) {
+                    return QString("%1:%2: %3").arg(camera->address.toString()).arg(camera->httpPort).arg(http->errorString());
+                }
+                connect(http, &QTcpServer::newConnection, this, [this, http, camera]() {
+                    while (QTcpSocket* socket = http->nextPendingConnection()) {
+                        acceptHttp(socket, camera);
+                    }
+                });
+            }
+        }
+
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(1);
+        connect(m_timer, &QTimer::timeout, this, &CameraGroup::pace);
+        m_timer->start();
+        return QString();
+    }
+
+    void stop()
+    {
+        if (m_timer) {
+            m_timer->stop();
+        }
+        for (Session* session : m_sessions) {
+            QObject::disconnect(session->socket, nullptr, this, nullptr);
+            session->socket->abort();
+            delete session;
+        }
+        m_sessions.clear();
+    }
+
+private:
+    void acceptRtsp(QTcpSocket* socket, const Camera* camera)
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        Session* session = new Session;
+        session->socket = socket;
+        session->camera = camera;
+        session->ssrc = m_random.generate();
+        session->sequence = static_cast<quint16>(m_random.generate());
+        session->timestampBase = m_random.generate();
+        m_sessions.append(session);
+        sessions.fetch_add(1, std::memory_order_relaxed);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, session]() { readRtsp(session); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, session]() {
+            // May be emitted from inside a handler still using the session
+            m_sessions.removeOne(session);
+            sessions.fetch_sub(1, std::memory_order_relaxed);
+            session->socket->deleteLater();
+            QMetaObject::invokeMethod(this, [session]() { delete session; }, Qt::QueuedConnection);
+        });
+    }
+
+    void readRtsp(Session* session)
+    {
+        session->input.append(session->socket->readAll());
+        while (!session->input.isEmpty()) {
+            // RTCP receiver reports from the client arrive interleaved too
+            if (session->input.at(0) == '$') {
+                if (session->input.size() < 4) {
+                    return;
+                }
+                const int length = (static_cast<quint8>(session->input.at(2)) << 8) | static_cast<quint8>(session->input.at(3));
+                if (session->input.size() < 4 + length) {
+                    return;
+                }
+                session->input.remove(0, 4 + length);
+                continue;
+            }
+
+            const int headerEnd = session->input.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                if (session->input.size() > MAX_REQUEST_BYTES) {
+                    session->socket->abort();
+                }
+                return;
+            }
+            const QString headers = QString::fromLatin1(session->input.left(headerEnd));
+            static const QRegularExpression contentLengthRegex("^content-length:\\s*(\\d+)",
+                QRegularExpression::CaseInsensitiveOption | QRegularExpression::MultilineOption);
+            const QRegularExpressionMatch contentLength = contentLengthRegex.match(headers);
+            const int bodyBytes = contentLength.hasMatch() ? contentLength.captured(1).toInt() : 0;
+            if (session->input.size() < headerEnd + 4 + bodyBytes) {
+                return;
+            }
+            session->input.remove(0, headerEnd + 4 + bodyBytes);
+            handleRequest(session, headers);
+            if (session->socket->state() != QAbstractSocket::ConnectedState) {
+                return;
+            }
+        }
+    }
+
+    void handleRequest(Session* session, const QString& headers)
+    {
+        const QStringList lines = headers.split("\r\n");
+        const QStringList requestLine = lines.first().split(' ');
+        const QString method = requestLine.value(0);
+        const QString url = requestLine.value(1);
+
+        static const QRegularExpression cseqRegex("^cseq:\\s*(\\S+)",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::MultilineOption);
+        static const QRegularExpression transportRegex("^transport:\\s*(.*)$",
+            QRegularExpression::CaseInsensitiveOption | QRegularExpression::MultilineOption);
+        const QString cseq = cseqRegex.match(headers).captured(1);
+
+        if (method == "OPTIONS") {
+            reply(session, cseq, "200 OK",
+                  "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, GET_PARAMETER, TEARDOWN\r\n");
+        } else if (method == "DESCRIBE") {
+            const QByteArray sdp = describe(session->camera);
+            const QString base = url.endsWith('/') ? url : url + '/';
+            reply(session, cseq, "200 OK",
+                  QString("Content-Base: %1\r\nContent-Type: application/sdp\r\n").arg(base), sdp);
+        } else if (method == "SETUP") {
+            const QString transport = transportRegex.match(headers).captured(1).trimmed();
+            if (!transport.contains("RTP/AVP/TCP", Qt::CaseInsensitive)) {
+                // UDP media is not simulated; clients fall back to TCP
+                reply(session, cseq, "461 Unsupported Transport");
+                return;
+            }
+            static const QRegularExpression interleavedRegex("interleaved=(\\d+)");
+            const QRegularExpressionMatch interleaved = interleavedRegex.match(transport);
+            session->channel = interleaved.hasMatch() ? interleaved.captured(1).toInt() : 0;
+            if (session->id.isEmpty()) {
+                session->id = QString::number(m_random.generate() & 0x7FFFFFFF);
+            }
+            reply(session, cseq, "200 OK",
+                  QString("Transport: RTP/AVP/TCP;unicast;interleaved=%1-%2;ssrc=%3;mode=\"play\"\r\n"
+                          "Session: %4;timeout=%5\r\n")
+                      .arg(session->channel).arg(session->channel + 1)
+                      .arg(session->ssrc, 8, 16, QChar('0')).arg(session->id).arg(SESSION_TIMEOUT_SECONDS));
+        } else if (method == "PLAY") {
+            reply(session, cseq, "200 OK",
+                  QString("Session: %1\r\nRange: npt=0.000-\r\nRTP-Info: url=%2;seq=%3;rtptime=%4\r\n")
+                      .arg(session->id).arg(url).arg(session->sequence)
+                      .arg(session->timestampBase + rtpTimestamp(session->frame)));
+            if (!session->playing) {
+                session->playing = true;
+                session->nominalNs = nowNs();
+                session->dueNs = session->nominalNs;
+                session->lastReportNs = session->nominalNs;
+            }
+        } else if (method == "PAUSE") {
+            session->playing = false;
+            reply(session, cseq, "200 OK", QString("Session: %1\r\n").arg(session->id));
+        } else if (method == "GET_PARAMETER" || method == "SET_PARAMETER") {
+            reply(session, cseq, "200 OK", QString("Session: %1\r\n").arg(session->id));
+        } else if (method == "TEARDOWN") {
+            session->playing = false;
+            reply(session, cseq, "200 OK", QString("Session: %1\r\n").arg(session->id));
+            session->socket->disconnectFromHost();
+        } else {
+            reply(session, cseq, "501 Not Implemented");
+        }
+    }
+
+    void reply(Session* session, const QString& cseq, const QString& status,
+               const QString& headers = QString(), const QByteArray& body = QByteArray())
+    {
+        QString response = QString("RTSP/1.0 %1\r\nCSeq: %2\r\n").arg(status, cseq);
+        response += headers;
+        response += QString("Date: %1\r\n").arg(QDateTime::currentDateTimeUtc().toString("ddd, dd MMM yyyy HH:mm:ss 'GMT'"));
+        if (!body.isEmpty()) {
+            response += QString("Content-Length: %1\r\n").arg(body.size());
+        }
+        response += "\r\n";
+        session->socket->write(response.toLatin1() + body);
+    }
+
+    QByteArray describe(const Camera* camera) const
+    {
+        QString name;
+        switch (camera->brand) {
+        case Brand::Hikvision:
+            name = "Media Presentation";
+            break;
+        case Brand::CPPlus:
+            name = "Media Server";
+            break;
+        case Brand::Generic:
+            name = "Session streamed by camera-sim";
+            break;
+        }
+        return QString("v=0\r\n"
+                       "o=- %1 1 IN IP4 %2\r\n"
+                       "s=%3\r\n"
+                       "c=IN IP4 0.0.0.0\r\n"
+                       "t=0 0\r\n"
+                       "a=control:*\r\n"
+                       "a=range:npt=0-\r\n"
+                       "m=video 0 RTP/AVP %4\r\n"
+                       "b=AS:%5\r\n"
+                       "a=rtpmap:%4 H264/%6\r\n"
+                       "a=fmtp:%4 packetization-mode=1;profile-level-id=640028;sprop-parameter-sets=%7\r\n"
+                       "a=framerate:%8\r\n"
+                       "a=control:trackID=1\r\n")
+            .arg(QDateTime::currentSecsSinceEpoch()).arg(camera->address.toString(), name)
+            .arg(RTP_PAYLOAD_TYPE).arg(m_options.bitrateKbps).arg(RTP_CLOCK_RATE)
+            .arg(QString::fromLatin1(SPROP_PARAMETER_SETS)).arg(m_options.fps)
+            .toLatin1();
+    }
+
+    void acceptHttp(QTcpSocket* socket, const Camera* camera)
+    {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, camera]() {
+            if (!socket->peek(MAX_REQUEST_BYTES).contains("\r\n\r\n")) {
+                return;
+            }
+            const bool head = socket->readAll().startsWith("HEAD ");
+            const QByteArray body = webPage(camera);
+            QByteArray response = "HTTP/1.1 200 OK\r\n";
+            switch (camera->brand) {
+            case Brand::Hikvision:
+                response += "Server: App-webs/\r\n";
+                break;
+            case Brand::CPPlus:
+                response += "Server: Webs\r\n";
+                break;
+            case Brand::Generic:
+                response += "Server: camera-sim\r\n";
+                break;
+            }
+            response += "Content-Type: text/html\r\nConnection: close\r\n";
+            response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+            if (!head) {
+                response += body;
+            }
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+
+    // Pages with the strings CameraDiscovery::detectBrand and detectModel look for
+    static QByteArray webPage(const Camera* camera)
+    {
+        switch (camera->brand) {
+        case Brand::Hikvision:
+            return QString("<!DOCTYPE html>\n<html><head><title>%1</title>\n"
+                           "<script>var deviceType = \"hikvision\"; location.href = \"doc/page/login.asp\";</script>\n"
+                           "</head><body><a href=\"webrec.htm\">%1</a></body></html>\n")
+                .arg(camera->model).toLatin1();
+        case Brand::CPPlus:
+            return QString("<!DOCTYPE html>\n<html><head><title>CP PLUS %1</title></head>\n"
+                           "<body><div id=\"product\">CP PLUS %1</div>\n"
+                           "<script>var rtspPath = \"/cam/realmonitor\";</script></body></html>\n")
+                .arg(camera->model).toLatin1();
+        case Brand::Generic:
+            break;
+        }
+        return QString("<!DOCTYPE html>\n<html><head><title>Network Camera %1</title>\n"
+                       "<script>var model = \"%2\";</script></head><body>Network Camera</body></html>\n")
+            .arg(camera->index + 1).arg(camera->model).toLatin1();
+    }
+
+    quint32 rtpTimestamp(qint64 frame) const
+    {
+        return static_cast<quint32>(frame * RTP_CLOCK_RATE / m_options.fps);
+    }
+
+    void pace()
+    {
+        const qint64 now = nowNs();
+        const QList<Session*> current = m_sessions;
+        for (Session* session : current) {
+            // At most a few frames per tick, so a stalled loop does not burst
+            for (int sent = 0; session->playing && session->dueNs <= now && sent < 4; ++sent) {
+                sendFrame(session);
+                session->nominalNs += m_frameIntervalNs;
+                const qint64 jitterNs = m_options.jitterMs > 0
+                    ? static_cast<qint64>(m_random.bounded(m_options.jitterMs * 1000)) * 1000 : 0;
+                session->dueNs = session->nominalNs + jitterNs;
+            }
+            if (session->playing && now - session->lastReportNs >= SENDER_REPORT_INTERVAL_NS) {
+                sendSenderReport(session);
+                session->lastReportNs = now;
+            }
+        }
+    }
+
+    void sendFrame(Session* session)
+    {
+        const bool idr = session->frame % m_options.gop == 0;
+        const quint32 timestamp = session->timestampBase + rtpTimestamp(session->frame);
+        ++session->frame;
+
+        if (session->socket->bytesToWrite() > MAX_QUEUED_BYTES) {
+            framesDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        QByteArray out;
+        const int frameBytes = idr ? m_idrFrameBytes : m_pFrameBytes;
+        out.reserve(frameBytes + (frameBytes / (m_options.packetBytes - RTP_HEADER_BYTES) + 4) * 18 + 64);
+        if (idr) {
+            appendPacket(session, out, timestamp, false, m_sps.constData(), m_sps.size(), nullptr, 0);
+            appendPacket(session, out, timestamp, false, m_pps.constData(), m_pps.size(), nullptr, 0);
+        }
+
+        const quint8 nri = idr ? 0x60 : 0x40;
+        const quint8 type = idr ? 5 : 1;
+        const int maxPayload = m_options.packetBytes - RTP_HEADER_BYTES;
+        if (frameBytes + 1 <= maxPayload) {
+            const char nal = static_cast<char>(nri | type);
+            appendPacket(session, out, timestamp, true, &nal, 1, m_filler.constData(), frameBytes);
+        } else {
+            // FU-A fragments
+            int offset = 0;
+            while (offset < frameBytes) {
+                const int take = qMin(maxPayload - 2, frameBytes - offset);
+                const bool first = offset == 0;
+                const bool last = offset + take == frameBytes;
+                const char fu[2] = { static_cast<char>(nri | 28),
+                                     static_cast<char>((first ? 0x80 : 0) | (last ? 0x40 : 0) | type) };
+                appendPacket(session, out, timestamp, last, fu, 2, m_filler.constData(), take);
+                offset += take;
+            }
+        }
+        session->socket->write(out);
+        bytesSent.fetch_add(static_cast<quint64>(out.size()), std::memory_order_relaxed);
+    }
+
+    void appendPacket(Session* session, QByteArray& out, quint32 timestamp, bool marker,
+                      const char* header, int headerBytes, const char* payload, int payloadBytes)
+    {
+        const int length = RTP_HEADER_BYTES + headerBytes + payloadBytes;
+        out.append('$');
+        out.append(static_cast<char>(session->channel));
+        appendBigEndian(out, static_cast<quint64>(length), 2);
+        out.append(static_cast<char>(0x80));
+        out.append(static_cast<char>((marker ? 0x80 : 0) | RTP_PAYLOAD_TYPE));
+        appendBigEndian(out, session->sequence++, 2);
+        appendBigEndian(out, timestamp, 4);
+        appendBigEndian(out, session->ssrc, 4);
+        out.append(header, headerBytes);
+        if (payloadBytes > 0) {
+            out.append(payload, payloadBytes);
+        }
+        ++session->packets;
+        session->octets += static_cast<quint32>(headerBytes + payloadBytes);
+    }
+
+    void sendSenderReport(Session* session)
+    {
+        const qint64 msecs = QDateTime::currentMSecsSinceEpoch();
+        const quint64 ntpSeconds = static_cast<quint64>(msecs / 1000) + NTP_UNIX_OFFSET;
+        const quint64 ntpFraction = (static_cast<quint64>(msecs % 1000) << 32) / 1000;
+
+        QByteArray out;
+        out.append('$');
+        out.append(static_cast<char>(session->channel + 1));
+        appendBigEndian(out, 28, 2);
+        out.append(static_cast<char>(0x80));
+        out.append(static_cast<char>(200));   // Sender report
+        appendBigEndian(out, 6, 2);           // Length in 32-bit words minus one
+        appendBigEndian(out, session->ssrc, 4);
+        appendBigEndian(out, ntpSeconds, 4);
+        appendBigEndian(out, ntpFraction, 4);
+        appendBigEndian(out, session->timestampBase + rtpTimestamp(session->frame), 4);
+        appendBigEndian(out, session->packets, 4);
+        appendBigEndian(out, session->octets, 4);
+        session->socket->write(out);
+    }
+
+    const Options m_options;
+    QRandomGenerator m_random;
+    const qint64 m_frameIntervalNs;
+    const QByteArray m_filler;
+    int m_pFrameBytes = 0;
+    int m_idrFrameBytes = 0;
+    QByteArray m_sps;
+    QByteArray m_pps;
+    QList<Camera> m_cameras;
+    QList<Session*> m_sessions;
+    QTimer* m_timer = nullptr;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulated RTSP cameras for load testing");
+    parser.addHelpOption();
+    const QCommandLineOption camerasOption("cameras", "Cameras to simulate.", "n", "16");
+    const QCommandLineOption addressOption("address", "Address of the first camera.", "ip", "127.0.0.1");
+    const QCommandLineOption portOption("port", "RTSP port of the first camera.", "port", "8554");
+    const QCommandLineOption spreadOption("spread", "One address per camera, counting up from --address, all on --port.");
+    const QCommandLineOption httpPortOption("http-port", "Web page port of the first camera, 0 for none.", "port", "0");
+    const QCommandLineOption brandOption("brand", "hikvision, cpplus, generic, or mixed to take turns.", "brand", "mixed");
+    const QCommandLineOption bitrateOption("bitrate", "Video bitrate per camera in kbit/s.", "kbit/s", "2048");
+    const QCommandLineOption fpsOption("fps", "Frames per second.", "n", "25");
+    const QCommandLineOption gopOption("gop", "Frames from one IDR frame to the next.", "frames", "50");
+    const QCommandLineOption packetOption("packet", "RTP packet size, header included.", "bytes", "1400");
+    const QCommandLineOption jitterOption("jitter", "Random delay of up to this much per frame.", "ms", "0");
+    const QCommandLineOption threadsOption("threads", "Threads serving the cameras.", "n", "2");
+    const QCommandLineOption seedOption("seed", "Seed for SSRCs, sequence numbers and jitter.", "n", "1");
+    const QCommandLineOption durationOption("duration", "Exit after this many seconds, 0 to run until killed.", "s", "0");
+    parser.addOptions({camerasOption, addressOption, portOption, spreadOption, httpPortOption, brandOption,
+                       bitrateOption, fpsOption, gopOption, packetOption, jitterOption, threadsOption,
+                       seedOption, durationOption});
+    parser.process(app);
+
+    Options options;
+    options.cameras = parser.value(camerasOption).toInt();
+    options.address = QHostAddress(parser.value(addressOption));
+    options.port = parser.value(portOption).toInt();
+    options.spread = parser.isSet(spreadOption);
+    options.httpPort = parser.value(httpPortOption).toInt();
+    options.brand = parser.value(brandOption).toLower();
+    options.bitrateKbps = parser.value(bitrateOption).toInt();
+    options.fps = parser.value(fpsOption).toInt();
+    options.gop = parser.value(gopOption).toInt();
+    options.packetBytes = parser.value(packetOption).toInt();
+    options.jitterMs = parser.value(jitterOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    const int duration = parser.value(durationOption).toInt();
+
+    const int ports = options.spread ? 1 : options.cameras;
+    if (options.cameras < 1 || options.address.protocol() != QAbstractSocket::IPv4Protocol
+        || options.port < 1 || options.port + ports > 65536
+        || options.httpPort < 0 || options.httpPort + ports > 65536
+        || !QStringList({"hikvision", "cpplus", "generic", "mixed"}).contains(options.brand)
+        || options.bitrateKbps < 1 || options.fps < 1 || options.fps > 1000 || options.gop < 1
+        || options.packetBytes < 64 || options.packetBytes > 65535 || options.jitterMs < 0
+        || options.threads < 1) {
+        err << "Invalid options, see --help" << Qt::endl;
+        return 2;
+    }
+
+    QList<QList<Camera>> groups(qMin(options.threads, options.cameras));
+    for (int i = 0; i < options.cameras; ++i) {
+        Camera camera;
+        camera.index = i;
+        camera.brand = brandOf(options.brand, i);
+        camera.model = modelOf(camera.brand, i);
+        camera.address = options.spread ? QHostAddress(options.address.toIPv4Address() + i) : options.address;
+        camera.rtspPort = static_cast<quint16>(options.spread ? options.port : options.port + i);
+        if (options.httpPort != 0) {
+            camera.httpPort = static_cast<quint16>(options.spread ? options.httpPort : options.httpPort + i);
+        }
+        groups[i % groups.size()].append(camera);
+        out << QString("rtsp://%1:%2%3").arg(camera.address.toString()).arg(camera.rtspPort).arg(streamPath(camera.brand));
+        if (camera.httpPort != 0) {
+            out << QString("  http://%1:%2/").arg(camera.address.toString()).arg(camera.httpPort);
+        }
+        out << "  " << camera.model << Qt::endl;
+    }
+
+    QList<QThread*> threads;
+    QList<CameraGroup*> cameraGroups;
+    for (int i = 0; i < groups.size(); ++i) {
+        QThread* thread = new QThread;
+        CameraGroup* group = new CameraGroup(options, options.seed + static_cast<quint32>(i));
+        group->moveToThread(thread);
+        thread->start();
+        threads.append(thread);
+        cameraGroups.append(group);
+
+        QString error;
+        const QList<Camera> cameras = groups.at(i);
+        QMetaObject::invokeMethod(group, [&error, group, cameras]() { error = group->start(cameras); },
+                                  Qt::BlockingQueuedConnection);
+        if (!error.isEmpty()) {
+            err << "Could not listen on " << error << Qt::endl;
+            if (options.spread) {
+                err << "Addresses outside 127.0.0.0/8 must be added to an interface first" << Qt::endl;
+            }
+            return 1;
+        }
+    }
+
+    // One status line every 5 seconds
+    quint64 lastBytes = 0;
+    QElapsedTimer interval;
+    interval.start();
+    QTimer status;
+    status.setInterval(5000);
+    QObject::connect(&status, &QTimer::timeout, &app, [&]() {
+        quint64 bytes = 0;
+        quint64 dropped = 0;
+        int sessions = 0;
+        for (CameraGroup* group : cameraGroups) {
+            bytes += group->bytesSent.load(std::memory_order_relaxed);
+            dropped += group->framesDropped.load(std::memory_order_relaxed);
+            sessions += group->sessions.load(std::memory_order_relaxed);
+        }
+        const double seconds = interval.restart() / 1000.0;
+        err << QString("%1 sessions  %2 Mbit/s  %3 frames dropped")
+                   .arg(sessions).arg((bytes - lastBytes) * 8.0 / seconds / 1e6, 0, 'f', 1).arg(dropped)
+            << Qt::endl;
+        lastBytes = bytes;
+    });
+    status.start();
+    if (duration > 0) {
+        QTimer::singleShot(duration * 1000, &app, &QCoreApplication::quit);
+    }
+
+    const int result = app.exec();
+    for (CameraGroup* group : cameraGroups) {
+        QMetaObject::invokeMethod(group, [group]() { group->stop(); }, Qt::BlockingQueuedConnection);
+    }
+    for (QThread* thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+    qDeleteAll(cameraGroups);
+    qDeleteAll(threads);
+    return result;
+}
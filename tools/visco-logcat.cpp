@@ -0,0 +1,100 @@
+// visco-logcat: prints Visco Connect binary logs as text.
+//
+// Lines come out in the format of visco-connect.log, so the usual grep and
+// diff habits work on them. Files are decoded in the order given; pass the
+// rotated visco-connect.vlog.1 before visco-connect.vlog to read them in
+// time order.
+//
+// Usage: visco-logcat [--level debug|info|warning|error] file.vlog...
+
+#include "BinaryLog.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+namespace {
+
+bool parseLevel(const QString& name, LogLevel* level)
+{
+    const QString lower = name.toLower();
+    if (lower == "debug") {
+        *level = LogLevel::Debug;
+    } else if (lower == "info") {
+        *level = LogLevel::Info;
+    } else if (lower == "warning" || lower == "warn") {
+        *level = LogLevel::Warning;
+    } else if (lower == "error") {
+        *level = LogLevel::Error;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    LogLevel minimumLevel = LogLevel::Debug;
+    QStringList files;
+    for (int i = 1; i < argc; ++i) {
+        const QString argument = QString::fromLocal8Bit(argv[i]);
+        if (argument == "--level" && i + 1 < argc) {
+            if (!parseLevel(QString::fromLocal8Bit(argv[++i]), &minimumLevel)) {
+                err << "Unknown level: " << argv[i] << Qt::endl;
+                return 2;
+            }
+        } else if (argument.startsWith("-")) {
+            files.clear();
+            break;
+        } else {
+            files.append(argument);
+        }
+    }
+
+    if (files.isEmpty()) {
+        err << "Usage: visco-logcat [--level debug|info|warning|error] file.vlog..." << Qt::endl;
+        return 2;
+    }
+
+    int status = 0;
+    for (const QString& path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << path << ": " << file.errorString() << Qt::endl;
+            status = 1;
+            continue;
+        }
+
+        BinaryLogReader reader(&file);
+        if (!reader.readHeader()) {
+            err << path << ": " << reader.errorString() << Qt::endl;
+            status = 1;
+            continue;
+        }
+
+        BinaryLogReader::Line line;
+        while (reader.next(&line)) {
+            if (line.level < minimumLevel) {
+                continue;
+            }
+            out << '[' << QDateTime::fromMSecsSinceEpoch(line.timestampMs).toString("yyyy-MM-dd hh:mm:ss.zzz")
+                << "] [" << Logger::logLevelToString(line.level)
+                << "] [" << line.category << "] " << line.message << '\n';
+        }
+
+        // A record cut short by a crash only ends the file
+        if (!reader.errorString().isEmpty() && !file.atEnd()) {
+            err << path << ": " << reader.errorString() << " at offset " << file.pos() << Qt::endl;
+            status = 1;
+        }
+    }
+
+    out.flush();
+    return status;
+}
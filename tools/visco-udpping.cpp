@@ -0,0 +1,357 @@
+// visco-udpping: round trip and one-way latency, jitter and loss against a
+// UdpEchoServer (udpEchoServerEnabled in config.json).
+//
+// Sends --rate probes per second, each carrying a sequence number and its
+// send time; the server stamps when it received the probe and when it sent
+// the reply. Every --interval seconds it prints, for that interval:
+//
+//   - probes sent and answered, and the loss among probes that were answered
+//     or timed out (no reply within --timeout)
+//   - round trip time min/avg/max, and the average with the time the server
+//     held the probe taken out ("net")
+//   - RFC 3550 interarrival jitter of each direction. It only uses
+//     differences of transit times, so clock offset between the hosts
+//     cancels out and no clock sync is needed
+//   - with --one-way, the average forward and backward delay. These are only
+//     meaningful when both clocks are synchronised (PTP, or NTP to well
+//     under the delays measured)
+//
+// Replies that arrive after their timeout, twice, or behind a later probe
+// are counted as late, duplicate and reordered. A summary follows once
+// --duration is over.
+//
+// Usage: visco-udpping host [--port port] [--rate n/s] [--size bytes]
+//            [--interval s] [--timeout s] [--duration s] [--one-way]
+
+#include "UdpEchoServer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostInfo>
+#include <QNetworkDatagram>
+#include <QSet>
+#include <QTextStream>
+#include <QTimer>
+#include <QUdpSocket>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct Options {
+    QHostAddress address;
+    quint16 port = 7778;
+    int rate = 50;
+    int size = 64;
+    double intervalSeconds = 1.0;
+    double timeoutSeconds = 1.0;
+    double durationSeconds = 10.0;   // 0 runs until killed
+    bool oneWay = false;
+};
+
+// Expired sequence numbers kept to tell late replies from duplicates
+const int EXPIRED_HISTORY = 65536;
+
+struct Stats {
+    quint64 sent = 0;
+    quint64 received = 0;
+    quint64 lost = 0;
+    quint64 late = 0;
+    quint64 duplicates = 0;
+    quint64 reordered = 0;
+    qint64 rttMinNs = std::numeric_limits<qint64>::max();
+    qint64 rttMaxNs = 0;
+    double rttSumNs = 0.0;
+    double holdSumNs = 0.0;
+    double forwardSumNs = 0.0;
+    double backwardSumNs = 0.0;
+
+    void add(const Stats& other)
+    {
+        sent += other.sent;
+        received += other.received;
+        lost += other.lost;
+        late += other.late;
+        duplicates += other.duplicates;
+        reordered += other.reordered;
+        rttMinNs = qMin(rttMinNs, other.rttMinNs);
+        rttMaxNs = qMax(rttMaxNs, other.rttMaxNs);
+        rttSumNs += other.rttSumNs;
+        holdSumNs += other.holdSumNs;
+        forwardSumNs += other.forwardSumNs;
+        backwardSumNs += other.backwardSumNs;
+    }
+};
+
+QString milliseconds(double ns)
+{
+    return QString::number(ns / 1e6, 'f', 3);
+}
+
+class Pinger : public QObject
+{
+public:
+    Pinger(const Options& options, QTextStream& out)
+        : m_options(options)
+        , m_out(out)
+        , m_probe(options.size, '\0')
+    {
+    }
+
+    Stats total;
+
+    void start()
+    {
+        connect(&m_socket, &QUdpSocket::readyRead, this, [this]() { readReplies(); });
+
+        m_sendTimer.setTimerType(Qt::PreciseTimer);
+        m_sendTimer.setInterval(qMax(1, 1000 / m_options.rate));
+        connect(&m_sendTimer, &QTimer::timeout, this, [this]() { sendDue(); });
+
+        m_reportTimer.setInterval(static_cast<int>(m_options.intervalSeconds * 1000));
+        connect(&m_reportTimer, &QTimer::timeout, this, [this]() { report(); });
+
+        m_out << QString("UDPPING %1:%2, %3-byte probes at %4/s")
+                 .arg(m_options.address.toString()).arg(m_options.port).arg(m_options.size).arg(m_options.rate)
+              << Qt::endl;
+        m_clock.start();
+        m_sendTimer.start();
+        m_reportTimer.start();
+        sendDue();
+    }
+
+    void printSummary() const
+    {
+        const Stats& s = total;
+        m_out << QString("--- %1:%2 udpping statistics ---").arg(m_options.address.toString()).arg(m_options.port)
+              << Qt::endl;
+        m_out << QString("%1 probes sent, %2 received, %3% loss, %4 late, %5 duplicate, %6 reordered")
+                 .arg(s.sent).arg(s.received).arg(lossPercent(s), 0, 'f', 2)
+                 .arg(s.late).arg(s.duplicates).arg(s.reordered) << Qt::endl;
+        if (s.received > 0) {
+            m_out << QString("rtt min/avg/max %1/%2/%3 ms, net avg %4 ms")
+                     .arg(milliseconds(s.rttMinNs), milliseconds(s.rttSumNs / s.received),
+                          milliseconds(s.rttMaxNs), milliseconds((s.rttSumNs - s.holdSumNs) / s.received))
+                  << Qt::endl;
+            if (m_options.oneWay) {
+                m_out << QString("one-way avg forward %1 ms, backward %2 ms")
+                         .arg(milliseconds(s.forwardSumNs / s.received), milliseconds(s.backwardSumNs / s.received))
+                      << Qt::endl;
+            }
+        }
+    }
+
+    // Stops sending, waits out the timeout for the last replies and quits
+    void finish()
+    {
+        m_sendTimer.stop();
+        QTimer::singleShot(static_cast<int>(m_options.timeoutSeconds * 1000), this, [this]() {
+            m_reportTimer.stop();
+            expire(std::numeric_limits<qint64>::max());
+            report();
+            QCoreApplication::quit();
+        });
+    }
+
+private:
+    void sendDue()
+    {
+        // Catch up to the rate, timers only have millisecond resolution
+        const quint64 due = static_cast<quint64>(m_clock.nsecsElapsed() / 1e9 * m_options.rate) + 1;
+        while (m_nextSequence < due) {
+            UdpEchoProbe probe;
+            probe.sequence = m_nextSequence++;
+            probe.clientSendNs = UdpEchoProbe::nowNs();
+            probe.write(m_probe.data());
+            // A failed send counts as lost once it times out
+            m_socket.writeDatagram(m_probe, m_options.address, m_options.port);
+            m_outstanding.insert(probe.sequence, probe.clientSendNs);
+            ++m_interval.sent;
+        }
+    }
+
+    void readReplies()
+    {
+        while (m_socket.hasPendingDatagrams()) {
+            const QByteArray datagram = m_socket.receiveDatagram(UdpEchoProbe::MAX_SIZE).data();
+            const qint64 receiveNs = UdpEchoProbe::nowNs();
+
+            UdpEchoProbe probe;
+            if (!UdpEchoProbe::parse(datagram.constData(), datagram.size(), &probe)
+                || !(probe.flags & UdpEchoProbe::Reply)) {
+                continue;
+            }
+            if (!m_outstanding.remove(probe.sequence)) {
+                if (m_expired.remove(probe.sequence)) {
+                    ++m_interval.late;
+                } else {
+                    ++m_interval.duplicates;
+                }
+                continue;
+            }
+
+            ++m_interval.received;
+            if (m_anyReceived && probe.sequence < m_highestReceived) {
+                ++m_interval.reordered;
+            }
+            m_highestReceived = m_anyReceived ? qMax(m_highestReceived, probe.sequence) : probe.sequence;
+
+            const qint64 rtt = receiveNs - probe.clientSendNs;
+            const qint64 hold = probe.serverTransmitNs - probe.serverReceiveNs;
+            const qint64 forward = probe.serverReceiveNs - probe.clientSendNs;
+            const qint64 backward = receiveNs - probe.serverTransmitNs;
+            m_interval.rttMinNs = qMin(m_interval.rttMinNs, rtt);
+            m_interval.rttMaxNs = qMax(m_interval.rttMaxNs, rtt);
+            m_interval.rttSumNs += rtt;
+            m_interval.holdSumNs += hold;
+            m_interval.forwardSumNs += forward;
+            m_interval.backwardSumNs += backward;
+
+            // RFC 3550 6.4.1: J += (|D| - J) / 16, D the change in transit time
+            if (m_anyReceived) {
+                m_forwardJitterNs += (std::abs(static_cast<double>(forward - m_lastForwardNs)) - m_forwardJitterNs) / 16.0;
+                m_backwardJitterNs += (std::abs(static_cast<double>(backward - m_lastBackwardNs)) - m_backwardJitterNs) / 16.0;
+            }
+            m_lastForwardNs = forward;
+            m_lastBackwardNs = backward;
+            m_anyReceived = true;
+        }
+    }
+
+    // Probes sent before the deadline without a reply are lost
+    void expire(qint64 deadlineNs)
+    {
+        for (auto it = m_outstanding.begin(); it != m_outstanding.end();) {
+            if (it.value() < deadlineNs) {
+                m_expired.insert(it.key());
+                m_expiredOrder.append(it.key());
+                ++m_interval.lost;
+                it = m_outstanding.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        while (m_expiredOrder.size() > EXPIRED_HISTORY) {
+            m_expired.remove(m_expiredOrder.takeFirst());
+        }
+    }
+
+    void report()
+    {
+        expire(UdpEchoProbe::nowNs() - static_cast<qint64>(m_options.timeoutSeconds * 1e9));
+
+        const Stats& s = m_interval;
+        QString line = QString("%1s  sent %2  recv %3  loss %4%")
+                       .arg(m_clock.nsecsElapsed() / 1e9, 6, 'f', 1)
+                       .arg(s.sent).arg(s.received)
+                       .arg(lossPercent(s), 0, 'f', 1);
+        if (s.received > 0) {
+            line += QString("  rtt %1/%2/%3 ms  net %4 ms  jitter fwd %5 bwd %6 ms")
+                    .arg(milliseconds(s.rttMinNs), milliseconds(s.rttSumNs / s.received),
+                         milliseconds(s.rttMaxNs), milliseconds((s.rttSumNs - s.holdSumNs) / s.received),
+                         milliseconds(m_forwardJitterNs), milliseconds(m_backwardJitterNs));
+            if (m_options.oneWay) {
+                line += QString("  owd fwd %1 bwd %2 ms")
+                        .arg(milliseconds(s.forwardSumNs / s.received), milliseconds(s.backwardSumNs / s.received));
+            }
+        }
+        if (s.late + s.duplicates + s.reordered > 0) {
+            line += QString("  late %1 dup %2 reord %3").arg(s.late).arg(s.duplicates).arg(s.reordered);
+        }
+        m_out << line << Qt::endl;
+
+        total.add(m_interval);
+        m_interval = Stats();
+    }
+
+    static double lossPercent(const Stats& s)
+    {
+        const quint64 resolved = s.received + s.lost;
+        return resolved == 0 ? 0.0 : 100.0 * s.lost / resolved;
+    }
+
+private:
+    const Options m_options;
+    QTextStream& m_out;
+    QUdpSocket m_socket;
+    QTimer m_sendTimer;
+    QTimer m_reportTimer;
+    QElapsedTimer m_clock;
+    QByteArray m_probe;
+
+    quint32 m_nextSequence = 0;
+    QHash<quint32, qint64> m_outstanding;    // Sequence to send time
+    QSet<quint32> m_expired;
+    QList<quint32> m_expiredOrder;
+
+    Stats m_interval;
+    bool m_anyReceived = false;
+    quint32 m_highestReceived = 0;
+    qint64 m_lastForwardNs = 0;
+    qint64 m_lastBackwardNs = 0;
+    double m_forwardJitterNs = 0.0;
+    double m_backwardJitterNs = 0.0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("UDP latency, jitter and loss probe for the Visco Connect UDP echo server");
+    parser.addHelpOption();
+    parser.addPositionalArgument("host", "Host running the UDP echo server.");
+    const QCommandLineOption portOption("port", "UDP echo server port.", "port", "7778");
+    const QCommandLineOption rateOption("rate", "Probes per second.", "n/s", "50");
+    const QCommandLineOption sizeOption("size", "Probe size, from 36 to 1472.", "bytes", "64");
+    const QCommandLineOption intervalOption("interval", "Seconds between reports.", "s", "1");
+    const QCommandLineOption timeoutOption("timeout", "Seconds before an unanswered probe counts as lost.", "s", "1");
+    const QCommandLineOption durationOption("duration", "Seconds to send probes, 0 to run until killed.", "s", "10");
+    const QCommandLineOption oneWayOption("one-way", "Also report one-way delays. Needs synchronised clocks.");
+    parser.addOptions({portOption, rateOption, sizeOption, intervalOption, timeoutOption, durationOption,
+                       oneWayOption});
+    parser.process(app);
+
+    Options options;
+    options.port = static_cast<quint16>(parser.value(portOption).toUShort());
+    options.rate = parser.value(rateOption).toInt();
+    options.size = parser.value(sizeOption).toInt();
+    options.intervalSeconds = parser.value(intervalOption).toDouble();
+    options.timeoutSeconds = parser.value(timeoutOption).toDouble();
+    options.durationSeconds = parser.value(durationOption).toDouble();
+    options.oneWay = parser.isSet(oneWayOption);
+    if (parser.positionalArguments().size() != 1 || options.port == 0
+        || options.rate < 1 || options.rate > 100000
+        || options.size < UdpEchoProbe::HEADER_SIZE || options.size > UdpEchoProbe::MAX_SIZE
+        || options.intervalSeconds < 0.1 || options.timeoutSeconds < 0.001 || options.durationSeconds < 0.0) {
+        err << "Invalid options, see --help" << Qt::endl;
+        return 2;
+    }
+
+    const QString host = parser.positionalArguments().constFirst();
+    options.address = QHostAddress(host);
+    if (options.address.isNull()) {
+        const QHostInfo info = QHostInfo::fromName(host);
+        if (info.addresses().isEmpty()) {
+            err << QString("Cannot resolve %1: %2").arg(host, info.errorString()) << Qt::endl;
+            return 2;
+        }
+        options.address = info.addresses().constFirst();
+    }
+
+    Pinger pinger(options, out);
+    pinger.start();
+    if (options.durationSeconds > 0.0) {
+        QTimer::singleShot(static_cast<int>(options.durationSeconds * 1000), &pinger, [&pinger]() { pinger.finish(); });
+    }
+    app.exec();
+
+    pinger.printSummary();
+    return pinger.total.received > 0 ? 0 : 1;
+}